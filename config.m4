@@ -15,48 +15,49 @@ if test "$PHP_CUDA" != "no"; then
       AC_MSG_RESULT([CUBLAS detected ])
       PHP_ADD_MAKEFILE_FRAGMENT($abs_srcdir/Makefile.frag, $abs_builddir)
       CFLAGS+=" -lcublas -lcudart "
-      AC_CHECK_HEADER([immintrin.h],
-              [
-                AC_DEFINE(HAVE_AVX2,1,[Have AV2/SSE support])
-                AC_MSG_RESULT([AVX2/SSE detected ])
-                CXX+=" -mavx2 -march=native "
-              ],[
-                AC_DEFINE(HAVE_AVX2,0,[Have AV2/SSE support])
-                AC_MSG_RESULT([AVX2/SSE not found ])
-              ], [
-
-              ]
-          )
     ],[
         AC_MSG_RESULT([wrong cublas version or library not found.])
-        AC_CHECK_HEADER([immintrin.h],
-            [
-              AC_DEFINE(HAVE_AVX2,1,[Have AV2/SSE support])
-              AC_MSG_RESULT([AVX2/SSE detected ])
-              CFLAGS+=" -mavx2 -march=native "
-            ],[
-              AC_DEFINE(HAVE_AVX2,0,[Have AV2/SSE support])
-              AC_MSG_RESULT([AVX2/SSE not found ])
-            ], [
-
-            ]
-        )
     ])
-else
-    AC_CHECK_HEADER([immintrin.h],
-        [
-          AC_DEFINE(HAVE_AVX2,1,[Have AV2/SSE support])
-          AC_MSG_RESULT([AVX2/SSE detected ])
-          CFLAGS+=" -mavx2 -march=native "
-        ],[
-          AC_DEFINE(HAVE_AVX2,0,[Have AV2/SSE support])
-          AC_MSG_RESULT([AVX2/SSE not found ])
-        ], [
-
-        ]
-    )
 fi
 
+dnl The AVX2/AVX-512F kernels are compiled with per-function target
+dnl attributes and selected at runtime, so no -m flags are added here.
+AC_MSG_CHECKING([whether the compiler supports AVX2 target attributes])
+AC_COMPILE_IFELSE([AC_LANG_PROGRAM([[
+#include <immintrin.h>
+__attribute__((target("avx2,fma"))) float f(float *a) {
+    __m256 v = _mm256_loadu_ps(a);
+    _mm256_storeu_ps(a, _mm256_fmadd_ps(v, v, v));
+    return a[0];
+}
+]], [[
+float a[8] = {0};
+__builtin_cpu_init();
+return __builtin_cpu_supports("avx2") ? (int) f(a) : 0;
+]])],[
+    AC_DEFINE(HAVE_AVX2,1,[Have AVX2 target support])
+    AC_MSG_RESULT([yes])
+
+    AC_MSG_CHECKING([whether the compiler supports AVX-512F target attributes])
+    AC_COMPILE_IFELSE([AC_LANG_PROGRAM([[
+#include <immintrin.h>
+__attribute__((target("avx512f,avx2,fma"))) void f(float *a, int n) {
+    __mmask16 m = (__mmask16) ((1u << n) - 1);
+    _mm512_mask_storeu_ps(a, m, _mm512_maskz_loadu_ps(m, a));
+}
+]], [[
+float a[16] = {0};
+__builtin_cpu_init();
+if (__builtin_cpu_supports("avx512f")) f(a, 3);
+]])],[
+        AC_DEFINE(HAVE_AVX512F,1,[Have AVX-512F target support])
+        AC_MSG_RESULT([yes])
+    ],[
+        AC_MSG_RESULT([no])
+    ])
+],[
+    AC_MSG_RESULT([no])
+])
 
 if test "$PHP_GD" != "no"; then
     AC_DEFINE(HAVE_GD,1,[Have GD support])
@@ -117,13 +118,18 @@ PHP_CHECK_LIBRARY(cudnn, cudnnCreate,
 
 if test "$PHP_NDARRAY" != "no"; then
   AC_DEFINE(HAVE_NDARRAY, 1, [ Have ndarray support ])
+  PHP_ADD_LIBRARY(pthread,,NDARRAY_SHARED_LIBADD)
   PHP_NEW_EXTENSION(ndarray,
       numpower.c \
       src/initializers.c \
       src/ndmath/double_math.c \
+      src/ndmath/simd_math.c \
       src/ndarray.c \
       src/debug.c \
       src/buffer.c \
+      src/cpu.c \
+      src/cpu_alloc.c \
+      src/threadpool.c \
       src/logic.c \
       src/gpu_alloc.c \
       src/ndmath/linalg.c \
@@ -132,6 +138,12 @@ if test "$PHP_NDARRAY" != "no"; then
       src/iterators.c \
       src/indexing.c \
       src/ndmath/arithmetics.c \
+      src/ndmath/elementwise.c \
+      src/ndmath/lazy.c \
+      src/ndmath/reduction.c \
+      src/ndmath/scan.c \
+      src/ndmath/sort.c \
+      src/ndmath/histogram.c \
       src/ndmath/calculation.c \
       src/ndmath/statistics.c \
       src/ndmath/signal.c \
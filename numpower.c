@@ -4,6 +4,7 @@
 
 #include <Zend/zend_modules.h>
 #include <Zend/zend_interfaces.h>
+#include <Zend/zend_objects.h>
 #include "php.h"
 #include "ext/standard/info.h"
 #include "numpower_arginfo.h"
@@ -15,6 +16,8 @@
 #include "php_numpower.h"
 #include "src/debug.h"
 #include "src/ndmath/arithmetics.h"
+#include "src/ndmath/elementwise.h"
+#include "src/ndmath/lazy.h"
 #include "src/logic.h"
 #include "src/manipulation.h"
 #include "src/ndmath/double_math.h"
@@ -25,7 +28,14 @@
 #include "src/ndmath/statistics.h"
 #include "src/ndmath/signal.h"
 #include "src/ndmath/calculation.h"
+#include "src/ndmath/reduction.h"
+#include "src/ndmath/scan.h"
+#include "src/ndmath/sort.h"
+#include "src/ndmath/histogram.h"
 #include "src/dnn.h"
+#include "src/cpu.h"
+#include "src/threadpool.h"
+#include "src/cpu_alloc.h"
 
 #ifdef HAVE_CUBLAS
 #include <cuda_runtime.h>
@@ -47,6 +57,94 @@
 
 static zend_object_handlers ndarray_object_handlers;
 static zend_object_handlers arithmetic_object_handlers;
+static zend_object_handlers lazy_object_handlers;
+
+/**
+ * LazyNDArray holds a deferred expression and, once evaluated,
+ * the NDArray object with its result.
+ */
+typedef struct {
+    NDArrayExpr *expr;
+    zval value;
+    zend_object std;
+} LazyNDArrayObject;
+
+static inline LazyNDArrayObject *
+lazy_object_fetch(zend_object *obj) {
+    return (LazyNDArrayObject *) ((char *) obj - XtOffsetOf(LazyNDArrayObject, std));
+}
+
+#define Z_LAZY_P(zv) lazy_object_fetch(Z_OBJ_P(zv))
+
+static NDArray* LAZY_TO_NDARRAY(zval *obj);
+
+/**
+ * NDArray objects keep a direct pointer to their NDArray, so methods
+ * and operators do not go through the buffer to find it. `uuid` is
+ * the buffer slot the array was registered in and is released when
+ * the object is freed.
+ */
+typedef struct {
+    NDArray *array;
+    int uuid;
+    zend_object std;
+} NDArrayObject;
+
+static inline NDArrayObject *
+ndarray_object_fetch(zend_object *obj) {
+    return (NDArrayObject *) ((char *) obj - XtOffsetOf(NDArrayObject, std));
+}
+
+#define Z_NDARRAY_P(zv) (ndarray_object_fetch(Z_OBJ_P(zv))->array)
+
+/**
+ * Attach `array` to a NDArray object, the object takes the reference.
+ * An array already held by the object, e.g. when __construct or
+ * __unserialize is called again, is released.
+ *
+ * @param obj
+ * @param array
+ */
+static void
+ndarray_object_set(zend_object *obj, NDArray *array) {
+    NDArrayObject *intern = ndarray_object_fetch(obj);
+    int old_uuid = (intern->array != NULL) ? intern->uuid : -1;
+    add_to_buffer(array);
+    intern->array = array;
+    intern->uuid = NDArray_UUID(array);
+    if (old_uuid >= 0) {
+        buffer_ndarray_free(old_uuid);
+    }
+}
+
+/**
+ * Initialize `zv` as a new NDArray object holding `array`
+ *
+ * @param zv
+ * @param array
+ */
+static void
+ndarray_object_init(zval *zv, NDArray *array) {
+    object_init_ex(zv, phpsci_ce_NDArray);
+    ndarray_object_set(Z_OBJ_P(zv), array);
+}
+
+#ifdef HAVE_GD
+/**
+ * GdImage class entry, looked up on first use as ext/gd may be
+ * loaded after this extension.
+ *
+ * @return
+ */
+static zend_class_entry*
+gd_image_class_entry() {
+    static zend_class_entry *gd_image_ce = NULL;
+    if (gd_image_ce == NULL) {
+        gd_image_ce = zend_hash_str_find_ptr(CG(class_table), "gdimage", sizeof("gdimage") - 1);
+    }
+    return gd_image_ce;
+}
+#endif
 
 int *
 zval_axis_argument(zval *arg, char *name, int *outsize)
@@ -81,11 +179,6 @@ zval_axis_argument(zval *arg, char *name, int *outsize)
     return result;
 }
 
-int
-get_object_uuid(zval* obj) {
-    return Z_LVAL_P(OBJ_PROP_NUM(Z_OBJ_P(obj), 0));
-}
-
 NDArray* ZVAL_TO_NDARRAY(zval* obj) {
     if (Z_TYPE_P(obj) == IS_ARRAY) {
         return Create_NDArray_FromZval(obj);
@@ -97,17 +190,15 @@ NDArray* ZVAL_TO_NDARRAY(zval* obj) {
         return NDArray_CreateFromDoubleScalar(Z_DVAL_P(obj));
     }
     if (Z_TYPE_P(obj) == IS_OBJECT) {
-        zend_class_entry* ce = NULL;
-        ce = Z_OBJCE_P(obj);
-        zend_string* class_name = Z_OBJ_P(obj)->ce->name;
-        if (strcmp(ZSTR_VAL(class_name), "NDArray") == 0) {
-            if (ce == phpsci_ce_NDArray) {
-                return buffer_get(get_object_uuid(obj));
-            }
+        zend_class_entry* ce = Z_OBJCE_P(obj);
+        if (ce == phpsci_ce_NDArray) {
+            return Z_NDARRAY_P(obj);
+        }
+        if (ce == phpsci_ce_LazyNDArray) {
+            return LAZY_TO_NDARRAY(obj);
         }
 #ifdef HAVE_GD
-        /* Check if the zend_object class name is "GdImage" */
-        if (strcmp(ZSTR_VAL(class_name), "GdImage") == 0) {
+        if (ce == gd_image_class_entry()) {
             return NDArray_FromGD(obj, false);
         }
 #endif
@@ -124,12 +215,8 @@ void CHECK_INPUT_AND_FREE(zval *a, NDArray *nda) {
         NDArray_FREE(nda);
     }
 #ifdef HAVE_GD
-    if (Z_TYPE_P(a) == IS_OBJECT) {
-        /* Check if the zend_object class name is "GdImage" */
-        zend_string* class_name = Z_OBJ_P(a)->ce->name;
-        if (strcmp(ZSTR_VAL(class_name), "GdImage") == 0) {
-            NDArray_FREE(nda);
-        }
+    if (Z_TYPE_P(a) == IS_OBJECT && Z_OBJCE_P(a) == gd_image_class_entry()) {
+        NDArray_FREE(nda);
     }
 #endif
 }
@@ -140,15 +227,92 @@ void RETURN_NDARRAY(NDArray* array, zval* return_value) {
         return;
     }
     if (NDArray_NDIM(array) > 0) {
-        add_to_buffer(array);
-        object_init_ex(return_value, phpsci_ce_NDArray);
-        ZVAL_LONG(OBJ_PROP_NUM(Z_OBJ_P(return_value), 0), NDArray_UUID(array));
+        ndarray_object_init(return_value, array);
     } else {
         ZVAL_DOUBLE(return_value, NDArray_GetFloatScalar(array));
         NDArray_FREE(array);
     }
 }
 
+/**
+ * Resolve an optional `out` argument. `*out_nd` is NULL when the
+ * argument was not given or is null.
+ *
+ * @param out
+ * @param out_nd
+ * @return SUCCESS or FAILURE if `out` is not an NDArray
+ */
+int
+ZVAL_TO_OUT_NDARRAY(zval *out, NDArray **out_nd) {
+    *out_nd = NULL;
+    if (out == NULL || Z_TYPE_P(out) == IS_NULL) {
+        return SUCCESS;
+    }
+    if (Z_TYPE_P(out) != IS_OBJECT || Z_OBJCE_P(out) != phpsci_ce_NDArray) {
+        zend_throw_error(NULL, "`out` argument must be an NDArray.");
+        return FAILURE;
+    }
+    *out_nd = Z_NDARRAY_P(out);
+    return SUCCESS;
+}
+
+/**
+ * Return `out` when the result was written into it, otherwise
+ * behave like RETURN_NDARRAY.
+ *
+ * @param array
+ * @param out
+ * @param return_value
+ */
+void RETURN_NDARRAY_OUT(NDArray* array, zval *out, zval* return_value) {
+    if (array == NULL) {
+        RETURN_THROWS();
+    }
+    if (out != NULL && Z_TYPE_P(out) != IS_NULL) {
+        RETURN_COPY(out);
+    }
+    RETURN_NDARRAY(array, return_value);
+}
+
+/**
+ * Reduce a CPU array over the `axis` argument of a reduction method, an
+ * integer or an array of integers. NULL reduces every axis.
+ *
+ * @param nda
+ * @param axis
+ * @param keepdims
+ * @param op
+ * @param ddof Delta degrees of freedom of the variance and std
+ * @param where Optional `where` mask argument, NULL to reduce every element
+ * @param skipnan Ignore NaN, the nan* reductions
+ * @return
+ */
+static NDArray*
+reduce_axis_argument(NDArray *nda, zval *axis, bool keepdims, NDArray_ReduceOp op, int ddof, zval *where,
+                     bool skipnan) {
+    NDArray *rtn, *where_nd = NULL;
+    int *axes = NULL, naxes = 0;
+    if (where != NULL) {
+        where_nd = ZVAL_TO_NDARRAY(where);
+        if (where_nd == NULL) {
+            return NULL;
+        }
+    }
+    if (axis != NULL) {
+        axes = zval_axis_argument(axis, "axis", &naxes);
+        if (axes == NULL) {
+            CHECK_INPUT_AND_FREE(where, where_nd);
+            return NULL;
+        }
+    }
+    rtn = NDArray_ReduceWhere(nda, op, axes, naxes, keepdims, ddof, skipnan, where_nd);
+    if (axes != NULL) {
+        efree(axes);
+    }
+    CHECK_INPUT_AND_FREE(where, where_nd);
+    return rtn;
+}
+
 NDArray**
 ARRAY_OF_NDARRAYS(zval *array, int *size) {
     zval *val;
@@ -163,7 +327,7 @@ ARRAY_OF_NDARRAYS(zval *array, int *size) {
             zend_class_entry* ce = NULL;
             ce = Z_OBJCE_P(val);
             if (ce == phpsci_ce_NDArray) {
-                rtn[cur_index] = buffer_get(get_object_uuid(val));
+                rtn[cur_index] = Z_NDARRAY_P(val);
             }
         }
         cur_index++;
@@ -185,42 +349,148 @@ static int ndarray_objects_compare(zval *obj1, zval *obj2) {
     return 1;
 }
 
-typedef struct {
-    zend_object std;
-    int value;
-} NDArrayObject;
-
-static int ndarray_do_operation_ex(zend_uchar opcode, zval *result, zval *op1, zval *op2) { /* {{{ */
-    NDArray *nda = ZVAL_TO_NDARRAY(op1);
-    NDArray *ndb = ZVAL_TO_NDARRAY(op2);
-    if (nda == NULL | ndb == NULL) {
-        return FAILURE;
-    }
-    NDArray *rtn = NULL;
+/**
+ * Map an arithmetic opcode to the matching element-wise operation
+ *
+ * @param opcode
+ * @param op
+ * @return 1 if the opcode is supported, 0 otherwise
+ */
+static int
+opcode_to_binary_op(zend_uchar opcode, NDArray_BinaryOp *op) {
     switch(opcode) {
     case ZEND_ADD:
-        rtn = NDArray_Add_Float(nda, ndb);
-        break;
+        *op = NDARRAY_BINARY_ADD;
+        return 1;
     case ZEND_SUB:
-        rtn = NDArray_Subtract_Float(nda, ndb);
-        break;
+        *op = NDARRAY_BINARY_SUBTRACT;
+        return 1;
     case ZEND_MUL:
-        rtn = NDArray_Multiply_Float(nda, ndb);
-        break;
+        *op = NDARRAY_BINARY_MULTIPLY;
+        return 1;
     case ZEND_DIV:
-        rtn = NDArray_Divide_Float(nda, ndb);
-        break;
+        *op = NDARRAY_BINARY_DIVIDE;
+        return 1;
     case ZEND_POW:
-        rtn = NDArray_Pow_Float(nda, ndb);
-        break;
+        *op = NDARRAY_BINARY_POW;
+        return 1;
     case ZEND_MOD:
-        rtn = NDArray_Mod_Float(nda, ndb);
-        break;
+        *op = NDARRAY_BINARY_MOD;
+        return 1;
     default:
+        return 0;
+    }
+}
+
+/**
+ * Return the CPU NDArray behind `obj` when it is an NDArray object and
+ * `scalar` is a PHP int or float, NULL otherwise.
+ */
+static NDArray*
+scalar_operand_target(zval *obj, zval *scalar) {
+    NDArray *target;
+    if (Z_TYPE_P(scalar) != IS_LONG && Z_TYPE_P(scalar) != IS_DOUBLE) {
+        return NULL;
+    }
+    if (Z_TYPE_P(obj) != IS_OBJECT || Z_OBJCE_P(obj) != phpsci_ce_NDArray) {
+        return NULL;
+    }
+    target = Z_NDARRAY_P(obj);
+    if (target == NULL || NDArray_DEVICE(target) != NDARRAY_DEVICE_CPU) {
+        return NULL;
+    }
+    return target;
+}
+
+/**
+ * Return the NDArray behind `operand` when it is a temporary of the
+ * running opline that nothing else references, so its buffer can be
+ * reused for a result of the given shape. Returns NULL otherwise.
+ *
+ * Only VM temporaries (e.g. the result of `$a * $b` in `$a * $b + $c`)
+ * qualify, a variable with a refcount of 1 is still reachable by name.
+ */
+static NDArray*
+elidable_temporary(zend_uchar opcode, zval *operand, zval *result, int ndim, const int *shape) {
+    zend_execute_data *ex = EG(current_execute_data);
+    const zend_op *opline;
+    NDArray *nda;
+
+    if (operand == result || Z_TYPE_P(operand) != IS_OBJECT ||
+        Z_OBJCE_P(operand) != phpsci_ce_NDArray || Z_REFCOUNT_P(operand) != 1) {
+        return NULL;
+    }
+    if (ex == NULL || ex->func == NULL || !ZEND_USER_CODE(ex->func->type) || ex->opline == NULL) {
+        return NULL;
+    }
+    opline = ex->opline;
+    if (opline->opcode != opcode) {
+        return NULL;
+    }
+    if (!((opline->op1_type & (IS_TMP_VAR|IS_VAR)) && ZEND_CALL_VAR(ex, opline->op1.var) == operand) &&
+        !((opline->op2_type & (IS_TMP_VAR|IS_VAR)) && ZEND_CALL_VAR(ex, opline->op2.var) == operand)) {
+        return NULL;
+    }
+    nda = Z_NDARRAY_P(operand);
+    if (nda == NULL || NDArray_DEVICE(nda) != NDARRAY_DEVICE_CPU || nda->base != NULL || nda->refcount != 1) {
+        return NULL;
+    }
+    if (NDArray_NDIM(nda) != ndim || !NDArray_CompareLists(NDArray_SHAPE(nda), shape, ndim)) {
+        return NULL;
+    }
+    return nda;
+}
+
+static int ndarray_do_operation_ex(zend_uchar opcode, zval *result, zval *op1, zval *op2) { /* {{{ */
+    NDArray_BinaryOp op;
+    NDArray *rtn = NULL, *target, *temp = NULL;
+    zval *temp_zval = NULL;
+    int ndim, shape[NDARRAY_MAX_DIMS];
+
+    if (!opcode_to_binary_op(opcode, &op)) {
+        return FAILURE;
+    }
+
+    // A LazyNDArray on the right records the operation in its own handler
+    if (Z_TYPE_P(op2) == IS_OBJECT && Z_OBJCE_P(op2) == phpsci_ce_LazyNDArray) {
         return FAILURE;
     }
-    CHECK_INPUT_AND_FREE(op1, nda);
-    CHECK_INPUT_AND_FREE(op2, ndb);
+
+    // Array-scalar operations skip the 0-d NDArray for the scalar side
+    if ((target = scalar_operand_target(op1, op2)) != NULL) {
+        temp_zval = op1;
+        temp = elidable_temporary(opcode, op1, result, NDArray_NDIM(target), NDArray_SHAPE(target));
+        rtn = NDArray_BinaryScalarOut(target, (float) zval_get_double(op2), op, 0, temp);
+    } else if ((target = scalar_operand_target(op2, op1)) != NULL) {
+        temp_zval = op2;
+        temp = elidable_temporary(opcode, op2, result, NDArray_NDIM(target), NDArray_SHAPE(target));
+        rtn = NDArray_BinaryScalarOut(target, (float) zval_get_double(op1), op, 1, temp);
+    } else {
+        NDArray *nda = ZVAL_TO_NDARRAY(op1);
+        NDArray *ndb = ZVAL_TO_NDARRAY(op2);
+        if (nda == NULL || ndb == NULL) {
+            CHECK_INPUT_AND_FREE(op1, nda);
+            CHECK_INPUT_AND_FREE(op2, ndb);
+            return FAILURE;
+        }
+        // Reuse the buffer of a temporary operand as the output
+        if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU && NDArray_DEVICE(ndb) == NDARRAY_DEVICE_CPU &&
+            (ndim = NDArray_BroadcastShape(nda, ndb, shape)) >= 0) {
+            temp_zval = op1;
+            temp = elidable_temporary(opcode, op1, result, ndim, shape);
+            if (temp == NULL) {
+                temp_zval = op2;
+                temp = elidable_temporary(opcode, op2, result, ndim, shape);
+            }
+        }
+        rtn = NDArray_BinaryOperationOut(nda, ndb, op, temp);
+        CHECK_INPUT_AND_FREE(op1, nda);
+        CHECK_INPUT_AND_FREE(op2, ndb);
+    }
+    if (rtn != NULL && rtn == temp) {
+        ZVAL_COPY(result, temp_zval);
+        return SUCCESS;
+    }
     RETURN_NDARRAY(rtn, result);
     if (rtn != NULL) {
         return SUCCESS;
@@ -289,19 +559,32 @@ int arithmetic_do_operation(zend_uchar opcode, zval *result, zval *op1, zval *op
 }
 
 
-static void ndarray_destructor(zend_object* object) {
-    zval *obj_uuid = OBJ_PROP_NUM(object, 0);
-    if (GC_REFCOUNT(object) <= 1 && Z_TYPE_P(obj_uuid) != IS_UNDEF) {
-        buffer_ndarray_free((int)Z_LVAL_P(obj_uuid));
-        zend_object_std_dtor(object);
+static void ndarray_free_object(zend_object *object) {
+    NDArrayObject *intern = ndarray_object_fetch(object);
+    if (intern->array != NULL) {
+        buffer_ndarray_free(intern->uuid);
+        intern->array = NULL;
+    }
+    zend_object_std_dtor(&intern->std);
+}
+
+static zend_object *ndarray_clone_object(zend_object *object) {
+    NDArrayObject *intern = ndarray_object_fetch(object);
+    zend_object *clone = object->ce->create_object(object->ce);
+    zend_objects_clone_members(clone, object);
+    if (intern->array != NULL) {
+        ndarray_object_set(clone, NDArray_Copy(intern->array, NDArray_DEVICE(intern->array)));
     }
+    return clone;
 }
 
 static void ndarray_objects_init(zend_class_entry *class_type) {
     memcpy(&ndarray_object_handlers, &std_object_handlers, sizeof(zend_object_handlers));
+    ndarray_object_handlers.offset = XtOffsetOf(NDArrayObject, std);
     ndarray_object_handlers.compare = ndarray_objects_compare;
     ndarray_object_handlers.do_operation = ndarray_do_operation;
-    ndarray_object_handlers.free_obj = ndarray_destructor;
+    ndarray_object_handlers.free_obj = ndarray_free_object;
+    ndarray_object_handlers.clone_obj = ndarray_clone_object;
 }
 
 static void arithmetic_objects_init(zend_class_entry *class_type) {
@@ -311,6 +594,8 @@ static void arithmetic_objects_init(zend_class_entry *class_type) {
 
 static zend_object *ndarray_create_object(zend_class_entry *class_type) {
     NDArrayObject *intern = zend_object_alloc(sizeof(NDArrayObject), class_type);
+    intern->array = NULL;
+    intern->uuid = -1;
 
     zend_object_std_init(&intern->std, class_type);
     object_properties_init(&intern->std, class_type);
@@ -320,21 +605,178 @@ static zend_object *ndarray_create_object(zend_class_entry *class_type) {
 }
 
 static zend_object *arithmetic_create_object(zend_class_entry *class_type) {
-    NDArrayObject *intern = zend_object_alloc(sizeof(NDArrayObject), class_type);
-    zend_object_std_init(&intern->std, class_type);
-    object_properties_init(&intern->std, class_type);
-    intern->std.handlers = &arithmetic_object_handlers;
-    return &intern->std;
+    zend_object *intern = zend_object_alloc(sizeof(zend_object), class_type);
+    zend_object_std_init(intern, class_type);
+    object_properties_init(intern, class_type);
+    intern->handlers = &arithmetic_object_handlers;
+    return intern;
 }
 
-NDArray* ZVALUUID_TO_NDARRAY(zval* obj) {
-    if (Z_TYPE_P(obj) == IS_LONG) {
-        return buffer_get(Z_LVAL_P(obj));
+/**
+ * Expression for a LazyNDArray, NDArray, PHP array or scalar operand.
+ * The caller owns the returned reference.
+ *
+ * @param operand
+ * @return
+ */
+static NDArrayExpr*
+ZVAL_TO_EXPR(zval *operand) {
+    NDArrayExpr *expr;
+    NDArray *nda;
+    if (Z_TYPE_P(operand) == IS_OBJECT && Z_OBJCE_P(operand) == phpsci_ce_LazyNDArray) {
+        expr = Z_LAZY_P(operand)->expr;
+        if (expr == NULL) {
+            zend_throw_error(NULL, "LazyNDArray must be created with NDArray::lazy().");
+            return NULL;
+        }
+        expr->refcount++;
+        return expr;
     }
-    if (Z_TYPE_P(obj) == IS_OBJECT) {
-        return buffer_get(get_object_uuid(obj));
+    if (Z_TYPE_P(operand) == IS_LONG || Z_TYPE_P(operand) == IS_DOUBLE) {
+        return NDArrayExpr_Scalar((float) zval_get_double(operand));
     }
-    return NULL;
+    nda = ZVAL_TO_NDARRAY(operand);
+    if (nda == NULL) {
+        return NULL;
+    }
+    expr = NDArrayExpr_Leaf(nda);
+    CHECK_INPUT_AND_FREE(operand, nda);
+    return expr;
+}
+
+/**
+ * Wrap `expr` in a new LazyNDArray, taking over the caller's reference
+ *
+ * @param expr
+ * @param return_value
+ */
+static void
+RETURN_LAZY(NDArrayExpr *expr, zval *return_value) {
+    if (expr == NULL) {
+        RETURN_THROWS();
+    }
+    object_init_ex(return_value, phpsci_ce_LazyNDArray);
+    Z_LAZY_P(return_value)->expr = expr;
+}
+
+/**
+ * Evaluate a LazyNDArray once and return its result. The result
+ * replaces the recorded expression, so the operands it referenced
+ * are released.
+ *
+ * @param obj
+ * @return
+ */
+static NDArray*
+LAZY_TO_NDARRAY(zval *obj) {
+    LazyNDArrayObject *intern = Z_LAZY_P(obj);
+    NDArray *rtn;
+    if (Z_TYPE(intern->value) == IS_UNDEF) {
+        if (intern->expr == NULL) {
+            zend_throw_error(NULL, "LazyNDArray must be created with NDArray::lazy().");
+            return NULL;
+        }
+        rtn = NDArrayExpr_Eval(intern->expr);
+        if (rtn == NULL) {
+            return NULL;
+        }
+        NDArrayExpr_FREE(intern->expr);
+        intern->expr = NDArrayExpr_Leaf(rtn);
+        ndarray_object_init(&intern->value, rtn);
+    }
+    return Z_NDARRAY_P(&intern->value);
+}
+
+/**
+ * Record `func` on a LazyNDArray operand instead of running it.
+ *
+ * @param operand
+ * @param out
+ * @param func
+ * @param return_value
+ * @return 1 if the operation was recorded, 0 if it must run now
+ */
+static int
+lazy_unary(zval *operand, zval *out, ElementWiseDoubleOperation func, zval *return_value) {
+    NDArrayExpr *expr;
+    if (Z_TYPE_P(operand) != IS_OBJECT || Z_OBJCE_P(operand) != phpsci_ce_LazyNDArray) {
+        return 0;
+    }
+    if (out != NULL && Z_TYPE_P(out) != IS_NULL) {
+        return 0;
+    }
+    expr = ZVAL_TO_EXPR(operand);
+    if (expr != NULL) {
+        RETURN_LAZY(NDArrayExpr_Unary(func, expr), return_value);
+        NDArrayExpr_FREE(expr);
+    }
+    return 1;
+}
+
+static int lazy_do_operation_ex(zend_uchar opcode, zval *result, zval *op1, zval *op2) {
+    NDArray_BinaryOp op;
+    NDArrayExpr *left, *right;
+
+    if (!opcode_to_binary_op(opcode, &op)) {
+        return FAILURE;
+    }
+    left = ZVAL_TO_EXPR(op1);
+    if (left == NULL) {
+        return FAILURE;
+    }
+    right = ZVAL_TO_EXPR(op2);
+    if (right == NULL) {
+        NDArrayExpr_FREE(left);
+        return FAILURE;
+    }
+    RETURN_LAZY(NDArrayExpr_Binary(op, left, right), result);
+    NDArrayExpr_FREE(left);
+    NDArrayExpr_FREE(right);
+    return EG(exception) ? FAILURE : SUCCESS;
+}
+
+static int lazy_do_operation(zend_uchar opcode, zval *result, zval *op1, zval *op2) {
+    zval op1_copy;
+    int retval;
+    // Compound assignments pass the same zval as op1 and result
+    if (result == op1) {
+        ZVAL_COPY_VALUE(&op1_copy, op1);
+        op1 = &op1_copy;
+    }
+    retval = lazy_do_operation_ex(opcode, result, op1, op2);
+    if (op1 == &op1_copy) {
+        if (retval == SUCCESS) {
+            zval_ptr_dtor(op1);
+        } else {
+            ZVAL_COPY_VALUE(result, op1);
+        }
+    }
+    return retval;
+}
+
+static void lazy_free_object(zend_object *object) {
+    LazyNDArrayObject *intern = lazy_object_fetch(object);
+    NDArrayExpr_FREE(intern->expr);
+    zval_ptr_dtor(&intern->value);
+    zend_object_std_dtor(&intern->std);
+}
+
+static void lazy_objects_init(zend_class_entry *class_type) {
+    memcpy(&lazy_object_handlers, &std_object_handlers, sizeof(zend_object_handlers));
+    lazy_object_handlers.offset = XtOffsetOf(LazyNDArrayObject, std);
+    lazy_object_handlers.do_operation = lazy_do_operation;
+    lazy_object_handlers.free_obj = lazy_free_object;
+    lazy_object_handlers.clone_obj = NULL;
+}
+
+static zend_object *lazy_create_object(zend_class_entry *class_type) {
+    LazyNDArrayObject *intern = zend_object_alloc(sizeof(LazyNDArrayObject), class_type);
+    intern->expr = NULL;
+    ZVAL_UNDEF(&intern->value);
+    zend_object_std_init(&intern->std, class_type);
+    object_properties_init(&intern->std, class_type);
+    intern->std.handlers = &lazy_object_handlers;
+    return &intern->std;
 }
 
 void RETURN_2NDARRAY(NDArray* array1, NDArray* array2, zval* return_value) {
@@ -348,9 +790,6 @@ void RETURN_2NDARRAY(NDArray* array1, NDArray* array2, zval* return_value) {
         return;
     }
 
-    add_to_buffer(array1);
-    add_to_buffer(array2);
-
     RETURN_NDARRAY(array1, &a);
     RETURN_NDARRAY(array2, &b);
     array_init(return_value);
@@ -373,17 +812,9 @@ void RETURN_3NDARRAY(NDArray* array1, NDArray* array2, NDArray* array3, zval* re
         return;
     }
 
-    add_to_buffer(array1);
-    add_to_buffer(array2);
-    add_to_buffer(array3);
-
-    object_init_ex(&a, phpsci_ce_NDArray);
-    object_init_ex(&b, phpsci_ce_NDArray);
-    object_init_ex(&c, phpsci_ce_NDArray);
-
-    ZVAL_LONG(OBJ_PROP_NUM(Z_OBJ_P(&a), 0), NDArray_UUID(array1));
-    ZVAL_LONG(OBJ_PROP_NUM(Z_OBJ_P(&b), 0), NDArray_UUID(array2));
-    ZVAL_LONG(OBJ_PROP_NUM(Z_OBJ_P(&c), 0), NDArray_UUID(array3));
+    ndarray_object_init(&a, array1);
+    ndarray_object_init(&b, array2);
+    ndarray_object_init(&c, array3);
 
     array_init_size(return_value, 3);
     add_next_index_zval(return_value, &a);
@@ -416,6 +847,29 @@ PHP_METHOD(ArithmeticOperand, __construct) {
 }
 
 
+/**
+ * LazyNDArray::eval
+ *
+ * Evaluate the recorded expression. The result is computed once and
+ * the same NDArray is returned by later calls.
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_lazy_eval, 0)
+ZEND_END_ARG_INFO()
+PHP_METHOD(LazyNDArray, eval) {
+    LazyNDArrayObject *intern;
+    NDArray *rtn;
+    ZEND_PARSE_PARAMETERS_NONE();
+    rtn = LAZY_TO_NDARRAY(ZEND_THIS);
+    if (rtn == NULL) {
+        RETURN_THROWS();
+    }
+    if (NDArray_NDIM(rtn) == 0) {
+        RETURN_DOUBLE(NDArray_GetFloatScalar(rtn));
+    }
+    intern = Z_LAZY_P(ZEND_THIS);
+    RETURN_COPY(&intern->value);
+}
+
 /* }}}*/
 ZEND_BEGIN_ARG_INFO(arginfo_construct, 1)
 ZEND_ARG_INFO(0, obj_zval)
@@ -430,8 +884,11 @@ PHP_METHOD(NDArray, __construct) {
     if (array == NULL) {
         return;
     }
-    add_to_buffer(array);
-    ZVAL_LONG(OBJ_PROP_NUM(obj, 0), NDArray_UUID(array));
+    if (Z_TYPE_P(obj_zval) == IS_OBJECT &&
+        (Z_OBJCE_P(obj_zval) == phpsci_ce_NDArray || Z_OBJCE_P(obj_zval) == phpsci_ce_LazyNDArray)) {
+        NDArray_ADDREF(array);
+    }
+    ndarray_object_set(obj, array);
 }
 
 ZEND_BEGIN_ARG_INFO(arginfo_fill, 1)
@@ -634,27 +1091,87 @@ PHP_METHOD(NDArray, setDevice) {
 #endif
 }
 
-// @todo Indices conversion lose precision, we must convert it directly to a integer vector in C
-//       without relying on ZVAL_TO_NDARRAY. We must apply the same for all other cases where a
-//       PHP array of longs is converted to NDArray before being converted to a C integer.
-ZEND_BEGIN_ARG_INFO(arginfo_reshape, 2)
-ZEND_ARG_INFO(0, a)
-ZEND_ARG_INFO(0, shape_zval)
+/**
+ * NDArray::setNumThreads
+ *
+ * @param execute_data
+ * @param return_value
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_setnumthreads, 0)
+ZEND_ARG_INFO(0, num_threads)
 ZEND_END_ARG_INFO();
-PHP_METHOD(NDArray, reshape) {
-    int *new_shape;
-    zval *shape_zval;
-    zval *a;
-    NDArray *rtn;
-    ZEND_PARSE_PARAMETERS_START(2, 2)
-        Z_PARAM_ZVAL(a)
-        Z_PARAM_ZVAL(shape_zval)
+PHP_METHOD(NDArray, setNumThreads) {
+    long num_threads;
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+    Z_PARAM_LONG(num_threads)
     ZEND_PARSE_PARAMETERS_END();
-    NDArray* target = ZVAL_TO_NDARRAY(a);
-    NDArray* shape = ZVAL_TO_NDARRAY(shape_zval);
-    new_shape = NDArray_ToIntVector(shape);
-
-    rtn = NDArray_Reshape(target, new_shape, NDArray_NUMELEMENTS(shape));
+    if (num_threads < 1 || num_threads > 1024) {
+        zend_throw_error(NULL, "The number of threads must be between 1 and 1024.");
+        return;
+    }
+    NDArray_SetNumThreads((int) num_threads);
+}
+
+/**
+ * NDArray::getNumThreads
+ *
+ * @param execute_data
+ * @param return_value
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_getnumthreads, 0)
+ZEND_END_ARG_INFO();
+PHP_METHOD(NDArray, getNumThreads) {
+    ZEND_PARSE_PARAMETERS_NONE();
+    RETURN_LONG(NDArray_GetNumThreads());
+}
+
+/**
+ * NDArray::memoryStats
+ *
+ * @param execute_data
+ * @param return_value
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_memorystats, 0)
+ZEND_END_ARG_INFO();
+PHP_METHOD(NDArray, memoryStats) {
+    NDArray_DataStats stats;
+    ZEND_PARSE_PARAMETERS_NONE();
+    NDArray_DataGetStats(&stats);
+    array_init(return_value);
+    add_assoc_long(return_value, "mmap_threshold", (zend_long) stats.mmap_threshold);
+    add_assoc_long(return_value, "mmap_limit", stats.mmap_limit == SIZE_MAX ? -1 : (zend_long) stats.mmap_limit);
+    add_assoc_long(return_value, "mapped", (zend_long) stats.mapped);
+    add_assoc_long(return_value, "peak_mapped", (zend_long) stats.peak_mapped);
+    add_assoc_long(return_value, "mappings", stats.mappings);
+    add_assoc_long(return_value, "total_mappings", stats.total_mappings);
+    add_assoc_long(return_value, "pool_cached", (zend_long) stats.pool_cached);
+    add_assoc_long(return_value, "arrays_live", MAIN_MEM_STACK.numLive);
+    add_assoc_long(return_value, "arrays_allocated", MAIN_MEM_STACK.totalAllocated);
+    add_assoc_long(return_value, "arrays_freed", MAIN_MEM_STACK.totalFreed);
+    add_assoc_long(return_value, "array_slots", MAIN_MEM_STACK.bufferSize);
+}
+
+// @todo Indices conversion lose precision, we must convert it directly to a integer vector in C
+//       without relying on ZVAL_TO_NDARRAY. We must apply the same for all other cases where a
+//       PHP array of longs is converted to NDArray before being converted to a C integer.
+ZEND_BEGIN_ARG_INFO(arginfo_reshape, 2)
+ZEND_ARG_INFO(0, a)
+ZEND_ARG_INFO(0, shape_zval)
+ZEND_END_ARG_INFO();
+PHP_METHOD(NDArray, reshape) {
+    int *new_shape;
+    zval *shape_zval;
+    zval *a;
+    NDArray *rtn;
+    ZEND_PARSE_PARAMETERS_START(2, 2)
+        Z_PARAM_ZVAL(a)
+        Z_PARAM_ZVAL(shape_zval)
+    ZEND_PARSE_PARAMETERS_END();
+    NDArray* target = ZVAL_TO_NDARRAY(a);
+    NDArray* shape = ZVAL_TO_NDARRAY(shape_zval);
+    new_shape = NDArray_ToIntVector(shape);
+
+    rtn = NDArray_Reshape(target, new_shape, NDArray_NUMELEMENTS(shape));
 
     if (rtn == NULL) {
         NDArray_FREE(shape);
@@ -681,18 +1198,16 @@ PHP_FUNCTION(print_r_) {
 
     if (do_return) {
         if (Z_TYPE_P(var) == IS_OBJECT) {
-            zend_class_entry* classEntry = Z_OBJCE_P(var);
-            if (!strcmp(classEntry->name->val, "NDArray")) {
-                target = buffer_get(get_object_uuid(var));
+            if (Z_OBJCE_P(var) == phpsci_ce_NDArray) {
+                target = Z_NDARRAY_P(var);
                 RETURN_STRING(NDArray_Print(target, 1));
             }
         }
         RETURN_STR(zend_print_zval_r_to_str(var, 0));
     } else {
         if (Z_TYPE_P(var) == IS_OBJECT) {
-            zend_class_entry* classEntry = Z_OBJCE_P(var);
-            if (!strcmp(classEntry->name->val, "NDArray")) {
-                target = buffer_get(get_object_uuid(var));
+            if (Z_OBJCE_P(var) == phpsci_ce_NDArray) {
+                target = Z_NDARRAY_P(var);
                 NDArray_Print(target, 0);
                 RETURN_TRUE;
             }
@@ -1604,24 +2119,34 @@ PHP_METHOD(NDArray, flatten) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_abs, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, abs) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_abs, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
-    rtn = NDArray_Abs(nda);
+    rtn = NDArray_AbsOut(nda, out_nd);
 
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -1632,20 +2157,32 @@ PHP_METHOD(NDArray, abs) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_sin, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, sin) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_sin, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map(nda, float_sin);
+        rtn = NDArray_MapOut(nda, float_sin, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise(nda, cuda_float_sin);
@@ -1656,7 +2193,7 @@ PHP_METHOD(NDArray, sin) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -1667,20 +2204,32 @@ PHP_METHOD(NDArray, sin) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_cos, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, cos) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_cos, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map(nda, float_cos);
+        rtn = NDArray_MapOut(nda, float_cos, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise(nda, cuda_float_cos);
@@ -1691,7 +2240,7 @@ PHP_METHOD(NDArray, cos) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -1702,20 +2251,32 @@ PHP_METHOD(NDArray, cos) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_tan, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, tan) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_tan, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map(nda, float_tan);
+        rtn = NDArray_MapOut(nda, float_tan, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise(nda, cuda_float_tan);
@@ -1726,7 +2287,7 @@ PHP_METHOD(NDArray, tan) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -1737,20 +2298,32 @@ PHP_METHOD(NDArray, tan) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_arcsin, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, arcsin) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_arcsin, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map(nda, float_arcsin);
+        rtn = NDArray_MapOut(nda, float_arcsin, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise(nda, cuda_float_arcsin);
@@ -1761,7 +2334,7 @@ PHP_METHOD(NDArray, arcsin) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -1772,20 +2345,32 @@ PHP_METHOD(NDArray, arcsin) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_rsqrt, 0, 0, 1)
                 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, rsqrt) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
             Z_PARAM_ZVAL(array)
+            Z_PARAM_OPTIONAL
+            Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_rsqrt, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map(nda, float_rsqrt);
+        rtn = NDArray_MapOut(nda, float_rsqrt, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise(nda, cuda_float_arccos);
@@ -1796,7 +2381,7 @@ PHP_METHOD(NDArray, rsqrt) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -1807,20 +2392,32 @@ PHP_METHOD(NDArray, rsqrt) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_arccos, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, arccos) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_arccos, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map(nda, float_arccos);
+        rtn = NDArray_MapOut(nda, float_arccos, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise(nda, cuda_float_arccos);
@@ -1831,7 +2428,7 @@ PHP_METHOD(NDArray, arccos) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -1842,20 +2439,32 @@ PHP_METHOD(NDArray, arccos) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_arctan, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, arctan) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_arctan, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map(nda, float_arctan);
+        rtn = NDArray_MapOut(nda, float_arctan, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise(nda, cuda_float_arctan);
@@ -1866,7 +2475,7 @@ PHP_METHOD(NDArray, arctan) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -1878,14 +2487,21 @@ PHP_METHOD(NDArray, arctan) {
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_arctan2, 0, 0, 2)
     ZEND_ARG_INFO(0, x)
     ZEND_ARG_INFO(0, y)
+    ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, arctan2) {
     NDArray *rtn = NULL;
-    zval *x, *y;
-    ZEND_PARSE_PARAMETERS_START(2, 2)
+    zval *x, *y, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(2, 3)
             Z_PARAM_ZVAL(x)
             Z_PARAM_ZVAL(y)
+            Z_PARAM_OPTIONAL
+            Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
     NDArray *ndx = ZVAL_TO_NDARRAY(x);
     NDArray *ndy = ZVAL_TO_NDARRAY(y);
     if (x == NULL || y == NULL) {
@@ -1893,7 +2509,9 @@ PHP_METHOD(NDArray, arctan2) {
     }
 
     if (NDArray_DEVICE(ndx) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map1ND(ndx, float_arctan2, ndy);
+        rtn = NDArray_Map1NDOut(ndx, float_arctan2, ndy, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise1N(ndx, cuda_float_arctan2, ndy);
@@ -1903,7 +2521,7 @@ PHP_METHOD(NDArray, arctan2) {
     }
     CHECK_INPUT_AND_FREE(x, ndx);
     CHECK_INPUT_AND_FREE(y, ndy);
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -1914,20 +2532,32 @@ PHP_METHOD(NDArray, arctan2) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_degrees, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, degrees) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_degrees, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map(nda, float_degrees);
+        rtn = NDArray_MapOut(nda, float_degrees, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise(nda, cuda_float_degrees);
@@ -1938,7 +2568,7 @@ PHP_METHOD(NDArray, degrees) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -1949,20 +2579,32 @@ PHP_METHOD(NDArray, degrees) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_sinh, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, sinh) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_sinh, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map(nda, float_sinh);
+        rtn = NDArray_MapOut(nda, float_sinh, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise(nda, cuda_float_sinh);
@@ -1973,7 +2615,7 @@ PHP_METHOD(NDArray, sinh) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -1984,20 +2626,32 @@ PHP_METHOD(NDArray, sinh) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_cosh, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, cosh) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_cosh, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map(nda, float_cosh);
+        rtn = NDArray_MapOut(nda, float_cosh, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise(nda, cuda_float_cosh);
@@ -2008,7 +2662,7 @@ PHP_METHOD(NDArray, cosh) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -2019,20 +2673,32 @@ PHP_METHOD(NDArray, cosh) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_tanh, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, tanh) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_tanh, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map(nda, float_tanh);
+        rtn = NDArray_MapOut(nda, float_tanh, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise(nda, cuda_float_tanh);
@@ -2043,7 +2709,48 @@ PHP_METHOD(NDArray, tanh) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
+}
+
+/**
+ * NDArray::sigmoid
+ *
+ * @param execute_data
+ * @param return_value
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_sigmoid, 0, 0, 1)
+ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NDArray, sigmoid) {
+    NDArray *rtn = NULL;
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
+    Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
+    ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_sigmoid, return_value)) {
+        return;
+    }
+    NDArray *nda = ZVAL_TO_NDARRAY(array);
+    if (nda == NULL) {
+        return;
+    }
+
+    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+        rtn = NDArray_MapOut(nda, float_sigmoid, out_nd);
+    } else {
+        zend_throw_error(NULL, "NDArray::sigmoid is not supported for GPU arrays.");
+    }
+    if (Z_TYPE_P(array) == IS_ARRAY) {
+        NDArray_FREE(nda);
+    }
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -2054,20 +2761,32 @@ PHP_METHOD(NDArray, tanh) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_arcsinh, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, arcsinh) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_arcsinh, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map(nda, float_arcsinh);
+        rtn = NDArray_MapOut(nda, float_arcsinh, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise(nda, cuda_float_arcsinh);
@@ -2078,7 +2797,7 @@ PHP_METHOD(NDArray, arcsinh) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -2089,20 +2808,32 @@ PHP_METHOD(NDArray, arcsinh) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_arccosh, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, arccosh) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_arccosh, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map(nda, float_arccosh);
+        rtn = NDArray_MapOut(nda, float_arccosh, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise(nda, cuda_float_arccosh);
@@ -2113,7 +2844,7 @@ PHP_METHOD(NDArray, arccosh) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -2147,20 +2878,32 @@ PHP_METHOD(NDArray, fromImage) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_arctanh, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, arctanh) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_arctanh, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map(nda, float_arctanh);
+        rtn = NDArray_MapOut(nda, float_arctanh, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise(nda, cuda_float_arctanh);
@@ -2171,7 +2914,7 @@ PHP_METHOD(NDArray, arctanh) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -2182,20 +2925,32 @@ PHP_METHOD(NDArray, arctanh) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_rint, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, rint) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_rint, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map(nda, float_rint);
+        rtn = NDArray_MapOut(nda, float_rint, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise(nda, cuda_float_rint);
@@ -2206,7 +2961,7 @@ PHP_METHOD(NDArray, rint) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -2217,20 +2972,32 @@ PHP_METHOD(NDArray, rint) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_fix, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, fix) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_fix, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map(nda, float_fix);
+        rtn = NDArray_MapOut(nda, float_fix, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise(nda, cuda_float_fix);
@@ -2241,7 +3008,7 @@ PHP_METHOD(NDArray, fix) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -2252,20 +3019,32 @@ PHP_METHOD(NDArray, fix) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_trunc, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, trunc) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_trunc, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map(nda, float_trunc);
+        rtn = NDArray_MapOut(nda, float_trunc, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise(nda, cuda_float_trunc);
@@ -2276,7 +3055,7 @@ PHP_METHOD(NDArray, trunc) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -2287,20 +3066,32 @@ PHP_METHOD(NDArray, trunc) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_sinc, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, sinc) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_sinc, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map(nda, float_sinc);
+        rtn = NDArray_MapOut(nda, float_sinc, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise(nda, cuda_float_sinc);
@@ -2311,7 +3102,7 @@ PHP_METHOD(NDArray, sinc) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -2322,20 +3113,32 @@ PHP_METHOD(NDArray, sinc) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_negative, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, negative) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_negate, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map(nda, float_negate);
+        rtn = NDArray_MapOut(nda, float_negate, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise(nda, cuda_float_negate);
@@ -2346,7 +3149,7 @@ PHP_METHOD(NDArray, negative) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -2357,20 +3160,32 @@ PHP_METHOD(NDArray, negative) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_positive, 0, 0, 1)
     ZEND_ARG_INFO(0, array)
+    ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, positive) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
         Z_PARAM_ZVAL(array)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_positive, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map(nda, float_positive);
+        rtn = NDArray_MapOut(nda, float_positive, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise(nda, cuda_float_positive);
@@ -2381,7 +3196,7 @@ PHP_METHOD(NDArray, positive) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -2392,20 +3207,32 @@ PHP_METHOD(NDArray, positive) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_reciprocal, 0, 0, 1)
     ZEND_ARG_INFO(0, array)
+    ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, reciprocal) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
         Z_PARAM_ZVAL(array)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_reciprocal, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map(nda, float_reciprocal);
+        rtn = NDArray_MapOut(nda, float_reciprocal, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise(nda, cuda_float_reciprocal);
@@ -2416,7 +3243,7 @@ PHP_METHOD(NDArray, reciprocal) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 
@@ -2428,20 +3255,32 @@ PHP_METHOD(NDArray, reciprocal) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_sign, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, sign) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_sign, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map(nda, float_sign);
+        rtn = NDArray_MapOut(nda, float_sign, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise(nda, cuda_float_sign);
@@ -2452,7 +3291,7 @@ PHP_METHOD(NDArray, sign) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -2465,23 +3304,32 @@ ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_clip, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
 ZEND_ARG_INFO(0, min)
 ZEND_ARG_INFO(0, max)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, clip) {
     NDArray *rtn = NULL;
-    zval *array;
+    zval *array, *out = NULL;
+    NDArray *out_nd;
     double min, max;
-    ZEND_PARSE_PARAMETERS_START(3, 3)
+    ZEND_PARSE_PARAMETERS_START(3, 4)
     Z_PARAM_ZVAL(array)
     Z_PARAM_DOUBLE(min)
     Z_PARAM_DOUBLE(max)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map2F(nda, float_clip, (float)min, (float)max);
+        rtn = NDArray_Map2FOut(nda, float_clip, (float)min, (float)max, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise2F(nda, cuda_float_clip, (float)min, (float)max);
@@ -2495,7 +3343,7 @@ PHP_METHOD(NDArray, clip) {
     if (Z_TYPE_P(array) != IS_ARRAY) {
         CHECK_INPUT_AND_FREE(array, nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -2573,23 +3421,30 @@ ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, argmax) {
     NDArray *rtn = NULL;
     zval *a;
-    long axis;
+    zend_long axis = 0;
+    bool axis_is_null = true;
     bool keepdims = false;
+    long index;
     ZEND_PARSE_PARAMETERS_START(1, 3)
         Z_PARAM_ZVAL(a)
         Z_PARAM_OPTIONAL
-        Z_PARAM_LONG(axis)
+        Z_PARAM_LONG_OR_NULL(axis, axis_is_null)
         Z_PARAM_BOOL(keepdims)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(a);
     if (nda == NULL) {
         return;
     }
-    if (ZEND_NUM_ARGS() == 1) {
-        axis = 128;
+    if (axis_is_null && !keepdims) {
+        // Flat index as an integer, exact for any size
+        index = NDArray_ArgMinMaxFlat(nda, true);
+        CHECK_INPUT_AND_FREE(a, nda);
+        if (index < 0) {
+            RETURN_THROWS();
+        }
+        RETURN_LONG(index);
     }
-    rtn = NDArray_ArgMinMaxCommon(nda, (int)axis, keepdims, true);
-    if (rtn == NULL) return;
+    rtn = NDArray_ArgMinMaxCommon(nda, axis_is_null ? NDARRAY_MAX_DIMS : (int) axis, keepdims, true);
     CHECK_INPUT_AND_FREE(a, nda);
     RETURN_NDARRAY(rtn, return_value);
 }
@@ -2608,23 +3463,30 @@ ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, argmin) {
     NDArray *rtn = NULL;
     zval *a;
-    long axis;
+    zend_long axis = 0;
+    bool axis_is_null = true;
     bool keepdims = false;
+    long index;
     ZEND_PARSE_PARAMETERS_START(1, 3)
         Z_PARAM_ZVAL(a)
         Z_PARAM_OPTIONAL
-        Z_PARAM_LONG(axis)
+        Z_PARAM_LONG_OR_NULL(axis, axis_is_null)
         Z_PARAM_BOOL(keepdims)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(a);
     if (nda == NULL) {
         return;
     }
-    if (ZEND_NUM_ARGS() == 1) {
-        axis = 128;
+    if (axis_is_null && !keepdims) {
+        // Flat index as an integer, exact for any size
+        index = NDArray_ArgMinMaxFlat(nda, false);
+        CHECK_INPUT_AND_FREE(a, nda);
+        if (index < 0) {
+            RETURN_THROWS();
+        }
+        RETURN_LONG(index);
     }
-    rtn = NDArray_ArgMinMaxCommon(nda, (int)axis, keepdims, false);
-    if (rtn == NULL) return;
+    rtn = NDArray_ArgMinMaxCommon(nda, axis_is_null ? NDARRAY_MAX_DIMS : (int) axis, keepdims, false);
     CHECK_INPUT_AND_FREE(a, nda);
     RETURN_NDARRAY(rtn, return_value);
 }
@@ -2638,51 +3500,43 @@ PHP_METHOD(NDArray, argmin) {
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_mean, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
 ZEND_ARG_INFO(0, axis)
+ZEND_ARG_INFO(0, keepdims)
+ZEND_ARG_INFO(0, where)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, mean) {
     NDArray *rtn = NULL;
-    zval *array;
-    long axis;
-    int i_axis;
-    ZEND_PARSE_PARAMETERS_START(1, 2)
+    zval *array, *axis = NULL, *where = NULL;
+    bool keepdims = false;
+    ZEND_PARSE_PARAMETERS_START(1, 4)
         Z_PARAM_ZVAL(array)
         Z_PARAM_OPTIONAL
-        Z_PARAM_LONG(axis)
+        Z_PARAM_ZVAL_OR_NULL(axis)
+        Z_PARAM_BOOL(keepdims)
+        Z_PARAM_ZVAL_OR_NULL(where)
     ZEND_PARSE_PARAMETERS_END();
-    i_axis = (int)axis;
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
-
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        if (ZEND_NUM_ARGS() == 1) {
-            RETURN_DOUBLE((NDArray_Sum_Float(nda) / NDArray_NUMELEMENTS(nda)));
-        } else {
-            NDArray *sum = reduce(nda, &i_axis, NDArray_Add_Float);
-            if (sum == NULL) {
-                CHECK_INPUT_AND_FREE(array, nda);
-                return;
-            }
-            NDArray *num_cols = NDArray_CreateFromLongScalar((long)NDArray_SHAPE(nda)[i_axis]);
-            rtn = NDArray_Divide_Float(sum, num_cols);
-            NDArray_FREE(sum);
-            NDArray_FREE(num_cols);
-        }
+    if (axis == NULL && !keepdims && where == NULL) {
+        double value = NDArray_Sum_Float(nda) / NDArray_NUMELEMENTS(nda);
+        CHECK_INPUT_AND_FREE(array, nda);
+        RETURN_DOUBLE(value);
+    }
+    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU || where != NULL) {
+        rtn = reduce_axis_argument(nda, axis, keepdims, NDARRAY_REDUCE_MEAN, 0, where, false);
     } else {
 #ifdef HAVE_CUBLAS
-        if (ZEND_NUM_ARGS() == 1) {
-            RETURN_DOUBLE((NDArray_Sum_Float(nda) / NDArray_NUMELEMENTS(nda)));
+        if (axis == NULL || Z_TYPE_P(axis) != IS_LONG || keepdims) {
+            zend_throw_error(NULL, "NDArray::mean only supports a single integer axis for GPU arrays.");
         } else {
+            int i_axis = (int) Z_LVAL_P(axis);
             rtn = single_reduce(nda, &i_axis, NDArray_Mean_Float);
         }
 #else
         zend_throw_error(NULL, "GPU operations unavailable. CUBLAS not detected.");
 #endif
     }
-    if (Z_TYPE_P(array) == IS_ARRAY) {
-        NDArray_FREE(nda);
-    }
     CHECK_INPUT_AND_FREE(array, nda);
     RETURN_NDARRAY(rtn, return_value);
 }
@@ -2696,37 +3550,35 @@ PHP_METHOD(NDArray, mean) {
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_median, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
 ZEND_ARG_INFO(0, axis)
+ZEND_ARG_INFO(0, keepdims)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, median) {
     NDArray *rtn = NULL;
-    zval *array;
-    long axis;
-    int i_axis;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
-    Z_PARAM_ZVAL(array)
+    zval *array, *axis = NULL;
+    bool keepdims = false;
+    int *axes = NULL, naxes = 0;
+    ZEND_PARSE_PARAMETERS_START(1, 3)
+        Z_PARAM_ZVAL(array)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_ZVAL_OR_NULL(axis)
+        Z_PARAM_BOOL(keepdims)
     ZEND_PARSE_PARAMETERS_END();
-    i_axis = (int)axis;
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
-
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        RETURN_DOUBLE(NDArray_Median_Float(nda));
-    } else {
-#ifdef HAVE_CUBLAS
-        if (ZEND_NUM_ARGS() == 1) {
-            RETURN_DOUBLE(NDArray_Median_Float(nda));
-        } else {
-            rtn = single_reduce(nda, &i_axis, NDArray_Median_Float);
+    if (axis != NULL) {
+        axes = zval_axis_argument(axis, "axis", &naxes);
+        if (axes == NULL) {
+            CHECK_INPUT_AND_FREE(array, nda);
+            return;
         }
-#else
-        zend_throw_error(NULL, "GPU operations unavailable. CUBLAS not detected.");
-#endif
     }
-    if (Z_TYPE_P(array) == IS_ARRAY) {
-        NDArray_FREE(nda);
+    rtn = NDArray_Median(nda, axes, naxes, keepdims);
+    if (axes != NULL) {
+        efree(axes);
     }
+    CHECK_INPUT_AND_FREE(array, nda);
     RETURN_NDARRAY(rtn, return_value);
 }
 
@@ -2739,40 +3591,33 @@ PHP_METHOD(NDArray, median) {
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_std, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
 ZEND_ARG_INFO(0, axis)
+ZEND_ARG_INFO(0, ddof)
+ZEND_ARG_INFO(0, keepdims)
+ZEND_ARG_INFO(0, where)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, std) {
     NDArray *rtn = NULL;
-    zval *array;
-    long axis;
-    int i_axis;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
-    Z_PARAM_ZVAL(array)
+    zval *array, *axis = NULL, *where = NULL;
+    zend_long ddof = 0;
+    bool keepdims = false;
+    ZEND_PARSE_PARAMETERS_START(1, 5)
+        Z_PARAM_ZVAL(array)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_ZVAL_OR_NULL(axis)
+        Z_PARAM_LONG(ddof)
+        Z_PARAM_BOOL(keepdims)
+        Z_PARAM_ZVAL_OR_NULL(where)
     ZEND_PARSE_PARAMETERS_END();
-    i_axis = (int)axis;
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
-
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+    if (NDArray_DEVICE(nda) != NDARRAY_DEVICE_CPU && axis == NULL && ddof == 0 && !keepdims && where == NULL) {
         rtn = NDArray_Std(nda);
     } else {
-#ifdef HAVE_CUBLAS
-        if (ZEND_NUM_ARGS() == 1) {
-            rtn = NDArray_Std(nda);
-        } else {
-            rtn = single_reduce(nda, &i_axis, NDArray_Mean_Float);
-        }
-#else
-        zend_throw_error(NULL, "GPU operations unavailable. CUBLAS not detected.");
-#endif
-    }
-    if (rtn == NULL) {
-        return;
-    }
-    if (Z_TYPE_P(array) == IS_ARRAY) {
-        NDArray_FREE(nda);
+        rtn = reduce_axis_argument(nda, axis, keepdims, NDARRAY_REDUCE_STD, (int) ddof, where, false);
     }
+    CHECK_INPUT_AND_FREE(array, nda);
     RETURN_NDARRAY(rtn, return_value);
 }
 
@@ -2782,30 +3627,42 @@ PHP_METHOD(NDArray, std) {
  * @param execute_data
  * @param return_value
  */
-ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_quantile, 0, 0, 1)
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_quantile, 0, 0, 2)
 ZEND_ARG_INFO(0, target)
+ZEND_ARG_INFO(0, q)
+ZEND_ARG_INFO(0, axis)
+ZEND_ARG_INFO(0, keepdims)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, quantile) {
     NDArray *rtn = NULL;
-    zval *a, *q;
-    long axis;
-    int i_axis;
-    ZEND_PARSE_PARAMETERS_START(2, 2)
-    Z_PARAM_ZVAL(a)
-    Z_PARAM_ZVAL(q)
+    zval *a, *q, *axis = NULL;
+    bool keepdims = false;
+    int *axes = NULL, naxes = 0;
+    ZEND_PARSE_PARAMETERS_START(2, 4)
+        Z_PARAM_ZVAL(a)
+        Z_PARAM_ZVAL(q)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_ZVAL_OR_NULL(axis)
+        Z_PARAM_BOOL(keepdims)
     ZEND_PARSE_PARAMETERS_END();
-    i_axis = (int)axis;
     NDArray *nda = ZVAL_TO_NDARRAY(a);
-    NDArray *ndq = ZVAL_TO_NDARRAY(q);
     if (nda == NULL) {
         return;
     }
-
-    rtn = NDArray_Quantile(nda, ndq);
-
-    if (rtn == NULL) {
+    NDArray *ndq = ZVAL_TO_NDARRAY(q);
+    if (ndq == NULL) {
+        CHECK_INPUT_AND_FREE(a, nda);
         return;
     }
+    if (axis != NULL) {
+        axes = zval_axis_argument(axis, "axis", &naxes);
+    }
+    if (axis == NULL || axes != NULL) {
+        rtn = NDArray_Quantile(nda, ndq, axes, naxes, keepdims);
+    }
+    if (axes != NULL) {
+        efree(axes);
+    }
     CHECK_INPUT_AND_FREE(a, nda);
     CHECK_INPUT_AND_FREE(q, ndq);
     RETURN_NDARRAY(rtn, return_value);
@@ -2857,40 +3714,33 @@ PHP_METHOD(NDArray, average) {
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_variance, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
 ZEND_ARG_INFO(0, axis)
+ZEND_ARG_INFO(0, ddof)
+ZEND_ARG_INFO(0, keepdims)
+ZEND_ARG_INFO(0, where)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, variance) {
     NDArray *rtn = NULL;
-    zval *array;
-    long axis;
-    int i_axis;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
-    Z_PARAM_ZVAL(array)
+    zval *array, *axis = NULL, *where = NULL;
+    zend_long ddof = 0;
+    bool keepdims = false;
+    ZEND_PARSE_PARAMETERS_START(1, 5)
+        Z_PARAM_ZVAL(array)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_ZVAL_OR_NULL(axis)
+        Z_PARAM_LONG(ddof)
+        Z_PARAM_BOOL(keepdims)
+        Z_PARAM_ZVAL_OR_NULL(where)
     ZEND_PARSE_PARAMETERS_END();
-    i_axis = (int)axis;
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
-
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
+    if (NDArray_DEVICE(nda) != NDARRAY_DEVICE_CPU && axis == NULL && ddof == 0 && !keepdims && where == NULL) {
         rtn = NDArray_Variance(nda);
     } else {
-#ifdef HAVE_CUBLAS
-        if (ZEND_NUM_ARGS() == 1) {
-            rtn = NDArray_Variance(nda);
-        } else {
-            rtn = single_reduce(nda, &i_axis, NDArray_Mean_Float);
-        }
-#else
-        zend_throw_error(NULL, "GPU operations unavailable. CUBLAS not detected.");
-#endif
-    }
-    if (rtn == NULL) {
-        return;
-    }
-    if (Z_TYPE_P(array) == IS_ARRAY) {
-        NDArray_FREE(nda);
+        rtn = reduce_axis_argument(nda, axis, keepdims, NDARRAY_REDUCE_VAR, (int) ddof, where, false);
     }
+    CHECK_INPUT_AND_FREE(array, nda);
     RETURN_NDARRAY(rtn, return_value);
 }
 
@@ -2902,20 +3752,32 @@ PHP_METHOD(NDArray, variance) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_ceil, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, ceil) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_ceil, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map(nda, float_ceil);
+        rtn = NDArray_MapOut(nda, float_ceil, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise(nda, cuda_float_ceil);
@@ -2926,7 +3788,7 @@ PHP_METHOD(NDArray, ceil) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -2938,22 +3800,31 @@ PHP_METHOD(NDArray, ceil) {
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_round, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
 ZEND_ARG_INFO(0, precision)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, round) {
     NDArray *rtn = NULL;
-    zval *array;
+    zval *array, *out = NULL;
+    NDArray *out_nd;
     long precision;
-    ZEND_PARSE_PARAMETERS_START(2, 2)
+    ZEND_PARSE_PARAMETERS_START(2, 3)
     Z_PARAM_ZVAL(array)
     Z_PARAM_LONG(precision)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map1F(nda, float_round, (float)precision);
+        rtn = NDArray_Map1FOut(nda, float_round, (float)precision, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise1F(nda, cuda_float_round, (float)precision);
@@ -2964,7 +3835,7 @@ PHP_METHOD(NDArray, round) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -2975,20 +3846,32 @@ PHP_METHOD(NDArray, round) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_floor, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, floor) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_floor, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map(nda, float_floor);
+        rtn = NDArray_MapOut(nda, float_floor, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise(nda, cuda_float_floor);
@@ -2999,7 +3882,7 @@ PHP_METHOD(NDArray, floor) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -3010,20 +3893,32 @@ PHP_METHOD(NDArray, floor) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_radians, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, radians) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_radians, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map(nda, float_radians);
+        rtn = NDArray_MapOut(nda, float_radians, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise(nda, cuda_float_radians);
@@ -3034,7 +3929,7 @@ PHP_METHOD(NDArray, radians) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -3045,19 +3940,31 @@ PHP_METHOD(NDArray, radians) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_sqrt, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, sqrt) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_sqrt, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map(nda, float_sqrt);
+        rtn = NDArray_MapOut(nda, float_sqrt, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise(nda, cuda_float_sqrt);
@@ -3068,7 +3975,7 @@ PHP_METHOD(NDArray, sqrt) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -3079,22 +3986,29 @@ PHP_METHOD(NDArray, sqrt) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_square, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, square) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
-    rtn = NDArray_Multiply_Float(nda, nda);
+    rtn = NDArray_BinaryOperationOut(nda, nda, NDARRAY_BINARY_MULTIPLY, out_nd);
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -3105,19 +4019,31 @@ PHP_METHOD(NDArray, square) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_exp, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, exp) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_exp, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map(nda, float_exp);
+        rtn = NDArray_MapOut(nda, float_exp, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise(nda, cuda_float_exp);
@@ -3128,7 +4054,7 @@ PHP_METHOD(NDArray, exp) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -3139,22 +4065,32 @@ PHP_METHOD(NDArray, exp) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_exp2, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, exp2) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_exp2, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
-    rtn = NDArray_Map(nda, float_exp2);
+    rtn = NDArray_MapOut(nda, float_exp2, out_nd);
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -3165,20 +4101,32 @@ PHP_METHOD(NDArray, exp2) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_expm1, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, expm1) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_expm1, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
 
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map(nda, float_expm1);
+        rtn = NDArray_MapOut(nda, float_expm1, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise(nda, cuda_float_expm1);
@@ -3189,7 +4137,7 @@ PHP_METHOD(NDArray, expm1) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -3200,19 +4148,31 @@ PHP_METHOD(NDArray, expm1) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_log, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, log) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_log, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map(nda, float_log);
+        rtn = NDArray_MapOut(nda, float_log, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise(nda, cuda_float_log);
@@ -3223,7 +4183,7 @@ PHP_METHOD(NDArray, log) {
     if (Z_TYPE_P(array) == IS_ARRAY) {
         NDArray_FREE(nda);
     }
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -3234,19 +4194,31 @@ PHP_METHOD(NDArray, log) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_logb, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, logb) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_logb, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map(nda, float_logb);
+        rtn = NDArray_MapOut(nda, float_logb, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise(nda, cuda_float_logb);
@@ -3255,7 +4227,7 @@ PHP_METHOD(NDArray, logb) {
 #endif
     }
     CHECK_INPUT_AND_FREE(array, nda);
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -3266,19 +4238,31 @@ PHP_METHOD(NDArray, logb) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_log10, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, log10) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_log10, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map(nda, float_log10);
+        rtn = NDArray_MapOut(nda, float_log10, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise(nda, cuda_float_log10);
@@ -3287,7 +4271,7 @@ PHP_METHOD(NDArray, log10) {
 #endif
     }
     CHECK_INPUT_AND_FREE(array, nda);
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -3298,19 +4282,31 @@ PHP_METHOD(NDArray, log10) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_log1p, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, log1p) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_log1p, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map(nda, float_log1p);
+        rtn = NDArray_MapOut(nda, float_log1p, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise(nda, cuda_float_log1p);
@@ -3319,7 +4315,7 @@ PHP_METHOD(NDArray, log1p) {
 #endif
     }
     CHECK_INPUT_AND_FREE(array, nda);
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
@@ -3330,19 +4326,31 @@ PHP_METHOD(NDArray, log1p) {
  */
 ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_log2, 0, 0, 1)
 ZEND_ARG_INFO(0, array)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, log2) {
     NDArray *rtn = NULL;
-    zval *array;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
+    zval *array, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_ZVAL(array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    if (lazy_unary(array, out, float_log2, return_value)) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(array);
     if (nda == NULL) {
         return;
     }
     if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU) {
-        rtn = NDArray_Map(nda, float_log2);
+        rtn = NDArray_MapOut(nda, float_log2, out_nd);
+    } else if (out_nd != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
     } else {
 #ifdef HAVE_CUBLAS
         rtn = NDArrayMathGPU_ElementWise(nda, cuda_float_log2);
@@ -3351,24 +4359,30 @@ PHP_METHOD(NDArray, log2) {
 #endif
     }
     CHECK_INPUT_AND_FREE(array, nda);
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
  * NDArray::subtract
  */
-ZEND_BEGIN_ARG_INFO(arginfo_ndarray_subtract, 0)
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_subtract, 0, 0, 2)
 ZEND_ARG_INFO(0, a)
 ZEND_ARG_INFO(0, b)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, subtract) {
     NDArray *rtn = NULL;
-    zval *a, *b;
-    long axis;
-    ZEND_PARSE_PARAMETERS_START(2, 2)
+    zval *a, *b, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(2, 3)
     Z_PARAM_ZVAL(a)
     Z_PARAM_ZVAL(b)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(a);
     NDArray *ndb = ZVAL_TO_NDARRAY(b);
     if (nda == NULL) {
@@ -3380,28 +4394,37 @@ PHP_METHOD(NDArray, subtract) {
     }
     if (!NDArray_IsBroadcastable(nda, ndb)) {
         zend_throw_error(NULL, "Can´t broadcast array.");
+        CHECK_INPUT_AND_FREE(a, nda);
+        CHECK_INPUT_AND_FREE(b, ndb);
+        return;
     }
-    rtn = NDArray_Subtract_Float(nda, ndb);
+    rtn = NDArray_BinaryOperationOut(nda, ndb, NDARRAY_BINARY_SUBTRACT, out_nd);
     CHECK_INPUT_AND_FREE(a, nda);
     CHECK_INPUT_AND_FREE(b, ndb);
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
  * NDArray::mod
  */
-ZEND_BEGIN_ARG_INFO(arginfo_ndarray_mod, 0)
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_mod, 0, 0, 2)
 ZEND_ARG_INFO(0, a)
 ZEND_ARG_INFO(0, b)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, mod) {
     NDArray *rtn = NULL;
-    zval *a, *b;
-    long axis;
-    ZEND_PARSE_PARAMETERS_START(2, 2)
+    zval *a, *b, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(2, 3)
     Z_PARAM_ZVAL(a)
     Z_PARAM_ZVAL(b)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(a);
     NDArray *ndb = ZVAL_TO_NDARRAY(b);
     if (nda == NULL) {
@@ -3413,28 +4436,37 @@ PHP_METHOD(NDArray, mod) {
     }
     if (!NDArray_IsBroadcastable(nda, ndb)) {
         zend_throw_error(NULL, "Can´t broadcast array.");
+        CHECK_INPUT_AND_FREE(a, nda);
+        CHECK_INPUT_AND_FREE(b, ndb);
+        return;
     }
-    rtn = NDArray_Mod_Float(nda, ndb);
+    rtn = NDArray_BinaryOperationOut(nda, ndb, NDARRAY_BINARY_MOD, out_nd);
     CHECK_INPUT_AND_FREE(a, nda);
-    CHECK_INPUT_AND_FREE(a, ndb);
-    RETURN_NDARRAY(rtn, return_value);
+    CHECK_INPUT_AND_FREE(b, ndb);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
  * NDArray::pow
  */
-ZEND_BEGIN_ARG_INFO(arginfo_ndarray_pow, 0)
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_pow, 0, 0, 2)
 ZEND_ARG_INFO(0, a)
 ZEND_ARG_INFO(0, b)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, pow) {
     NDArray *rtn = NULL;
-    zval *a, *b;
-    long axis;
-    ZEND_PARSE_PARAMETERS_START(2, 2)
+    zval *a, *b, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(2, 3)
     Z_PARAM_ZVAL(a)
     Z_PARAM_ZVAL(b)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(a);
     NDArray *ndb = ZVAL_TO_NDARRAY(b);
     if (nda == NULL) {
@@ -3444,31 +4476,39 @@ PHP_METHOD(NDArray, pow) {
         CHECK_INPUT_AND_FREE(a, nda);
         return;
     }
-    if (!NDArray_ShapeCompare(nda, ndb)) {
-        zend_throw_error(NULL, "Incompatible shapes");
+    if (!NDArray_IsBroadcastable(nda, ndb)) {
+        zend_throw_error(NULL, "Can´t broadcast array.");
+        CHECK_INPUT_AND_FREE(a, nda);
+        CHECK_INPUT_AND_FREE(b, ndb);
         return;
     }
-    rtn = NDArray_Pow_Float(nda, ndb);
+    rtn = NDArray_BinaryOperationOut(nda, ndb, NDARRAY_BINARY_POW, out_nd);
     CHECK_INPUT_AND_FREE(a, nda);
     CHECK_INPUT_AND_FREE(b, ndb);
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
  * NDArray::multiply
  */
-ZEND_BEGIN_ARG_INFO(arginfo_ndarray_multiply, 0)
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_multiply, 0, 0, 2)
 ZEND_ARG_INFO(0, a)
 ZEND_ARG_INFO(0, b)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, multiply) {
     NDArray *rtn = NULL;
-    zval *a, *b;
-    long axis;
-    ZEND_PARSE_PARAMETERS_START(2, 2)
+    zval *a, *b, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(2, 3)
     Z_PARAM_ZVAL(a)
     Z_PARAM_ZVAL(b)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(a);
     NDArray *ndb = ZVAL_TO_NDARRAY(b);
     if (nda == NULL) {
@@ -3480,61 +4520,79 @@ PHP_METHOD(NDArray, multiply) {
     }
     if (!NDArray_IsBroadcastable(nda, ndb)) {
         zend_throw_error(NULL, "Can´t broadcast array.");
+        CHECK_INPUT_AND_FREE(a, nda);
+        CHECK_INPUT_AND_FREE(b, ndb);
+        return;
     }
-    rtn = NDArray_Multiply_Float(nda, ndb);
-
+    rtn = NDArray_BinaryOperationOut(nda, ndb, NDARRAY_BINARY_MULTIPLY, out_nd);
     CHECK_INPUT_AND_FREE(a, nda);
     CHECK_INPUT_AND_FREE(b, ndb);
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
  * NDArray::divide
  */
-ZEND_BEGIN_ARG_INFO(arginfo_ndarray_divide, 0)
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_divide, 0, 0, 2)
 ZEND_ARG_INFO(0, a)
 ZEND_ARG_INFO(0, b)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, divide) {
     NDArray *rtn = NULL;
-    zval *a, *b;
-    long axis;
-    ZEND_PARSE_PARAMETERS_START(2, 2)
+    zval *a, *b, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(2, 3)
     Z_PARAM_ZVAL(a)
     Z_PARAM_ZVAL(b)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(a);
     NDArray *ndb = ZVAL_TO_NDARRAY(b);
     if (nda == NULL) {
         return;
     }
     if (ndb == NULL) {
+        CHECK_INPUT_AND_FREE(a, nda);
         return;
     }
     if (!NDArray_IsBroadcastable(nda, ndb)) {
         zend_throw_error(NULL, "Can´t broadcast array.");
+        CHECK_INPUT_AND_FREE(a, nda);
+        CHECK_INPUT_AND_FREE(b, ndb);
+        return;
     }
-    rtn = NDArray_Divide_Float(nda, ndb);
+    rtn = NDArray_BinaryOperationOut(nda, ndb, NDARRAY_BINARY_DIVIDE, out_nd);
     CHECK_INPUT_AND_FREE(a, nda);
     CHECK_INPUT_AND_FREE(b, ndb);
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
 }
 
 /**
  * NDArray::add
  */
-ZEND_BEGIN_ARG_INFO(arginfo_ndarray_add, 0)
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_add, 0, 0, 2)
 ZEND_ARG_INFO(0, a)
 ZEND_ARG_INFO(0, b)
+ZEND_ARG_INFO(0, out)
 ZEND_END_ARG_INFO()
 PHP_METHOD(NDArray, add) {
     NDArray *rtn = NULL;
-    zval *a, *b;
-    long axis;
-    ZEND_PARSE_PARAMETERS_START(2, 2)
+    zval *a, *b, *out = NULL;
+    NDArray *out_nd;
+    ZEND_PARSE_PARAMETERS_START(2, 3)
     Z_PARAM_ZVAL(a)
     Z_PARAM_ZVAL(b)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL(out)
     ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(a);
     NDArray *ndb = ZVAL_TO_NDARRAY(b);
     if (nda == NULL) {
@@ -3546,11 +4604,99 @@ PHP_METHOD(NDArray, add) {
     }
     if (!NDArray_IsBroadcastable(nda, ndb)) {
         zend_throw_error(NULL, "Can´t broadcast array.");
+        CHECK_INPUT_AND_FREE(a, nda);
+        CHECK_INPUT_AND_FREE(b, ndb);
+        return;
     }
-    rtn = NDArray_Add_Float(nda, ndb);
+    rtn = NDArray_BinaryOperationOut(nda, ndb, NDARRAY_BINARY_ADD, out_nd);
     CHECK_INPUT_AND_FREE(a, nda);
     CHECK_INPUT_AND_FREE(b, ndb);
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
+}
+
+/**
+ * Shared implementation of NDArray::addInPlace, subtractInPlace,
+ * multiplyInPlace, divideInPlace, modInPlace and powInPlace. The result
+ * is written into the current array, which is returned. A PHP int or
+ * float operand is applied directly instead of through a 0-d NDArray.
+ *
+ * @param execute_data
+ * @param return_value
+ * @param op
+ */
+static void
+inplace_method(INTERNAL_FUNCTION_PARAMETERS, NDArray_BinaryOp op) {
+    zval *b;
+    zval *obj_zval = getThis();
+    NDArray *self, *other, *rtn;
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+    Z_PARAM_ZVAL(b)
+    ZEND_PARSE_PARAMETERS_END();
+    if ((self = scalar_operand_target(obj_zval, b)) != NULL) {
+        rtn = NDArray_BinaryScalarOut(self, (float) zval_get_double(b), op, 0, self);
+    } else {
+        self = ZVAL_TO_NDARRAY(obj_zval);
+        if (self == NULL) {
+            RETURN_THROWS();
+        }
+        other = ZVAL_TO_NDARRAY(b);
+        if (other == NULL) {
+            RETURN_THROWS();
+        }
+        rtn = NDArray_BinaryOperationOut(self, other, op, self);
+        CHECK_INPUT_AND_FREE(b, other);
+    }
+    if (rtn == NULL) {
+        RETURN_THROWS();
+    }
+    RETURN_COPY(obj_zval);
+}
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_inplace, 0, 0, 1)
+ZEND_ARG_INFO(0, b)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NDArray, addInPlace) {
+    inplace_method(INTERNAL_FUNCTION_PARAM_PASSTHRU, NDARRAY_BINARY_ADD);
+}
+
+PHP_METHOD(NDArray, subtractInPlace) {
+    inplace_method(INTERNAL_FUNCTION_PARAM_PASSTHRU, NDARRAY_BINARY_SUBTRACT);
+}
+
+PHP_METHOD(NDArray, multiplyInPlace) {
+    inplace_method(INTERNAL_FUNCTION_PARAM_PASSTHRU, NDARRAY_BINARY_MULTIPLY);
+}
+
+PHP_METHOD(NDArray, divideInPlace) {
+    inplace_method(INTERNAL_FUNCTION_PARAM_PASSTHRU, NDARRAY_BINARY_DIVIDE);
+}
+
+PHP_METHOD(NDArray, modInPlace) {
+    inplace_method(INTERNAL_FUNCTION_PARAM_PASSTHRU, NDARRAY_BINARY_MOD);
+}
+
+PHP_METHOD(NDArray, powInPlace) {
+    inplace_method(INTERNAL_FUNCTION_PARAM_PASSTHRU, NDARRAY_BINARY_POW);
+}
+
+/**
+ * NDArray::lazy
+ *
+ * Start a deferred expression. Operators and element-wise math
+ * functions applied to the returned LazyNDArray are recorded and
+ * computed in a single fused pass by LazyNDArray::eval().
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_lazy, 0, 0, 1)
+ZEND_ARG_INFO(0, a)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NDArray, lazy) {
+    zval *a;
+    NDArrayExpr *expr;
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+    Z_PARAM_ZVAL(a)
+    ZEND_PARSE_PARAMETERS_END();
+    expr = ZVAL_TO_EXPR(a);
+    RETURN_LAZY(expr, return_value);
 }
 
 /**
@@ -4509,245 +5655,748 @@ PHP_METHOD(NDArray, norm) {
         return;
     }
 
-    rtn = NDArray_Norm(nda, (int)order);
+    rtn = NDArray_Norm(nda, (int)order);
+
+    CHECK_INPUT_AND_FREE(a, nda);
+    RETURN_NDARRAY(rtn, return_value);
+}
+
+/**
+ * NDArray::cond
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_ndarray_cond, 0)
+ZEND_ARG_INFO(0, a)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NDArray, cond) {
+    NDArray *rtn;
+    zval *a;
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+    Z_PARAM_ZVAL(a)
+    ZEND_PARSE_PARAMETERS_END();
+    NDArray *nda = ZVAL_TO_NDARRAY(a);
+    if (nda == NULL) {
+        return;
+    }
+    rtn = NDArray_Cond(nda);
+    if (rtn == NULL) {
+        return;
+    }
+    CHECK_INPUT_AND_FREE(a, nda);
+    RETURN_NDARRAY(rtn, return_value);
+}
+
+/**
+ * NDArray::inv
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_ndarray_inv, 0)
+ZEND_ARG_INFO(0, a)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NDArray, inv) {
+    NDArray *rtn;
+    zval *a, *b;
+    long axis;
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+    Z_PARAM_ZVAL(a)
+    ZEND_PARSE_PARAMETERS_END();
+    NDArray *nda = ZVAL_TO_NDARRAY(a);
+    if (nda == NULL) {
+        return;
+    }
+
+    rtn = NDArray_Inverse(nda);
+
+    CHECK_INPUT_AND_FREE(a, nda);
+    RETURN_NDARRAY(rtn, return_value);
+}
+
+/**
+ * NDArray::svd
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_ndarray_svd, 0)
+ZEND_ARG_INFO(0, a)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NDArray, svd) {
+    NDArray **rtns;
+    zval *a, *b;
+    long axis;
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+    Z_PARAM_ZVAL(a)
+    ZEND_PARSE_PARAMETERS_END();
+    NDArray *nda = ZVAL_TO_NDARRAY(a);
+    if (nda == NULL) {
+        return;
+    }
+    rtns = NDArray_SVD(nda);
+    if (rtns == NULL) {
+        return;
+    }
+    CHECK_INPUT_AND_FREE(a, nda);
+    RETURN_3NDARRAY(rtns[0], rtns[1], rtns[2], return_value);
+    efree(rtns);
+}
+
+/**
+ * NDArray::det
+ */
+ZEND_BEGIN_ARG_INFO(arginfo_ndarray_det, 0)
+ZEND_ARG_INFO(0, a)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NDArray, det) {
+    NDArray *rtn, *nda;
+    zval *a;
+    ZEND_PARSE_PARAMETERS_START(1, 1)
+    Z_PARAM_ZVAL(a)
+    ZEND_PARSE_PARAMETERS_END();
+    nda = ZVAL_TO_NDARRAY(a);
+    if (nda == NULL) {
+        return;
+    }
+    rtn = NDArray_Det(nda);
+    CHECK_INPUT_AND_FREE(a, nda);
+    RETURN_NDARRAY(rtn, return_value);
+}
+
+/**
+ * NDArray::sum
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_sum, 0, 0, 1)
+ZEND_ARG_INFO(0, a)
+ZEND_ARG_INFO(0, axis)
+ZEND_ARG_INFO(0, keepdims)
+ZEND_ARG_INFO(0, where)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NDArray, sum) {
+    NDArray *rtn = NULL;
+    zval *a, *axis = NULL, *where = NULL;
+    bool keepdims = false;
+    double value;
+    ZEND_PARSE_PARAMETERS_START(1, 4)
+    Z_PARAM_ZVAL(a)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL_OR_NULL(axis)
+    Z_PARAM_BOOL(keepdims)
+    Z_PARAM_ZVAL_OR_NULL(where)
+    ZEND_PARSE_PARAMETERS_END();
+    NDArray *nda = ZVAL_TO_NDARRAY(a);
+    if (nda == NULL) {
+        return;
+    }
+    if (axis == NULL && !keepdims && where == NULL) {
+        value = NDArray_Sum_Float(nda);
+        CHECK_INPUT_AND_FREE(a, nda);
+        RETURN_DOUBLE(value);
+    }
+    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU || where != NULL) {
+        rtn = reduce_axis_argument(nda, axis, keepdims, NDARRAY_REDUCE_SUM, 0, where, false);
+    } else if (axis == NULL || Z_TYPE_P(axis) != IS_LONG || keepdims) {
+        zend_throw_error(NULL, "NDArray::sum only supports a single integer axis for GPU arrays.");
+    } else {
+        int axis_i = (int) Z_LVAL_P(axis);
+        rtn = reduce(nda, &axis_i, NDArray_Add_Float);
+    }
+    CHECK_INPUT_AND_FREE(a, nda);
+    RETURN_NDARRAY(rtn, return_value);
+}
+
+/**
+ * NDArray::min
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_min, 0, 0, 1)
+ZEND_ARG_INFO(0, a)
+ZEND_ARG_INFO(0, axis)
+ZEND_ARG_INFO(0, keepdims)
+ZEND_ARG_INFO(0, where)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NDArray, min) {
+    NDArray *rtn = NULL;
+    zval *a, *axis = NULL, *where = NULL;
+    bool keepdims = false;
+    double value;
+    ZEND_PARSE_PARAMETERS_START(1, 4)
+    Z_PARAM_ZVAL(a)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL_OR_NULL(axis)
+    Z_PARAM_BOOL(keepdims)
+    Z_PARAM_ZVAL_OR_NULL(where)
+    ZEND_PARSE_PARAMETERS_END();
+    NDArray *nda = ZVAL_TO_NDARRAY(a);
+    if (nda == NULL) {
+        return;
+    }
+    if (axis == NULL && !keepdims && where == NULL) {
+        value = NDArray_Min(nda);
+        CHECK_INPUT_AND_FREE(a, nda);
+        RETURN_DOUBLE(value);
+    }
+    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU || where != NULL) {
+        rtn = reduce_axis_argument(nda, axis, keepdims, NDARRAY_REDUCE_MIN, 0, where, false);
+    } else if (axis == NULL || Z_TYPE_P(axis) != IS_LONG || keepdims) {
+        zend_throw_error(NULL, "NDArray::min only supports a single integer axis for GPU arrays.");
+    } else {
+        int axis_i = (int) Z_LVAL_P(axis);
+        rtn = single_reduce(nda, &axis_i, NDArray_Min);
+    }
+    CHECK_INPUT_AND_FREE(a, nda);
+    RETURN_NDARRAY(rtn, return_value);
+}
+
+/**
+ * NDArray::max
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_max, 0, 0, 1)
+ZEND_ARG_INFO(0, a)
+ZEND_ARG_INFO(0, axis)
+ZEND_ARG_INFO(0, keepdims)
+ZEND_ARG_INFO(0, where)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NDArray, max) {
+    NDArray *rtn = NULL;
+    zval *a, *axis = NULL, *where = NULL;
+    bool keepdims = false;
+    double value;
+    ZEND_PARSE_PARAMETERS_START(1, 4)
+    Z_PARAM_ZVAL(a)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL_OR_NULL(axis)
+    Z_PARAM_BOOL(keepdims)
+    Z_PARAM_ZVAL_OR_NULL(where)
+    ZEND_PARSE_PARAMETERS_END();
+    NDArray *nda = ZVAL_TO_NDARRAY(a);
+    if (nda == NULL) {
+        return;
+    }
+    if (axis == NULL && !keepdims && where == NULL) {
+        value = NDArray_Max(nda);
+        CHECK_INPUT_AND_FREE(a, nda);
+        RETURN_DOUBLE(value);
+    }
+    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU || where != NULL) {
+        rtn = reduce_axis_argument(nda, axis, keepdims, NDARRAY_REDUCE_MAX, 0, where, false);
+    } else {
+        zend_throw_error(NULL, "Axis not supported for GPU operation");
+    }
+    CHECK_INPUT_AND_FREE(a, nda);
+    RETURN_NDARRAY(rtn, return_value);
+}
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_prod, 0, 0, 1)
+ZEND_ARG_INFO(0, a)
+ZEND_ARG_INFO(0, axis)
+ZEND_ARG_INFO(0, keepdims)
+ZEND_ARG_INFO(0, where)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NDArray, prod) {
+    NDArray *rtn = NULL;
+    zval *a, *axis = NULL, *where = NULL;
+    bool keepdims = false;
+    float value;
+    ZEND_PARSE_PARAMETERS_START(1, 4)
+    Z_PARAM_ZVAL(a)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ZVAL_OR_NULL(axis)
+    Z_PARAM_BOOL(keepdims)
+    Z_PARAM_ZVAL_OR_NULL(where)
+    ZEND_PARSE_PARAMETERS_END();
+    NDArray *nda = ZVAL_TO_NDARRAY(a);
+    if (nda == NULL) {
+        return;
+    }
+    if (axis == NULL && !keepdims && where == NULL) {
+        value = NDArray_Float_Prod(nda);
+        CHECK_INPUT_AND_FREE(a, nda);
+        RETURN_DOUBLE(value);
+    }
+    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_CPU || where != NULL) {
+        rtn = reduce_axis_argument(nda, axis, keepdims, NDARRAY_REDUCE_PROD, 0, where, false);
+    } else if (axis == NULL || Z_TYPE_P(axis) != IS_LONG || keepdims) {
+        zend_throw_error(NULL, "NDArray::prod only supports a single integer axis for GPU arrays.");
+    } else {
+        int axis_i = (int) Z_LVAL_P(axis);
+        rtn = reduce(nda, &axis_i, NDArray_Multiply_Float);
+    }
+    CHECK_INPUT_AND_FREE(a, nda);
+    RETURN_NDARRAY(rtn, return_value);
+}
+
+/**
+ * Shared implementation of the NaN-ignoring reductions NDArray::nansum,
+ * nanmean, nanmin, nanmax, nanvar and nanstd. The variances take a
+ * `ddof` argument before `keepdims`, like NDArray::variance and std.
+ *
+ * @param execute_data
+ * @param return_value
+ * @param op
+ */
+static void
+nan_reduce_method(INTERNAL_FUNCTION_PARAMETERS, NDArray_ReduceOp op) {
+    NDArray *rtn = NULL;
+    zval *a, *axis = NULL, *where = NULL;
+    zend_long ddof = 0;
+    bool keepdims = false;
+    if (op == NDARRAY_REDUCE_VAR || op == NDARRAY_REDUCE_STD) {
+        ZEND_PARSE_PARAMETERS_START(1, 5)
+            Z_PARAM_ZVAL(a)
+            Z_PARAM_OPTIONAL
+            Z_PARAM_ZVAL_OR_NULL(axis)
+            Z_PARAM_LONG(ddof)
+            Z_PARAM_BOOL(keepdims)
+            Z_PARAM_ZVAL_OR_NULL(where)
+        ZEND_PARSE_PARAMETERS_END();
+    } else {
+        ZEND_PARSE_PARAMETERS_START(1, 4)
+            Z_PARAM_ZVAL(a)
+            Z_PARAM_OPTIONAL
+            Z_PARAM_ZVAL_OR_NULL(axis)
+            Z_PARAM_BOOL(keepdims)
+            Z_PARAM_ZVAL_OR_NULL(where)
+        ZEND_PARSE_PARAMETERS_END();
+    }
+    NDArray *nda = ZVAL_TO_NDARRAY(a);
+    if (nda == NULL) {
+        return;
+    }
+    rtn = reduce_axis_argument(nda, axis, keepdims, op, (int) ddof, where, true);
+    CHECK_INPUT_AND_FREE(a, nda);
+    RETURN_NDARRAY(rtn, return_value);
+}
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_nanreduce, 0, 0, 1)
+ZEND_ARG_INFO(0, a)
+ZEND_ARG_INFO(0, axis)
+ZEND_ARG_INFO(0, keepdims)
+ZEND_ARG_INFO(0, where)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NDArray, nansum) {
+    nan_reduce_method(INTERNAL_FUNCTION_PARAM_PASSTHRU, NDARRAY_REDUCE_SUM);
+}
+
+PHP_METHOD(NDArray, nanmean) {
+    nan_reduce_method(INTERNAL_FUNCTION_PARAM_PASSTHRU, NDARRAY_REDUCE_MEAN);
+}
+
+PHP_METHOD(NDArray, nanmin) {
+    nan_reduce_method(INTERNAL_FUNCTION_PARAM_PASSTHRU, NDARRAY_REDUCE_MIN);
+}
+
+PHP_METHOD(NDArray, nanmax) {
+    nan_reduce_method(INTERNAL_FUNCTION_PARAM_PASSTHRU, NDARRAY_REDUCE_MAX);
+}
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_nanmoments, 0, 0, 1)
+ZEND_ARG_INFO(0, a)
+ZEND_ARG_INFO(0, axis)
+ZEND_ARG_INFO(0, ddof)
+ZEND_ARG_INFO(0, keepdims)
+ZEND_ARG_INFO(0, where)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NDArray, nanvar) {
+    nan_reduce_method(INTERNAL_FUNCTION_PARAM_PASSTHRU, NDARRAY_REDUCE_VAR);
+}
+
+PHP_METHOD(NDArray, nanstd) {
+    nan_reduce_method(INTERNAL_FUNCTION_PARAM_PASSTHRU, NDARRAY_REDUCE_STD);
+}
+
+/**
+ * Shared implementation of NDArray::segmentSum, segmentMean, segmentMin
+ * and segmentMax
+ *
+ * @param execute_data
+ * @param return_value
+ * @param op
+ */
+static void
+segment_method(INTERNAL_FUNCTION_PARAMETERS, NDArray_ReduceOp op) {
+    NDArray *rtn = NULL;
+    zval *values, *ids;
+    zend_long num_segments;
+    ZEND_PARSE_PARAMETERS_START(3, 3)
+        Z_PARAM_ZVAL(values)
+        Z_PARAM_ZVAL(ids)
+        Z_PARAM_LONG(num_segments)
+    ZEND_PARSE_PARAMETERS_END();
+    NDArray *ids_nd = ZVAL_TO_NDARRAY(ids);
+    if (ids_nd == NULL) {
+        return;
+    }
+    NDArray *nda = ZVAL_TO_NDARRAY(values);
+    if (nda == NULL) {
+        CHECK_INPUT_AND_FREE(ids, ids_nd);
+        return;
+    }
+    rtn = NDArray_SegmentReduce(nda, ids_nd, num_segments, op);
+    CHECK_INPUT_AND_FREE(values, nda);
+    CHECK_INPUT_AND_FREE(ids, ids_nd);
+    RETURN_NDARRAY(rtn, return_value);
+}
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_segment, 0, 0, 3)
+ZEND_ARG_INFO(0, values)
+ZEND_ARG_INFO(0, ids)
+ZEND_ARG_INFO(0, num_segments)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NDArray, segmentSum) {
+    segment_method(INTERNAL_FUNCTION_PARAM_PASSTHRU, NDARRAY_REDUCE_SUM);
+}
+
+PHP_METHOD(NDArray, segmentMean) {
+    segment_method(INTERNAL_FUNCTION_PARAM_PASSTHRU, NDARRAY_REDUCE_MEAN);
+}
+
+PHP_METHOD(NDArray, segmentMin) {
+    segment_method(INTERNAL_FUNCTION_PARAM_PASSTHRU, NDARRAY_REDUCE_MIN);
+}
+
+PHP_METHOD(NDArray, segmentMax) {
+    segment_method(INTERNAL_FUNCTION_PARAM_PASSTHRU, NDARRAY_REDUCE_MAX);
+}
+
+/**
+ * Shared implementation of NDArray::cumsum, cumprod and cummax
+ *
+ * @param execute_data
+ * @param return_value
+ * @param op
+ */
+static void
+scan_method(INTERNAL_FUNCTION_PARAMETERS, NDArray_ScanOp op) {
+    NDArray *rtn = NULL, *out_nd;
+    zval *a, *out = NULL;
+    zend_long axis = 0;
+    bool axis_is_null = true;
+    ZEND_PARSE_PARAMETERS_START(1, 3)
+        Z_PARAM_ZVAL(a)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG_OR_NULL(axis, axis_is_null)
+        Z_PARAM_ZVAL(out)
+    ZEND_PARSE_PARAMETERS_END();
+    if (ZVAL_TO_OUT_NDARRAY(out, &out_nd) == FAILURE) {
+        return;
+    }
+    NDArray *nda = ZVAL_TO_NDARRAY(a);
+    if (nda == NULL) {
+        return;
+    }
+    rtn = NDArray_Scan(nda, op, axis_is_null ? NDARRAY_MAX_DIMS : (int) axis, out_nd);
+    CHECK_INPUT_AND_FREE(a, nda);
+    RETURN_NDARRAY_OUT(rtn, out, return_value);
+}
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_cumsum, 0, 0, 1)
+ZEND_ARG_INFO(0, a)
+ZEND_ARG_INFO(0, axis)
+ZEND_ARG_INFO(0, out)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NDArray, cumsum) {
+    scan_method(INTERNAL_FUNCTION_PARAM_PASSTHRU, NDARRAY_SCAN_SUM);
+}
 
-    CHECK_INPUT_AND_FREE(a, nda);
-    RETURN_NDARRAY(rtn, return_value);
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_cumprod, 0, 0, 1)
+ZEND_ARG_INFO(0, a)
+ZEND_ARG_INFO(0, axis)
+ZEND_ARG_INFO(0, out)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NDArray, cumprod) {
+    scan_method(INTERNAL_FUNCTION_PARAM_PASSTHRU, NDARRAY_SCAN_PROD);
+}
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_cummax, 0, 0, 1)
+ZEND_ARG_INFO(0, a)
+ZEND_ARG_INFO(0, axis)
+ZEND_ARG_INFO(0, out)
+ZEND_END_ARG_INFO()
+PHP_METHOD(NDArray, cummax) {
+    scan_method(INTERNAL_FUNCTION_PARAM_PASSTHRU, NDARRAY_SCAN_MAX);
 }
 
 /**
- * NDArray::cond
+ * NDArray::sort
+ *
+ * @param execute_data
+ * @param return_value
  */
-ZEND_BEGIN_ARG_INFO(arginfo_ndarray_cond, 0)
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_sort, 0, 0, 1)
 ZEND_ARG_INFO(0, a)
+ZEND_ARG_INFO(0, axis)
 ZEND_END_ARG_INFO()
-PHP_METHOD(NDArray, cond) {
-    NDArray *rtn;
+PHP_METHOD(NDArray, sort) {
+    NDArray *rtn = NULL;
     zval *a;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
-    Z_PARAM_ZVAL(a)
+    zend_long axis = -1;
+    bool axis_is_null = false;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
+        Z_PARAM_ZVAL(a)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG_OR_NULL(axis, axis_is_null)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(a);
     if (nda == NULL) {
         return;
     }
-    rtn = NDArray_Cond(nda);
-    if (rtn == NULL) {
-        return;
-    }
+    rtn = NDArray_Sort(nda, axis_is_null ? NDARRAY_MAX_DIMS : (int) axis, 0);
     CHECK_INPUT_AND_FREE(a, nda);
     RETURN_NDARRAY(rtn, return_value);
 }
 
 /**
- * NDArray::inv
+ * NDArray::argsort
+ *
+ * @param execute_data
+ * @param return_value
  */
-ZEND_BEGIN_ARG_INFO(arginfo_ndarray_inv, 0)
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_argsort, 0, 0, 1)
 ZEND_ARG_INFO(0, a)
+ZEND_ARG_INFO(0, axis)
 ZEND_END_ARG_INFO()
-PHP_METHOD(NDArray, inv) {
-    NDArray *rtn;
-    zval *a, *b;
-    long axis;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
-    Z_PARAM_ZVAL(a)
+PHP_METHOD(NDArray, argsort) {
+    NDArray *rtn = NULL;
+    zval *a;
+    zend_long axis = -1;
+    bool axis_is_null = false;
+    ZEND_PARSE_PARAMETERS_START(1, 2)
+        Z_PARAM_ZVAL(a)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG_OR_NULL(axis, axis_is_null)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(a);
     if (nda == NULL) {
         return;
     }
-
-    rtn = NDArray_Inverse(nda);
-
+    rtn = NDArray_Sort(nda, axis_is_null ? NDARRAY_MAX_DIMS : (int) axis, 1);
     CHECK_INPUT_AND_FREE(a, nda);
     RETURN_NDARRAY(rtn, return_value);
 }
 
 /**
- * NDArray::svd
+ * NDArray::partition
+ *
+ * @param execute_data
+ * @param return_value
  */
-ZEND_BEGIN_ARG_INFO(arginfo_ndarray_svd, 0)
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_partition, 0, 0, 2)
 ZEND_ARG_INFO(0, a)
+ZEND_ARG_INFO(0, kth)
+ZEND_ARG_INFO(0, axis)
 ZEND_END_ARG_INFO()
-PHP_METHOD(NDArray, svd) {
-    NDArray **rtns;
-    zval *a, *b;
-    long axis;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
-    Z_PARAM_ZVAL(a)
+PHP_METHOD(NDArray, partition) {
+    NDArray *rtn = NULL;
+    zval *a, *kth;
+    zend_long axis = -1;
+    bool axis_is_null = false;
+    int *kth_i, nkth, i;
+    long *kth_l;
+    ZEND_PARSE_PARAMETERS_START(2, 3)
+        Z_PARAM_ZVAL(a)
+        Z_PARAM_ZVAL(kth)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG_OR_NULL(axis, axis_is_null)
     ZEND_PARSE_PARAMETERS_END();
+    kth_i = zval_axis_argument(kth, "kth", &nkth);
+    if (kth_i == NULL) {
+        return;
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(a);
     if (nda == NULL) {
+        efree(kth_i);
         return;
     }
-    rtns = NDArray_SVD(nda);
-    if (rtns == NULL) {
-        return;
+    kth_l = emalloc(sizeof(long) * (nkth > 0 ? nkth : 1));
+    for (i = 0; i < nkth; i++) {
+        kth_l[i] = kth_i[i];
     }
+    rtn = NDArray_Partition(nda, kth_l, nkth, axis_is_null ? NDARRAY_MAX_DIMS : (int) axis);
+    efree(kth_l);
+    efree(kth_i);
     CHECK_INPUT_AND_FREE(a, nda);
-    RETURN_3NDARRAY(rtns[0], rtns[1], rtns[2], return_value);
-    efree(rtns);
+    RETURN_NDARRAY(rtn, return_value);
 }
 
 /**
- * NDArray::det
+ * NDArray::topk
+ *
+ * @param execute_data
+ * @param return_value
  */
-ZEND_BEGIN_ARG_INFO(arginfo_ndarray_det, 0)
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_topk, 0, 0, 2)
 ZEND_ARG_INFO(0, a)
+ZEND_ARG_INFO(0, k)
+ZEND_ARG_INFO(0, axis)
+ZEND_ARG_INFO(0, largest)
 ZEND_END_ARG_INFO()
-PHP_METHOD(NDArray, det) {
-    NDArray *rtn, *nda;
+PHP_METHOD(NDArray, topk) {
+    NDArray *values, *indexes;
     zval *a;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
-    Z_PARAM_ZVAL(a)
+    zend_long k, axis = -1;
+    bool axis_is_null = false, largest = true;
+    ZEND_PARSE_PARAMETERS_START(2, 4)
+        Z_PARAM_ZVAL(a)
+        Z_PARAM_LONG(k)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_LONG_OR_NULL(axis, axis_is_null)
+        Z_PARAM_BOOL(largest)
     ZEND_PARSE_PARAMETERS_END();
-    nda = ZVAL_TO_NDARRAY(a);
+    NDArray *nda = ZVAL_TO_NDARRAY(a);
     if (nda == NULL) {
         return;
     }
-    rtn = NDArray_Det(nda);
+    NDArray_TopK(nda, k, axis_is_null ? NDARRAY_MAX_DIMS : (int) axis, largest, &values, &indexes);
     CHECK_INPUT_AND_FREE(a, nda);
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_2NDARRAY(values, indexes, return_value);
 }
 
 /**
- * NDArray::sum
+ * NDArray::histogram
+ *
+ * @param execute_data
+ * @param return_value
  */
-ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_sum, 0, 0, 1)
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_histogram, 0, 0, 1)
 ZEND_ARG_INFO(0, a)
-ZEND_ARG_INFO(0, axis)
+ZEND_ARG_INFO(0, bins)
+ZEND_ARG_INFO(0, range)
 ZEND_END_ARG_INFO()
-PHP_METHOD(NDArray, sum) {
-    NDArray *rtn = NULL;
-    zval *a;
-    long axis;
-    int axis_i;
-    ZEND_PARSE_PARAMETERS_START(1, 2)
-    Z_PARAM_ZVAL(a)
-    Z_PARAM_OPTIONAL
-    Z_PARAM_LONG(axis)
+PHP_METHOD(NDArray, histogram) {
+    NDArray *hist = NULL, *edges = NULL, *bins_nd = NULL;
+    zval *a, *bins = NULL, *range = NULL, *val;
+    double range_d[2];
+    int i = 0;
+    ZEND_PARSE_PARAMETERS_START(1, 3)
+        Z_PARAM_ZVAL(a)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_ZVAL(bins)
+        Z_PARAM_ARRAY_OR_NULL(range)
     ZEND_PARSE_PARAMETERS_END();
-    axis_i = (int)axis;
+    if (range != NULL) {
+        if (zend_array_count(Z_ARRVAL_P(range)) != 2) {
+            zend_throw_error(NULL, "`range` must be an array of two numbers.");
+            return;
+        }
+        ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(range), val) {
+            range_d[i++] = zval_get_double(val);
+        } ZEND_HASH_FOREACH_END();
+    }
+    if (bins != NULL && Z_TYPE_P(bins) != IS_LONG) {
+        bins_nd = ZVAL_TO_NDARRAY(bins);
+        if (bins_nd == NULL) {
+            return;
+        }
+    }
     NDArray *nda = ZVAL_TO_NDARRAY(a);
     if (nda == NULL) {
+        CHECK_INPUT_AND_FREE(bins, bins_nd);
         return;
     }
-    if (ZEND_NUM_ARGS() == 2) {
-        rtn = reduce(nda, &axis_i, NDArray_Add_Float);
-    } else {
-        double value = NDArray_Sum_Float(nda);
-        CHECK_INPUT_AND_FREE(a, nda);
-        RETURN_DOUBLE(value);
-        return;
-    }
+    NDArray_Histogram(nda, bins == NULL ? 10 : (int) zval_get_long(bins), bins_nd, range != NULL ? range_d : NULL,
+                      &hist, &edges);
     CHECK_INPUT_AND_FREE(a, nda);
-    RETURN_NDARRAY(rtn, return_value);
+    CHECK_INPUT_AND_FREE(bins, bins_nd);
+    RETURN_2NDARRAY(hist, edges, return_value);
 }
 
 /**
- * NDArray::min
+ * NDArray::bincount
+ *
+ * @param execute_data
+ * @param return_value
  */
-ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_min, 0, 0, 1)
-ZEND_ARG_INFO(0, a)
-ZEND_ARG_INFO(0, axis)
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_bincount, 0, 0, 1)
+ZEND_ARG_INFO(0, x)
+ZEND_ARG_INFO(0, weights)
+ZEND_ARG_INFO(0, minlength)
 ZEND_END_ARG_INFO()
-PHP_METHOD(NDArray, min) {
-    NDArray *rtn = NULL;
-    zval *a;
-    long axis;
-    int axis_i;
-    double value;
-    ZEND_PARSE_PARAMETERS_START(1, 1)
-    Z_PARAM_ZVAL(a)
-    Z_PARAM_OPTIONAL
-    Z_PARAM_LONG(axis)
+PHP_METHOD(NDArray, bincount) {
+    NDArray *rtn = NULL, *weights_nd = NULL;
+    zval *x, *weights = NULL;
+    zend_long minlength = 0;
+    ZEND_PARSE_PARAMETERS_START(1, 3)
+        Z_PARAM_ZVAL(x)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_ZVAL_OR_NULL(weights)
+        Z_PARAM_LONG(minlength)
     ZEND_PARSE_PARAMETERS_END();
-    NDArray *nda = ZVAL_TO_NDARRAY(a);
-    if (nda == NULL) {
-        return;
+    if (weights != NULL) {
+        weights_nd = ZVAL_TO_NDARRAY(weights);
+        if (weights_nd == NULL) {
+            return;
+        }
     }
-    if (ZEND_NUM_ARGS() == 2) {
-        axis_i = (int)axis;
-        rtn = single_reduce(nda, &axis_i, NDArray_Min);
-    } else {
-        value = NDArray_Min(nda);
-        CHECK_INPUT_AND_FREE(a, nda);
-        RETURN_DOUBLE(value);
+    NDArray *nda = ZVAL_TO_NDARRAY(x);
+    if (nda == NULL) {
+        CHECK_INPUT_AND_FREE(weights, weights_nd);
         return;
     }
-    CHECK_INPUT_AND_FREE(a, nda);
+    rtn = NDArray_Bincount(nda, weights_nd, minlength);
+    CHECK_INPUT_AND_FREE(x, nda);
+    CHECK_INPUT_AND_FREE(weights, weights_nd);
     RETURN_NDARRAY(rtn, return_value);
 }
 
 /**
- * NDArray::max
+ * NDArray::digitize
+ *
+ * @param execute_data
+ * @param return_value
  */
-ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_max, 0, 0, 1)
-ZEND_ARG_INFO(0, a)
-ZEND_ARG_INFO(0, axis)
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_digitize, 0, 0, 2)
+ZEND_ARG_INFO(0, x)
+ZEND_ARG_INFO(0, bins)
+ZEND_ARG_INFO(0, right)
 ZEND_END_ARG_INFO()
-PHP_METHOD(NDArray, max) {
+PHP_METHOD(NDArray, digitize) {
     NDArray *rtn = NULL;
-    zval *a;
-    long axis;
-    int axis_i;
-    double value;
-    ZEND_PARSE_PARAMETERS_START(1, 2)
-    Z_PARAM_ZVAL(a)
-    Z_PARAM_OPTIONAL
-    Z_PARAM_LONG(axis)
+    zval *x, *bins;
+    bool right = false;
+    ZEND_PARSE_PARAMETERS_START(2, 3)
+        Z_PARAM_ZVAL(x)
+        Z_PARAM_ZVAL(bins)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_BOOL(right)
     ZEND_PARSE_PARAMETERS_END();
-    NDArray *nda = ZVAL_TO_NDARRAY(a);
-    if (nda == NULL) {
+    NDArray *bins_nd = ZVAL_TO_NDARRAY(bins);
+    if (bins_nd == NULL) {
         return;
     }
-    if (ZEND_NUM_ARGS() == 2) {
-        if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_GPU) {
-            zend_throw_error(NULL, "Axis not supported for GPU operation");
-            return;
-        }
-        axis_i = (int)axis;
-        rtn = NDArray_MaxAxis(nda, axis_i);
-    } else {
-        value = NDArray_Max(nda);
-        CHECK_INPUT_AND_FREE(a, nda);
-        RETURN_DOUBLE(value);
+    NDArray *nda = ZVAL_TO_NDARRAY(x);
+    if (nda == NULL) {
+        CHECK_INPUT_AND_FREE(bins, bins_nd);
         return;
     }
-    CHECK_INPUT_AND_FREE(a, nda);
+    rtn = NDArray_Digitize(nda, bins_nd, right);
+    CHECK_INPUT_AND_FREE(x, nda);
+    CHECK_INPUT_AND_FREE(bins, bins_nd);
     RETURN_NDARRAY(rtn, return_value);
 }
 
-ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_prod, 0, 0, 1)
+/**
+ * NDArray::unique
+ *
+ * @param execute_data
+ * @param return_value
+ */
+ZEND_BEGIN_ARG_INFO_EX(arginfo_ndarray_unique, 0, 0, 1)
 ZEND_ARG_INFO(0, a)
-ZEND_ARG_INFO(0, axis)
+ZEND_ARG_INFO(0, return_counts)
 ZEND_END_ARG_INFO()
-PHP_METHOD(NDArray, prod) {
-    NDArray *rtn = NULL;
+PHP_METHOD(NDArray, unique) {
+    NDArray *values = NULL, *counts = NULL;
     zval *a;
-    long axis;
-    int axis_i;
-    float value;
+    bool return_counts = false;
     ZEND_PARSE_PARAMETERS_START(1, 2)
-    Z_PARAM_ZVAL(a)
-    Z_PARAM_OPTIONAL
-    Z_PARAM_LONG(axis)
+        Z_PARAM_ZVAL(a)
+        Z_PARAM_OPTIONAL
+        Z_PARAM_BOOL(return_counts)
     ZEND_PARSE_PARAMETERS_END();
-    axis_i = (int)axis;
     NDArray *nda = ZVAL_TO_NDARRAY(a);
     if (nda == NULL) {
         return;
     }
-    if (ZEND_NUM_ARGS() == 2) {
-        rtn = reduce(nda, &axis_i, NDArray_Multiply_Float);
-    } else {
-        value = NDArray_Float_Prod(nda);
-        CHECK_INPUT_AND_FREE(a, nda);
-        RETURN_DOUBLE(value);
+    NDArray_Unique(nda, &values, return_counts ? &counts : NULL);
+    CHECK_INPUT_AND_FREE(a, nda);
+    if (return_counts) {
+        RETURN_2NDARRAY(values, counts, return_value);
         return;
     }
-    CHECK_INPUT_AND_FREE(a, nda);
-    RETURN_NDARRAY(rtn, return_value);
+    RETURN_NDARRAY(values, return_value);
 }
 
 ZEND_BEGIN_ARG_INFO(arginfo_ndarray_array, 0)
@@ -4774,8 +6423,7 @@ PHP_METHOD(NDArray, slice) {
     int j;
     zend_object *obj = Z_OBJ_P(ZEND_THIS);
     NDArray *rtn = NULL;
-    zval *obj_uuid = OBJ_PROP_NUM(obj, 0);
-    NDArray* ndarray = ZVALUUID_TO_NDARRAY(obj_uuid);
+    NDArray* ndarray = ndarray_object_fetch(obj)->array;
     NDArray** indices_axis;
 
     int num_args = ZEND_NUM_ARGS();
@@ -4819,8 +6467,7 @@ PHP_METHOD(NDArray, size) {
     zend_object *obj = Z_OBJ_P(ZEND_THIS);
     ZEND_PARSE_PARAMETERS_START(0, 0)
     ZEND_PARSE_PARAMETERS_END();
-    zval *obj_uuid = OBJ_PROP_NUM(obj, 0);
-    NDArray* ndarray = ZVALUUID_TO_NDARRAY(obj_uuid);
+    NDArray* ndarray = ndarray_object_fetch(obj)->array;
     RETURN_LONG(NDArray_NUMELEMENTS(ndarray));
 }
 
@@ -4834,8 +6481,7 @@ PHP_METHOD(NDArray, count) {
     zend_object *obj = Z_OBJ_P(ZEND_THIS);
     ZEND_PARSE_PARAMETERS_START(0, 0)
     ZEND_PARSE_PARAMETERS_END();
-    zval *obj_uuid = OBJ_PROP_NUM(obj, 0);
-    NDArray* ndarray = ZVALUUID_TO_NDARRAY(obj_uuid);
+    NDArray* ndarray = ndarray_object_fetch(obj)->array;
     RETURN_LONG(NDArray_SHAPE(ndarray)[0]);
 }
 
@@ -4843,10 +6489,8 @@ PHP_METHOD(NDArray, current) {
     zend_object *obj = Z_OBJ_P(ZEND_THIS);
     ZEND_PARSE_PARAMETERS_START(0, 0)
     ZEND_PARSE_PARAMETERS_END();
-    zval *obj_uuid = OBJ_PROP_NUM(obj, 0);
-    NDArray* ndarray = ZVALUUID_TO_NDARRAY(obj_uuid);
+    NDArray* ndarray = ndarray_object_fetch(obj)->array;
     NDArray* result  = NDArrayIteratorPHP_GET(ndarray);
-    add_to_buffer(result);
     RETURN_NDARRAY(result, return_value);
 }
 
@@ -4854,8 +6498,7 @@ PHP_METHOD(NDArray, key) {
     zend_object *obj = Z_OBJ_P(ZEND_THIS);
     ZEND_PARSE_PARAMETERS_START(0, 0)
     ZEND_PARSE_PARAMETERS_END();
-    zval *obj_uuid = OBJ_PROP_NUM(obj, 0);
-    NDArray* ndarray = ZVALUUID_TO_NDARRAY(obj_uuid);
+    NDArray* ndarray = ndarray_object_fetch(obj)->array;
     RETURN_LONG(ndarray->php_iterator->current_index);
 }
 
@@ -4863,8 +6506,7 @@ PHP_METHOD(NDArray, next) {
     zend_object *obj = Z_OBJ_P(ZEND_THIS);
     ZEND_PARSE_PARAMETERS_START(0, 0)
     ZEND_PARSE_PARAMETERS_END();
-    zval *obj_uuid = OBJ_PROP_NUM(obj, 0);
-    NDArray* ndarray = ZVALUUID_TO_NDARRAY(obj_uuid);
+    NDArray* ndarray = ndarray_object_fetch(obj)->array;
     NDArrayIteratorPHP_NEXT(ndarray);
 }
 
@@ -4872,8 +6514,7 @@ PHP_METHOD(NDArray, rewind) {
     zend_object *obj = Z_OBJ_P(ZEND_THIS);
     ZEND_PARSE_PARAMETERS_START(0, 0)
     ZEND_PARSE_PARAMETERS_END();
-    zval *obj_uuid = OBJ_PROP_NUM(obj, 0);
-    NDArray* ndarray = ZVALUUID_TO_NDARRAY(obj_uuid);
+    NDArray* ndarray = ndarray_object_fetch(obj)->array;
     NDArrayIteratorPHP_REWIND(ndarray);
 }
 
@@ -4883,8 +6524,7 @@ PHP_METHOD(NDArray, offsetExists) {
     ZEND_PARSE_PARAMETERS_START(1, 1)
     Z_PARAM_LONG(offset)
     ZEND_PARSE_PARAMETERS_END();
-    zval *obj_uuid = OBJ_PROP_NUM(obj, 0);
-    NDArray* ndarray = ZVALUUID_TO_NDARRAY(obj_uuid);
+    NDArray* ndarray = ndarray_object_fetch(obj)->array;
     if (offset < 0) {
         RETURN_BOOL(0);
         return;
@@ -4902,8 +6542,7 @@ PHP_METHOD(NDArray, offsetGet) {
     ZEND_PARSE_PARAMETERS_START(1, 1)
     Z_PARAM_ZVAL(offset)
     ZEND_PARSE_PARAMETERS_END();
-    zval *obj_uuid = OBJ_PROP_NUM(obj, 0);
-    NDArray* ndarray = ZVALUUID_TO_NDARRAY(obj_uuid);
+    NDArray* ndarray = ndarray_object_fetch(obj)->array;
     if (Z_TYPE_P(offset) == IS_LONG) {
         if (Z_LVAL_P(offset) < 0) {
             zend_throw_error(NULL, "Negative indexes are not implemented.");
@@ -4932,8 +6571,7 @@ PHP_METHOD(NDArray, offsetSet) {
     Z_PARAM_ZVAL(offset)
     Z_PARAM_ZVAL(value)
     ZEND_PARSE_PARAMETERS_END();
-    zval *obj_uuid = OBJ_PROP_NUM(obj, 0);
-    NDArray* ndarray = ZVALUUID_TO_NDARRAY(obj_uuid);
+    NDArray* ndarray = ndarray_object_fetch(obj)->array;
     if (Z_TYPE_P(offset) == IS_LONG || Z_TYPE_P(offset) == IS_DOUBLE) {
         if (zval_get_long(offset) < 0) {
             zend_throw_error(NULL, "Negative indexes are not implemented.");
@@ -4986,8 +6624,10 @@ PHP_METHOD(NDArray, __unserialize) {
         Z_PARAM_ZVAL(data)
     ZEND_PARSE_PARAMETERS_END();
     NDArray *nda = ZVAL_TO_NDARRAY(data);
-    add_to_buffer(nda);
-    ZVAL_LONG(OBJ_PROP_NUM(obj, 0), NDArray_UUID(nda));
+    if (nda == NULL) {
+        return;
+    }
+    ndarray_object_set(obj, nda);
 }
 
 
@@ -5005,8 +6645,7 @@ PHP_METHOD(NDArray, valid) {
     zend_object *obj = Z_OBJ_P(ZEND_THIS);
     ZEND_PARSE_PARAMETERS_START(0, 0)
     ZEND_PARSE_PARAMETERS_END();
-    zval *obj_uuid = OBJ_PROP_NUM(obj, 0);
-    NDArray* ndarray = ZVALUUID_TO_NDARRAY(obj_uuid);
+    NDArray* ndarray = ndarray_object_fetch(obj)->array;
     is_done = NDArrayIteratorPHP_ISDONE(ndarray);
     if (is_done == 0) {
         RETURN_BOOL(1);
@@ -5020,8 +6659,7 @@ PHP_METHOD(NDArray, __toString) {
     zend_object *obj = Z_OBJ_P(ZEND_THIS);
     ZEND_PARSE_PARAMETERS_START(0, 0)
     ZEND_PARSE_PARAMETERS_END();
-    zval *obj_uuid = OBJ_PROP_NUM(obj, 0);
-    NDArray* ndarray = ZVALUUID_TO_NDARRAY(obj_uuid);
+    NDArray* ndarray = ndarray_object_fetch(obj)->array;
     char *result = NDArray_Print(ndarray, 1);
     RETVAL_STRING(result);
     efree(result);
@@ -5031,6 +6669,11 @@ static const zend_function_entry class_arithmetic_methods[] = {
     PHP_FE_END
 };
 
+static const zend_function_entry class_LazyNDArray_methods[] = {
+    ZEND_ME(LazyNDArray, eval, arginfo_lazy_eval, ZEND_ACC_PUBLIC)
+    PHP_FE_END
+};
+
 static const zend_function_entry class_NDArray_methods[] = {
     ZEND_ME(NDArray, __construct, arginfo_construct, ZEND_ACC_PUBLIC)
     ZEND_ME(NDArray, dump, arginfo_dump, ZEND_ACC_PUBLIC)
@@ -5039,6 +6682,9 @@ static const zend_function_entry class_NDArray_methods[] = {
     ZEND_ME(NDArray, cpu, arginfo_cpu, ZEND_ACC_PUBLIC)
     ZEND_ME(NDArray, isGPU, arginfo_is_gpu, ZEND_ACC_PUBLIC)
     ZEND_ME(NDArray, setDevice, arginfo_setdevice, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NDArray, setNumThreads, arginfo_setnumthreads, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NDArray, getNumThreads, arginfo_getnumthreads, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NDArray, memoryStats, arginfo_memorystats, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NDArray, save, arginfo_save, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NDArray, load, arginfo_load, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
 
@@ -5156,6 +6802,7 @@ static const zend_function_entry class_NDArray_methods[] = {
     ZEND_ME(NDArray, sinh, arginfo_ndarray_sinh, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NDArray, cosh, arginfo_ndarray_cosh, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NDArray, tanh, arginfo_ndarray_tanh, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NDArray, sigmoid, arginfo_ndarray_sigmoid, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NDArray, arcsinh, arginfo_ndarray_arcsinh, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NDArray, arccosh, arginfo_ndarray_arccosh, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NDArray, arctanh, arginfo_ndarray_arctanh, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
@@ -5189,7 +6836,35 @@ static const zend_function_entry class_NDArray_methods[] = {
     ZEND_ME(NDArray, multiply, arginfo_ndarray_multiply, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NDArray, sum, arginfo_ndarray_sum, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NDArray, prod, arginfo_ndarray_prod, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NDArray, nansum, arginfo_ndarray_nanreduce, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NDArray, nanmean, arginfo_ndarray_nanreduce, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NDArray, nanmin, arginfo_ndarray_nanreduce, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NDArray, nanmax, arginfo_ndarray_nanreduce, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NDArray, nanvar, arginfo_ndarray_nanmoments, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NDArray, nanstd, arginfo_ndarray_nanmoments, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NDArray, segmentSum, arginfo_ndarray_segment, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NDArray, segmentMean, arginfo_ndarray_segment, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NDArray, segmentMin, arginfo_ndarray_segment, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NDArray, segmentMax, arginfo_ndarray_segment, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NDArray, cumsum, arginfo_ndarray_cumsum, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NDArray, cumprod, arginfo_ndarray_cumprod, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NDArray, cummax, arginfo_ndarray_cummax, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NDArray, sort, arginfo_ndarray_sort, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NDArray, argsort, arginfo_ndarray_argsort, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NDArray, partition, arginfo_ndarray_partition, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NDArray, topk, arginfo_ndarray_topk, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NDArray, histogram, arginfo_ndarray_histogram, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NDArray, bincount, arginfo_ndarray_bincount, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NDArray, digitize, arginfo_ndarray_digitize, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NDArray, unique, arginfo_ndarray_unique, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     ZEND_ME(NDArray, mod, arginfo_ndarray_mod, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    ZEND_ME(NDArray, addInPlace, arginfo_ndarray_inplace, ZEND_ACC_PUBLIC)
+    ZEND_ME(NDArray, subtractInPlace, arginfo_ndarray_inplace, ZEND_ACC_PUBLIC)
+    ZEND_ME(NDArray, multiplyInPlace, arginfo_ndarray_inplace, ZEND_ACC_PUBLIC)
+    ZEND_ME(NDArray, divideInPlace, arginfo_ndarray_inplace, ZEND_ACC_PUBLIC)
+    ZEND_ME(NDArray, modInPlace, arginfo_ndarray_inplace, ZEND_ACC_PUBLIC)
+    ZEND_ME(NDArray, powInPlace, arginfo_ndarray_inplace, ZEND_ACC_PUBLIC)
+    ZEND_ME(NDArray, lazy, arginfo_ndarray_lazy, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
 
     ZEND_ME(NDArray, size, arginfo_size, ZEND_ACC_PUBLIC)
     ZEND_ME(NDArray, count, arginfo_count, ZEND_ACC_PUBLIC)
@@ -5216,12 +6891,6 @@ static zend_class_entry *register_class_NDArray(zend_class_entry *class_entry_It
     class_entry = zend_register_internal_class(&ce);
     zend_class_implements(class_entry, 3, class_entry_Iterator, class_entry_Countable, class_entry_ArrayAccess);
 
-    zval property_id_default_value;
-    ZVAL_UNDEF(&property_id_default_value);
-    zend_string *property_id_name = zend_string_init("id", sizeof("id") - 1, 1);
-    zend_declare_typed_property(class_entry, property_id_name, &property_id_default_value, ZEND_ACC_PRIVATE, NULL, (zend_type) ZEND_TYPE_INIT_MASK(MAY_BE_LONG));
-    zend_string_release(property_id_name);
-
     return class_entry;
 }
 
@@ -5234,12 +6903,55 @@ static zend_class_entry *register_class_ArithmeticOperand(zend_class_entry *clas
     return class_entry;
 }
 
+static zend_class_entry *register_class_LazyNDArray(void) {
+    zend_class_entry ce, *class_entry;
+    INIT_CLASS_ENTRY(ce, "LazyNDArray", class_LazyNDArray_methods);
+    lazy_objects_init(&ce);
+    ce.create_object = lazy_create_object;
+    class_entry = zend_register_internal_class(&ce);
+    class_entry->ce_flags |= ZEND_ACC_FINAL | ZEND_ACC_NO_DYNAMIC_PROPERTIES;
+    return class_entry;
+}
+
+/**
+ * ndarray.mmap_threshold, size in bytes (K, M and G suffixes allowed), 0 disables the mmap path
+ */
+static PHP_INI_MH(OnUpdateMmapThreshold) {
+    zend_long threshold = zend_atol(ZSTR_VAL(new_value), ZSTR_LEN(new_value));
+    if (threshold < 0) {
+        return FAILURE;
+    }
+    NDArray_DataSetMmapThreshold((size_t) threshold);
+    return SUCCESS;
+}
+
+/**
+ * ndarray.mmap_limit, size in bytes (K, M and G suffixes allowed), -1 for no limit
+ */
+static PHP_INI_MH(OnUpdateMmapLimit) {
+    zend_long limit = zend_atol(ZSTR_VAL(new_value), ZSTR_LEN(new_value));
+    if (limit < -1) {
+        return FAILURE;
+    }
+    NDArray_DataSetMmapLimit(limit == -1 ? SIZE_MAX : (size_t) limit);
+    return SUCCESS;
+}
+
+PHP_INI_BEGIN()
+    PHP_INI_ENTRY("ndarray.mmap_threshold", "4M", PHP_INI_ALL, OnUpdateMmapThreshold)
+    PHP_INI_ENTRY("ndarray.mmap_limit", "-1", PHP_INI_ALL, OnUpdateMmapLimit)
+PHP_INI_END()
+
 /**
  * MINIT
  */
 PHP_MINIT_FUNCTION(ndarray) {
+    REGISTER_INI_ENTRIES();
+    NDArray_CPU_Init();
+    NDArray_ThreadPool_Init();
     phpsci_ce_NDArray = register_class_NDArray(zend_ce_iterator, zend_ce_countable, zend_ce_arrayaccess);
     phpsci_ce_ArithmeticOperand = register_class_ArithmeticOperand(zend_ce_iterator, zend_ce_countable, zend_ce_arrayaccess);
+    phpsci_ce_LazyNDArray = register_class_LazyNDArray();
     return SUCCESS;
 }
 
@@ -5248,6 +6960,7 @@ PHP_RINIT_FUNCTION(ndarray) {
     srand(seed);
     bypass_printr();
     buffer_init(2);
+    NDArray_DataPoolInit();
 #if defined(ZTS) && defined(COMPILE_DL_NDARRAY)
     ZEND_TSRMLS_CACHE_UPDATE();
 #endif
@@ -5255,12 +6968,26 @@ PHP_RINIT_FUNCTION(ndarray) {
 }
 
 PHP_MINFO_FUNCTION(ndarray) {
+    NDArray_DataStats stats;
+    char value[32];
+
+    NDArray_DataGetStats(&stats);
     php_info_print_table_start();
     php_info_print_table_header(2, "support", "enabled");
+    php_info_print_table_row(2, "SIMD kernels", NDArray_CPU_LevelName(NDArray_CPU_Level()));
+    snprintf(value, sizeof(value), "%zu", stats.mapped);
+    php_info_print_table_row(2, "mmap bytes in use", value);
+    snprintf(value, sizeof(value), "%zu", stats.peak_mapped);
+    php_info_print_table_row(2, "mmap peak bytes", value);
+    snprintf(value, sizeof(value), "%ld", stats.mappings);
+    php_info_print_table_row(2, "mmap buffers", value);
     php_info_print_table_end();
+    DISPLAY_INI_ENTRIES();
 }
 
 PHP_MSHUTDOWN_FUNCTION(ndarray) {
+    NDArray_ThreadPool_Shutdown();
+    UNREGISTER_INI_ENTRIES();
     return SUCCESS;
 }
 
@@ -5270,6 +6997,7 @@ PHP_RSHUTDOWN_FUNCTION(ndarray) {
     if(!getenv(envvar)) {
         buffer_free();
     }
+    NDArray_DataPoolShutdown();
 #ifdef HAVE_CUBLAS
     if(getenv(envvar_vcheck)) {
         vmemcheck();
@@ -5278,6 +7006,14 @@ PHP_RSHUTDOWN_FUNCTION(ndarray) {
     return SUCCESS;
 }
 
+/**
+ * Runs once the object store is gone, unmaps buffers that outlived the request
+ */
+ZEND_MODULE_POST_ZEND_DEACTIVATE_D(ndarray) {
+    NDArray_DataReleaseMappings();
+    return SUCCESS;
+}
+
 zend_module_entry ndarray_module_entry = {
     STANDARD_MODULE_HEADER,
     "NumPower",					    /* Extension name */
@@ -5288,7 +7024,9 @@ zend_module_entry ndarray_module_entry = {
     PHP_RSHUTDOWN(ndarray), /* PHP_RSHUTDOWN - Request shutdown */
     PHP_MINFO(ndarray),			    /* PHP_MINFO - Module info */
     PHP_NDARRAY_VERSION,		    /* Version */
-    STANDARD_MODULE_PROPERTIES
+    NO_MODULE_GLOBALS,
+    ZEND_MODULE_POST_ZEND_DEACTIVATE_N(ndarray),   /* Unmaps leftover buffers */
+    STANDARD_MODULE_PROPERTIES_EX
 };
 /* }}} */
 
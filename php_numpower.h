@@ -63,6 +63,7 @@ ZEND_FUNCTION(print_r_);
 
 PHPAPI zend_class_entry *phpsci_ce_NDArray;
 PHPAPI zend_class_entry *phpsci_ce_ArithmeticOperand;
+PHPAPI zend_class_entry *phpsci_ce_LazyNDArray;
 
 # define PHP_NDARRAY_VERSION "0.6.0"
 
@@ -1,4 +1,5 @@
 #include <stdlib.h>
+#include <stdint.h>
 #include <php.h>
 #include "Zend/zend_alloc.h"
 #include "buffer.h"
@@ -32,6 +33,19 @@ CArrayBuffer_ISDEBUGON() {
     return 1;
 }
 
+/**
+ * Smallest size of the buffer, it is never shrunk below it
+ */
+#define BUFFER_MIN_SIZE 16
+
+/**
+ * A free slot stores the index of the next free slot, shifted left with
+ * the low bit set. NDArray pointers are aligned, so their low bit is 0.
+ */
+#define BUFFER_SLOT_IS_FREE(p) (((uintptr_t) (p)) & 1)
+#define BUFFER_FREE_SLOT(next) ((NDArray *) ((((uintptr_t) ((next) + 1)) << 1) | 1))
+#define BUFFER_NEXT_FREE(p) ((int) (((uintptr_t) (p)) >> 1) - 1)
+
 /**
  * Initialize MemoryStack Buffer
  */
@@ -39,7 +53,8 @@ void buffer_init(int size) {
     MAIN_MEM_STACK.buffer = (NDArray**)emalloc(size * sizeof(NDArray*));
     MAIN_MEM_STACK.bufferSize = size;
     MAIN_MEM_STACK.numElements = 0;
-    MAIN_MEM_STACK.lastFreed = -1;
+    MAIN_MEM_STACK.numLive = 0;
+    MAIN_MEM_STACK.freeHead = -1;
     MAIN_MEM_STACK.totalGPUAllocated = 0;
     MAIN_MEM_STACK.totalAllocated = 0;
     MAIN_MEM_STACK.totalFreed = 0;
@@ -56,21 +71,52 @@ void buffer_free() {
 }
 
 /**
+ * Halve the buffer while at most a quarter of it was handed out. Only
+ * the tail past `numElements` is released, every slot on the free list
+ * is below it.
+ */
+static void
+buffer_shrink() {
+    int newSize = MAIN_MEM_STACK.bufferSize;
+    while (newSize > BUFFER_MIN_SIZE && MAIN_MEM_STACK.numElements <= newSize / 4) {
+        newSize /= 2;
+    }
+    if (newSize != MAIN_MEM_STACK.bufferSize) {
+        MAIN_MEM_STACK.buffer = (NDArray**)erealloc(MAIN_MEM_STACK.buffer, newSize * sizeof(NDArray*));
+        MAIN_MEM_STACK.bufferSize = newSize;
+    }
+}
+
+/**
+ * Release the NDArray of a slot and recycle the slot. The last slot
+ * handed out is given back to the unused tail, any other one is pushed
+ * on the free list. The buffer shrinks as it empties and all its slots
+ * are reset once no NDArray is left. The allocation counters are kept,
+ * they are only reset by buffer_init.
+ *
  * @param uuid
  */
 void buffer_ndarray_free(int uuid) {
-    if (MAIN_MEM_STACK.buffer != NULL) {
-        if (MAIN_MEM_STACK.lastFreed == -1) {
-            MAIN_MEM_STACK.lastFreed = uuid;
-        }
-        if (MAIN_MEM_STACK.buffer[uuid] != NULL) {
-            NDArray_FREE(MAIN_MEM_STACK.buffer[uuid]);
-            MAIN_MEM_STACK.buffer[uuid] = NULL;
-            MAIN_MEM_STACK.totalFreed++;
-        }
-        if (MAIN_MEM_STACK.numElements - 1 == 0) {
-            buffer_free();
-        }
+    if (MAIN_MEM_STACK.buffer == NULL || uuid < 0 || uuid >= MAIN_MEM_STACK.numElements ||
+        BUFFER_SLOT_IS_FREE(MAIN_MEM_STACK.buffer[uuid]) || MAIN_MEM_STACK.buffer[uuid] == NULL) {
+        return;
+    }
+    NDArray_FREE(MAIN_MEM_STACK.buffer[uuid]);
+    MAIN_MEM_STACK.totalFreed++;
+    MAIN_MEM_STACK.numLive--;
+    if (MAIN_MEM_STACK.numLive == 0) {
+        // Every slot is free, start over from the first one
+        MAIN_MEM_STACK.numElements = 0;
+        MAIN_MEM_STACK.freeHead = -1;
+        buffer_shrink();
+        return;
+    }
+    if (uuid == MAIN_MEM_STACK.numElements - 1) {
+        MAIN_MEM_STACK.numElements--;
+        buffer_shrink();
+    } else {
+        MAIN_MEM_STACK.buffer[uuid] = BUFFER_FREE_SLOT(MAIN_MEM_STACK.freeHead);
+        MAIN_MEM_STACK.freeHead = uuid;
     }
 }
 
@@ -78,24 +124,30 @@ void buffer_ndarray_free(int uuid) {
  * @param uuid
  */
 NDArray* buffer_get(int uuid) {
-    assert(MAIN_MEM_STACK.buffer[uuid] != NULL);
+    assert(MAIN_MEM_STACK.buffer[uuid] != NULL && !BUFFER_SLOT_IS_FREE(MAIN_MEM_STACK.buffer[uuid]));
     return MAIN_MEM_STACK.buffer[uuid];
 }
 
 /**
- * Add CArray to MemoryStack (Buffer) and retrieve MemoryPointer
+ * Add CArray to MemoryStack (Buffer) and retrieve MemoryPointer. The
+ * most recently freed slot is reused first, the buffer only grows when
+ * no slot is free.
  *
  * @param array CArray CArray to add into the stack
  * @param size  size_t Size of CArray in bytes
  */
 void add_to_buffer(NDArray* ndarray) {
+    int uuid;
     if (MAIN_MEM_STACK.buffer == NULL) {
-        buffer_init(1);
+        buffer_init(BUFFER_MIN_SIZE);
     }
-    if (MAIN_MEM_STACK.lastFreed > -1) {
-        ndarray->uuid = MAIN_MEM_STACK.lastFreed;
-        MAIN_MEM_STACK.buffer[MAIN_MEM_STACK.lastFreed] = ndarray;
-        MAIN_MEM_STACK.lastFreed = -1;
+    if (MAIN_MEM_STACK.freeHead > -1) {
+        uuid = MAIN_MEM_STACK.freeHead;
+        MAIN_MEM_STACK.freeHead = BUFFER_NEXT_FREE(MAIN_MEM_STACK.buffer[uuid]);
+        ndarray->uuid = uuid;
+        MAIN_MEM_STACK.buffer[uuid] = ndarray;
+        MAIN_MEM_STACK.numLive++;
+        MAIN_MEM_STACK.totalAllocated++;
         return;
     }
 
@@ -117,5 +169,6 @@ void add_to_buffer(NDArray* ndarray) {
     // Add the NDArray to the buffer
     MAIN_MEM_STACK.buffer[MAIN_MEM_STACK.numElements] = ndarray;
     MAIN_MEM_STACK.numElements++;
+    MAIN_MEM_STACK.numLive++;
     MAIN_MEM_STACK.totalAllocated++;
-}
\ No newline at end of file
+}
@@ -4,12 +4,16 @@
 
 /**
  * MemoryStack : The memory buffer of CArrays
+ *
+ * Free slots are chained into a stack through the slots themselves, a
+ * free slot holds the tagged index of the next free one (see buffer.c).
  */
 struct MemoryStack {
     NDArray** buffer;   // Dynamic array to store NDArray pointers
     int bufferSize;     // Current size of the buffer
-    int numElements;
-    int lastFreed;
+    int numElements;    // Slots in use or on the free list, the others were never handed out
+    int numLive;        // Slots holding an NDArray
+    int freeHead;       // Most recently freed slot, -1 when the free list is empty
     int totalGPUAllocated;
     int totalAllocated;
     int totalFreed;
@@ -0,0 +1,63 @@
+#include <stdlib.h>
+#include <string.h>
+#include "cpu.h"
+#include "../config.h"
+
+static NDArray_CPULevel cpu_level = NDARRAY_CPU_BASELINE;
+
+static const char *cpu_level_names[NDARRAY_CPU_NUM_LEVELS] = {
+    [NDARRAY_CPU_BASELINE] = "baseline",
+    [NDARRAY_CPU_AVX2] = "avx2",
+    [NDARRAY_CPU_AVX512F] = "avx512f",
+};
+
+/**
+ * Detect the highest level supported by the running CPU. Must be called
+ * once from MINIT, before any kernel is looked up.
+ *
+ * The NDARRAY_CPU environment variable ("baseline", "avx2") lowers the
+ * detected level, which is useful to test the fallback paths on a host
+ * that supports more.
+ */
+void
+NDArray_CPU_Init(void) {
+    NDArray_CPULevel level = NDARRAY_CPU_BASELINE;
+    const char *limit = getenv("NDARRAY_CPU");
+    int i;
+#ifdef HAVE_AVX2
+    // Also checks that the OS saves the YMM/ZMM registers
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        level = NDARRAY_CPU_AVX2;
+        if (__builtin_cpu_supports("avx512f")) {
+            level = NDARRAY_CPU_AVX512F;
+        }
+    }
+#endif
+    if (limit != NULL) {
+        for (i = 0; i < level; i++) {
+            if (!strcmp(limit, cpu_level_names[i])) {
+                level = (NDArray_CPULevel) i;
+                break;
+            }
+        }
+    }
+    cpu_level = level;
+}
+
+/**
+ * @return
+ */
+NDArray_CPULevel
+NDArray_CPU_Level(void) {
+    return cpu_level;
+}
+
+/**
+ * @param level
+ * @return
+ */
+const char*
+NDArray_CPU_LevelName(NDArray_CPULevel level) {
+    return cpu_level_names[level];
+}
@@ -0,0 +1,31 @@
+#ifndef PHPSCI_NDARRAY_CPU_H
+#define PHPSCI_NDARRAY_CPU_H
+
+/**
+ * Instruction set levels the SIMD kernels are built for. Each level
+ * implies the ones before it.
+ */
+typedef enum {
+    NDARRAY_CPU_BASELINE = 0,   // Plain C, SSE2 on x86-64
+    NDARRAY_CPU_AVX2,           // AVX2 + FMA
+    NDARRAY_CPU_AVX512F,
+    NDARRAY_CPU_NUM_LEVELS
+} NDArray_CPULevel;
+
+/**
+ * Kernels above the baseline are compiled with these attributes instead
+ * of global -m flags, so the extension builds for the baseline and only
+ * enters them after NDArray_CPU_Init found the instructions at runtime.
+ */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NDARRAY_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define NDARRAY_TARGET_AVX512F __attribute__((target("avx512f,avx2,fma")))
+#else
+#define NDARRAY_TARGET_AVX2
+#define NDARRAY_TARGET_AVX512F
+#endif
+
+void NDArray_CPU_Init(void);
+NDArray_CPULevel NDArray_CPU_Level(void);
+const char* NDArray_CPU_LevelName(NDArray_CPULevel level);
+#endif //PHPSCI_NDARRAY_CPU_H
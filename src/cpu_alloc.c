@@ -0,0 +1,337 @@
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <php.h>
+#include "Zend/zend_alloc.h"
+#include "cpu_alloc.h"
+
+/**
+ * Size classes are powers of two from 64 bytes to 4 MB. Larger
+ * buffers are allocated with their exact size and are not pooled.
+ */
+#define POOL_MIN_SHIFT 6
+#define POOL_NUM_CLASSES 17
+#define POOL_CLASS_SIZE(c) (((size_t) 1) << ((c) + POOL_MIN_SHIFT))
+#define POOL_UNPOOLED POOL_NUM_CLASSES
+#define POOL_MAPPED (POOL_NUM_CLASSES + 1)
+
+/**
+ * Bytes of freed buffers kept for reuse, beyond it they go back to
+ * the Zend allocator.
+ */
+#define POOL_MAX_CACHED (32 * 1024 * 1024)
+
+/**
+ * Stored right before every buffer handed out
+ */
+typedef struct {
+    void *raw;          // Pointer returned by emalloc, or the start of the mapping
+    int size_class;     // POOL_UNPOOLED for buffers above the largest class
+} pool_header;
+
+/**
+ * Buffers at or above the mmap threshold get their own mapping, outside
+ * of Zend MM and memory_limit. The data starts NDARRAY_DATA_ALIGNMENT
+ * bytes into the mapping and this header sits right before it.
+ */
+typedef struct map_header {
+    struct map_header *prev;
+    struct map_header *next;
+    size_t length;      // Bytes mapped
+    pool_header pool;   // Must be the last member
+} map_header;
+
+#define MAP_HUGE_ALIGNMENT (2 * 1024 * 1024)
+
+/**
+ * Freed buffers of each class, chained through their first bytes.
+ * Buffers come from emalloc, so the lists only live for one request.
+ */
+static struct {
+    void *free_list[POOL_NUM_CLASSES];
+    size_t cached;
+    int active;
+} data_pool;
+
+/**
+ * Mappings alive in this process, with the accounting reported by
+ * NDArray_DataGetStats. Threshold and limit come from the
+ * ndarray.mmap_threshold and ndarray.mmap_limit INI entries.
+ */
+static struct {
+    size_t threshold;   // 0 disables the mmap path
+    size_t limit;       // SIZE_MAX for no limit
+    size_t mapped;
+    size_t peak;
+    long count;
+    long total;
+    map_header *head;
+} data_map = {NDARRAY_MMAP_THRESHOLD_DEFAULT, SIZE_MAX, 0, 0, 0, 0, NULL};
+
+static int
+size_class(size_t size) {
+    int c = 0;
+    while (c < POOL_NUM_CLASSES && POOL_CLASS_SIZE(c) < size) {
+        c++;
+    }
+    return c;
+}
+
+/**
+ * mmap `length` bytes, aligned to a huge page when the mapping spans at
+ * least one so MADV_HUGEPAGE can back it with huge pages from the start.
+ *
+ * @param length multiple of the page size
+ * @return MAP_FAILED on failure
+ */
+static void *
+map_pages(size_t length) {
+    char *raw, *base;
+    size_t head;
+
+    if (length < MAP_HUGE_ALIGNMENT) {
+        return mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+    raw = mmap(NULL, length + MAP_HUGE_ALIGNMENT, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+        return MAP_FAILED;
+    }
+    base = (char *) (((uintptr_t) raw + MAP_HUGE_ALIGNMENT - 1) & ~((uintptr_t) MAP_HUGE_ALIGNMENT - 1));
+    head = base - raw;
+    if (head > 0) {
+        munmap(raw, head);
+    }
+    if (head < MAP_HUGE_ALIGNMENT) {
+        munmap(base + length, MAP_HUGE_ALIGNMENT - head);
+    }
+#ifdef MADV_HUGEPAGE
+    madvise(base, length, MADV_HUGEPAGE);
+#endif
+    return base;
+}
+
+/**
+ * Allocate `size` bytes in a mapping of their own
+ *
+ * @param size
+ * @return NULL if mmap failed
+ */
+static void *
+map_alloc(size_t size) {
+    static size_t page_size = 0;
+    size_t length;
+    map_header *header;
+    char *base, *ptr;
+
+    if (page_size == 0) {
+        page_size = (size_t) sysconf(_SC_PAGESIZE);
+    }
+    length = (size + NDARRAY_DATA_ALIGNMENT + page_size - 1) & ~(page_size - 1);
+    if (data_map.limit != SIZE_MAX && (length > data_map.limit || data_map.mapped > data_map.limit - length)) {
+        zend_error_noreturn(E_ERROR, "NDArray mmap limit of %zu bytes exhausted (tried to allocate %zu bytes)",
+                            data_map.limit, size);
+    }
+    base = map_pages(length);
+    if (base == MAP_FAILED) {
+        return NULL;
+    }
+    ptr = base + NDARRAY_DATA_ALIGNMENT;
+    header = (map_header *) ptr - 1;
+    header->length = length;
+    header->pool.raw = base;
+    header->pool.size_class = POOL_MAPPED;
+    header->prev = NULL;
+    header->next = data_map.head;
+    if (data_map.head != NULL) {
+        data_map.head->prev = header;
+    }
+    data_map.head = header;
+    data_map.mapped += length;
+    data_map.count++;
+    data_map.total++;
+    if (data_map.mapped > data_map.peak) {
+        data_map.peak = data_map.mapped;
+    }
+    return ptr;
+}
+
+/**
+ * Unlink and unmap a buffer from map_alloc
+ *
+ * @param header
+ */
+static void
+map_free(map_header *header) {
+    if (header->prev != NULL) {
+        header->prev->next = header->next;
+    } else {
+        data_map.head = header->next;
+    }
+    if (header->next != NULL) {
+        header->next->prev = header->prev;
+    }
+    data_map.mapped -= header->length;
+    data_map.count--;
+    munmap(header->pool.raw, header->length);
+}
+
+/**
+ * Allocate a NDARRAY_DATA_ALIGNMENT aligned buffer of at least `size`
+ * bytes, reusing one freed earlier in the request when possible.
+ * Buffers at or above the mmap threshold are mapped directly.
+ * Release it with NDArray_DataFree.
+ *
+ * @param size
+ * @return
+ */
+void *
+NDArray_DataAlloc(size_t size) {
+    int c = size_class(size);
+    size_t bytes = (c == POOL_UNPOOLED) ? size : POOL_CLASS_SIZE(c);
+    pool_header *header;
+    char *raw, *ptr;
+
+    if (data_map.threshold != 0 && size >= data_map.threshold) {
+        ptr = map_alloc(size);
+        if (ptr != NULL) {
+            return ptr;
+        }
+    }
+    if (c != POOL_UNPOOLED && data_pool.free_list[c] != NULL) {
+        ptr = data_pool.free_list[c];
+        data_pool.free_list[c] = *(void **) ptr;
+        data_pool.cached -= bytes;
+        return ptr;
+    }
+    raw = emalloc(bytes + sizeof(pool_header) + NDARRAY_DATA_ALIGNMENT - 1);
+    ptr = (char *) (((uintptr_t) raw + sizeof(pool_header) + NDARRAY_DATA_ALIGNMENT - 1) &
+                    ~((uintptr_t) NDARRAY_DATA_ALIGNMENT - 1));
+    header = (pool_header *) ptr - 1;
+    header->raw = raw;
+    header->size_class = c;
+    return ptr;
+}
+
+/**
+ * NDArray_DataAlloc with the first `size` bytes set to zero. Fresh
+ * mappings are already zeroed by the kernel.
+ *
+ * @param size
+ * @return
+ */
+void *
+NDArray_DataCalloc(size_t size) {
+    void *ptr = NDArray_DataAlloc(size);
+    if (((pool_header *) ptr - 1)->size_class != POOL_MAPPED) {
+        memset(ptr, 0, size);
+    }
+    return ptr;
+}
+
+/**
+ * Return a buffer from NDArray_DataAlloc to its size class, or to
+ * Zend MM when the pool is full or not running. Mapped buffers are
+ * unmapped right away.
+ *
+ * @param ptr
+ */
+void
+NDArray_DataFree(void *ptr) {
+    pool_header *header;
+    int c;
+
+    if (ptr == NULL) {
+        return;
+    }
+    header = (pool_header *) ptr - 1;
+    c = header->size_class;
+    if (c == POOL_MAPPED) {
+        map_free((map_header *) ((char *) header - offsetof(map_header, pool)));
+        return;
+    }
+    if (data_pool.active && c != POOL_UNPOOLED && data_pool.cached + POOL_CLASS_SIZE(c) <= POOL_MAX_CACHED) {
+        *(void **) ptr = data_pool.free_list[c];
+        data_pool.free_list[c] = ptr;
+        data_pool.cached += POOL_CLASS_SIZE(c);
+        return;
+    }
+    efree(header->raw);
+}
+
+/**
+ * Start pooling for a request, called from RINIT
+ */
+void
+NDArray_DataPoolInit(void) {
+    memset(&data_pool, 0, sizeof(data_pool));
+    data_pool.active = 1;
+    data_map.peak = data_map.mapped;
+    data_map.total = 0;
+}
+
+/**
+ * Release the cached buffers, called from RSHUTDOWN. Arrays freed after
+ * this give their buffers straight back to Zend MM.
+ */
+void
+NDArray_DataPoolShutdown(void) {
+    int c;
+    void *ptr, *next;
+
+    for (c = 0; c < POOL_NUM_CLASSES; c++) {
+        for (ptr = data_pool.free_list[c]; ptr != NULL; ptr = next) {
+            next = *(void **) ptr;
+            efree(((pool_header *) ptr - 1)->raw);
+        }
+        data_pool.free_list[c] = NULL;
+    }
+    data_pool.cached = 0;
+    data_pool.active = 0;
+}
+
+/**
+ * Unmap buffers still alive once the request is over, called after the
+ * object store has been destroyed so no array can reach them anymore.
+ */
+void
+NDArray_DataReleaseMappings(void) {
+    while (data_map.head != NULL) {
+        map_free(data_map.head);
+    }
+}
+
+/**
+ * Buffers of at least `threshold` bytes are mapped directly, 0 turns
+ * the mmap path off
+ *
+ * @param threshold
+ */
+void
+NDArray_DataSetMmapThreshold(size_t threshold) {
+    data_map.threshold = threshold;
+}
+
+/**
+ * Cap on the bytes mapped at once, SIZE_MAX for no cap
+ *
+ * @param limit
+ */
+void
+NDArray_DataSetMmapLimit(size_t limit) {
+    data_map.limit = limit;
+}
+
+/**
+ * @param stats
+ */
+void
+NDArray_DataGetStats(NDArray_DataStats *stats) {
+    stats->mmap_threshold = data_map.threshold;
+    stats->mmap_limit = data_map.limit;
+    stats->mapped = data_map.mapped;
+    stats->peak_mapped = data_map.peak;
+    stats->mappings = data_map.count;
+    stats->total_mappings = data_map.total;
+    stats->pool_cached = data_pool.cached;
+}
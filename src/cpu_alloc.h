@@ -0,0 +1,37 @@
+#ifndef NUMPOWER_CPU_ALLOC_H
+#define NUMPOWER_CPU_ALLOC_H
+
+#include <stddef.h>
+
+/**
+ * Alignment of the buffers returned by NDArray_DataAlloc, one cache
+ * line and a full AVX-512 vector.
+ */
+#define NDARRAY_DATA_ALIGNMENT 64
+
+/**
+ * Default for ndarray.mmap_threshold, buffers this large skip Zend MM
+ */
+#define NDARRAY_MMAP_THRESHOLD_DEFAULT (4 * 1024 * 1024)
+
+typedef struct NDArray_DataStats {
+    size_t mmap_threshold;
+    size_t mmap_limit;          // SIZE_MAX when unlimited
+    size_t mapped;              // Bytes currently mapped
+    size_t peak_mapped;         // Highest `mapped` seen in this request
+    long mappings;              // Live mappings
+    long total_mappings;        // Mappings created in this request
+    size_t pool_cached;         // Bytes held by the size class free lists
+} NDArray_DataStats;
+
+void *NDArray_DataAlloc(size_t size);
+void *NDArray_DataCalloc(size_t size);
+void NDArray_DataFree(void *ptr);
+void NDArray_DataPoolInit(void);
+void NDArray_DataPoolShutdown(void);
+void NDArray_DataReleaseMappings(void);
+void NDArray_DataSetMmapThreshold(size_t threshold);
+void NDArray_DataSetMmapLimit(size_t limit);
+void NDArray_DataGetStats(NDArray_DataStats *stats);
+
+#endif //NUMPOWER_CPU_ALLOC_H
@@ -8,7 +8,9 @@
 #include "Zend/zend_hash.h"
 #include "iterators.h"
 #include "indexing.h"
+#include "cpu_alloc.h"
 #include <math.h>
+#include <stdint.h>
 #include <time.h>
 
 #ifdef HAVE_CUBLAS
@@ -135,14 +137,111 @@ int* Generate_Strides(const int* dimensions, int dimensions_size, int elsize) {
 }
 
 /**
+ * Arrays with at most this many bytes of data keep it in the header
+ * allocation.
+ */
+#define NDARRAY_INLINE_DATA_BYTES 64
+
+/**
+ * Fixed part of a header allocation, followed by `ndim` dimensions,
+ * `ndim` strides and, for small arrays, the data.
+ */
+typedef struct NDArrayHeader {
+    NDArray array;
+    NDArrayDescriptor descriptor;
+    NDArrayIterator iterator;
+    NDArrayIterator php_iterator;
+} NDArrayHeader;
+
+/**
+ * Allocate an NDArray with its descriptor, iterators, dimensions and
+ * strides in a single block. `data_bytes` of storage are reserved in
+ * the same block when they fit NDARRAY_INLINE_DATA_BYTES, otherwise
+ * `data` is left NULL for the caller to allocate.
+ *
+ * Dimensions and strides are not initialized. Fields later replaced
+ * by separately allocated buffers are freed by NDArray_FREE as usual.
+ *
+ * @param ndim
+ * @param data_bytes
+ * @return
+ */
+NDArray*
+NDArray_Alloc(int ndim, size_t data_bytes) {
+    NDArrayHeader *header;
+    NDArray *rtn;
+    int nvec = ndim > 0 ? ndim : 1;
+    size_t size = ZEND_MM_ALIGNED_SIZE_EX(sizeof(NDArrayHeader) + 2 * nvec * sizeof(int), 16);
+
+    if (data_bytes > NDARRAY_INLINE_DATA_BYTES) {
+        data_bytes = 0;
+    }
+    header = emalloc(size + data_bytes);
+    rtn = &header->array;
+    rtn->uuid = 0;
+    rtn->ndim = ndim;
+    rtn->flags = 0;
+    rtn->refcount = 1;
+    rtn->base = NULL;
+    rtn->device = NDARRAY_DEVICE_CPU;
+    rtn->header_size = (int)(size + data_bytes);
+    rtn->descriptor = &header->descriptor;
+    rtn->iterator = &header->iterator;
+    rtn->php_iterator = &header->php_iterator;
+    rtn->iterator->current_index = 0;
+    rtn->php_iterator->current_index = 0;
+    rtn->dimensions = (int *)(header + 1);
+    rtn->strides = rtn->dimensions + nvec;
+    rtn->data = data_bytes > 0 ? (char *)header + size : NULL;
+    return rtn;
+}
+
+/**
+ * Create an NDArray header for `shape`, with inline storage for small
+ * CPU arrays when `inline_data` is set. Takes ownership of `shape`.
+ */
+static NDArray*
+create_ndarray(int *shape, int ndim, const char *type, int device, int inline_data) {
+    NDArray* rtn;
+    int type_size = get_type_size(type);
+    long total_num_elements = 1;
+
+    if (shape == NULL) {
+        return NULL;
+    }
+
+    // Calculate number of elements
+    for (int i = 0; i < ndim; i++) {
+        total_num_elements = total_num_elements * shape[i];
+    }
+
+    rtn = NDArray_Alloc(ndim, (inline_data && device == NDARRAY_DEVICE_CPU) ? total_num_elements * type_size : 0);
+    rtn->descriptor->numElements = total_num_elements;
+    rtn->descriptor->elsize = type_size;
+    rtn->descriptor->type = type;
+    rtn->device = device;
+    if (ndim > 0) {
+        memcpy(rtn->dimensions, shape, sizeof(int) * ndim);
+        rtn->strides[ndim - 1] = type_size;
+        for (int i = ndim - 2; i >= 0; i--) {
+            rtn->strides[i] = shape[i + 1] * rtn->strides[i + 1];
+        }
+    }
+    efree(shape);
+    return rtn;
+}
+
+/**
+ * Give `array` a data buffer from the aligned data pool
  *
  * @param buffer
  * @param numElements
  * @param elsize
  */
 void
-NDArray_CreateBuffer(NDArray* array, int numElements, int elsize) {
-    array->data = emalloc(numElements * elsize);
+NDArray_CreateBuffer(NDArray* array, long numElements, int elsize) {
+    array->data = NDArray_DataAlloc((size_t) numElements * elsize);
+    NDArray_ENABLEFLAGS(array, NDARRAY_ARRAY_ALIGNED | NDARRAY_ARRAY_POOLED);
 }
 
 int iteration = 0;
@@ -221,9 +320,11 @@ NDArray* Create_NDArray_FromZendArray(zend_array* ht, int ndim) {
     for (int i = 1; i < ndim; i++) {
         total_num_elements = total_num_elements * shape[i];
     }
-    NDArray* array = Create_NDArray(shape, ndim, NDARRAY_TYPE_FLOAT32, NDARRAY_DEVICE_CPU);
+    NDArray* array = create_ndarray(shape, ndim, NDARRAY_TYPE_FLOAT32, NDARRAY_DEVICE_CPU, 1);
     if (ndim != 0) {
-        NDArray_CreateBuffer(array, total_num_elements, get_type_size(NDARRAY_TYPE_FLOAT32));
+        if (array->data == NULL) {
+            NDArray_CreateBuffer(array, total_num_elements, get_type_size(NDARRAY_TYPE_FLOAT32));
+        }
         NDArray_CopyFromZendArray(array, ht, &last_index);
     } else {
         array->data = NULL;
@@ -254,35 +355,7 @@ NDArray* Create_NDArray_FromZval(zval* php_object) {
  */
 NDArray*
 Create_NDArray(int* shape, int ndim, const char* type, const int device) {
-    NDArray* rtn;
-    int type_size = get_type_size(type);
-
-    if (shape == NULL) {
-        return NULL;
-    }
-
-    long total_num_elements = shape[0];
-
-    if (ndim == 0) {
-        total_num_elements = 1;
-    }
-
-    // Calculate number of elements
-    for (int i = 1; i < ndim; i++) {
-        total_num_elements = total_num_elements * shape[i];
-    }
-
-    rtn = emalloc(sizeof(NDArray));
-    rtn->descriptor = Create_Descriptor(total_num_elements, type_size, type);
-    rtn->flags = 0;
-    rtn->ndim = ndim;
-    rtn->dimensions = shape;
-    rtn->refcount = 1;
-    rtn->base = NULL;
-    rtn->device = device;
-    rtn->strides = Generate_Strides(shape, ndim, type_size);
-    NDArrayIterator_INIT(rtn);
-    return rtn;
+    return create_ndarray(shape, ndim, type, device, 0);
 }
 
 /**
@@ -298,7 +371,7 @@ Create_NDArray(int* shape, int ndim, const char* type, const int device) {
  */
 NDArray*
 NDArray_FromNDArrayBase(NDArray *target, char *data_ptr, int* shape, int* strides, const int ndim) {
-    NDArray* rtn = emalloc(sizeof(NDArray));
+    NDArray* rtn = NDArray_Alloc(ndim, 0);
     int total_num_elements = 1;
 
     rtn->strides = strides;
@@ -308,63 +381,15 @@ NDArray_FromNDArrayBase(NDArray *target, char *data_ptr, int* shape, int* stride
         total_num_elements = total_num_elements * NDArray_SHAPE(rtn)[i];
     }
 
-    rtn->flags = 0;
     rtn->data = data_ptr;
     rtn->base = target;
-    rtn->ndim = ndim;
-    rtn->refcount = 1;
     rtn->device = NDArray_DEVICE(target);
-    rtn->descriptor = Create_Descriptor(total_num_elements, sizeof(float), NDARRAY_TYPE_FLOAT32);
-    NDArrayIterator_INIT(rtn);
-    NDArray_ADDREF(target);
-    return rtn;
-}
-
-/**
- * Create an NDArray View from another NDArray
- *
- * @param target
- * @param buffer_offset
- * @param shape
- * @param strides
- * @param ndim
- * @return
- */
-NDArray*
-NDArray_FromNDArray(NDArray *target, int buffer_offset, int* shape, int* strides, const int* ndim) {
-    NDArray* rtn = emalloc(sizeof(NDArray));
-    int total_num_elements = 1;
-    int out_ndim;
-
-    if (strides == NULL) {
-        rtn->strides = emalloc(sizeof(int) * NDArray_NDIM(target));
-        memcpy(NDArray_STRIDES(rtn), NDArray_STRIDES(target), sizeof(int) * NDArray_NDIM(target));
+    if (((uintptr_t) rtn->data & (NDARRAY_DATA_ALIGNMENT - 1)) == 0) {
+        NDArray_ENABLEFLAGS(rtn, NDARRAY_ARRAY_ALIGNED);
     }
-    if (shape == NULL) {
-        out_ndim = NDArray_NDIM(target);
-        rtn->dimensions = emalloc(sizeof(int) * NDArray_NDIM(target));
-        memcpy(NDArray_SHAPE(rtn), NDArray_SHAPE(target), sizeof(int) * NDArray_NDIM(target));
-    }
-
-    if (shape != NULL) {
-        rtn->dimensions = shape;
-        rtn->strides = strides;
-        out_ndim = *ndim;
-    }
-
-    // Calculate number of elements
-    for (int i = 0; i < out_ndim; i++) {
-        total_num_elements = total_num_elements * NDArray_SHAPE(rtn)[i];
-    }
-
-    rtn->flags = 0;
-    rtn->data = target->data + buffer_offset;
-    rtn->base = target;
-    rtn->ndim = out_ndim;
-    rtn->refcount = 1;
-    rtn->device = NDArray_DEVICE(target);
-    rtn->descriptor = Create_Descriptor(total_num_elements, sizeof(float), NDARRAY_TYPE_FLOAT32);
-    NDArrayIterator_INIT(rtn);
+    rtn->descriptor->numElements = total_num_elements;
+    rtn->descriptor->elsize = sizeof(float);
+    rtn->descriptor->type = NDARRAY_TYPE_FLOAT32;
     NDArray_ADDREF(target);
     return rtn;
 }
@@ -378,7 +403,8 @@ NDArray_FromNDArray(NDArray *target, int buffer_offset, int* shape, int* strides
  */
 NDArray*
 NDArray_Empty(int *shape, int ndim, const char *type, int device) {
-    NDArray* rtn = Create_NDArray(shape, ndim, type, NDARRAY_DEVICE_CPU);
+    NDArray* rtn = create_ndarray(shape, ndim, type, NDARRAY_DEVICE_CPU,
+                                  device == NDARRAY_DEVICE_CPU && is_type(type, NDARRAY_TYPE_FLOAT32));
 
     if (rtn == NULL) {
         return rtn;
@@ -387,7 +413,9 @@ NDArray_Empty(int *shape, int ndim, const char *type, int device) {
     if (is_type(type, NDARRAY_TYPE_FLOAT32)) {
         if (device == NDARRAY_DEVICE_CPU) {
             rtn->device = NDARRAY_DEVICE_CPU;
-            rtn->data = emalloc(NDArray_NUMELEMENTS(rtn) * sizeof(float));
+            if (rtn->data == NULL) {
+                NDArray_CreateBuffer(rtn, NDArray_NUMELEMENTS(rtn), sizeof(float));
+            }
         } else {
 #ifdef HAVE_CUBLAS
             rtn->device = NDARRAY_DEVICE_GPU;
@@ -418,18 +446,19 @@ NDArray_EmptyLike(NDArray *a) {
  */
 NDArray*
 NDArray_Zeros(int *shape, int ndim, const char *type, const int device) {
-    NDArray* rtn = Create_NDArray(shape, ndim, type, device);
+    NDArray* rtn = create_ndarray(shape, ndim, type, device, 1);
 
     if (rtn == NULL) {
         return rtn;
     }
 
     if (device == NDARRAY_DEVICE_CPU) {
-        if (is_type(type, NDARRAY_TYPE_DOUBLE64)) {
-            rtn->data = ecalloc(rtn->descriptor->numElements, sizeof(double));
-        }
-        if (is_type(type, NDARRAY_TYPE_FLOAT32)) {
-            rtn->data = ecalloc(rtn->descriptor->numElements, sizeof(float));
+        if (rtn->data == NULL) {
+            // Fresh mappings are zeroed already, only pooled buffers are cleared
+            rtn->data = NDArray_DataCalloc((size_t) NDArray_NUMELEMENTS(rtn) * NDArray_ELSIZE(rtn));
+            NDArray_ENABLEFLAGS(rtn, NDARRAY_ARRAY_ALIGNED | NDARRAY_ARRAY_POOLED);
+        } else {
+            memset(rtn->data, 0, NDArray_NUMELEMENTS(rtn) * NDArray_ELSIZE(rtn));
         }
     }
 #ifdef HAVE_CUBLAS
@@ -456,13 +485,15 @@ NDArray_Zeros(int *shape, int ndim, const char *type, const int device) {
  */
 NDArray*
 NDArray_Ones(int *shape, int ndim, const char *type) {
-    NDArray* rtn = Create_NDArray(shape, ndim, type, NDARRAY_DEVICE_CPU);
+    NDArray* rtn = create_ndarray(shape, ndim, type, NDARRAY_DEVICE_CPU, 1);
     if (rtn == NULL) {
         return NULL;
     }
 
     long i;
-    rtn->data = emalloc(sizeof(float) * NDArray_NUMELEMENTS(rtn));
+    if (rtn->data == NULL) {
+        NDArray_CreateBuffer(rtn, NDArray_NUMELEMENTS(rtn), sizeof(float));
+    }
     for (i = 0; i < NDArray_NUMELEMENTS(rtn); i++) {
         NDArray_FDATA(rtn)[i] = (float)1.0;
     }
@@ -665,20 +696,11 @@ NDArray_Full(int *shape, int ndim,  double fill_value) {
  */
 NDArray*
 NDArray_CreateFromDoubleScalar(double scalar) {
-    NDArray *rtn = safe_emalloc(1, sizeof(NDArray), 0);
+    NDArray *rtn = NDArray_Alloc(0, sizeof(float));
 
-    rtn->ndim = 0;
-    rtn->descriptor = emalloc(sizeof(NDArrayDescriptor));
     rtn->descriptor->numElements = 1;
     rtn->descriptor->elsize = sizeof(float);
     rtn->descriptor->type = NDARRAY_TYPE_FLOAT32;
-    rtn->data = emalloc(sizeof(float));
-    rtn->device = NDARRAY_DEVICE_CPU;
-    rtn->strides = emalloc(sizeof(int));
-    rtn->dimensions = emalloc(sizeof(int));
-    rtn->iterator = NULL;
-    rtn->base = NULL;
-    rtn->refcount = 1;
     ((float*)rtn->data)[0] = (float)scalar;
 
     return rtn;
@@ -690,20 +712,11 @@ NDArray_CreateFromDoubleScalar(double scalar) {
  */
 NDArray*
 NDArray_CreateFromFloatScalar(float scalar) {
-    NDArray *rtn = safe_emalloc(1, sizeof(NDArray), 0);
+    NDArray *rtn = NDArray_Alloc(0, sizeof(float));
 
-    rtn->ndim = 0;
-    rtn->descriptor = emalloc(sizeof(NDArrayDescriptor));
     rtn->descriptor->numElements = 1;
-    rtn->descriptor->elsize = sizeof(float );
+    rtn->descriptor->elsize = sizeof(float);
     rtn->descriptor->type = NDARRAY_TYPE_FLOAT32;
-    rtn->data = emalloc(sizeof(float));
-    rtn->device = NDARRAY_DEVICE_CPU;
-    rtn->strides = emalloc(sizeof(int));
-    rtn->dimensions = emalloc(sizeof(int));
-    rtn->iterator = NULL;
-    rtn->base = NULL;
-    rtn->refcount = 1;
     ((float *)rtn->data)[0] = scalar;
 
     return rtn;
@@ -715,20 +728,11 @@ NDArray_CreateFromFloatScalar(float scalar) {
  */
 NDArray*
 NDArray_CreateFromLongScalar(long scalar) {
-    NDArray *rtn = safe_emalloc(1, sizeof(NDArray), 0);
+    NDArray *rtn = NDArray_Alloc(0, sizeof(float));
 
-    rtn->ndim = 0;
-    rtn->descriptor = emalloc(sizeof(NDArrayDescriptor));
     rtn->descriptor->numElements = 1;
     rtn->descriptor->elsize = sizeof(float);
     rtn->descriptor->type = NDARRAY_TYPE_FLOAT32;
-    rtn->data = emalloc(sizeof(float));
-    rtn->device = NDARRAY_DEVICE_CPU;
-    rtn->strides = emalloc(sizeof(int));
-    rtn->dimensions = emalloc(sizeof(int));
-    rtn->iterator = NULL;
-    rtn->base = NULL;
-    rtn->refcount = 1;
     ((float*)rtn->data)[0] = (float)scalar;
 
     return rtn;
@@ -744,47 +748,30 @@ NDArray_Copy(NDArray *a, int device) {
     NDArray *rtn;
     if (device == NDARRAY_DEVICE_GPU) {
 #ifdef HAVE_CUBLAS
-        rtn = emalloc(sizeof(NDArray));
-        rtn->dimensions = emalloc(sizeof(int) * NDArray_NDIM(a));
+        rtn = NDArray_Alloc(NDArray_NDIM(a), 0);
         memcpy(rtn->dimensions, NDArray_SHAPE(a), NDArray_NDIM(a) * sizeof(int));
-        rtn->strides = emalloc(sizeof(int) * NDArray_NDIM(a));
         memcpy(rtn->strides, NDArray_STRIDES(a), NDArray_NDIM(a) * sizeof(int));
         rtn->device = NDARRAY_DEVICE_GPU;
-        rtn->refcount = 1;
-        rtn->flags = 0;
-        rtn->base = NULL;
-        rtn->ndim = NDArray_NDIM(a);
         vmalloc((void **) &rtn->data, NDArray_NUMELEMENTS(a) * sizeof(float));
         cudaMemcpy(NDArray_FDATA(rtn), NDArray_FDATA(a), NDArray_NUMELEMENTS(a) * sizeof(float), cudaMemcpyDeviceToDevice);
-        rtn->descriptor = emalloc(sizeof(NDArrayDescriptor));
         rtn->descriptor->numElements = NDArray_NUMELEMENTS(a);
         rtn->descriptor->elsize = NDArray_ELSIZE(a);
         rtn->descriptor->type = NDArray_TYPE(a);
-        NDArrayIterator_INIT(rtn);
         return rtn;
 #else
         return NULL;
 #endif
     } else {
-        rtn = emalloc(sizeof(NDArray));
-        if (NDArray_NDIM(a) > 0) {
-            rtn->dimensions = (int*)emalloc(sizeof(int) * NDArray_NDIM(a));
-            memcpy(rtn->dimensions, NDArray_SHAPE(a), NDArray_NDIM(a) * sizeof(int));
-            rtn->strides = (int*)emalloc(sizeof(int) * NDArray_NDIM(a));
-            memcpy(rtn->strides, NDArray_STRIDES(a), NDArray_NDIM(a) * sizeof(int));
-        } else {
-            rtn->dimensions = emalloc(sizeof(int));
-            rtn->strides = emalloc(sizeof(int));
+        rtn = NDArray_Alloc(NDArray_NDIM(a), NDArray_NUMELEMENTS(a) * sizeof(float));
+        memcpy(rtn->dimensions, NDArray_SHAPE(a), NDArray_NDIM(a) * sizeof(int));
+        memcpy(rtn->strides, NDArray_STRIDES(a), NDArray_NDIM(a) * sizeof(int));
+        if (rtn->data == NULL) {
+            NDArray_CreateBuffer(rtn, NDArray_NUMELEMENTS(a), sizeof(float));
         }
-        rtn->device = NDARRAY_DEVICE_CPU;
-        rtn->refcount = 1;
-        rtn->flags = 0;
-        rtn->ndim = NDArray_NDIM(a);
-        rtn->base = NULL;
-        rtn->data = emalloc(NDArray_NUMELEMENTS(a) * sizeof(float));
         memcpy(NDArray_DATA(rtn), NDArray_DATA(a), NDArray_NUMELEMENTS(a) * sizeof(float));
-        rtn->descriptor = Create_Descriptor(NDArray_NUMELEMENTS(a), NDArray_ELSIZE(a), NDArray_TYPE(a));
-        NDArrayIterator_INIT(rtn);
+        rtn->descriptor->numElements = NDArray_NUMELEMENTS(a);
+        rtn->descriptor->elsize = NDArray_ELSIZE(a);
+        rtn->descriptor->type = NDArray_TYPE(a);
         return rtn;
     }
 }
@@ -5,8 +5,9 @@
 #include "ndarray.h"
 
 NDArray* Create_NDArray(int* shape, int ndim, const char* type, int device);
+NDArray* NDArray_Alloc(int ndim, size_t data_bytes);
+void NDArray_CreateBuffer(NDArray* array, long numElements, int elsize);
 NDArray* Create_NDArray_FromZval(zval* php_object);
-NDArray* NDArray_FromNDArray(NDArray *target, int buffer_offset, int* shape, int* strides, const int* ndim);
 NDArray* NDArray_Zeros(int *shape, int ndim, const char *type, int device);
 NDArray* NDArray_Ones(int *shape, int ndim, const char *type);
 NDArray* NDArray_Identity(int size);
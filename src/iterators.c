@@ -115,14 +115,14 @@ NDArrayIterator_GET(NDArray* array) {
  */
 void
 NDArrayIterator_FREE(NDArray* array) {
-    if (array->iterator != NULL) {
+    if (array->iterator != NULL && !NDArray_HEADER_OWNS(array, array->iterator)) {
         efree(array->iterator);
-        array->iterator = NULL;
     }
-    if (array->php_iterator != NULL) {
+    if (array->php_iterator != NULL && !NDArray_HEADER_OWNS(array, array->php_iterator)) {
         efree(array->php_iterator);
-        array->php_iterator = NULL;
     }
+    array->iterator = NULL;
+    array->php_iterator = NULL;
 }
 
 NDArrayIter*
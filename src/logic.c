@@ -3,6 +3,8 @@
 #include "../config.h"
 #include "initializers.h"
 #include "manipulation.h"
+#include "ndmath/elementwise.h"
+#include "cpu.h"
 #include <Zend/zend.h>
 #include <php.h>
 
@@ -14,51 +16,58 @@
 
 #ifdef HAVE_AVX2
 #include <immintrin.h>
-#endif
 
-/**
- * Check if all values are not 0
- *
- * @param a
- * @return
- */
-float
-NDArray_All(NDArray *a) {
+static NDARRAY_TARGET_AVX2 float
+float_all_avx2(const float *array, int n) {
     int i;
-    float *array = NDArray_FDATA(a);
-#ifdef HAVE_AVX2
     __m256 zero = _mm256_set1_ps(0.0f);
-    for (i = 0; i < NDArray_NUMELEMENTS(a) - 7; i += 8) {
+    for (i = 0; i + 8 <= n; i += 8) {
         __m256 elements = _mm256_loadu_ps(&array[i]);
-        __m256 comparison = _mm256_cmp_ps(elements, zero, _CMP_NEQ_OQ);
+        __m256 comparison = _mm256_cmp_ps(elements, zero, _CMP_NEQ_UQ);
 
         // Perform horizontal OR operation on comparison results
         int mask = _mm256_movemask_ps(comparison);
-        if (mask != 0x0F) {
+        if (mask != 0xFF) {
             return 0;  // At least one element is zero
         }
     }
 
     // Check remaining elements (if any)
-    for (; i < NDArray_NUMELEMENTS(a); i++) {
+    for (; i < n; i++) {
         if (array[i] == 0.0) {
             return 0;  // Element is zero
         }
     }
 
     return 1;  // All elements are non-zero
-#else
+}
+#endif
+
+/**
+ * Check if all values are not 0
+ *
+ * @param a
+ * @return
+ */
+float
+NDArray_All(NDArray *a) {
+    int i;
+    float *array = NDArray_FDATA(a);
+#ifdef HAVE_AVX2
+    if (NDArray_CPU_Level() >= NDARRAY_CPU_AVX2) {
+        return float_all_avx2(array, NDArray_NUMELEMENTS(a));
+    }
+#endif
     for (i = 0; i < NDArray_NUMELEMENTS(a); i++) {
         if (array[i] == 0.0) {
             return 0;  // Element is zero
         }
     }
     return 1;
-#endif
 }
 
 /**
- * Return if NDArray is equal element-wise
+ * Return if NDArray is greater element-wise
  *
  * @param nda
  * @param ndb
@@ -66,101 +75,7 @@ NDArray_All(NDArray *a) {
  */
 NDArray*
 NDArray_Greater(NDArray* nda, NDArray* ndb) {
-    NDArray *a_temp = NULL, *b_temp = NULL;
-    if ((NDArray_DEVICE(nda) != NDArray_DEVICE(ndb)) && NDArray_NDIM(nda) != 0 && NDArray_NDIM(ndb) != 0) {
-        zend_throw_error(NULL, "Devices mismatch in `equal` function");
-        return NULL;
-    }
-
-    // If a or b are scalars, reshape
-    if (NDArray_NDIM(nda) == 0 && NDArray_NDIM(ndb) > 0) {
-        a_temp = nda;
-        int *n_shape = emalloc(sizeof(int) * NDArray_NDIM(ndb));
-        copy(NDArray_SHAPE(ndb), n_shape, NDArray_NDIM(ndb));
-        nda = NDArray_Zeros(n_shape, NDArray_NDIM(ndb), NDArray_TYPE(ndb), NDArray_DEVICE(ndb));
-        nda = NDArray_Fill(nda, NDArray_FDATA(a_temp)[0]);
-    } else if (NDArray_NDIM(ndb) == 0 && NDArray_NDIM(nda) > 0) {
-        b_temp = ndb;
-        int *n_shape = emalloc(sizeof(int) * NDArray_NDIM(nda));
-        copy(NDArray_SHAPE(nda), n_shape, NDArray_NDIM(nda));
-        ndb = NDArray_Zeros(n_shape, NDArray_NDIM(nda), NDArray_TYPE(nda), NDArray_DEVICE(nda));
-        ndb = NDArray_Fill(ndb, NDArray_FDATA(b_temp)[0]);
-    }
-
-    int i;
-    int *rtn_shape = emalloc(sizeof(int) * NDArray_NDIM(nda));
-
-    for (i = 0; i < NDArray_NDIM(nda); i++) {
-        rtn_shape[i] = NDArray_SHAPE(nda)[i];
-    }
-
-    NDArray *broadcasted = NULL;
-    NDArray *a_broad = NULL, *b_broad = NULL;
-
-    if (NDArray_NUMELEMENTS(nda) < NDArray_NUMELEMENTS(ndb)) {
-        broadcasted = NDArray_Broadcast(nda, ndb);
-        a_broad = broadcasted;
-        b_broad = ndb;
-    } else if (NDArray_NUMELEMENTS(ndb) < NDArray_NUMELEMENTS(nda)) {
-        broadcasted = NDArray_Broadcast(ndb, nda);
-        b_broad = broadcasted;
-        a_broad = nda;
-    } else {
-        b_broad = ndb;
-        a_broad = nda;
-    }
-
-    NDArray *result = NDArray_Empty(rtn_shape, NDArray_NDIM(a_broad), NDArray_TYPE(a_broad), NDArray_DEVICE(a_broad));
-
-    if (b_broad == NULL) {
-        zend_throw_error(NULL, "Can't broadcast arrays.");
-        return NULL;
-    }
-    if (NDArray_DEVICE(a_broad) == NDARRAY_DEVICE_GPU) {
-#ifdef HAVE_CUBLAS
-        cuda_float_compare_greater(NDArray_SHAPE(a_broad)[0], NDArray_FDATA(a_broad), NDArray_FDATA(b_broad), NDArray_FDATA(result),
-                                   NDArray_NUMELEMENTS(a_broad));
-#endif
-    } else {
-#ifdef HAVE_AVX2
-        // Process 8 elements at a time using AVX2
-        i = 0;
-        for (; i < NDArray_NUMELEMENTS(a_broad) - 7; i += 8) {
-            // Load 8 elements from each array
-            __m256 vec1 = _mm256_loadu_ps(&NDArray_FDATA(a_broad)[i]);
-            __m256 vec2 = _mm256_loadu_ps(&NDArray_FDATA(b_broad)[i]);
-
-            // Compare elements for equality
-            __m256 cmp = _mm256_cmp_ps(vec1, vec2, _CMP_GT_OQ);
-
-            __m256 ones = _mm256_set1_ps(1.0f);
-            __m256 zeros = _mm256_set1_ps(+0.0f);
-            __m256 resultVec = _mm256_blendv_ps(zeros, ones, cmp);
-
-            // Store the results
-            _mm256_storeu_ps(&NDArray_FDATA(result)[i], resultVec);
-        }
-
-        // Process remaining elements using scalar operations
-        for (; i < NDArray_NUMELEMENTS(a_broad); i++) {
-            NDArray_FDATA(result)[i] = NDArray_FDATA(a_broad)[i] > NDArray_FDATA(b_broad)[i] ? 1.0f : 0.0f;
-        }
-#else
-        for (i = 0; i < NDArray_NUMELEMENTS(a_broad); i++) {
-            NDArray_FDATA(result)[i] = NDArray_FDATA(a_broad)[i] > NDArray_FDATA(b_broad)[i] ? 1.0f : 0.0f;
-        }
-#endif
-    }
-    if (a_temp != NULL) {
-        NDArray_FREE(nda);
-    }
-    if (b_temp != NULL) {
-        NDArray_FREE(ndb);
-    }
-    if (broadcasted != NULL) {
-        NDArray_FREE(broadcasted);
-    }
-    return result;
+    return NDArray_BinaryOperation(nda, ndb, NDARRAY_BINARY_GREATER);
 }
 
 /**
@@ -170,97 +85,7 @@ NDArray_Greater(NDArray* nda, NDArray* ndb) {
  */
 NDArray*
 NDArray_Less(NDArray* nda, NDArray* ndb) {
-    NDArray *a_temp = NULL, *b_temp = NULL;
-    if ((NDArray_DEVICE(nda) != NDArray_DEVICE(ndb)) && NDArray_NDIM(nda) != 0 && NDArray_NDIM(ndb) != 0) {
-        zend_throw_error(NULL, "Devices mismatch in `equal` function");
-        return NULL;
-    }
-
-    // If a or b are scalars, reshape
-    if (NDArray_NDIM(nda) == 0 && NDArray_NDIM(ndb) > 0) {
-        a_temp = nda;
-        int *n_shape = emalloc(sizeof(int) * NDArray_NDIM(ndb));
-        copy(NDArray_SHAPE(ndb), n_shape, NDArray_NDIM(ndb));
-        nda = NDArray_Zeros(n_shape, NDArray_NDIM(ndb), NDArray_TYPE(ndb), NDArray_DEVICE(ndb));
-        nda = NDArray_Fill(nda, NDArray_FDATA(a_temp)[0]);
-    } else if (NDArray_NDIM(ndb) == 0 && NDArray_NDIM(nda) > 0) {
-        b_temp = ndb;
-        int *n_shape = emalloc(sizeof(int) * NDArray_NDIM(nda));
-        copy(NDArray_SHAPE(nda), n_shape, NDArray_NDIM(nda));
-        ndb = NDArray_Zeros(n_shape, NDArray_NDIM(nda), NDArray_TYPE(nda), NDArray_DEVICE(nda));
-        ndb = NDArray_Fill(ndb, NDArray_FDATA(b_temp)[0]);
-    }
-
-    int i;
-    int *rtn_shape = emalloc(sizeof(int) * NDArray_NDIM(nda));
-
-    for (i = 0; i < NDArray_NDIM(nda); i++) {
-        rtn_shape[i] = NDArray_SHAPE(nda)[i];
-    }
-
-    NDArray *broadcasted = NULL;
-    NDArray *a_broad = NULL, *b_broad = NULL;
-
-    if (NDArray_NUMELEMENTS(nda) < NDArray_NUMELEMENTS(ndb)) {
-        broadcasted = NDArray_Broadcast(nda, ndb);
-        a_broad = broadcasted;
-        b_broad = ndb;
-    } else if (NDArray_NUMELEMENTS(ndb) < NDArray_NUMELEMENTS(nda)) {
-        broadcasted = NDArray_Broadcast(ndb, nda);
-        b_broad = broadcasted;
-        a_broad = nda;
-    } else {
-        b_broad = ndb;
-        a_broad = nda;
-    }
-
-    NDArray *result = NDArray_Empty(rtn_shape, NDArray_NDIM(a_broad), NDArray_TYPE(a_broad), NDArray_DEVICE(a_broad));
-
-    if (NDArray_DEVICE(nda) == NDARRAY_DEVICE_GPU) {
-#ifdef HAVE_CUBLAS
-        cuda_float_compare_less(NDArray_SHAPE(a_broad)[0], NDArray_FDATA(a_broad), NDArray_FDATA(b_broad), NDArray_FDATA(result),
-                                NDArray_NUMELEMENTS(a_broad));
-#endif
-    } else {
-#ifdef HAVE_AVX2
-        // Process 8 elements at a time using AVX2
-        i = 0;
-        for (; i < NDArray_NUMELEMENTS(nda) - 7; i += 8) {
-            // Load 8 elements from each array
-            __m256 vec1 = _mm256_loadu_ps(&NDArray_FDATA(nda)[i]);
-            __m256 vec2 = _mm256_loadu_ps(&NDArray_FDATA(ndb)[i]);
-
-            // Compare elements for equality
-            __m256 cmp = _mm256_cmp_ps(vec1, vec2, _CMP_LT_OQ);
-
-            // Convert comparison results to float (1.0 for true, 0.0 for false)
-            __m256 resultVec = _mm256_and_ps(cmp, _mm256_set1_ps(1.0f));
-
-            // Store the results
-            _mm256_storeu_ps(&NDArray_FDATA(result)[i], resultVec);
-        }
-
-        // Process remaining elements using scalar operations
-        for (; i < NDArray_NUMELEMENTS(nda); i++) {
-            NDArray_FDATA(result)[i] = NDArray_FDATA(nda)[i] < NDArray_FDATA(ndb)[i] ? 1.0f : 0.0f;
-        }
-        return result;
-#else
-        for (i = 0; i < NDArray_NUMELEMENTS(nda); i++) {
-            NDArray_FDATA(result)[i] = NDArray_FDATA(nda)[i] < NDArray_FDATA(ndb)[i] ? 1.0f : 0.0f;
-        }
-#endif
-    }
-    if (a_temp != NULL) {
-        NDArray_FREE(nda);
-    }
-    if (b_temp != NULL) {
-        NDArray_FREE(ndb);
-    }
-    if (broadcasted != NULL) {
-        NDArray_FREE(broadcasted);
-    }
-    return result;
+    return NDArray_BinaryOperation(nda, ndb, NDARRAY_BINARY_LESS);
 }
 
 /**
@@ -270,101 +95,7 @@ NDArray_Less(NDArray* nda, NDArray* ndb) {
  */
 NDArray*
 NDArray_LessEqual(NDArray* nda, NDArray* ndb) {
-    NDArray *a_temp = NULL, *b_temp = NULL;
-    if ((NDArray_DEVICE(nda) != NDArray_DEVICE(ndb)) && NDArray_NDIM(nda) != 0 && NDArray_NDIM(ndb) != 0) {
-        zend_throw_error(NULL, "Devices mismatch in `equal` function");
-        return NULL;
-    }
-
-    // If a or b are scalars, reshape
-    if (NDArray_NDIM(nda) == 0 && NDArray_NDIM(ndb) > 0) {
-        a_temp = nda;
-        int *n_shape = emalloc(sizeof(int) * NDArray_NDIM(ndb));
-        copy(NDArray_SHAPE(ndb), n_shape, NDArray_NDIM(ndb));
-        nda = NDArray_Zeros(n_shape, NDArray_NDIM(ndb), NDArray_TYPE(ndb), NDArray_DEVICE(ndb));
-        nda = NDArray_Fill(nda, NDArray_FDATA(a_temp)[0]);
-    } else if (NDArray_NDIM(ndb) == 0 && NDArray_NDIM(nda) > 0) {
-        b_temp = ndb;
-        int *n_shape = emalloc(sizeof(int) * NDArray_NDIM(nda));
-        copy(NDArray_SHAPE(nda), n_shape, NDArray_NDIM(nda));
-        ndb = NDArray_Zeros(n_shape, NDArray_NDIM(nda), NDArray_TYPE(nda), NDArray_DEVICE(nda));
-        ndb = NDArray_Fill(ndb, NDArray_FDATA(b_temp)[0]);
-    }
-
-    int i;
-    int *rtn_shape = emalloc(sizeof(int) * NDArray_NDIM(nda));
-
-    for (i = 0; i < NDArray_NDIM(nda); i++) {
-        rtn_shape[i] = NDArray_SHAPE(nda)[i];
-    }
-
-    NDArray *broadcasted = NULL;
-    NDArray *a_broad = NULL, *b_broad = NULL;
-
-    if (NDArray_NUMELEMENTS(nda) < NDArray_NUMELEMENTS(ndb)) {
-        broadcasted = NDArray_Broadcast(nda, ndb);
-        a_broad = broadcasted;
-        b_broad = ndb;
-    } else if (NDArray_NUMELEMENTS(ndb) < NDArray_NUMELEMENTS(nda)) {
-        broadcasted = NDArray_Broadcast(ndb, nda);
-        b_broad = broadcasted;
-        a_broad = nda;
-    } else {
-        b_broad = ndb;
-        a_broad = nda;
-    }
-
-    NDArray *result = NDArray_Empty(rtn_shape, NDArray_NDIM(a_broad), NDArray_TYPE(a_broad), NDArray_DEVICE(a_broad));
-
-    if (b_broad == NULL) {
-        zend_throw_error(NULL, "Can't broadcast arrays.");
-        return NULL;
-    }
-
-    if (NDArray_DEVICE(a_broad) == NDARRAY_DEVICE_GPU) {
-#ifdef HAVE_CUBLAS
-        cuda_float_compare_less_equal(NDArray_SHAPE(a_broad)[0], NDArray_FDATA(a_broad), NDArray_FDATA(b_broad), NDArray_FDATA(result),
-                                      NDArray_NUMELEMENTS(a_broad));
-#endif
-    } else {
-#ifdef HAVE_AVX2
-        // Process 8 elements at a time using AVX2
-        i = 0;
-        for (; i < NDArray_NUMELEMENTS(a_broad) - 7; i += 8) {
-            // Load 8 elements from each array
-            __m256 vec1 = _mm256_loadu_ps(&NDArray_FDATA(a_broad)[i]);
-            __m256 vec2 = _mm256_loadu_ps(&NDArray_FDATA(b_broad)[i]);
-
-            // Compare elements for equality
-            __m256 cmp = _mm256_cmp_ps(vec1, vec2, _CMP_LE_OQ);
-
-            // Convert comparison results to float (1.0 for true, 0.0 for false)
-            __m256 resultVec = _mm256_and_ps(cmp, _mm256_set1_ps(1.0f));
-
-            // Store the results
-            _mm256_storeu_ps(&NDArray_FDATA(result)[i], resultVec);
-        }
-
-        // Process remaining elements using scalar operations
-        for (; i < NDArray_NUMELEMENTS(a_broad); i++) {
-            NDArray_FDATA(result)[i] = NDArray_FDATA(a_broad)[i] <= NDArray_FDATA(b_broad)[i] ? 1.0f : 0.0f;
-        }
-#else
-        for (i = 0; i < NDArray_NUMELEMENTS(a_broad); i++) {
-            NDArray_FDATA(result)[i] = NDArray_FDATA(a_broad)[i] <= NDArray_FDATA(b_broad)[i] ? 1.0f : 0.0f;
-        }
-#endif
-    }
-    if (a_temp != NULL) {
-        NDArray_FREE(nda);
-    }
-    if (b_temp != NULL) {
-        NDArray_FREE(ndb);
-    }
-    if (broadcasted != NULL) {
-        NDArray_FREE(broadcasted);
-    }
-    return result;
+    return NDArray_BinaryOperation(nda, ndb, NDARRAY_BINARY_LESS_EQUAL);
 }
 
 /**
@@ -376,96 +107,7 @@ NDArray_LessEqual(NDArray* nda, NDArray* ndb) {
  */
 NDArray*
 NDArray_GreaterEqual(NDArray* nda, NDArray* ndb) {
-    NDArray *a_temp = NULL, *b_temp = NULL;
-    if ((NDArray_DEVICE(nda) != NDArray_DEVICE(ndb)) && NDArray_NDIM(nda) != 0 && NDArray_NDIM(ndb) != 0) {
-        zend_throw_error(NULL, "Devices mismatch in `equal` function");
-        return NULL;
-    }
-
-    // If a or b are scalars, reshape
-    if (NDArray_NDIM(nda) == 0 && NDArray_NDIM(ndb) > 0) {
-        a_temp = nda;
-        int *n_shape = emalloc(sizeof(int) * NDArray_NDIM(ndb));
-        copy(NDArray_SHAPE(ndb), n_shape, NDArray_NDIM(ndb));
-        nda = NDArray_Zeros(n_shape, NDArray_NDIM(ndb), NDArray_TYPE(ndb), NDArray_DEVICE(ndb));
-        nda = NDArray_Fill(nda, NDArray_FDATA(a_temp)[0]);
-    } else if (NDArray_NDIM(ndb) == 0 && NDArray_NDIM(nda) > 0) {
-        b_temp = ndb;
-        int *n_shape = emalloc(sizeof(int) * NDArray_NDIM(nda));
-        copy(NDArray_SHAPE(nda), n_shape, NDArray_NDIM(nda));
-        ndb = NDArray_Zeros(n_shape, NDArray_NDIM(nda), NDArray_TYPE(nda), NDArray_DEVICE(nda));
-        ndb = NDArray_Fill(ndb, NDArray_FDATA(b_temp)[0]);
-    }
-
-    int i;
-    int *rtn_shape = emalloc(sizeof(int) * NDArray_NDIM(nda));
-
-    for (i = 0; i < NDArray_NDIM(nda); i++) {
-        rtn_shape[i] = NDArray_SHAPE(nda)[i];
-    }
-
-    NDArray *broadcasted = NULL;
-    NDArray *a_broad = NULL, *b_broad = NULL;
-
-    if (NDArray_NUMELEMENTS(nda) < NDArray_NUMELEMENTS(ndb)) {
-        broadcasted = NDArray_Broadcast(nda, ndb);
-        a_broad = broadcasted;
-        b_broad = ndb;
-    } else if (NDArray_NUMELEMENTS(ndb) < NDArray_NUMELEMENTS(nda)) {
-        broadcasted = NDArray_Broadcast(ndb, nda);
-        b_broad = broadcasted;
-        a_broad = nda;
-    } else {
-        b_broad = ndb;
-        a_broad = nda;
-    }
-
-    NDArray *result = NDArray_Empty(rtn_shape, NDArray_NDIM(a_broad), NDArray_TYPE(a_broad), NDArray_DEVICE(a_broad));
-
-    if (NDArray_DEVICE(a_broad) == NDARRAY_DEVICE_GPU) {
-#ifdef HAVE_CUBLAS
-        cuda_float_compare_greater_equal(NDArray_SHAPE(a_broad)[0], NDArray_FDATA(a_broad), NDArray_FDATA(b_broad), NDArray_FDATA(result),
-                                         NDArray_NUMELEMENTS(b_broad));
-#endif
-    } else {
-#ifdef HAVE_AVX2
-        // Process 8 elements at a time using AVX2
-        i = 0;
-        for (; i < NDArray_NUMELEMENTS(a_broad) - 7; i += 8) {
-            // Load 8 elements from each array
-            __m256 vec1 = _mm256_loadu_ps(&NDArray_FDATA(a_broad)[i]);
-            __m256 vec2 = _mm256_loadu_ps(&NDArray_FDATA(b_broad)[i]);
-
-            // Compare elements for equality
-            __m256 cmp = _mm256_cmp_ps(vec1, vec2, _CMP_GE_OS);
-
-            // Convert comparison results to float (1.0 for true, 0.0 for false)
-            __m256 resultVec = _mm256_and_ps(cmp, _mm256_set1_ps(1.0f));
-
-            // Store the results
-            _mm256_storeu_ps(&NDArray_FDATA(result)[i], resultVec);
-        }
-
-        // Process remaining elements using scalar operations
-        for (; i < NDArray_NUMELEMENTS(a_broad); i++) {
-            NDArray_FDATA(result)[i] = NDArray_FDATA(a_broad)[i] >= NDArray_FDATA(b_broad)[i] ? 1.0f : 0.0f;
-        }
-#else
-        for (i = 0; i < NDArray_NUMELEMENTS(a_broad); i++) {
-            NDArray_FDATA(result)[i] = NDArray_FDATA(a_broad)[i] >= NDArray_FDATA(b_broad)[i] ? 1.0f : 0.0f;
-        }
-#endif
-    }
-    if (a_temp != NULL) {
-        NDArray_FREE(nda);
-    }
-    if (b_temp != NULL) {
-        NDArray_FREE(ndb);
-    }
-    if (broadcasted != NULL) {
-        NDArray_FREE(broadcasted);
-    }
-    return result;
+    return NDArray_BinaryOperation(nda, ndb, NDARRAY_BINARY_GREATER_EQUAL);
 }
 
 /**
@@ -477,96 +119,7 @@ NDArray_GreaterEqual(NDArray* nda, NDArray* ndb) {
  */
 NDArray*
 NDArray_Equal(NDArray* nda, NDArray* ndb) {
-    NDArray *a_temp = NULL, *b_temp = NULL;
-    if ((NDArray_DEVICE(nda) != NDArray_DEVICE(ndb)) && NDArray_NDIM(nda) != 0 && NDArray_NDIM(ndb) != 0) {
-        zend_throw_error(NULL, "Devices mismatch in `equal` function");
-        return NULL;
-    }
-
-    // If a or b are scalars, reshape
-    if (NDArray_NDIM(nda) == 0 && NDArray_NDIM(ndb) > 0) {
-        a_temp = nda;
-        int *n_shape = emalloc(sizeof(int) * NDArray_NDIM(ndb));
-        copy(NDArray_SHAPE(ndb), n_shape, NDArray_NDIM(ndb));
-        nda = NDArray_Zeros(n_shape, NDArray_NDIM(ndb), NDArray_TYPE(ndb), NDArray_DEVICE(ndb));
-        nda = NDArray_Fill(nda, NDArray_FDATA(a_temp)[0]);
-    } else if (NDArray_NDIM(ndb) == 0 && NDArray_NDIM(nda) > 0) {
-        b_temp = ndb;
-        int *n_shape = emalloc(sizeof(int) * NDArray_NDIM(nda));
-        copy(NDArray_SHAPE(nda), n_shape, NDArray_NDIM(nda));
-        ndb = NDArray_Zeros(n_shape, NDArray_NDIM(nda), NDArray_TYPE(nda), NDArray_DEVICE(nda));
-        ndb = NDArray_Fill(ndb, NDArray_FDATA(b_temp)[0]);
-    }
-
-    int i;
-    int *rtn_shape = emalloc(sizeof(int) * NDArray_NDIM(nda));
-
-    for (i = 0; i < NDArray_NDIM(nda); i++) {
-        rtn_shape[i] = NDArray_SHAPE(nda)[i];
-    }
-
-    NDArray *broadcasted = NULL;
-    NDArray *a_broad = NULL, *b_broad = NULL;
-
-    if (NDArray_NUMELEMENTS(nda) < NDArray_NUMELEMENTS(ndb)) {
-        broadcasted = NDArray_Broadcast(nda, ndb);
-        a_broad = broadcasted;
-        b_broad = ndb;
-    } else if (NDArray_NUMELEMENTS(ndb) < NDArray_NUMELEMENTS(nda)) {
-        broadcasted = NDArray_Broadcast(ndb, nda);
-        b_broad = broadcasted;
-        a_broad = nda;
-    } else {
-        b_broad = ndb;
-        a_broad = nda;
-    }
-
-    NDArray *result = NDArray_Empty(rtn_shape, NDArray_NDIM(a_broad), NDArray_TYPE(a_broad), NDArray_DEVICE(a_broad));
-
-    if (NDArray_DEVICE(a_broad) == NDARRAY_DEVICE_GPU) {
-#ifdef HAVE_CUBLAS
-        cuda_float_compare_equal(NDArray_SHAPE(a_broad)[0], NDArray_FDATA(a_broad), NDArray_FDATA(b_broad), NDArray_FDATA(result),
-                                 NDArray_NUMELEMENTS(a_broad));
-#endif
-    } else {
-#if HAVE_AVX2
-        // Process 8 elements at a time using AVX2
-        i = 0;
-        for (; i < NDArray_NUMELEMENTS(nda) - 7; i += 8) {
-            // Load 8 elements from each array
-            __m256 vec1 = _mm256_loadu_ps(&NDArray_FDATA(nda)[i]);
-            __m256 vec2 = _mm256_loadu_ps(&NDArray_FDATA(ndb)[i]);
-
-            // Compare elements for equality
-            __m256 cmp = _mm256_cmp_ps(vec1, vec2, _CMP_EQ_OQ);
-
-            // Convert comparison results to float (1.0 for true, 0.0 for false)
-            __m256 resultVec = _mm256_and_ps(cmp, _mm256_set1_ps(1.0f));
-
-            // Store the results
-            _mm256_storeu_ps(&NDArray_FDATA(result)[i], resultVec);
-        }
-
-        // Process remaining elements using scalar operations
-        for (; i < NDArray_NUMELEMENTS(nda); i++) {
-            NDArray_FDATA(result)[i] = (fabsf(NDArray_FDATA(nda)[i] - NDArray_FDATA(ndb)[i]) <= 0.0000001f) ? 1.0f : 0.0f;
-        }
-#else
-        for (i = 0; i < NDArray_NUMELEMENTS(nda); i++) {
-            NDArray_FDATA(result)[i] = (fabsf(NDArray_FDATA(nda)[i] - NDArray_FDATA(ndb)[i]) <= 0.0000001f) ? 1.0f : 0.0f;
-        }
-#endif
-    }
-    if (a_temp != NULL) {
-        NDArray_FREE(nda);
-    }
-    if (b_temp != NULL) {
-        NDArray_FREE(ndb);
-    }
-    if (broadcasted != NULL) {
-        NDArray_FREE(broadcasted);
-    }
-    return result;
+    return NDArray_BinaryOperation(nda, ndb, NDARRAY_BINARY_EQUAL);
 }
 
 /**
@@ -578,96 +131,7 @@ NDArray_Equal(NDArray* nda, NDArray* ndb) {
  */
 NDArray*
 NDArray_NotEqual(NDArray* nda, NDArray* ndb) {
-    NDArray *a_temp = NULL, *b_temp = NULL;
-    if ((NDArray_DEVICE(nda) != NDArray_DEVICE(ndb)) && NDArray_NDIM(nda) != 0 && NDArray_NDIM(ndb) != 0) {
-        zend_throw_error(NULL, "Devices mismatch in `equal` function");
-        return NULL;
-    }
-
-    // If a or b are scalars, reshape
-    if (NDArray_NDIM(nda) == 0 && NDArray_NDIM(ndb) > 0) {
-        a_temp = nda;
-        int *n_shape = emalloc(sizeof(int) * NDArray_NDIM(ndb));
-        copy(NDArray_SHAPE(ndb), n_shape, NDArray_NDIM(ndb));
-        nda = NDArray_Zeros(n_shape, NDArray_NDIM(ndb), NDArray_TYPE(ndb), NDArray_DEVICE(ndb));
-        nda = NDArray_Fill(nda, NDArray_FDATA(a_temp)[0]);
-    } else if (NDArray_NDIM(ndb) == 0 && NDArray_NDIM(nda) > 0) {
-        b_temp = ndb;
-        int *n_shape = emalloc(sizeof(int) * NDArray_NDIM(nda));
-        copy(NDArray_SHAPE(nda), n_shape, NDArray_NDIM(nda));
-        ndb = NDArray_Zeros(n_shape, NDArray_NDIM(nda), NDArray_TYPE(nda), NDArray_DEVICE(nda));
-        ndb = NDArray_Fill(ndb, NDArray_FDATA(b_temp)[0]);
-    }
-
-    int i;
-    int *rtn_shape = emalloc(sizeof(int) * NDArray_NDIM(nda));
-
-    for (i = 0; i < NDArray_NDIM(nda); i++) {
-        rtn_shape[i] = NDArray_SHAPE(nda)[i];
-    }
-
-    NDArray *broadcasted = NULL;
-    NDArray *a_broad = NULL, *b_broad = NULL;
-
-    if (NDArray_NUMELEMENTS(nda) < NDArray_NUMELEMENTS(ndb)) {
-        broadcasted = NDArray_Broadcast(nda, ndb);
-        a_broad = broadcasted;
-        b_broad = ndb;
-    } else if (NDArray_NUMELEMENTS(ndb) < NDArray_NUMELEMENTS(nda)) {
-        broadcasted = NDArray_Broadcast(ndb, nda);
-        b_broad = broadcasted;
-        a_broad = nda;
-    } else {
-        b_broad = ndb;
-        a_broad = nda;
-    }
-
-    NDArray *result = NDArray_Empty(rtn_shape, NDArray_NDIM(a_broad), NDArray_TYPE(a_broad), NDArray_DEVICE(a_broad));
-
-    if (NDArray_DEVICE(a_broad) == NDARRAY_DEVICE_GPU) {
-#ifdef HAVE_CUBLAS
-        cuda_float_compare_not_equal(NDArray_SHAPE(a_broad)[0], NDArray_FDATA(a_broad), NDArray_FDATA(b_broad), NDArray_FDATA(result),
-                                     NDArray_NUMELEMENTS(a_broad));
-#endif
-    } else {
-#if HAVE_AVX2
-        // Process 8 elements at a time using AVX2
-        i = 0;
-        for (; i < NDArray_NUMELEMENTS(a_broad) - 7; i += 8) {
-            // Load 8 elements from each array
-            __m256 vec1 = _mm256_loadu_ps(&NDArray_FDATA(a_broad)[i]);
-            __m256 vec2 = _mm256_loadu_ps(&NDArray_FDATA(b_broad)[i]);
-
-            // Compare elements for equality
-            __m256 cmp = _mm256_cmp_ps(vec1, vec2, _CMP_NEQ_OQ);
-
-            // Convert comparison results to float (1.0 for true, 0.0 for false)
-            __m256 resultVec = _mm256_and_ps(cmp, _mm256_set1_ps(1.0f));
-
-            // Store the results
-            _mm256_storeu_ps(&NDArray_FDATA(result)[i], resultVec);
-        }
-
-        // Process remaining elements using scalar operations
-        for (; i < NDArray_NUMELEMENTS(a_broad); i++) {
-            NDArray_FDATA(result)[i] = (fabsf(NDArray_FDATA(a_broad)[i] - NDArray_FDATA(b_broad)[i]) <= 0.0000001f) ? 0.0f : 1.0f;
-        }
-#else
-        for (i = 0; i < NDArray_NUMELEMENTS(nda); i++) {
-            NDArray_FDATA(result)[i] = (fabsf(NDArray_FDATA(nda)[i] - NDArray_FDATA(ndb)[i]) <= 0.0000001f) ? 0.0f : 1.0f;
-        }
-#endif
-    }
-    if (a_temp != NULL) {
-        NDArray_FREE(nda);
-    }
-    if (b_temp != NULL) {
-        NDArray_FREE(ndb);
-    }
-    if (broadcasted != NULL) {
-        NDArray_FREE(broadcasted);
-    }
-    return result;
+    return NDArray_BinaryOperation(nda, ndb, NDARRAY_BINARY_NOT_EQUAL);
 }
 
 /**
@@ -715,27 +179,44 @@ NDArray_ArrayEqual(NDArray *a, NDArray *b) {
     return compare_ndarrays(a, b);
 }
 
-int
-float_allclose(float* arr1, float* arr2, const int* shape,
-               const int* strides_a, const int* strided_b,
-               int ndim, float atol, float rtol) {
-    int totalElements = 1;
-    for (int i = 0; i < ndim; i++) {
-        totalElements *= shape[i];
-    }
-    unsigned long index_a, index_b;
-    for (int i = 0; i < totalElements; i++) {
-        index_a = (i * sizeof(float)) + (i * strides_a[0]/sizeof(float));
-        index_b = (i * sizeof(float)) + (i * strided_b[0]/sizeof(float));
-        float diff = fabsf(arr1[(int)index_a] - arr2[(int)index_b]);
-        float tolerance = atol + rtol * fabsf(arr2[(int)index_b]);
+/**
+ * 1 if |a - b| <= atol + rtol * |b| for the `n` contiguous elements
+ */
+static int
+float_allclose(const float *a, const float *b, long n, float atol, float rtol) {
+    long i;
+    for (i = 0; i < n; i++) {
+        float diff = fabsf(a[i] - b[i]);
+        float tolerance = atol + rtol * fabsf(b[i]);
         if (diff > tolerance) {
-            return false;
+            return 0;
         }
     }
+    return 1;
+}
 
-    return true;
+#ifdef HAVE_AVX512F
+static NDARRAY_TARGET_AVX512F int
+float_allclose_avx512f(const float *a, const float *b, long n, float atol, float rtol) {
+    const __m512 vatol = _mm512_set1_ps(atol), vrtol = _mm512_set1_ps(rtol);
+    __mmask16 m = 0xFFFF;
+    long i;
+    for (i = 0; i < n; i += 16) {
+        if (n - i < 16) {
+            m = (__mmask16) ((1u << (n - i)) - 1);
+        }
+        __m512 va = _mm512_maskz_loadu_ps(m, a + i);
+        __m512 vb = _mm512_maskz_loadu_ps(m, b + i);
+        __m512 diff = _mm512_abs_ps(_mm512_sub_ps(va, vb));
+        // No FMA, so the tolerance rounds exactly like float_allclose
+        __m512 tolerance = _mm512_add_ps(vatol, _mm512_mul_ps(vrtol, _mm512_abs_ps(vb)));
+        if (_mm512_mask_cmp_ps_mask(m, diff, tolerance, _CMP_GT_OQ)) {
+            return 0;
+        }
+    }
+    return 1;
 }
+#endif
 
 /**
  * NDArray::allclose
@@ -751,6 +232,7 @@ NDArray_AllClose(NDArray* a, NDArray *b, float rtol, float atol) {
     if (NDArray_DEVICE(a) == NDARRAY_DEVICE_GPU || NDArray_DEVICE(b) == NDARRAY_DEVICE_GPU)
     {
         zend_throw_error(NULL, "`allclose` is not compatible with GPU operations.");
+        return -1;
     }
 
     if (NDArray_ShapeCompare(a, b) == 0) {
@@ -764,9 +246,12 @@ NDArray_AllClose(NDArray* a, NDArray *b, float rtol, float atol) {
     }
 
     if (NDArray_DEVICE(a) == NDARRAY_DEVICE_CPU) {
-        return float_allclose(NDArray_FDATA(a), NDArray_FDATA(b), NDArray_SHAPE(a),
-                              NDArray_STRIDES(a), NDArray_STRIDES(b),
-                              NDArray_NDIM(a), atol, rtol);
+#ifdef HAVE_AVX512F
+        if (NDArray_CPU_Level() >= NDARRAY_CPU_AVX512F) {
+            return float_allclose_avx512f(NDArray_FDATA(a), NDArray_FDATA(b), NDArray_NUMELEMENTS(a), atol, rtol);
+        }
+#endif
+        return float_allclose(NDArray_FDATA(a), NDArray_FDATA(b), NDArray_NUMELEMENTS(a), atol, rtol);
     }
     return -1;
 }
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include "iterators.h"
 #include "indexing.h"
 #include "debug.h"
+#include "threadpool.h"
 
 #ifdef HAVE_CUBLAS
 #include <cuda_runtime.h>
@@ -373,6 +374,44 @@ NDArray_Append(NDArray **arrays, int axis, int num_arrays) {
     return output;
 }
 
+typedef struct {
+    const char *src;
+    char *dst;
+    int ndim;
+    const int *shape;
+    const int *strides;
+    int elsize;
+} contiguous_copy_ctx;
+
+/**
+ * Copy elements [start, end), in C order, of a strided array into a
+ * contiguous buffer
+ */
+static void
+contiguous_copy_range(long start, long end, void *ctx) {
+    const contiguous_copy_ctx *c = ctx;
+    int coords[NDARRAY_MAX_DIMS];
+    long rem = start, offset = 0, i;
+    int d;
+
+    for (d = c->ndim - 1; d >= 0; d--) {
+        coords[d] = (int) (rem % c->shape[d]);
+        rem /= c->shape[d];
+        offset += (long) coords[d] * c->strides[d];
+    }
+    for (i = start; i < end; i++) {
+        memcpy(c->dst + i * c->elsize, c->src + offset, c->elsize);
+        for (d = c->ndim - 1; d >= 0; d--) {
+            offset += c->strides[d];
+            if (++coords[d] < c->shape[d]) {
+                break;
+            }
+            offset -= (long) c->strides[d] * c->shape[d];
+            coords[d] = 0;
+        }
+    }
+}
+
 /**
  * @param a
  * @return
@@ -380,32 +419,23 @@ NDArray_Append(NDArray **arrays, int axis, int num_arrays) {
 NDArray*
 NDArray_ToContiguous(NDArray *a) {
     NDArray *ret = NDArray_EmptyLike(a);
-    efree(ret->strides);
-    ret->strides = Generate_Strides(NDArray_SHAPE(a), NDArray_NDIM(a), NDArray_ELSIZE(a));
-
-    int index;
-    int elsize = NDArray_ELSIZE(a);
-    int ret_size = NDArray_NUMELEMENTS(ret);
-    int a_size = NDArray_NUMELEMENTS(a);
-
-    int ncopies = (ret_size / a_size);
-
-    NDArrayIter *a_it = NDArray_NewElementWiseIter(a);
-    NDArrayIter *ret_it = NDArray_NewElementWiseIter(ret);
 
     if (NDArray_DEVICE(a) == NDARRAY_DEVICE_CPU) {
-        while (ncopies--) {
-            index = a_size;
-            while (index--) {
-                memmove(ret_it->dataptr, a_it->dataptr, elsize);
-                NDArray_ITER_NEXT(a_it);
-                NDArray_ITER_NEXT(ret_it);
-            }
-            NDArray_ITER_RESET(a_it);
-        }
+        contiguous_copy_ctx ctx = {
+            NDArray_DATA(a), NDArray_DATA(ret), NDArray_NDIM(a),
+            NDArray_SHAPE(a), NDArray_STRIDES(a), NDArray_ELSIZE(a)
+        };
+        NDArray_ParallelFor(NDArray_NUMELEMENTS(a), NDARRAY_PARALLEL_GRAIN, contiguous_copy_range, &ctx);
     }
 #ifdef HAVE_CUBLAS
     if (NDArray_DEVICE(a) == NDARRAY_DEVICE_GPU) {
+        int index;
+        int elsize = NDArray_ELSIZE(a);
+        int ret_size = NDArray_NUMELEMENTS(ret);
+        int a_size = NDArray_NUMELEMENTS(a);
+        int ncopies = (ret_size / a_size);
+        NDArrayIter *a_it = NDArray_NewElementWiseIter(a);
+        NDArrayIter *ret_it = NDArray_NewElementWiseIter(ret);
         while (ncopies--) {
             index = a_size;
             while (index--) {
@@ -415,10 +445,10 @@ NDArray_ToContiguous(NDArray *a) {
             }
             NDArray_ITER_RESET(a_it);
         }
+        efree(a_it);
+        efree(ret_it);
     }
 #endif
-    efree(a_it);
-    efree(ret_it);
     return ret;
 }
 
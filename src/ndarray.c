@@ -4,6 +4,10 @@
 #include "iterators.h"
 #include "initializers.h"
 #include "types.h"
+#include "ndmath/simd_math.h"
+#include "cpu.h"
+#include "threadpool.h"
+#include "cpu_alloc.h"
 #include <php.h>
 #include "../config.h"
 #include "Zend/zend_alloc.h"
@@ -171,18 +175,15 @@ NDArray_FromGD(zval *a, bool channel_last) {
     return rtn;
 }
 
-void
-NDArray_ToGD(NDArray *a, NDArray *n_alpha, zval *output) {
-    if (NDArray_NDIM(a) != 3 || NDArray_SHAPE(a)[0] != 3) {
-        zend_throw_error(NULL, "Incompatible shape for image");
-        return;
-    }
+#ifdef HAVE_AVX2
+/**
+ * AVX2 body of NDArray_ToGD, packs 8 pixels at a time
+ */
+static NDARRAY_TARGET_AVX2 void
+ndarray_to_gd_avx2(NDArray *a, NDArray *n_alpha, gdImagePtr im) {
     int color_index, i, j;
     int offset_green, offset_red, offset_blue, offset_alpha;
     int red, green, blue, alpha;
-    gdImagePtr im = gdImageCreateTrueColor_(NDArray_SHAPE(a)[2], NDArray_SHAPE(a)[1]);
-
-#ifdef HAVE_AVX2
     __m256i alpha_values;
     int elsize = NDArray_ELSIZE(a);
     __m256i alpha_mask = _mm256_set_epi32(0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF);
@@ -252,7 +253,27 @@ NDArray_ToGD(NDArray *a, NDArray *n_alpha, zval *output) {
             im->tpixels[i][j] = color_index;
         }
     }
-#else
+}
+#endif
+
+void
+NDArray_ToGD(NDArray *a, NDArray *n_alpha, zval *output) {
+    if (NDArray_NDIM(a) != 3 || NDArray_SHAPE(a)[0] != 3) {
+        zend_throw_error(NULL, "Incompatible shape for image");
+        return;
+    }
+    int color_index, i, j;
+    int offset_green, offset_red, offset_blue, offset_alpha;
+    int red, green, blue, alpha;
+    gdImagePtr im = gdImageCreateTrueColor_(NDArray_SHAPE(a)[2], NDArray_SHAPE(a)[1]);
+
+#ifdef HAVE_AVX2
+    if (NDArray_CPU_Level() >= NDARRAY_CPU_AVX2) {
+        ndarray_to_gd_avx2(a, n_alpha, im);
+        php_gd_assign_libgdimageptr_as_extgdimage(output, im);
+        return;
+    }
+#endif
     for (int i = 0; i < im->sy; i++) {
         for (int j = 0; j < im->sx; j++) {
             offset_alpha = (NDArray_STRIDES(a)[0]/ NDArray_ELSIZE(a) * i) +
@@ -278,7 +299,6 @@ NDArray_ToGD(NDArray *a, NDArray *n_alpha, zval *output) {
             im->tpixels[i][j] = color_index;
         }
     }
-#endif
     php_gd_assign_libgdimageptr_as_extgdimage(output, im);
 }
 
@@ -597,19 +617,27 @@ NDArray_FREE(NDArray *array) {
 
     // If the reference count reaches zero, free the memory
     if (array->refcount == 0) {
-        if (array->iterator != NULL) {
-            NDArrayIterator_FREE(array);
+        // Fields inside the header allocation go away with it
+        if (array->iterator != NULL && !NDArray_HEADER_OWNS(array, array->iterator)) {
+            efree(array->iterator);
         }
 
-        if (array->strides != NULL) {
+        if (array->php_iterator != NULL && !NDArray_HEADER_OWNS(array, array->php_iterator)) {
+            efree(array->php_iterator);
+        }
+
+        if (array->strides != NULL && !NDArray_HEADER_OWNS(array, array->strides)) {
             efree(array->strides);
         }
 
-        if (array->dimensions != NULL) {
+        if (array->dimensions != NULL && !NDArray_HEADER_OWNS(array, array->dimensions)) {
             efree(array->dimensions);
         }
 
-        if (array->data != NULL && array->base == NULL && array->descriptor->numElements > 0) {
+        if (array->data != NULL && array->base == NULL && NDArray_CHKFLAGS(array, NDARRAY_ARRAY_POOLED)) {
+            NDArray_DataFree(array->data);
+        } else if (array->data != NULL && array->base == NULL && array->descriptor->numElements > 0 &&
+            !NDArray_HEADER_OWNS(array, array->data)) {
             if (NDArray_DEVICE(array) == NDARRAY_DEVICE_CPU) {
                 efree(array->data);
             } else {
@@ -622,7 +650,7 @@ NDArray_FREE(NDArray *array) {
             NDArray_FREE(array->base);
         }
 
-        if (array->descriptor != NULL) {
+        if (array->descriptor != NULL && !NDArray_HEADER_OWNS(array, array->descriptor)) {
             efree(array->descriptor);
         }
         array->refcount = -1;
@@ -639,6 +667,16 @@ NDArray_FREE(NDArray *array) {
  */
 void
 NDArray_FREEDATA(NDArray *target) {
+    if (NDArray_CHKFLAGS(target, NDARRAY_ARRAY_POOLED)) {
+        NDArray_DataFree(target->data);
+        NDArray_CLEARFLAGS(target, NDARRAY_ARRAY_ALIGNED | NDARRAY_ARRAY_POOLED);
+        target->data = NULL;
+        return;
+    }
+    if (NDArray_HEADER_OWNS(target, target->data)) {
+        target->data = NULL;
+        return;
+    }
     if (NDArray_DEVICE(target) == NDARRAY_DEVICE_CPU) {
         efree(target->data);
     }
@@ -676,19 +714,217 @@ NDArray_Print(NDArray *array, int do_return) {
     return str;
 }
 
+/**
+ * Check if the array data is laid out in C order without gaps
+ *
+ * @param a
+ * @return
+ */
+int
+NDArray_IsContiguous(const NDArray *a) {
+    int i;
+    long expected = NDArray_ELSIZE(a);
+    for (i = NDArray_NDIM(a) - 1; i >= 0; i--) {
+        if (NDArray_SHAPE(a)[i] != 1 && NDArray_STRIDES(a)[i] != expected) {
+            return 0;
+        }
+        expected *= NDArray_SHAPE(a)[i];
+    }
+    return 1;
+}
+
+/**
+ * Check if `out` can receive the result of an operation with
+ * the given shape and device. Raises an error if it can't.
+ *
+ * @param out
+ * @param ndim
+ * @param shape
+ * @param device
+ * @return 1 if `out` is valid, 0 otherwise
+ */
+int
+NDArray_CheckOutput(NDArray *out, int ndim, const int *shape, int device) {
+    if (NDArray_DEVICE(out) != device) {
+        zend_throw_error(NULL, "`out` must be on the same device as the operands.");
+        return 0;
+    }
+    if (NDArray_NDIM(out) != ndim || !NDArray_CompareLists(NDArray_SHAPE(out), shape, ndim)) {
+        zend_throw_error(NULL, "`out` shape does not match the result shape.");
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * Validate `out` for a map over `array` or allocate a new result
+ *
+ * @param array
+ * @param out
+ * @return
+ */
+static NDArray *
+map_output(NDArray *array, NDArray *out) {
+    if (out == NULL) {
+        return NDArray_EmptyLike(array);
+    }
+    if (!NDArray_CheckOutput(out, NDArray_NDIM(array), NDArray_SHAPE(array), NDArray_DEVICE(array))) {
+        return NULL;
+    }
+    if (!NDArray_IsContiguous(out)) {
+        zend_throw_error(NULL, "`out` must be a contiguous array.");
+        return NULL;
+    }
+    return out;
+}
+
+/**
+ * Whether a map writing `out` while reading `in`, both contiguous
+ * buffers of `n` floats, could read an element after it was overwritten.
+ * Writing over the exact same elements is safe.
+ *
+ * @param in
+ * @param out
+ * @param n
+ * @return
+ */
+static int
+map_overlaps(const float *in, const float *out, long n) {
+    return in != out && in < out + n && out < in + n;
+}
+
+/**
+ * Copy a map computed into a temporary because `out` partly overlapped
+ * its input, then release the temporary
+ *
+ * @param tmp
+ * @param out
+ * @return `out`
+ */
+static NDArray *
+map_copy_back(NDArray *tmp, NDArray *out) {
+    if (tmp == NULL) {
+        return NULL;
+    }
+    memcpy(NDArray_FDATA(out), NDArray_FDATA(tmp), sizeof(float) * NDArray_NUMELEMENTS(out));
+    NDArray_FREE(tmp);
+    return out;
+}
+
+typedef struct {
+    const float *in;
+    const float *in2;
+    float *out;
+    float val1;
+    float val2;
+    ElementWiseDoubleOperation op;
+    ElementWiseFloatOperation1F op1;
+    ElementWiseFloatOperation2F op2;
+    NDArray_VectorKernel kernel;
+    NDArray_VectorKernel2F kernel2;
+} map_ctx;
+
+static void
+map_range(long start, long end, void *ctx) {
+    const map_ctx *c = ctx;
+    long i;
+    if (c->kernel != NULL) {
+        c->kernel(c->in + start, c->out + start, end - start);
+        return;
+    }
+    for (i = start; i < end; i++) {
+        c->out[i] = c->op(c->in[i]);
+    }
+}
+
+static void
+map1f_range(long start, long end, void *ctx) {
+    const map_ctx *c = ctx;
+    long i;
+    for (i = start; i < end; i++) {
+        c->out[i] = c->op1(c->in[i], c->val1);
+    }
+}
+
+static void
+map1nd_range(long start, long end, void *ctx) {
+    const map_ctx *c = ctx;
+    long i;
+    for (i = start; i < end; i++) {
+        c->out[i] = c->op1(c->in[i], c->in2[i]);
+    }
+}
+
+static void
+map2f_range(long start, long end, void *ctx) {
+    const map_ctx *c = ctx;
+    long i;
+    if (c->kernel2 != NULL) {
+        c->kernel2(c->in + start, c->out + start, end - start, c->val1, c->val2);
+        return;
+    }
+    for (i = start; i < end; i++) {
+        c->out[i] = c->op2(c->in[i], c->val1, c->val2);
+    }
+}
+
+/**
+ * Maps run on the thread pool once the array is larger than the parallel
+ * threshold, each thread handling cache-sized chunks of the buffer.
+ *
+ * @param array
+ * @param op
+ * @param out Optional output array, may be `array` itself
+ */
+NDArray *
+NDArray_MapOut(NDArray *array, ElementWiseDoubleOperation op, NDArray *out) {
+    map_ctx ctx = {0};
+    NDArray *rtn = map_output(array, out);
+    if (rtn == NULL) {
+        return NULL;
+    }
+    if (out != NULL && map_overlaps(NDArray_FDATA(array), NDArray_FDATA(out), NDArray_NUMELEMENTS(array))) {
+        // Partial overlap, compute into a temporary first
+        return map_copy_back(NDArray_MapOut(array, op, NULL), out);
+    }
+    ctx.in = NDArray_FDATA(array);
+    ctx.out = NDArray_FDATA(rtn);
+    ctx.op = op;
+    ctx.kernel = NDArray_GetVectorKernel(op);
+    NDArray_ParallelFor(NDArray_NUMELEMENTS(array), NDARRAY_PARALLEL_GRAIN, map_range, &ctx);
+    return rtn;
+}
+
 /**
  * @param array
  */
 NDArray *
 NDArray_Map(NDArray *array, ElementWiseDoubleOperation op) {
-    NDArray *rtn;
-    int i;
-    int *new_shape = emalloc(sizeof(int) * NDArray_NDIM(array));
-    memcpy(new_shape, NDArray_SHAPE(array), sizeof(int) * NDArray_NDIM(array));
-    rtn = NDArray_Zeros(new_shape, NDArray_NDIM(array), NDARRAY_TYPE_FLOAT32, NDArray_DEVICE(array));
-    for (i = 0; i < NDArray_NUMELEMENTS(array); i++) {
-        NDArray_FDATA(rtn)[i] = op(NDArray_FDATA(array)[i]);
+    return NDArray_MapOut(array, op, NULL);
+}
+
+/**
+ * @param array
+ * @param op
+ * @param val1
+ * @param out Optional output array, may be `array` itself
+ */
+NDArray *
+NDArray_Map1FOut(NDArray *array, ElementWiseFloatOperation1F op, float val1, NDArray *out) {
+    map_ctx ctx = {0};
+    NDArray *rtn = map_output(array, out);
+    if (rtn == NULL) {
+        return NULL;
+    }
+    if (out != NULL && map_overlaps(NDArray_FDATA(array), NDArray_FDATA(out), NDArray_NUMELEMENTS(array))) {
+        // Partial overlap, compute into a temporary first
+        return map_copy_back(NDArray_Map1FOut(array, op, val1, NULL), out);
     }
+    ctx.in = NDArray_FDATA(array);
+    ctx.out = NDArray_FDATA(rtn);
+    ctx.op1 = op;
+    ctx.val1 = val1;
+    NDArray_ParallelFor(NDArray_NUMELEMENTS(array), NDARRAY_PARALLEL_GRAIN, map1f_range, &ctx);
     return rtn;
 }
 
@@ -697,15 +933,32 @@ NDArray_Map(NDArray *array, ElementWiseDoubleOperation op) {
  */
 NDArray *
 NDArray_Map1F(NDArray *array, ElementWiseFloatOperation1F op, float val1) {
-    NDArray *rtn;
-    int i;
-    int *new_shape = emalloc(sizeof(int) * NDArray_NDIM(array));
-    memcpy(new_shape, NDArray_SHAPE(array), sizeof(int) * NDArray_NDIM(array));
-    rtn = NDArray_Zeros(new_shape, NDArray_NDIM(array), NDARRAY_TYPE_FLOAT32, NDArray_DEVICE(array));
+    return NDArray_Map1FOut(array, op, val1, NULL);
+}
 
-    for (i = 0; i < NDArray_NUMELEMENTS(array); i++) {
-        NDArray_FDATA(rtn)[i] = op(NDArray_FDATA(array)[i], val1);
+/**
+ * @param array
+ * @param op
+ * @param val1
+ * @param out Optional output array, may be `array` itself
+ */
+NDArray *
+NDArray_Map1NDOut(NDArray *array, ElementWiseFloatOperation1F op, NDArray *val1, NDArray *out) {
+    map_ctx ctx = {0};
+    NDArray *rtn = map_output(array, out);
+    if (rtn == NULL) {
+        return NULL;
+    }
+    if (out != NULL && (map_overlaps(NDArray_FDATA(array), NDArray_FDATA(out), NDArray_NUMELEMENTS(array)) ||
+                        map_overlaps(NDArray_FDATA(val1), NDArray_FDATA(out), NDArray_NUMELEMENTS(array)))) {
+        // Partial overlap, compute into a temporary first
+        return map_copy_back(NDArray_Map1NDOut(array, op, val1, NULL), out);
     }
+    ctx.in = NDArray_FDATA(array);
+    ctx.in2 = NDArray_FDATA(val1);
+    ctx.out = NDArray_FDATA(rtn);
+    ctx.op1 = op;
+    NDArray_ParallelFor(NDArray_NUMELEMENTS(array), NDARRAY_PARALLEL_GRAIN, map1nd_range, &ctx);
     return rtn;
 }
 
@@ -714,15 +967,34 @@ NDArray_Map1F(NDArray *array, ElementWiseFloatOperation1F op, float val1) {
  */
 NDArray *
 NDArray_Map1ND(NDArray *array, ElementWiseFloatOperation1F op, NDArray *val1) {
-    NDArray *rtn;
-    int i;
-    int *new_shape = emalloc(sizeof(int) * NDArray_NDIM(array));
-    memcpy(new_shape, NDArray_SHAPE(array), sizeof(int) * NDArray_NDIM(array));
-    rtn = NDArray_Zeros(new_shape, NDArray_NDIM(array), NDARRAY_TYPE_FLOAT32, NDArray_DEVICE(array));
+    return NDArray_Map1NDOut(array, op, val1, NULL);
+}
 
-    for (i = 0; i < NDArray_NUMELEMENTS(array); i++) {
-        NDArray_FDATA(rtn)[i] = op(NDArray_FDATA(array)[i], NDArray_FDATA(val1)[i]);
+/**
+ * @param array
+ * @param op
+ * @param val1
+ * @param val2
+ * @param out Optional output array, may be `array` itself
+ */
+NDArray *
+NDArray_Map2FOut(NDArray *array, ElementWiseFloatOperation2F op, float val1, float val2, NDArray *out) {
+    map_ctx ctx = {0};
+    NDArray *rtn = map_output(array, out);
+    if (rtn == NULL) {
+        return NULL;
     }
+    if (out != NULL && map_overlaps(NDArray_FDATA(array), NDArray_FDATA(out), NDArray_NUMELEMENTS(array))) {
+        // Partial overlap, compute into a temporary first
+        return map_copy_back(NDArray_Map2FOut(array, op, val1, val2, NULL), out);
+    }
+    ctx.in = NDArray_FDATA(array);
+    ctx.out = NDArray_FDATA(rtn);
+    ctx.op2 = op;
+    ctx.val1 = val1;
+    ctx.val2 = val2;
+    ctx.kernel2 = NDArray_GetVectorKernel2F(op);
+    NDArray_ParallelFor(NDArray_NUMELEMENTS(array), NDARRAY_PARALLEL_GRAIN, map2f_range, &ctx);
     return rtn;
 }
 
@@ -731,16 +1003,7 @@ NDArray_Map1ND(NDArray *array, ElementWiseFloatOperation1F op, NDArray *val1) {
  */
 NDArray *
 NDArray_Map2F(NDArray *array, ElementWiseFloatOperation2F op, float val1, float val2) {
-    NDArray *rtn;
-    int i;
-    int *new_shape = emalloc(sizeof(int) * NDArray_NDIM(array));
-    memcpy(new_shape, NDArray_SHAPE(array), sizeof(int) * NDArray_NDIM(array));
-    rtn = NDArray_Zeros(new_shape, NDArray_NDIM(array), NDARRAY_TYPE_FLOAT32, NDArray_DEVICE(array));
-
-    for (i = 0; i < NDArray_NUMELEMENTS(array); i++) {
-        NDArray_FDATA(rtn)[i] = op(NDArray_FDATA(array)[i], val1, val2);
-    }
-    return rtn;
+    return NDArray_Map2FOut(array, op, val1, val2, NULL);
 }
 
 /**
@@ -761,12 +1024,7 @@ NDArray_Min(NDArray *target) {
         return -1.f;
 #endif
     } else {
-        min = array[0];
-        for (int i = 1; i < length; i++) {
-            if (array[i] < min) {
-                min = array[i];
-            }
-        }
+        min = NDArray_FloatMin(array, length);
     }
     return min;
 }
@@ -948,12 +1206,7 @@ NDArray_Max(NDArray *target) {
         return -1.f;
 #endif
     } else {
-        max = array[0];
-        for (int i = 1; i < length; i++) {
-            if (array[i] > max) {
-                max = array[i];
-            }
-        }
+        max = NDArray_FloatMax(array, length);
     }
     return max;
 }
@@ -1049,6 +1302,7 @@ NDArray_ToGPU(NDArray *target) {
     memcpy(new_shape, NDArray_SHAPE(target), sizeof(int) * NDArray_NDIM(target));
 
     NDArray *rtn = NDArray_Zeros(new_shape, n_ndim, NDARRAY_TYPE_FLOAT32, NDArray_DEVICE(target));
+    NDArray_FREEDATA(rtn);
     rtn->device = NDARRAY_DEVICE_GPU;
 
     vmalloc((void **) &tmp_gpu, NDArray_NUMELEMENTS(target) * sizeof(float));
@@ -1058,7 +1312,6 @@ NDArray_ToGPU(NDArray *target) {
         zend_throw_error(NULL, "Error synchronizing: %s\n", cudaGetErrorString(err));
         return NULL;
     }
-    efree(rtn->data);
     rtn->data = (char *) tmp_gpu;
     return rtn;
 #else
@@ -1123,36 +1376,16 @@ NDArray_ShapeCompare(NDArray *a, NDArray *b) {
  */
 int
 NDArray_IsBroadcastable(const NDArray *array1, const NDArray *array2) {
-    if (NDArray_NDIM(array1) == 1 && NDArray_NDIM(array2) > 1) {
-        if (NDArray_SHAPE(array1)[0] == NDArray_SHAPE(array2)[NDArray_NDIM(array2) - 1]) {
-            return 1;
-        } else {
-            return 0;
-        }
-    }
-    if (NDArray_NDIM(array1) > 1 && NDArray_NDIM(array2) == 1) {
-        if (NDArray_SHAPE(array2)[0] == NDArray_SHAPE(array1)[NDArray_NDIM(array1) - 1]) {
-            return 1;
-        } else {
-            return 0;
-        }
-    }
-
-    // Determine the maximum number of dimensions
+    int i, dim1, dim2;
     int maxDims = (NDArray_NDIM(array1) > NDArray_NDIM(array2)) ? NDArray_NDIM(array1) : NDArray_NDIM(array2);
-
-    // Pad the shape arrays with 1s if necessary
-    int paddedShape1[maxDims];
-    int paddedShape2[maxDims];
-
-    for (int i = 0; i < maxDims; i++) {
-        paddedShape1[i] = (i < NDArray_NDIM(array1)) ? NDArray_SHAPE(array1)[i] : 1;
-        paddedShape2[i] = (i < NDArray_NDIM(array2)) ? NDArray_SHAPE(array2)[i] : 1;
-    }
-
-    // Check if the modified arrays are broadcastable
-    for (int i = 0; i < maxDims; i++) {
-        if (paddedShape1[i] != paddedShape2[i] && paddedShape1[i] != 1 && paddedShape2[i] != 1) {
+    int offset1 = maxDims - NDArray_NDIM(array1);
+    int offset2 = maxDims - NDArray_NDIM(array2);
+
+    // Shapes are aligned to the right, missing leading dimensions count as 1
+    for (i = 0; i < maxDims; i++) {
+        dim1 = (i >= offset1) ? NDArray_SHAPE(array1)[i - offset1] : 1;
+        dim2 = (i >= offset2) ? NDArray_SHAPE(array2)[i - offset2] : 1;
+        if (dim1 != dim2 && dim1 != 1 && dim2 != 1) {
             return 0;
         }
     }
@@ -1385,6 +1618,8 @@ NDArray_Load(char * filename)
         return NULL;
     }
     fread(out, sizeof(NDArray), 1, file);
+    out->header_size = 0;
+    NDArray_CLEARFLAGS(out, NDARRAY_ARRAY_ALIGNED | NDARRAY_ARRAY_POOLED);
 
     out->dimensions = emalloc(sizeof(int) * NDArray_NDIM(out));
     out->strides = emalloc(sizeof(int) * NDArray_NDIM(out));
@@ -10,8 +10,11 @@ extern "C" {
 #include <stdbool.h>
 
 #define NDARRAY_MAX_DIMS 128
+#define NDARRAY_MAX_FLOAT_INDEX 16777216  // 2^24, indexes stored in float32 arrays are exact up to it
 #define NDARRAY_ARRAY_C_CONTIGUOUS    0x0001
 #define NDARRAY_ARRAY_F_CONTIGUOUS    0x0002
+#define NDARRAY_ARRAY_ALIGNED         0x0004  // Data starts on a NDARRAY_DATA_ALIGNMENT boundary
+#define NDARRAY_ARRAY_POOLED          0x0008  // Data comes from NDArray_DataAlloc
 
 #define NDARRAY_UNLIKELY(x) (x)
 #define NDArray_DATA(a) ((void *)((a)->data))
@@ -27,6 +30,7 @@ extern "C" {
 #define NDArray_NUMELEMENTS(a) ((long)((a)->descriptor->numElements))
 #define NDArray_ELSIZE(a) ((int)((a)->descriptor->elsize))
 #define NDArray_DEVICE(a) ((int)((a)->device))
+#define NDArray_ISALIGNED(a) (((a)->flags & NDARRAY_ARRAY_ALIGNED) != 0)
 
 #define NDArray_ADDREF(a) ((a)->refcount++)
 #define NDArray_DELREF(a) ((a)->refcount--)
@@ -71,8 +75,16 @@ typedef struct NDArray {
     NDArrayIterator* php_iterator;
     int refcount;
     int device; // NDArray Device   0 = CPU     1 = GPU
+    int header_size;     // Bytes of the allocation holding this header (0 when allocated alone)
 } NDArray;
 
+/*
+ * True when `ptr` lives inside the header allocation of `a` and is
+ * released together with it.
+ */
+#define NDArray_HEADER_OWNS(a, ptr) \
+    ((char *)(ptr) >= (char *)(a) && (char *)(ptr) < (char *)(a) + (a)->header_size)
+
 /*
  * Enables the specified array flags.
  */
@@ -128,6 +140,10 @@ int NDArray_AssignArray(NDArray *dst, NDArray *src);
 int NDArray_CompareLists(int const *l1, int const *l2, int n);
 void NDArray_CreateMultiSortedStridePerm(int narrays, NDArray **arrays, int ndim, int *out_strideperm);
 void NDArray_CreateSortedStridePerm(int ndim, int const *strides, ndarray_stride_sort_item *out_strideperm);
+int NDArray_IsContiguous(const NDArray *a);
+int NDArray_CheckOutput(NDArray *out, int ndim, const int *shape, int device);
+int broadcast_strides(int ndim, int const *shape, int strides_ndim, int const *strides_shape, int const *strides,
+                      char const *strides_name, int *out_strides);
 
 #ifdef __cplusplus
 }
@@ -140,5 +156,9 @@ NDArray* NDArray_Map(NDArray *array, ElementWiseDoubleOperation op);
 NDArray* NDArray_Map2F(NDArray *array, ElementWiseFloatOperation2F op, float val1, float val2);
 NDArray* NDArray_Map1F(NDArray *array, ElementWiseFloatOperation1F op, float val1);
 NDArray * NDArray_Map1ND(NDArray *array, ElementWiseFloatOperation1F op, NDArray *val1);
+NDArray* NDArray_MapOut(NDArray *array, ElementWiseDoubleOperation op, NDArray *out);
+NDArray* NDArray_Map1FOut(NDArray *array, ElementWiseFloatOperation1F op, float val1, NDArray *out);
+NDArray* NDArray_Map2FOut(NDArray *array, ElementWiseFloatOperation2F op, float val1, float val2, NDArray *out);
+NDArray* NDArray_Map1NDOut(NDArray *array, ElementWiseFloatOperation1F op, NDArray *val1, NDArray *out);
 
 #endif //PHPSCI_NDARRAY_NDARRAY_H
@@ -14,5 +14,6 @@ float NDArray_Float_Prod(NDArray* a);
 float NDArray_Mean_Float(NDArray* a);
 float NDArray_Mean_Float_Axis(NDArray* a, NDArray *b);
 NDArray* NDArray_Abs(NDArray *nda);
+NDArray* NDArray_AbsOut(NDArray *nda, NDArray *out);
 float NDArray_Median_Float(NDArray* a);
 #endif //PHPSCI_NDARRAY_ARITHMETICS_H
@@ -1,194 +1,290 @@
 #include <string.h>
+#include <math.h>
 #include "../manipulation.h"
 #include "../initializers.h"
 #include "calculation.h"
+#include "reduction.h"
+#include "simd_math.h"
 #include <Zend/zend.h>
 #include "../../config.h"
 #include "../ndarray.h"
+#include "../types.h"
+#include "../threadpool.h"
 
-static int
-float_argmax(float *ip, int n, float *max_ind)
-{
-    int i;
-    float mp = *ip;
-    *max_ind = 0;
-    if (isnanf(mp)) {
-        /* nan encountered; it's maximal */
+/**
+ * Columns handled together when the reduced axis is not the innermost
+ * one, their best values and indexes stay on the stack
+ */
+#define ARG_COLUMN_BLOCK 256
+
+/**
+ * Iteration space of argmax/argmin along one axis. The kept axes index
+ * the outputs in C order, the reduced axis is walked through its stride
+ * so no transposed copy is made.
+ */
+typedef struct {
+    int is_argmax;
+    int nd;
+    int dims[NDARRAY_MAX_DIMS];
+    int strides[NDARRAY_MAX_DIMS];
+    long m;                 // Length of the reduced axis
+    int axis_stride;
+    long columns;           // Outputs per group, the innermost kept axis when it is contiguous
+    char *in;
+    float *out;
+} arg_ctx;
+
+/**
+ * Index of the first maximum (minimum) of `n` strided elements, or of
+ * the first NaN
+ */
+static long
+arg_row(const char *in, int stride, long n, int is_argmax) {
+    long i, r = 0;
+    float best, x;
+
+    if (stride == sizeof(float)) {
+        return is_argmax ? NDArray_FloatArgMax((const float *) in, n) : NDArray_FloatArgMin((const float *) in, n);
+    }
+    best = *(const float *) in;
+    if (isnan(best)) {
         return 0;
     }
     for (i = 1; i < n; i++) {
-        ip++;
-        /*
-        * Propagate nans, similarly as max() and min()
-        */
-        if (*ip > mp) {  /* negated, for correct nan handling */
-            mp = *ip;
-            *max_ind = (float)i;
-            if (isnanf(mp)) {
-                /* nan encountered, it's maximal */
-                break;
+        x = *(const float *) (in + i * stride);
+        if (is_argmax ? x > best : x < best) {
+            best = x;
+            r = i;
+        } else if (isnan(x)) {
+            return i;
+        }
+    }
+    return r;
+}
+
+/**
+ * Reduce `n` contiguous columns at once, reading the reduced axis one
+ * row at a time
+ */
+static void
+arg_columns(const arg_ctx *c, const char *in, float *out, long n) {
+    float best[ARG_COLUMN_BLOCK], x;
+    long index[ARG_COLUMN_BLOCK];
+    const float *row;
+    long i, k;
+
+    memcpy(best, in, sizeof(float) * n);
+    memset(index, 0, sizeof(long) * n);
+    for (i = 1; i < c->m; i++) {
+        row = (const float *) (in + i * c->axis_stride);
+        for (k = 0; k < n; k++) {
+            x = row[k];
+            // A NaN is kept once found, like the row kernels
+            if (!isnan(best[k]) && ((c->is_argmax ? x > best[k] : x < best[k]) || isnan(x))) {
+                best[k] = x;
+                index[k] = i;
             }
         }
     }
-    return 0;
+    for (k = 0; k < n; k++) {
+        out[k] = (float) index[k];
+    }
 }
 
-static int
-float_argmin(float *ip, int n, float *min_ind)
-{
-    int i;
-    float mp = *ip;
-    *min_ind = 0;
-    if (isnanf(mp)) {
-        /* nan encountered; it's minimal */
-        return 0;
+/**
+ * Compute the groups of outputs belonging to elements [start, end) of
+ * the input
+ */
+static void
+arg_range(long start, long end, void *ctx) {
+    const arg_ctx *c = ctx;
+    long per_group = c->m * c->columns;
+    long lo = (start + per_group - 1) / per_group;
+    long hi = (end + per_group - 1) / per_group;
+    long g, rest, k, len;
+    int d, nd = (c->columns > 1) ? c->nd - 1 : c->nd;
+    char *base;
+
+    for (g = lo; g < hi; g++) {
+        base = c->in;
+        rest = g;
+        for (d = nd - 1; d >= 0; d--) {
+            base += (rest % c->dims[d]) * (long) c->strides[d];
+            rest /= c->dims[d];
+        }
+        if (c->columns == 1) {
+            c->out[g] = (float) arg_row(base, c->axis_stride, c->m, c->is_argmax);
+            continue;
+        }
+        for (k = 0; k < c->columns; k += ARG_COLUMN_BLOCK) {
+            len = (c->columns - k < ARG_COLUMN_BLOCK) ? c->columns - k : ARG_COLUMN_BLOCK;
+            arg_columns(c, base + k * sizeof(float), c->out + g * c->columns + k, len);
+        }
     }
+}
 
-    for (i = 1; i < n; i++) {
-        ip++;
+typedef struct {
+    const float *in;
+    int is_argmax;
+} arg_flat_ctx;
 
-        if (!_LESS_THAN_OR_EQUAL(mp, *ip)) {
-            mp = *ip;
-            *min_ind = (float)i;
-            if (isnanf(mp)) {
-                break;
-            }
+static void
+arg_flat_range(long start, long end, void *ctx, void *partial) {
+    const arg_flat_ctx *c = ctx;
+    if (start >= end) {
+        *(long *) partial = -1;
+        return;
+    }
+    *(long *) partial = start + (c->is_argmax ? NDArray_FloatArgMax(c->in + start, end - start)
+                                              : NDArray_FloatArgMin(c->in + start, end - start));
+}
+
+/**
+ * Index of the first maximum (minimum) of a CPU array in C order, or of
+ * its first NaN. Contiguous data is scanned with the SIMD kernels, in
+ * parallel for large arrays.
+ *
+ * @param a
+ * @param is_argmax
+ * @return the flat index, -1 with an exception set on error
+ */
+long
+NDArray_ArgMinMaxFlat(NDArray *a, bool is_argmax) {
+    long partials[NDARRAY_MAX_CHUNKS];
+    long chunks, i, r, k, n = NDArray_NUMELEMENTS(a);
+    NDArray *contiguous = NULL;
+    arg_flat_ctx ctx;
+    const float *in;
+
+    if (NDArray_DEVICE(a) == NDARRAY_DEVICE_GPU) {
+        zend_throw_error(NULL, "GPU not supported.");
+        return -1;
+    }
+    if (n == 0) {
+        zend_throw_error(NULL, "attempt to get %s of an empty sequence", is_argmax ? "argmax" : "argmin");
+        return -1;
+    }
+    if (!NDArray_IsContiguous(a)) {
+        contiguous = NDArray_ToContiguous(a);
+    }
+    in = NDArray_FDATA(contiguous != NULL ? contiguous : a);
+    ctx.in = in;
+    ctx.is_argmax = is_argmax;
+    chunks = NDArray_ParallelReduce(n, NDARRAY_PARALLEL_GRAIN, arg_flat_range, &ctx, partials, sizeof(long));
+    // Chunks are merged in order, so the first occurrence wins
+    r = partials[0];
+    for (i = 1; i < chunks && !isnan(in[r]); i++) {
+        k = partials[i];
+        if (k >= 0 && (isnan(in[k]) || (is_argmax ? in[k] > in[r] : in[k] < in[r]))) {
+            r = k;
         }
     }
-    return 0;
+    if (contiguous != NULL) {
+        NDArray_FREE(contiguous);
+    }
+    return r;
 }
 
 /**
  * ArgMin and ArgMax common function
  *
- * This work is derived from NumPy
+ * Indexes are computed as integers and stored in a float32 array, so
+ * axes longer than NDARRAY_MAX_FLOAT_INDEX are rejected instead of
+ * returning rounded indexes. Use NDArray_ArgMinMaxFlat for the index
+ * in the whole array.
  *
  * @param op
- * @param axis
- * @param out
+ * @param axis Axis to reduce, NDARRAY_MAX_DIMS for the flattened array
  * @param keepdims
  * @param is_argmax
  * @return
  */
 NDArray *
 NDArray_ArgMinMaxCommon(NDArray *op, int axis, bool keepdims, bool is_argmax) {
+    char reduced[NDARRAY_MAX_DIMS];
+    char *func_name = is_argmax ? "argmax" : "argmin";
+    int i, out_ndim = 0;
+    int *out_shape;
+    long index;
+    arg_ctx ctx;
+    NDArray *rtn;
+
     if (NDArray_DEVICE(op) == NDARRAY_DEVICE_GPU) {
         zend_throw_error(NULL, "GPU not supported.");
         return NULL;
     }
 
-    NDArray *ap = NULL, *rp = NULL;
-    NDArray_ArgFunc* arg_func = NULL;
-    char *ip, *func_name;
-    float *rptr;
-    int i, n, m;
-    int elsize;
-    // Keep a copy because axis changes via call to NDArray_CheckAxis
-    int axis_copy = axis;
-    int *out_shape;
-    // Keep the number of dimensions and shape of
-    // original array. Helps when `keepdims` is True.
-    int* original_op_shape = NDArray_SHAPE(op);
-    int out_ndim = NDArray_NDIM(op);
-
-    if ((ap = (NDArray *)NDArray_CheckAxis(op, &axis, 0)) == NULL) {
-        zend_throw_error(NULL, "Invalid axis parameter");
-        NDArray_FREE(op);
-        return NULL;
-    }
-
-    if (axis != NDArray_NDIM(ap)-1) {
-        NDArray_Dims newaxes;
-        int dims[NDARRAY_MAX_DIMS];
-        int j;
-
-        newaxes.ptr = dims;
-        newaxes.len = NDArray_NDIM(ap);
-        for (j = 0; j < axis; j++) {
-            dims[j] = j;
-        }
-        for (j = axis; j < NDArray_NDIM(ap) - 1; j++) {
-            dims[j] = j + 1;
+    out_shape = emalloc(sizeof(int) * (NDArray_NDIM(op) > 0 ? NDArray_NDIM(op) : 1));
+    out_shape[0] = 1;
+    if (axis == NDARRAY_MAX_DIMS || NDArray_NDIM(op) == 0) {
+        if (NDArray_NUMELEMENTS(op) > NDARRAY_MAX_FLOAT_INDEX) {
+            efree(out_shape);
+            zend_throw_error(NULL, "%s of more than %d elements can't be stored exactly in a float32 array",
+                             func_name, NDARRAY_MAX_FLOAT_INDEX);
+            return NULL;
         }
-        dims[NDArray_NDIM(ap) - 1] = axis;
-        op = NDArray_Transpose(ap, &newaxes);
-        NDArray_FREE(ap);
-        if (op == NULL) {
+        index = NDArray_ArgMinMaxFlat(op, is_argmax);
+        if (index < 0) {
+            efree(out_shape);
             return NULL;
         }
-    }
-    else {
-        op = ap;
-    }
-
-    // Will get native-byte order contiguous copy.
-    NDArrayDescriptor *descr = NDArray_DESCRIPTOR(op);
-    if (descr == NULL) {
-        return NULL;
-    }
-
-    ap = NDArray_FromNDArray(op, 0, NULL, NULL, NULL);
-
-    NDArray_FREE(op);
-    if (ap == NULL) {
-        return NULL;
-    }
-
-    // Decides the shape of the output array.
-    if (!keepdims) {
-        out_ndim = NDArray_NDIM(ap) - 1;
-        out_shape = emalloc(sizeof(int) * NDArray_NDIM(ap));
-        memcpy(out_shape, NDArray_SHAPE(ap), sizeof(int) * NDArray_NDIM(ap));
-    }
-    else {
-        out_shape = emalloc(out_ndim * sizeof(int));
-        if (axis_copy == NDARRAY_MAX_DIMS) {
-            for (i = 0; i < out_ndim; i++) {
+        if (keepdims) {
+            for (i = 0; i < NDArray_NDIM(op); i++) {
                 out_shape[i] = 1;
             }
+            out_ndim = NDArray_NDIM(op);
         }
-        else {
-            memcpy(out_shape, original_op_shape, out_ndim * sizeof(int));
-            out_shape[axis] = 1;
-        }
+        rtn = NDArray_Empty(out_shape, out_ndim, NDARRAY_TYPE_FLOAT32, NDARRAY_DEVICE_CPU);
+        NDArray_FDATA(rtn)[0] = (float) index;
+        return rtn;
     }
 
-    if (is_argmax) {
-        func_name = "argmax";
-        if (NDArray_DEVICE(op) == NDARRAY_DEVICE_CPU) {
-            arg_func = float_argmax;
-        }
+    if (NDArray_ReduceAxes(NDArray_NDIM(op), &axis, 1, reduced) < 0) {
+        efree(out_shape);
+        return NULL;
     }
-    else {
-        func_name = "argmin";
-        if (NDArray_DEVICE(op) == NDARRAY_DEVICE_CPU) {
-            arg_func = float_argmin;
-        }
+    if (axis < 0) {
+        axis += NDArray_NDIM(op);
     }
-
-    elsize = NDArray_ELSIZE(ap);
-    m = NDArray_SHAPE(ap)[NDArray_NDIM(ap)-1];
-    if (m == 0) {
+    ctx.m = NDArray_SHAPE(op)[axis];
+    if (ctx.m == 0) {
+        efree(out_shape);
         zend_throw_error(NULL, "attempt to get %s of an empty sequence", func_name);
-        goto fail;
+        return NULL;
     }
-
-    rp = NDArray_Zeros(out_shape, out_ndim, NDArray_TYPE(ap), NDArray_DEVICE(ap));
-
-    if (rp == NULL) {
-        goto fail;
+    if (ctx.m > NDARRAY_MAX_FLOAT_INDEX) {
+        efree(out_shape);
+        zend_throw_error(NULL, "%s along an axis of more than %d elements can't be stored exactly in a float32 array",
+                         func_name, NDARRAY_MAX_FLOAT_INDEX);
+        return NULL;
     }
 
-    n = NDArray_NUMELEMENTS(ap)/m;
-    rptr = (float*)NDArray_DATA(rp);
-    for (ip = NDArray_DATA(ap), i = 0; i < n; i++, ip += elsize*m) {
-        arg_func((float*)ip, m, rptr);
-        rptr += 1;
+    ctx.nd = 0;
+    for (i = 0; i < NDArray_NDIM(op); i++) {
+        if (i == axis) {
+            if (keepdims) {
+                out_shape[out_ndim++] = 1;
+            }
+            continue;
+        }
+        out_shape[out_ndim++] = NDArray_SHAPE(op)[i];
+        ctx.dims[ctx.nd] = NDArray_SHAPE(op)[i];
+        ctx.strides[ctx.nd++] = NDArray_STRIDES(op)[i];
     }
+    rtn = NDArray_Empty(out_shape, out_ndim, NDARRAY_TYPE_FLOAT32, NDARRAY_DEVICE_CPU);
 
-    NDArray_FREE(ap);
-    return rp;
-fail:
-    zend_throw_error(NULL, "%s fatal error", func_name);
-    return NULL;
+    ctx.is_argmax = is_argmax;
+    ctx.axis_stride = NDArray_STRIDES(op)[axis];
+    ctx.in = NDArray_DATA(op);
+    ctx.out = NDArray_FDATA(rtn);
+    // A contiguous innermost output axis is reduced a block of columns at
+    // a time, otherwise every output scans its own strided row
+    ctx.columns = 1;
+    if (ctx.axis_stride != sizeof(float) && ctx.nd > 0 && ctx.strides[ctx.nd - 1] == sizeof(float)) {
+        ctx.columns = ctx.dims[ctx.nd - 1];
+    }
+    if (NDArray_NUMELEMENTS(rtn) > 0) {
+        NDArray_ParallelFor(NDArray_NUMELEMENTS(rtn) * ctx.m, NDARRAY_PARALLEL_GRAIN, arg_range, &ctx);
+    }
+    return rtn;
 }
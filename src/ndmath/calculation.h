@@ -3,10 +3,7 @@
 
 #include "../ndarray.h"
 
-typedef int (NDArray_ArgFunc)(float*, int, float *);
-
-#define _LESS_THAN_OR_EQUAL(a,b) ((a) <= (b))
-
+long NDArray_ArgMinMaxFlat(NDArray *a, bool is_argmax);
 NDArray * NDArray_ArgMinMaxCommon(NDArray *op, int axis, bool keepdims, bool is_argmax);
 
 #endif //NUMPOWER_CALCULATION_H
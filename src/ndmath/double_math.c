@@ -109,20 +109,7 @@ float float_cos(float val) {
 }
 
 float float_rsqrt(float val) {
-    const float threehalfs = 1.5F;
-
-    float x2 = val * 0.5F;
-    float y = val;
-
-    // Evil floating-point bit level hacking
-    uint32_t i = *(uint32_t *)&y;  // Treat float's bits as an integer
-    i = 0x5f3759df - (i >> 1);     // Initial guess for Newton's method
-    y = *(float *)&i;              // Treat bits as float
-
-    // One iteration of Newton's method
-    y = y * (threehalfs - (x2 * y * y));
-
-    return y;
+    return 1.0f / sqrtf(val);
 }
 
 /**
@@ -173,6 +160,14 @@ float float_tanh(float val) {
     return tanhf(val);
 }
 
+/**
+ * @param val
+ * @return
+ */
+float float_sigmoid(float val) {
+    return 1.0f / (1.0f + expf(-val));
+}
+
 float float_arcsinh(float val) {
     return asinhf(val);
 }
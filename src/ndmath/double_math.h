@@ -25,6 +25,7 @@ float float_radians(float val);
 float float_sinh(float val);
 float float_cosh(float val);
 float float_tanh(float val);
+float float_sigmoid(float val);
 float float_arcsinh(float val);
 float float_arccosh(float val);
 float float_arctanh(float val);
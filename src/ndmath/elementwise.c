@@ -0,0 +1,805 @@
+#include <php.h>
+#include "Zend/zend_alloc.h"
+#include "Zend/zend_API.h"
+#include <string.h>
+#include <math.h>
+#include "elementwise.h"
+#include "../../config.h"
+#include "../initializers.h"
+#include "../types.h"
+#include "../manipulation.h"
+#include "../cpu.h"
+#include "../threadpool.h"
+
+#ifdef HAVE_CUBLAS
+#include "cuda/cuda_math.h"
+#endif
+
+#ifdef HAVE_AVX2
+#include <immintrin.h>
+#endif
+
+/**
+ * Replace -0.0 with +0.0
+ *
+ * @param val
+ * @return
+ */
+static inline float
+float_fix_negative_zero(float val) {
+    return (val == 0.0f) ? 0.0f : val;
+}
+
+#ifdef HAVE_AVX2
+static inline NDARRAY_TARGET_AVX2 __m256
+fix_negative_zero(__m256 vec) {
+    __m256 zero = _mm256_set1_ps(-0.0f);
+    __m256 mask = _mm256_cmp_ps(vec, zero, _CMP_EQ_OQ);
+    return _mm256_blendv_ps(vec, _mm256_setzero_ps(), mask);
+}
+
+#define NDARRAY_BINARY_VECTOR_BODY_AVX2(VECTOR_OP)                              \
+        for (; i + 8 <= n; i += 8) {                                            \
+            __m256 vx = _mm256_loadu_ps(a + i);                                 \
+            __m256 vy = _mm256_loadu_ps(b + i);                                 \
+            _mm256_storeu_ps(o + i, VECTOR_OP);                                 \
+        }
+#define NDARRAY_BINARY_VECTOR_BODY_SCALAR_X_AVX2(VECTOR_OP)                     \
+        {                                                                       \
+            const __m256 vx = _mm256_set1_ps(x);                                \
+            for (; i + 8 <= n; i += 8) {                                        \
+                __m256 vy = _mm256_loadu_ps(b + i);                             \
+                _mm256_storeu_ps(o + i, VECTOR_OP);                             \
+            }                                                                   \
+        }
+#define NDARRAY_BINARY_VECTOR_BODY_SCALAR_Y_AVX2(VECTOR_OP)                     \
+        {                                                                       \
+            const __m256 vy = _mm256_set1_ps(y);                                \
+            for (; i + 8 <= n; i += 8) {                                        \
+                __m256 vx = _mm256_loadu_ps(a + i);                             \
+                _mm256_storeu_ps(o + i, VECTOR_OP);                             \
+            }                                                                   \
+        }
+#endif
+#ifdef HAVE_AVX512F
+static inline NDARRAY_TARGET_AVX512F __m512
+fix_negative_zero512(__m512 vec) {
+    __m512 zero = _mm512_setzero_ps();
+    return _mm512_mask_mov_ps(vec, _mm512_cmp_ps_mask(vec, zero, _CMP_EQ_OQ), zero);
+}
+
+/**
+ * Lanes [0, n) of a 16-lane mask
+ */
+#define NDARRAY_TAIL_MASK16(n) ((__mmask16) ((1u << (n)) - 1))
+
+#define NDARRAY_BINARY_VECTOR_BODY_AVX512F(VECTOR_OP)                           \
+        for (; i + 16 <= n; i += 16) {                                          \
+            __m512 vx = _mm512_loadu_ps(a + i);                                 \
+            __m512 vy = _mm512_loadu_ps(b + i);                                 \
+            _mm512_storeu_ps(o + i, VECTOR_OP);                                 \
+        }                                                                       \
+        if (i < n) {                                                            \
+            const __mmask16 m = NDARRAY_TAIL_MASK16(n - i);                     \
+            __m512 vx = _mm512_maskz_loadu_ps(m, a + i);                        \
+            __m512 vy = _mm512_maskz_loadu_ps(m, b + i);                        \
+            _mm512_mask_storeu_ps(o + i, m, VECTOR_OP);                         \
+            i = n;                                                              \
+        }
+#define NDARRAY_BINARY_VECTOR_BODY_SCALAR_X_AVX512F(VECTOR_OP)                  \
+        {                                                                       \
+            const __m512 vx = _mm512_set1_ps(x);                                \
+            for (; i + 16 <= n; i += 16) {                                      \
+                __m512 vy = _mm512_loadu_ps(b + i);                             \
+                _mm512_storeu_ps(o + i, VECTOR_OP);                             \
+            }                                                                   \
+            if (i < n) {                                                        \
+                const __mmask16 m = NDARRAY_TAIL_MASK16(n - i);                 \
+                __m512 vy = _mm512_maskz_loadu_ps(m, b + i);                    \
+                _mm512_mask_storeu_ps(o + i, m, VECTOR_OP);                     \
+                i = n;                                                          \
+            }                                                                   \
+        }
+#define NDARRAY_BINARY_VECTOR_BODY_SCALAR_Y_AVX512F(VECTOR_OP)                  \
+        {                                                                       \
+            const __m512 vy = _mm512_set1_ps(y);                                \
+            for (; i + 16 <= n; i += 16) {                                      \
+                __m512 vx = _mm512_loadu_ps(a + i);                             \
+                _mm512_storeu_ps(o + i, VECTOR_OP);                             \
+            }                                                                   \
+            if (i < n) {                                                        \
+                const __mmask16 m = NDARRAY_TAIL_MASK16(n - i);                 \
+                __m512 vx = _mm512_maskz_loadu_ps(m, a + i);                    \
+                _mm512_mask_storeu_ps(o + i, m, VECTOR_OP);                     \
+                i = n;                                                          \
+            }                                                                   \
+        }
+#endif
+#define NDARRAY_BINARY_VECTOR_BODY_BASELINE(VECTOR_OP)
+#define NDARRAY_BINARY_VECTOR_BODY_SCALAR_X_BASELINE(VECTOR_OP)
+#define NDARRAY_BINARY_VECTOR_BODY_SCALAR_Y_BASELINE(VECTOR_OP)
+
+/**
+ * Defines the inner loop `name` for one CPU level. `SCALAR_OP` is an
+ * expression of the floats `x` and `y`, `VECTOR_OP` the same expression
+ * over the __m256 `vx` and `vy`, which is dropped at the baseline level.
+ * The vector paths run when the output is contiguous and each input is
+ * either contiguous or a broadcasted scalar (0 stride), in which case the
+ * scalar is kept in a register for the whole span.
+ */
+#define NDARRAY_BINARY_LOOP_LEVEL(name, TARGET, LEVEL, SCALAR_OP, VECTOR_OP)    \
+static TARGET void                                                              \
+name(char *ip1, int is1, char *ip2, int is2, char *op, int os, long n) {        \
+    long i = 0;                                                                 \
+    if (os == sizeof(float) && is1 == sizeof(float) && is2 == sizeof(float)) { \
+        float *a = (float *) ip1, *b = (float *) ip2, *o = (float *) op;        \
+        NDARRAY_BINARY_VECTOR_BODY_##LEVEL(VECTOR_OP)                           \
+        for (; i < n; i++) {                                                    \
+            float x = a[i], y = b[i];                                           \
+            o[i] = (SCALAR_OP);                                                 \
+        }                                                                       \
+        return;                                                                 \
+    }                                                                           \
+    if (os == sizeof(float) && is1 == sizeof(float) && is2 == 0) {              \
+        float *a = (float *) ip1, *o = (float *) op;                            \
+        const float y = *(float *) ip2;                                         \
+        NDARRAY_BINARY_VECTOR_BODY_SCALAR_Y_##LEVEL(VECTOR_OP)                  \
+        for (; i < n; i++) {                                                    \
+            float x = a[i];                                                     \
+            o[i] = (SCALAR_OP);                                                 \
+        }                                                                       \
+        return;                                                                 \
+    }                                                                           \
+    if (os == sizeof(float) && is1 == 0 && is2 == sizeof(float)) {              \
+        float *b = (float *) ip2, *o = (float *) op;                            \
+        const float x = *(float *) ip1;                                         \
+        NDARRAY_BINARY_VECTOR_BODY_SCALAR_X_##LEVEL(VECTOR_OP)                  \
+        for (; i < n; i++) {                                                    \
+            float y = b[i];                                                     \
+            o[i] = (SCALAR_OP);                                                 \
+        }                                                                       \
+        return;                                                                 \
+    }                                                                           \
+    for (; i < n; i++) {                                                        \
+        float x = *(float *) (ip1 + i * is1);                                   \
+        float y = *(float *) (ip2 + i * is2);                                   \
+        *(float *) (op + i * os) = (SCALAR_OP);                                 \
+    }                                                                           \
+}
+
+/**
+ * Generates `name` for the baseline and, when the compiler supports it,
+ * `name##_avx2`.
+ */
+#ifdef HAVE_AVX2
+#define NDARRAY_BINARY_LOOP(name, SCALAR_OP, VECTOR_OP)                         \
+NDARRAY_BINARY_LOOP_LEVEL(name, , BASELINE, SCALAR_OP, VECTOR_OP)               \
+NDARRAY_BINARY_LOOP_LEVEL(name##_avx2, NDARRAY_TARGET_AVX2, AVX2, SCALAR_OP, VECTOR_OP)
+#else
+#define NDARRAY_BINARY_LOOP(name, SCALAR_OP, VECTOR_OP)                         \
+NDARRAY_BINARY_LOOP_LEVEL(name, , BASELINE, SCALAR_OP, VECTOR_OP)
+#endif
+
+/**
+ * Same as NDARRAY_BINARY_LOOP plus `name##_avx512f`, where `VECTOR512_OP`
+ * is the expression over the __m512 `vx` and `vy`. Tails are handled
+ * with masked loads and stores instead of the scalar loop.
+ */
+#ifdef HAVE_AVX512F
+#define NDARRAY_BINARY_LOOP512(name, SCALAR_OP, VECTOR_OP, VECTOR512_OP)        \
+NDARRAY_BINARY_LOOP(name, SCALAR_OP, VECTOR_OP)                                 \
+NDARRAY_BINARY_LOOP_LEVEL(name##_avx512f, NDARRAY_TARGET_AVX512F, AVX512F, SCALAR_OP, VECTOR512_OP)
+#else
+#define NDARRAY_BINARY_LOOP512(name, SCALAR_OP, VECTOR_OP, VECTOR512_OP)        \
+NDARRAY_BINARY_LOOP(name, SCALAR_OP, VECTOR_OP)
+#endif
+
+/**
+ * 1.0 in the lanes of `mask`, 0.0 elsewhere
+ */
+#define V512_FROM_MASK(mask) _mm512_maskz_mov_ps(mask, _mm512_set1_ps(1.0f))
+
+NDARRAY_BINARY_LOOP512(float_add_loop, x + y, _mm256_add_ps(vx, vy), _mm512_add_ps(vx, vy))
+NDARRAY_BINARY_LOOP512(float_subtract_loop, x - y, _mm256_sub_ps(vx, vy), _mm512_sub_ps(vx, vy))
+NDARRAY_BINARY_LOOP512(float_multiply_loop, float_fix_negative_zero(x * y),
+                       fix_negative_zero(_mm256_mul_ps(vx, vy)),
+                       fix_negative_zero512(_mm512_mul_ps(vx, vy)))
+NDARRAY_BINARY_LOOP512(float_divide_loop, x / y, _mm256_div_ps(vx, vy), _mm512_div_ps(vx, vy))
+NDARRAY_BINARY_LOOP512(float_greater_loop, (x > y) ? 1.0f : 0.0f,
+                       _mm256_and_ps(_mm256_cmp_ps(vx, vy, _CMP_GT_OQ), _mm256_set1_ps(1.0f)),
+                       V512_FROM_MASK(_mm512_cmp_ps_mask(vx, vy, _CMP_GT_OQ)))
+NDARRAY_BINARY_LOOP512(float_greater_equal_loop, (x >= y) ? 1.0f : 0.0f,
+                       _mm256_and_ps(_mm256_cmp_ps(vx, vy, _CMP_GE_OQ), _mm256_set1_ps(1.0f)),
+                       V512_FROM_MASK(_mm512_cmp_ps_mask(vx, vy, _CMP_GE_OQ)))
+NDARRAY_BINARY_LOOP512(float_less_loop, (x < y) ? 1.0f : 0.0f,
+                       _mm256_and_ps(_mm256_cmp_ps(vx, vy, _CMP_LT_OQ), _mm256_set1_ps(1.0f)),
+                       V512_FROM_MASK(_mm512_cmp_ps_mask(vx, vy, _CMP_LT_OQ)))
+NDARRAY_BINARY_LOOP512(float_less_equal_loop, (x <= y) ? 1.0f : 0.0f,
+                       _mm256_and_ps(_mm256_cmp_ps(vx, vy, _CMP_LE_OQ), _mm256_set1_ps(1.0f)),
+                       V512_FROM_MASK(_mm512_cmp_ps_mask(vx, vy, _CMP_LE_OQ)))
+NDARRAY_BINARY_LOOP512(float_equal_loop, (x == y) ? 1.0f : 0.0f,
+                       _mm256_and_ps(_mm256_cmp_ps(vx, vy, _CMP_EQ_OQ), _mm256_set1_ps(1.0f)),
+                       V512_FROM_MASK(_mm512_cmp_ps_mask(vx, vy, _CMP_EQ_OQ)))
+NDARRAY_BINARY_LOOP512(float_not_equal_loop, (x != y) ? 1.0f : 0.0f,
+                       _mm256_and_ps(_mm256_cmp_ps(vx, vy, _CMP_NEQ_UQ), _mm256_set1_ps(1.0f)),
+                       V512_FROM_MASK(_mm512_cmp_ps_mask(vx, vy, _CMP_NEQ_UQ)))
+
+/**
+ * fmodf has no exact vector form, x - trunc(x / y) * y loses precision
+ * for large quotients and gives NaN for infinite divisors, so mod
+ * stays on this scalar loop.
+ */
+static void
+float_mod_loop(char *ip1, int is1, char *ip2, int is2, char *op, int os, long n) {
+    for (long i = 0; i < n; i++) {
+        *(float *) (op + i * os) = fmodf(*(float *) (ip1 + i * is1), *(float *) (ip2 + i * is2));
+    }
+}
+
+static void
+float_pow_loop(char *ip1, int is1, char *ip2, int is2, char *op, int os, long n) {
+    if (os == sizeof(float) && is1 == sizeof(float) && is2 == 0 && *(float *) ip2 == 2.0f) {
+        float *a = (float *) ip1, *o = (float *) op;
+        for (long i = 0; i < n; i++) {
+            o[i] = a[i] * a[i];
+        }
+        return;
+    }
+    for (long i = 0; i < n; i++) {
+        *(float *) (op + i * os) = powf(*(float *) (ip1 + i * is1), *(float *) (ip2 + i * is2));
+    }
+}
+
+#define NDARRAY_BINARY_LOOPS(SUFFIX) {                                         \
+    [NDARRAY_BINARY_ADD] = float_add_loop##SUFFIX,                              \
+    [NDARRAY_BINARY_SUBTRACT] = float_subtract_loop##SUFFIX,                    \
+    [NDARRAY_BINARY_MULTIPLY] = float_multiply_loop##SUFFIX,                    \
+    [NDARRAY_BINARY_DIVIDE] = float_divide_loop##SUFFIX,                        \
+    [NDARRAY_BINARY_MOD] = float_mod_loop,                                      \
+    [NDARRAY_BINARY_POW] = float_pow_loop,                                      \
+    [NDARRAY_BINARY_GREATER] = float_greater_loop##SUFFIX,                      \
+    [NDARRAY_BINARY_GREATER_EQUAL] = float_greater_equal_loop##SUFFIX,          \
+    [NDARRAY_BINARY_LESS] = float_less_loop##SUFFIX,                            \
+    [NDARRAY_BINARY_LESS_EQUAL] = float_less_equal_loop##SUFFIX,                \
+    [NDARRAY_BINARY_EQUAL] = float_equal_loop##SUFFIX,                          \
+    [NDARRAY_BINARY_NOT_EQUAL] = float_not_equal_loop##SUFFIX,                  \
+}
+
+/**
+ * Inner loops per CPU level, rows above the level found by
+ * NDArray_CPU_Init are never read.
+ */
+static const NDArray_BinaryLoop binary_loops[NDARRAY_CPU_NUM_LEVELS][NDARRAY_BINARY_NUM_OPS] = {
+    [NDARRAY_CPU_BASELINE] = NDARRAY_BINARY_LOOPS(),
+#ifdef HAVE_AVX2
+    [NDARRAY_CPU_AVX2] = NDARRAY_BINARY_LOOPS(_avx2),
+#ifdef HAVE_AVX512F
+    [NDARRAY_CPU_AVX512F] = {
+        [NDARRAY_BINARY_ADD] = float_add_loop_avx512f,
+        [NDARRAY_BINARY_SUBTRACT] = float_subtract_loop_avx512f,
+        [NDARRAY_BINARY_MULTIPLY] = float_multiply_loop_avx512f,
+        [NDARRAY_BINARY_DIVIDE] = float_divide_loop_avx512f,
+        [NDARRAY_BINARY_MOD] = float_mod_loop,
+        [NDARRAY_BINARY_POW] = float_pow_loop,
+        [NDARRAY_BINARY_GREATER] = float_greater_loop_avx512f,
+        [NDARRAY_BINARY_GREATER_EQUAL] = float_greater_equal_loop_avx512f,
+        [NDARRAY_BINARY_LESS] = float_less_loop_avx512f,
+        [NDARRAY_BINARY_LESS_EQUAL] = float_less_equal_loop_avx512f,
+        [NDARRAY_BINARY_EQUAL] = float_equal_loop_avx512f,
+        [NDARRAY_BINARY_NOT_EQUAL] = float_not_equal_loop_avx512f,
+    },
+#else
+    [NDARRAY_CPU_AVX512F] = NDARRAY_BINARY_LOOPS(_avx2),
+#endif
+#endif
+};
+
+/**
+ * Inner loop used by the broadcasting engine for `op`
+ *
+ * @param op
+ * @return
+ */
+NDArray_BinaryLoop
+NDArray_GetBinaryLoop(NDArray_BinaryOp op) {
+    return binary_loops[NDArray_CPU_Level()][op];
+}
+
+/**
+ * Compute the broadcasted shape of two shapes following the usual
+ * right-aligned rules. `out_shape` must hold at least max(ndim_a, ndim_b)
+ * elements.
+ *
+ * @param ndim_a
+ * @param shape_a
+ * @param ndim_b
+ * @param shape_b
+ * @param out_shape
+ * @return the output ndim or -1 if the shapes are not broadcastable
+ */
+int
+NDArray_BroadcastShapes(int ndim_a, const int *shape_a, int ndim_b, const int *shape_b, int *out_shape) {
+    int i, dim_a, dim_b;
+    int ndim = (ndim_a > ndim_b) ? ndim_a : ndim_b;
+    int offset_a = ndim - ndim_a;
+    int offset_b = ndim - ndim_b;
+
+    for (i = 0; i < ndim; i++) {
+        dim_a = (i >= offset_a) ? shape_a[i - offset_a] : 1;
+        dim_b = (i >= offset_b) ? shape_b[i - offset_b] : 1;
+        if (dim_a == dim_b || dim_b == 1) {
+            out_shape[i] = dim_a;
+        } else if (dim_a == 1) {
+            out_shape[i] = dim_b;
+        } else {
+            return -1;
+        }
+    }
+    return ndim;
+}
+
+/**
+ * Compute the broadcasted shape of two arrays.
+ *
+ * @param a
+ * @param b
+ * @param out_shape
+ * @return the output ndim or -1 if the shapes are not broadcastable
+ */
+int
+NDArray_BroadcastShape(const NDArray *a, const NDArray *b, int *out_shape) {
+    return NDArray_BroadcastShapes(NDArray_NDIM(a), NDArray_SHAPE(a), NDArray_NDIM(b), NDArray_SHAPE(b), out_shape);
+}
+
+typedef struct {
+    NDArray_BinaryLoop loop;
+    int nd;
+    int dims[NDARRAY_MAX_DIMS];
+    int sa[NDARRAY_MAX_DIMS];
+    int sb[NDARRAY_MAX_DIMS];
+    int so[NDARRAY_MAX_DIMS];
+    char *a;
+    char *b;
+    char *out;
+} binary_iter_ctx;
+
+/**
+ * Run the loop over elements [start, end) of the collapsed iteration
+ * space, in C order. The first and last inner rows may be partial.
+ */
+static void
+binary_iterate_range(long start, long end, void *ctx) {
+    const binary_iter_ctx *c = ctx;
+    int i, inner = c->nd - 1;
+    int coords[NDARRAY_MAX_DIMS];
+    long rem = start, count;
+    char *a = c->a, *b = c->b, *out = c->out;
+
+    for (i = inner; i >= 0; i--) {
+        coords[i] = (int) (rem % c->dims[i]);
+        rem /= c->dims[i];
+        a += (long) coords[i] * c->sa[i];
+        b += (long) coords[i] * c->sb[i];
+        out += (long) coords[i] * c->so[i];
+    }
+
+    while (start < end) {
+        count = c->dims[inner] - coords[inner];
+        if (count > end - start) {
+            count = end - start;
+        }
+        c->loop(a, c->sa[inner], b, c->sb[inner], out, c->so[inner], count);
+        start += count;
+        // Back to the start of the row, then step the outer dimensions
+        a -= (long) coords[inner] * c->sa[inner];
+        b -= (long) coords[inner] * c->sb[inner];
+        out -= (long) coords[inner] * c->so[inner];
+        coords[inner] = 0;
+        for (i = inner - 1; i >= 0; i--) {
+            a += c->sa[i];
+            b += c->sb[i];
+            out += c->so[i];
+            if (++coords[i] < c->dims[i]) {
+                break;
+            }
+            a -= (long) c->sa[i] * c->dims[i];
+            b -= (long) c->sb[i] * c->dims[i];
+            out -= (long) c->so[i] * c->dims[i];
+            coords[i] = 0;
+        }
+    }
+}
+
+/**
+ * Run `loop` over a broadcasted iteration space.
+ *
+ * Unit dimensions are dropped and adjacent dimensions that are contiguous
+ * for all three operands are merged, so the inner loop runs over the
+ * longest possible span. Broadcasted dimensions have a 0 stride and merge
+ * as well.
+ *
+ * Large iteration spaces are split into chunks of NDARRAY_PARALLEL_GRAIN
+ * elements that run on the thread pool. Chunks write disjoint parts of
+ * the output, so this is safe as long as `out` does not partially
+ * overlap an input, which the callers check.
+ */
+static void
+binary_iterate(NDArray_BinaryLoop loop, int ndim, const int *shape,
+               char *a, const int *a_strides,
+               char *b, const int *b_strides,
+               char *out, const int *out_strides) {
+    int i, nd = 0;
+    long total = 1;
+    binary_iter_ctx ctx;
+
+    for (i = 0; i < ndim; i++) {
+        if (shape[i] == 0) {
+            return;
+        }
+        if (shape[i] == 1) {
+            continue;
+        }
+        if (nd > 0 && ctx.sa[nd - 1] == a_strides[i] * shape[i]
+                   && ctx.sb[nd - 1] == b_strides[i] * shape[i]
+                   && ctx.so[nd - 1] == out_strides[i] * shape[i]) {
+            ctx.dims[nd - 1] *= shape[i];
+            ctx.sa[nd - 1] = a_strides[i];
+            ctx.sb[nd - 1] = b_strides[i];
+            ctx.so[nd - 1] = out_strides[i];
+            continue;
+        }
+        ctx.dims[nd] = shape[i];
+        ctx.sa[nd] = a_strides[i];
+        ctx.sb[nd] = b_strides[i];
+        ctx.so[nd] = out_strides[i];
+        nd++;
+    }
+
+    if (nd == 0) {
+        loop(a, 0, b, 0, out, 0, 1);
+        return;
+    }
+
+    for (i = 0; i < nd; i++) {
+        total *= ctx.dims[i];
+    }
+    ctx.loop = loop;
+    ctx.nd = nd;
+    ctx.a = a;
+    ctx.b = b;
+    ctx.out = out;
+    NDArray_ParallelFor(total, NDARRAY_PARALLEL_GRAIN, binary_iterate_range, &ctx);
+}
+
+static void
+float_copy_loop(char *ip1, int is1, char *ip2, int is2, char *op, int os, long n) {
+    if (is1 == sizeof(float) && os == sizeof(float)) {
+        memmove(op, ip1, n * sizeof(float));
+        return;
+    }
+    for (long i = 0; i < n; i++) {
+        *(float *) (op + i * os) = *(float *) (ip1 + i * is1);
+    }
+}
+
+/**
+ * Lowest and one-past-highest byte touched by a strided float array
+ */
+static void
+strided_extent(char *data, int ndim, const int *shape, const int *strides, char **low, char **high) {
+    *low = data;
+    *high = data + sizeof(float);
+    for (int i = 0; i < ndim; i++) {
+        if (shape[i] == 0) {
+            *high = *low;
+            return;
+        }
+        if (strides[i] > 0) {
+            *high += (long) strides[i] * (shape[i] - 1);
+        } else {
+            *low += (long) strides[i] * (shape[i] - 1);
+        }
+    }
+}
+
+/**
+ * Whether reading `in` through `in_strides` while writing `out` could
+ * read an element after it was overwritten. Reading and writing the
+ * exact same elements in the same order is safe.
+ */
+static int
+output_overlaps_input(NDArray *out, NDArray *in, const int *in_strides) {
+    char *out_low, *out_high, *in_low, *in_high;
+    if (NDArray_DATA(out) == NDArray_DATA(in) &&
+        NDArray_CompareLists(NDArray_STRIDES(out), in_strides, NDArray_NDIM(out))) {
+        return 0;
+    }
+    strided_extent(NDArray_DATA(out), NDArray_NDIM(out), NDArray_SHAPE(out), NDArray_STRIDES(out),
+                   &out_low, &out_high);
+    strided_extent(NDArray_DATA(in), NDArray_NDIM(out), NDArray_SHAPE(out), in_strides, &in_low, &in_high);
+    return out_low < in_high && in_low < out_high;
+}
+
+/**
+ * Apply a binary element-wise operation to two CPU arrays with
+ * broadcasting.
+ *
+ * Operands are never materialized to the output shape: broadcasted
+ * dimensions are read through a 0 stride. Non-contiguous views are
+ * read through their own strides.
+ *
+ * When `out` is given the result is written into it and `out` is
+ * returned, otherwise a new array is allocated. `out` may be one of
+ * the operands.
+ *
+ * @param a
+ * @param b
+ * @param op
+ * @param out
+ * @return
+ */
+NDArray*
+NDArray_BinaryElementWiseOut(NDArray *a, NDArray *b, NDArray_BinaryOp op, NDArray *out) {
+    int ndim;
+    int out_shape[NDARRAY_MAX_DIMS];
+    int a_strides[NDARRAY_MAX_DIMS], b_strides[NDARRAY_MAX_DIMS];
+    int *rtn_shape;
+    NDArray *rtn, *tmp;
+
+    if (NDArray_DEVICE(a) != NDARRAY_DEVICE_CPU || NDArray_DEVICE(b) != NDARRAY_DEVICE_CPU) {
+        zend_throw_error(NULL, "Device mismatch, both NDArray MUST be in the CPU.");
+        return NULL;
+    }
+
+    ndim = NDArray_BroadcastShape(a, b, out_shape);
+    if (ndim < 0) {
+        zend_throw_error(NULL, "Can't broadcast arrays.");
+        return NULL;
+    }
+
+    if (out != NULL && !NDArray_CheckOutput(out, ndim, out_shape, NDARRAY_DEVICE_CPU)) {
+        return NULL;
+    }
+
+    broadcast_strides(ndim, out_shape, NDArray_NDIM(a), NDArray_SHAPE(a), NDArray_STRIDES(a), "a", a_strides);
+    broadcast_strides(ndim, out_shape, NDArray_NDIM(b), NDArray_SHAPE(b), NDArray_STRIDES(b), "b", b_strides);
+
+    if (out != NULL) {
+        if (output_overlaps_input(out, a, a_strides) || output_overlaps_input(out, b, b_strides)) {
+            // Partial overlap, compute into a temporary first
+            tmp = NDArray_BinaryElementWiseOut(a, b, op, NULL);
+            binary_iterate(float_copy_loop, ndim, out_shape,
+                           NDArray_DATA(tmp), NDArray_STRIDES(tmp),
+                           NDArray_DATA(tmp), NDArray_STRIDES(tmp),
+                           NDArray_DATA(out), NDArray_STRIDES(out));
+            NDArray_FREE(tmp);
+            return out;
+        }
+        rtn = out;
+    } else {
+        rtn_shape = emalloc(sizeof(int) * (ndim > 0 ? ndim : 1));
+        rtn_shape[0] = 1;
+        memcpy(rtn_shape, out_shape, sizeof(int) * ndim);
+        rtn = NDArray_Empty(rtn_shape, ndim, NDARRAY_TYPE_FLOAT32, NDARRAY_DEVICE_CPU);
+    }
+
+    binary_iterate(NDArray_GetBinaryLoop(op), ndim, out_shape,
+                   NDArray_DATA(a), a_strides,
+                   NDArray_DATA(b), b_strides,
+                   NDArray_DATA(rtn), NDArray_STRIDES(rtn));
+    return rtn;
+}
+
+/**
+ * @param a
+ * @param b
+ * @param op
+ * @return
+ */
+NDArray*
+NDArray_BinaryElementWise(NDArray *a, NDArray *b, NDArray_BinaryOp op) {
+    return NDArray_BinaryElementWiseOut(a, b, op, NULL);
+}
+
+/**
+ * Apply a binary element-wise operation between a CPU array and a
+ * scalar without creating an NDArray for the scalar.
+ *
+ * When `out` is given the result is written into it and `out` is
+ * returned. `out` may be `a`.
+ *
+ * @param a
+ * @param scalar
+ * @param op
+ * @param scalar_first 1 for `scalar op a`, 0 for `a op scalar`
+ * @param out
+ * @return
+ */
+NDArray*
+NDArray_BinaryScalarOut(NDArray *a, float scalar, NDArray_BinaryOp op, int scalar_first, NDArray *out) {
+    int zero_strides[NDARRAY_MAX_DIMS];
+    int *rtn_shape;
+    NDArray *rtn, *tmp;
+
+    if (NDArray_DEVICE(a) != NDARRAY_DEVICE_CPU) {
+        zend_throw_error(NULL, "Device mismatch, both NDArray MUST be in the CPU.");
+        return NULL;
+    }
+
+    if (out != NULL) {
+        if (!NDArray_CheckOutput(out, NDArray_NDIM(a), NDArray_SHAPE(a), NDARRAY_DEVICE_CPU)) {
+            return NULL;
+        }
+        if (output_overlaps_input(out, a, NDArray_STRIDES(a))) {
+            // Partial overlap, compute into a temporary first
+            tmp = NDArray_BinaryScalarOut(a, scalar, op, scalar_first, NULL);
+            binary_iterate(float_copy_loop, NDArray_NDIM(a), NDArray_SHAPE(a),
+                           NDArray_DATA(tmp), NDArray_STRIDES(tmp),
+                           NDArray_DATA(tmp), NDArray_STRIDES(tmp),
+                           NDArray_DATA(out), NDArray_STRIDES(out));
+            NDArray_FREE(tmp);
+            return out;
+        }
+        rtn = out;
+    } else {
+        rtn_shape = emalloc(sizeof(int) * (NDArray_NDIM(a) > 0 ? NDArray_NDIM(a) : 1));
+        rtn_shape[0] = 1;
+        memcpy(rtn_shape, NDArray_SHAPE(a), sizeof(int) * NDArray_NDIM(a));
+        rtn = NDArray_Empty(rtn_shape, NDArray_NDIM(a), NDARRAY_TYPE_FLOAT32, NDARRAY_DEVICE_CPU);
+    }
+
+    memset(zero_strides, 0, sizeof(int) * NDArray_NDIM(a));
+    if (scalar_first) {
+        binary_iterate(NDArray_GetBinaryLoop(op), NDArray_NDIM(a), NDArray_SHAPE(a),
+                       (char *) &scalar, zero_strides,
+                       NDArray_DATA(a), NDArray_STRIDES(a),
+                       NDArray_DATA(rtn), NDArray_STRIDES(rtn));
+    } else {
+        binary_iterate(NDArray_GetBinaryLoop(op), NDArray_NDIM(a), NDArray_SHAPE(a),
+                       NDArray_DATA(a), NDArray_STRIDES(a),
+                       (char *) &scalar, zero_strides,
+                       NDArray_DATA(rtn), NDArray_STRIDES(rtn));
+    }
+    return rtn;
+}
+
+/**
+ * @param a
+ * @param scalar
+ * @param op
+ * @param scalar_first 1 for `scalar op a`, 0 for `a op scalar`
+ * @return
+ */
+NDArray*
+NDArray_BinaryScalar(NDArray *a, float scalar, NDArray_BinaryOp op, int scalar_first) {
+    return NDArray_BinaryScalarOut(a, scalar, op, scalar_first, NULL);
+}
+
+#ifdef HAVE_CUBLAS
+typedef void (*CudaBinaryOperation)(int, float *, float *, float *, int);
+
+static const CudaBinaryOperation binary_cuda_ops[NDARRAY_BINARY_NUM_OPS] = {
+    [NDARRAY_BINARY_ADD] = cuda_add_float,
+    [NDARRAY_BINARY_SUBTRACT] = cuda_subtract_float,
+    [NDARRAY_BINARY_MULTIPLY] = cuda_multiply_float,
+    [NDARRAY_BINARY_DIVIDE] = cuda_divide_float,
+    [NDARRAY_BINARY_MOD] = cuda_mod_float,
+    [NDARRAY_BINARY_POW] = cuda_pow_float,
+    [NDARRAY_BINARY_GREATER] = cuda_float_compare_greater,
+    [NDARRAY_BINARY_GREATER_EQUAL] = cuda_float_compare_greater_equal,
+    [NDARRAY_BINARY_LESS] = cuda_float_compare_less,
+    [NDARRAY_BINARY_LESS_EQUAL] = cuda_float_compare_less_equal,
+    [NDARRAY_BINARY_EQUAL] = cuda_float_compare_equal,
+    [NDARRAY_BINARY_NOT_EQUAL] = cuda_float_compare_not_equal,
+};
+
+/**
+ * Apply a binary CUDA kernel to two GPU arrays. The smaller operand is
+ * materialized on the device with NDArray_Broadcast.
+ *
+ * @param a
+ * @param b
+ * @param op
+ * @return
+ */
+static NDArray*
+binary_elementwise_gpu(NDArray *a, NDArray *b, NDArray_BinaryOp op) {
+    NDArray *a_temp = NULL, *b_temp = NULL;
+    NDArray *broadcasted = NULL;
+    NDArray *a_broad = NULL, *b_broad = NULL;
+
+    // If a or b are scalars, reshape
+    if (NDArray_NDIM(a) == 0 && NDArray_NDIM(b) > 0) {
+        a_temp = a;
+        int *n_shape = emalloc(sizeof(int) * NDArray_NDIM(b));
+        copy(NDArray_SHAPE(b), n_shape, NDArray_NDIM(b));
+        a = NDArray_Zeros(n_shape, NDArray_NDIM(b), NDArray_TYPE(b), NDArray_DEVICE(b));
+        a = NDArray_Fill(a, NDArray_GetFloatScalar(a_temp));
+    } else if (NDArray_NDIM(b) == 0 && NDArray_NDIM(a) > 0) {
+        b_temp = b;
+        int *n_shape = emalloc(sizeof(int) * NDArray_NDIM(a));
+        copy(NDArray_SHAPE(a), n_shape, NDArray_NDIM(a));
+        b = NDArray_Zeros(n_shape, NDArray_NDIM(a), NDArray_TYPE(a), NDArray_DEVICE(a));
+        b = NDArray_Fill(b, NDArray_GetFloatScalar(b_temp));
+    }
+
+    if (NDArray_NUMELEMENTS(a) < NDArray_NUMELEMENTS(b)) {
+        broadcasted = NDArray_Broadcast(a, b);
+        a_broad = broadcasted;
+        b_broad = b;
+    } else if (NDArray_NUMELEMENTS(b) < NDArray_NUMELEMENTS(a)) {
+        broadcasted = NDArray_Broadcast(b, a);
+        b_broad = broadcasted;
+        a_broad = a;
+    } else {
+        b_broad = b;
+        a_broad = a;
+    }
+
+    if (b_broad == NULL || a_broad == NULL) {
+        zend_throw_error(NULL, "Can't broadcast arrays.");
+        return NULL;
+    }
+
+    int *rtn_shape = emalloc(sizeof(int) * (NDArray_NDIM(a_broad) > 0 ? NDArray_NDIM(a_broad) : 1));
+    rtn_shape[0] = 1;
+    memcpy(rtn_shape, NDArray_SHAPE(a_broad), sizeof(int) * NDArray_NDIM(a_broad));
+    NDArray *rtn = NDArray_Empty(rtn_shape, NDArray_NDIM(a_broad), NDARRAY_TYPE_FLOAT32, NDARRAY_DEVICE_GPU);
+    binary_cuda_ops[op](NDArray_NUMELEMENTS(a_broad), NDArray_FDATA(a_broad), NDArray_FDATA(b_broad),
+                        NDArray_FDATA(rtn), NDArray_NUMELEMENTS(a_broad));
+
+    if (a_temp != NULL) {
+        NDArray_FREE(a);
+    }
+    if (b_temp != NULL) {
+        NDArray_FREE(b);
+    }
+    if (broadcasted != NULL) {
+        NDArray_FREE(broadcasted);
+    }
+    return rtn;
+}
+#endif
+
+/**
+ * Apply a binary element-wise operation on the device where
+ * the operands live. `out` is only supported for CPU arrays.
+ *
+ * @param a
+ * @param b
+ * @param op
+ * @param out
+ * @return
+ */
+NDArray*
+NDArray_BinaryOperationOut(NDArray *a, NDArray *b, NDArray_BinaryOp op, NDArray *out) {
+    if (NDArray_DEVICE(a) != NDArray_DEVICE(b) && NDArray_NDIM(a) != 0 && NDArray_NDIM(b) != 0) {
+        zend_throw_error(NULL, "Device mismatch, both NDArray MUST be in the same device.");
+        return NULL;
+    }
+
+    if (NDArray_DEVICE(a) == NDARRAY_DEVICE_CPU && NDArray_DEVICE(b) == NDARRAY_DEVICE_CPU) {
+        return NDArray_BinaryElementWiseOut(a, b, op, out);
+    }
+    if (out != NULL) {
+        zend_throw_error(NULL, "`out` argument is not supported for GPU arrays.");
+        return NULL;
+    }
+#ifdef HAVE_CUBLAS
+    return binary_elementwise_gpu(a, b, op);
+#else
+    zend_throw_error(NULL, "GPU operations unavailable. CUBLAS not detected.");
+    return NULL;
+#endif
+}
+
+/**
+ * @param a
+ * @param b
+ * @param op
+ * @return
+ */
+NDArray*
+NDArray_BinaryOperation(NDArray *a, NDArray *b, NDArray_BinaryOp op) {
+    return NDArray_BinaryOperationOut(a, b, op, NULL);
+}
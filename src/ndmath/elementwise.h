@@ -0,0 +1,40 @@
+#ifndef PHPSCI_NDARRAY_ELEMENTWISE_H
+#define PHPSCI_NDARRAY_ELEMENTWISE_H
+
+#include "../ndarray.h"
+
+/**
+ * Binary element-wise operations handled by the broadcasting engine
+ */
+typedef enum {
+    NDARRAY_BINARY_ADD = 0,
+    NDARRAY_BINARY_SUBTRACT,
+    NDARRAY_BINARY_MULTIPLY,
+    NDARRAY_BINARY_DIVIDE,
+    NDARRAY_BINARY_MOD,
+    NDARRAY_BINARY_POW,
+    NDARRAY_BINARY_GREATER,
+    NDARRAY_BINARY_GREATER_EQUAL,
+    NDARRAY_BINARY_LESS,
+    NDARRAY_BINARY_LESS_EQUAL,
+    NDARRAY_BINARY_EQUAL,
+    NDARRAY_BINARY_NOT_EQUAL,
+    NDARRAY_BINARY_NUM_OPS
+} NDArray_BinaryOp;
+
+/**
+ * Inner loop of a binary operation over `n` elements. Strides are in bytes
+ * and may be 0 for broadcasted operands.
+ */
+typedef void (*NDArray_BinaryLoop)(char *ip1, int is1, char *ip2, int is2, char *op, int os, long n);
+
+int NDArray_BroadcastShapes(int ndim_a, const int *shape_a, int ndim_b, const int *shape_b, int *out_shape);
+int NDArray_BroadcastShape(const NDArray *a, const NDArray *b, int *out_shape);
+NDArray_BinaryLoop NDArray_GetBinaryLoop(NDArray_BinaryOp op);
+NDArray* NDArray_BinaryElementWise(NDArray *a, NDArray *b, NDArray_BinaryOp op);
+NDArray* NDArray_BinaryElementWiseOut(NDArray *a, NDArray *b, NDArray_BinaryOp op, NDArray *out);
+NDArray* NDArray_BinaryScalar(NDArray *a, float scalar, NDArray_BinaryOp op, int scalar_first);
+NDArray* NDArray_BinaryScalarOut(NDArray *a, float scalar, NDArray_BinaryOp op, int scalar_first, NDArray *out);
+NDArray* NDArray_BinaryOperation(NDArray *a, NDArray *b, NDArray_BinaryOp op);
+NDArray* NDArray_BinaryOperationOut(NDArray *a, NDArray *b, NDArray_BinaryOp op, NDArray *out);
+#endif //PHPSCI_NDARRAY_ELEMENTWISE_H
@@ -0,0 +1,519 @@
+#include <php.h>
+#include "Zend/zend_alloc.h"
+#include "Zend/zend_API.h"
+#include <limits.h>
+#include <string.h>
+#include <math.h>
+#include "histogram.h"
+#include "simd_math.h"
+#include "sort.h"
+#include "../../config.h"
+#include "../initializers.h"
+#include "../manipulation.h"
+#include "../types.h"
+#include "../threadpool.h"
+
+/**
+ * Largest number of private bins, over all threads, a counting pass may
+ * allocate. Above it fewer chunks are used.
+ */
+#define BIN_MAX_PARTIAL (1L << 22)
+
+typedef enum {
+    BINS_UNIFORM = 0,       // Equal width bins, the index is computed
+    BINS_EDGES,             // Sorted edges, the index is searched
+    BINS_INTEGER,           // Non-negative integers index the bins directly
+} bin_mode;
+
+typedef struct {
+    bin_mode mode;
+    const float *in;
+    const float *weights;
+    long nbins;
+    const float *edges;     // nbins + 1 edges, unless BINS_INTEGER
+    double lo;
+    double norm;            // Bins per unit, BINS_UNIFORM
+} bin_ctx;
+
+/**
+ * Number of the `n` ascending edges smaller than `x` (`right`) or smaller
+ * than or equal to it. NaN is greater than every edge.
+ */
+static inline long
+search_edges(const float *edges, long n, float x, int right) {
+    long lo = 0, hi = n, mid;
+    if (isnan(x)) {
+        return n;
+    }
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (right ? edges[mid] < x : edges[mid] <= x) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/**
+ * Bin of `x`, -1 when it falls outside of the edges. The last bin
+ * includes its right edge.
+ */
+static inline long
+bin_index(const bin_ctx *c, float x) {
+    long b;
+
+    if (c->mode == BINS_INTEGER) {
+        return (long) x;
+    }
+    if (!(x >= c->edges[0] && x <= c->edges[c->nbins])) {
+        return -1;
+    }
+    if (c->mode == BINS_UNIFORM) {
+        b = (long) (((double) x - c->lo) * c->norm);
+        if (b >= c->nbins) {
+            b = c->nbins - 1;
+        }
+        // The rounded edges are authoritative, move by one bin if needed
+        if (x < c->edges[b]) {
+            b--;
+        } else if (b + 1 < c->nbins && x >= c->edges[b + 1]) {
+            b++;
+        }
+        return b;
+    }
+    b = search_edges(c->edges, c->nbins + 1, x, 0) - 1;
+    return (b == c->nbins) ? b - 1 : b;
+}
+
+/**
+ * Count the elements [start, end) into a private histogram
+ */
+static void
+bin_range(long start, long end, void *ctx, void *partial) {
+    const bin_ctx *c = ctx;
+    double *h = partial;
+    long i, b;
+
+    memset(h, 0, sizeof(double) * c->nbins);
+    for (i = start; i < end; i++) {
+        b = bin_index(c, c->in[i]);
+        if (b >= 0) {
+            h[b] += (c->weights != NULL) ? (double) c->weights[i] : 1.0;
+        }
+    }
+}
+
+/**
+ * Count `n` elements into `out`. Every chunk of the input fills its own
+ * histogram, they are added in order at the end so the result does not
+ * depend on the number of threads.
+ */
+static void
+bin_count(bin_ctx *c, long n, float *out) {
+    long chunks, grain = NDARRAY_PARALLEL_GRAIN, max_chunks, i, b;
+    double *partials, sum;
+
+    max_chunks = BIN_MAX_PARTIAL / (c->nbins > 0 ? c->nbins : 1);
+    if (max_chunks < 1) {
+        max_chunks = 1;
+    }
+    if (n / grain > max_chunks) {
+        grain = n / max_chunks + 1;
+    }
+    chunks = NDArray_ParallelChunks(n, grain);
+    partials = emalloc(sizeof(double) * c->nbins * chunks);
+    chunks = NDArray_ParallelReduce(n, grain, bin_range, c, partials, sizeof(double) * c->nbins);
+    for (b = 0; b < c->nbins; b++) {
+        sum = 0;
+        for (i = 0; i < chunks; i++) {
+            sum += partials[i * c->nbins + b];
+        }
+        out[b] = (float) sum;
+    }
+    efree(partials);
+}
+
+/**
+ * Contiguous float data of a CPU array, `*copy` receives a contiguous
+ * copy to free when `a` is not contiguous
+ */
+static const float *
+contiguous_data(NDArray *a, NDArray **copy) {
+    *copy = NULL;
+    if (!NDArray_IsContiguous(a)) {
+        *copy = NDArray_ToContiguous(a);
+        return NDArray_FDATA(*copy);
+    }
+    return NDArray_FDATA(a);
+}
+
+/**
+ * @return 1 if the edges are ascending (descending with `descending`)
+ */
+static int
+edges_monotonic(const float *edges, long n, int descending) {
+    long i;
+    for (i = 1; i < n; i++) {
+        if (descending ? !(edges[i] <= edges[i - 1]) : !(edges[i] >= edges[i - 1])) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Histogram of the elements of a CPU array. With an integer number of
+ * bins they span `range`, or the minimum and maximum of the array, with
+ * equal widths and the bin of every element is computed directly.
+ * Explicit edges must be ascending and are binary searched. Values
+ * outside of the edges are not counted.
+ *
+ * @param a
+ * @param bins Number of equal width bins, when `edges` is NULL
+ * @param edges Optional 1-D array of bin edges
+ * @param range Optional lower and upper edge of equal width bins
+ * @param hist Receives the counts
+ * @param bin_edges Receives the edges
+ * @return 0, -1 with an exception set on error
+ */
+int
+NDArray_Histogram(NDArray *a, int bins, NDArray *edges, const double *range, NDArray **hist, NDArray **bin_edges) {
+    NDArray *copy = NULL, *edges_copy = NULL;
+    const float *data;
+    long i, n = NDArray_NUMELEMENTS(a);
+    double lo = 0, hi = 1, step;
+    int *shape;
+    bin_ctx ctx;
+
+    *hist = NULL;
+    *bin_edges = NULL;
+    if (NDArray_DEVICE(a) == NDARRAY_DEVICE_GPU || (edges != NULL && NDArray_DEVICE(edges) == NDARRAY_DEVICE_GPU)) {
+        zend_throw_error(NULL, "GPU not supported.");
+        return -1;
+    }
+    memset(&ctx, 0, sizeof(ctx));
+    if (edges != NULL) {
+        if (NDArray_NDIM(edges) != 1 || NDArray_NUMELEMENTS(edges) < 2) {
+            zend_throw_error(NULL, "`bins` must be 1d, when an array");
+            return -1;
+        }
+        ctx.mode = BINS_EDGES;
+        ctx.nbins = NDArray_NUMELEMENTS(edges) - 1;
+        shape = emalloc(sizeof(int));
+        shape[0] = (int) ctx.nbins + 1;
+        *bin_edges = NDArray_Empty(shape, 1, NDARRAY_TYPE_FLOAT32, NDARRAY_DEVICE_CPU);
+        memcpy(NDArray_FDATA(*bin_edges), contiguous_data(edges, &edges_copy), sizeof(float) * (ctx.nbins + 1));
+        if (edges_copy != NULL) {
+            NDArray_FREE(edges_copy);
+        }
+        if (!edges_monotonic(NDArray_FDATA(*bin_edges), ctx.nbins + 1, 0)) {
+            NDArray_FREE(*bin_edges);
+            *bin_edges = NULL;
+            zend_throw_error(NULL, "`bins` must increase monotonically, when an array");
+            return -1;
+        }
+    } else {
+        if (bins < 1) {
+            zend_throw_error(NULL, "`bins` must be positive, when an integer");
+            return -1;
+        }
+        if (range != NULL) {
+            lo = range[0];
+            hi = range[1];
+            if (lo > hi) {
+                zend_throw_error(NULL, "max must be larger than min in range parameter.");
+                return -1;
+            }
+        } else if (n > 0) {
+            data = contiguous_data(a, &copy);
+            lo = NDArray_FloatMin(data, n);
+            hi = NDArray_FloatMax(data, n);
+            if (copy != NULL) {
+                NDArray_FREE(copy);
+                copy = NULL;
+            }
+        }
+        if (!isfinite(lo) || !isfinite(hi)) {
+            zend_throw_error(NULL, "autodetected range of [%g, %g] is not finite", lo, hi);
+            return -1;
+        }
+        if (lo == hi) {
+            lo -= 0.5;
+            hi += 0.5;
+        }
+        ctx.mode = BINS_UNIFORM;
+        ctx.nbins = bins;
+        ctx.lo = lo;
+        ctx.norm = (double) bins / (hi - lo);
+        step = (hi - lo) / bins;
+        shape = emalloc(sizeof(int));
+        shape[0] = bins + 1;
+        *bin_edges = NDArray_Empty(shape, 1, NDARRAY_TYPE_FLOAT32, NDARRAY_DEVICE_CPU);
+        for (i = 0; i < bins; i++) {
+            NDArray_FDATA(*bin_edges)[i] = (float) (lo + (double) i * step);
+        }
+        NDArray_FDATA(*bin_edges)[bins] = (float) hi;
+    }
+
+    ctx.edges = NDArray_FDATA(*bin_edges);
+    shape = emalloc(sizeof(int));
+    shape[0] = (int) ctx.nbins;
+    *hist = NDArray_Empty(shape, 1, NDARRAY_TYPE_FLOAT32, NDARRAY_DEVICE_CPU);
+    ctx.in = contiguous_data(a, &copy);
+    bin_count(&ctx, n, NDArray_FDATA(*hist));
+    if (copy != NULL) {
+        NDArray_FREE(copy);
+    }
+    return 0;
+}
+
+typedef struct {
+    float max;
+    int invalid;
+} bincount_check;
+
+static void
+bincount_check_range(long start, long end, void *ctx, void *partial) {
+    const float *in = ctx;
+    bincount_check *r = partial;
+    long i;
+
+    r->max = -1;
+    r->invalid = 0;
+    for (i = start; i < end; i++) {
+        // Also rejects NaN
+        if (!(in[i] >= 0) || in[i] != floorf(in[i])) {
+            r->invalid = 1;
+            return;
+        }
+        if (in[i] > r->max) {
+            r->max = in[i];
+        }
+    }
+}
+
+/**
+ * Number of occurrences of every non-negative integer in a CPU array, or
+ * the sum of their weights. Every value indexes its bin directly.
+ *
+ * @param x Array of non-negative integral values
+ * @param weights Optional array of the shape of `x`
+ * @param minlength Minimum number of bins
+ * @return 1-D array of max(max(x) + 1, minlength) elements
+ */
+NDArray *
+NDArray_Bincount(NDArray *x, NDArray *weights, long minlength) {
+    bincount_check partials[NDARRAY_MAX_CHUNKS];
+    NDArray *copy = NULL, *weights_copy = NULL, *rtn;
+    long chunks, i, n = NDArray_NUMELEMENTS(x), nbins;
+    float max = -1;
+    int *shape;
+    bin_ctx ctx;
+
+    if (NDArray_DEVICE(x) == NDARRAY_DEVICE_GPU || (weights != NULL && NDArray_DEVICE(weights) == NDARRAY_DEVICE_GPU)) {
+        zend_throw_error(NULL, "GPU not supported.");
+        return NULL;
+    }
+    if (minlength < 0) {
+        zend_throw_error(NULL, "'minlength' must not be negative");
+        return NULL;
+    }
+    if (weights != NULL && NDArray_NUMELEMENTS(weights) != n) {
+        zend_throw_error(NULL, "The weights and list don't have the same length.");
+        return NULL;
+    }
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.mode = BINS_INTEGER;
+    ctx.in = contiguous_data(x, &copy);
+    chunks = NDArray_ParallelReduce(n, NDARRAY_PARALLEL_GRAIN, bincount_check_range, (void *) ctx.in,
+                                    partials, sizeof(bincount_check));
+    for (i = 0; i < chunks; i++) {
+        if (partials[i].invalid) {
+            if (copy != NULL) {
+                NDArray_FREE(copy);
+            }
+            zend_throw_error(NULL, "bincount only accepts non-negative integers");
+            return NULL;
+        }
+        if (partials[i].max > max) {
+            max = partials[i].max;
+        }
+    }
+    nbins = (long) max + 1;
+    if (nbins < minlength) {
+        nbins = minlength;
+    }
+    if (nbins > INT_MAX) {
+        if (copy != NULL) {
+            NDArray_FREE(copy);
+        }
+        zend_throw_error(NULL, "maximum value is too large for bincount");
+        return NULL;
+    }
+    shape = emalloc(sizeof(int));
+    shape[0] = (int) nbins;
+    rtn = NDArray_Empty(shape, 1, NDARRAY_TYPE_FLOAT32, NDARRAY_DEVICE_CPU);
+    ctx.nbins = nbins;
+    if (weights != NULL) {
+        ctx.weights = contiguous_data(weights, &weights_copy);
+    }
+    bin_count(&ctx, n, NDArray_FDATA(rtn));
+    if (copy != NULL) {
+        NDArray_FREE(copy);
+    }
+    if (weights_copy != NULL) {
+        NDArray_FREE(weights_copy);
+    }
+    return rtn;
+}
+
+typedef struct {
+    const float *in;
+    float *out;
+    const float *bins;
+    long nbins;
+    int right;
+    int descending;
+} digitize_ctx;
+
+static void
+digitize_range(long start, long end, void *ctx) {
+    const digitize_ctx *c = ctx;
+    long i, k, lo, hi, mid;
+    float x;
+
+    for (i = start; i < end; i++) {
+        x = c->in[i];
+        if (!c->descending) {
+            k = search_edges(c->bins, c->nbins, x, c->right);
+        } else if (isnan(x)) {
+            k = 0;
+        } else {
+            // Count the edges above (or not below) x from the front
+            lo = 0;
+            hi = c->nbins;
+            while (lo < hi) {
+                mid = lo + (hi - lo) / 2;
+                if (c->right ? c->bins[mid] >= x : c->bins[mid] > x) {
+                    lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+            k = lo;
+        }
+        c->out[i] = (float) k;
+    }
+}
+
+/**
+ * Index of the bin every element of `x` belongs to. With ascending bins
+ * and `right` false, i is returned for bins[i - 1] <= x < bins[i];
+ * `right` moves the equality to the right edge. Descending bins are
+ * supported too, like numpy.digitize.
+ *
+ * @param x
+ * @param bins 1-D monotonic array
+ * @param right
+ * @return a contiguous array of the shape of `x`
+ */
+NDArray *
+NDArray_Digitize(NDArray *x, NDArray *bins, int right) {
+    NDArray *copy = NULL, *bins_copy = NULL, *rtn;
+    int *shape;
+    digitize_ctx ctx;
+
+    if (NDArray_DEVICE(x) == NDARRAY_DEVICE_GPU || NDArray_DEVICE(bins) == NDARRAY_DEVICE_GPU) {
+        zend_throw_error(NULL, "GPU not supported.");
+        return NULL;
+    }
+    if (NDArray_NDIM(bins) != 1) {
+        zend_throw_error(NULL, "object too deep for desired array");
+        return NULL;
+    }
+    ctx.bins = contiguous_data(bins, &bins_copy);
+    ctx.nbins = NDArray_NUMELEMENTS(bins);
+    ctx.right = right;
+    ctx.descending = ctx.nbins > 1 && ctx.bins[ctx.nbins - 1] < ctx.bins[0];
+    if (!edges_monotonic(ctx.bins, ctx.nbins, ctx.descending)) {
+        if (bins_copy != NULL) {
+            NDArray_FREE(bins_copy);
+        }
+        zend_throw_error(NULL, "bins must be monotonically increasing or decreasing");
+        return NULL;
+    }
+    shape = emalloc(sizeof(int) * (NDArray_NDIM(x) > 0 ? NDArray_NDIM(x) : 1));
+    memcpy(shape, NDArray_SHAPE(x), sizeof(int) * NDArray_NDIM(x));
+    rtn = NDArray_Empty(shape, NDArray_NDIM(x), NDARRAY_TYPE_FLOAT32, NDARRAY_DEVICE_CPU);
+    ctx.in = contiguous_data(x, &copy);
+    ctx.out = NDArray_FDATA(rtn);
+    NDArray_ParallelFor(NDArray_NUMELEMENTS(x), NDARRAY_PARALLEL_GRAIN, digitize_range, &ctx);
+    if (copy != NULL) {
+        NDArray_FREE(copy);
+    }
+    if (bins_copy != NULL) {
+        NDArray_FREE(bins_copy);
+    }
+    return rtn;
+}
+
+/**
+ * Sorted distinct elements of a CPU array and optionally the number of
+ * times each one occurs. The flattened array is radix sorted and equal
+ * neighbours are merged, NaN values count as a single element.
+ *
+ * @param a
+ * @param values Receives the 1-D array of distinct elements
+ * @param counts Receives the 1-D array of counts, may be NULL
+ * @return 0, -1 with an exception set on error
+ */
+int
+NDArray_Unique(NDArray *a, NDArray **values, NDArray **counts) {
+    NDArray *sorted;
+    long i, nunique = 0, n = NDArray_NUMELEMENTS(a);
+    const float *s;
+    float *v, *c = NULL;
+    int *shape;
+
+    *values = NULL;
+    if (counts != NULL) {
+        *counts = NULL;
+    }
+    sorted = NDArray_Sort(a, NDARRAY_MAX_DIMS, 0);
+    if (sorted == NULL) {
+        return -1;
+    }
+    s = NDArray_FDATA(sorted);
+    for (i = 0; i < n; i++) {
+        // NaN is sorted last, the first one starts the only NaN run
+        if (i == 0 || (s[i] != s[i - 1] && !(isnan(s[i]) && isnan(s[i - 1])))) {
+            nunique++;
+        }
+    }
+    shape = emalloc(sizeof(int));
+    shape[0] = (int) nunique;
+    *values = NDArray_Empty(shape, 1, NDARRAY_TYPE_FLOAT32, NDARRAY_DEVICE_CPU);
+    v = NDArray_FDATA(*values);
+    if (counts != NULL) {
+        shape = emalloc(sizeof(int));
+        shape[0] = (int) nunique;
+        *counts = NDArray_Empty(shape, 1, NDARRAY_TYPE_FLOAT32, NDARRAY_DEVICE_CPU);
+        c = NDArray_FDATA(*counts);
+    }
+    nunique = 0;
+    for (i = 0; i < n; i++) {
+        if (i == 0 || (s[i] != s[i - 1] && !(isnan(s[i]) && isnan(s[i - 1])))) {
+            v[nunique++] = s[i];
+            if (c != NULL) {
+                c[nunique - 1] = 0;
+            }
+        }
+        if (c != NULL) {
+            c[nunique - 1] += 1;
+        }
+    }
+    NDArray_FREE(sorted);
+    return 0;
+}
@@ -0,0 +1,10 @@
+#ifndef PHPSCI_NDARRAY_HISTOGRAM_H
+#define PHPSCI_NDARRAY_HISTOGRAM_H
+
+#include "../ndarray.h"
+
+int NDArray_Histogram(NDArray *a, int bins, NDArray *edges, const double *range, NDArray **hist, NDArray **bin_edges);
+NDArray* NDArray_Bincount(NDArray *x, NDArray *weights, long minlength);
+NDArray* NDArray_Digitize(NDArray *x, NDArray *bins, int right);
+int NDArray_Unique(NDArray *a, NDArray **values, NDArray **counts);
+#endif //PHPSCI_NDARRAY_HISTOGRAM_H
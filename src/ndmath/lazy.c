@@ -0,0 +1,368 @@
+#include <php.h>
+#include "Zend/zend_alloc.h"
+#include "Zend/zend_API.h"
+#include <string.h>
+#include "lazy.h"
+#include "simd_math.h"
+#include "../../config.h"
+#include "../initializers.h"
+#include "../types.h"
+
+/**
+ * Number of elements evaluated per node before moving to the next
+ * block. Every intermediate node gets a scratch block of this size,
+ * small enough for the whole working set of a typical expression to
+ * stay in L1/L2.
+ */
+#define NDARRAY_EXPR_BLOCK 512
+
+static NDArrayExpr*
+expr_alloc(NDArrayExpr_Kind kind, int ndim, const int *shape) {
+    NDArrayExpr *expr = emalloc(sizeof(NDArrayExpr));
+    expr->kind = kind;
+    expr->refcount = 1;
+    expr->ndim = ndim;
+    expr->shape = emalloc(sizeof(int) * (ndim > 0 ? ndim : 1));
+    if (ndim > 0) {
+        memcpy(expr->shape, shape, sizeof(int) * ndim);
+    }
+    expr->array = NULL;
+    expr->scalar = 0.0f;
+    expr->func = NULL;
+    expr->op = NDARRAY_BINARY_ADD;
+    expr->left = NULL;
+    expr->right = NULL;
+    expr->slot = -1;
+    return expr;
+}
+
+/**
+ * Expression reading an existing array. The array is referenced, not
+ * copied, so changes made to it before evaluation are visible.
+ *
+ * @param array
+ * @return
+ */
+NDArrayExpr*
+NDArrayExpr_Leaf(NDArray *array) {
+    NDArrayExpr *expr;
+    if (NDArray_DEVICE(array) != NDARRAY_DEVICE_CPU) {
+        zend_throw_error(NULL, "Lazy evaluation is only available for CPU arrays.");
+        return NULL;
+    }
+    expr = expr_alloc(NDARRAY_EXPR_LEAF, NDArray_NDIM(array), NDArray_SHAPE(array));
+    NDArray_ADDREF(array);
+    expr->array = array;
+    return expr;
+}
+
+/**
+ * @param scalar
+ * @return
+ */
+NDArrayExpr*
+NDArrayExpr_Scalar(float scalar) {
+    NDArrayExpr *expr = expr_alloc(NDARRAY_EXPR_SCALAR, 0, NULL);
+    expr->scalar = scalar;
+    return expr;
+}
+
+/**
+ * `func` applied element-wise to `operand`. The caller keeps its own
+ * reference to `operand`.
+ *
+ * @param func
+ * @param operand
+ * @return
+ */
+NDArrayExpr*
+NDArrayExpr_Unary(ElementWiseDoubleOperation func, NDArrayExpr *operand) {
+    NDArrayExpr *expr = expr_alloc(NDARRAY_EXPR_UNARY, operand->ndim, operand->shape);
+    expr->func = func;
+    operand->refcount++;
+    expr->left = operand;
+    return expr;
+}
+
+/**
+ * `left op right` with broadcasting. The caller keeps its own
+ * references to `left` and `right`.
+ *
+ * @param op
+ * @param left
+ * @param right
+ * @return NULL if the operands can't be broadcast together
+ */
+NDArrayExpr*
+NDArrayExpr_Binary(NDArray_BinaryOp op, NDArrayExpr *left, NDArrayExpr *right) {
+    NDArrayExpr *expr;
+    int shape[NDARRAY_MAX_DIMS];
+    int ndim = NDArray_BroadcastShapes(left->ndim, left->shape, right->ndim, right->shape, shape);
+    if (ndim < 0) {
+        zend_throw_error(NULL, "Can't broadcast arrays.");
+        return NULL;
+    }
+    expr = expr_alloc(NDARRAY_EXPR_BINARY, ndim, shape);
+    expr->op = op;
+    left->refcount++;
+    right->refcount++;
+    expr->left = left;
+    expr->right = right;
+    return expr;
+}
+
+/**
+ * Release a reference to `expr`
+ *
+ * @param expr
+ */
+void
+NDArrayExpr_FREE(NDArrayExpr *expr) {
+    if (expr == NULL || --expr->refcount > 0) {
+        return;
+    }
+    NDArrayExpr_FREE(expr->left);
+    NDArrayExpr_FREE(expr->right);
+    if (expr->array != NULL) {
+        NDArray_FREE(expr->array);
+    }
+    efree(expr->shape);
+    efree(expr);
+}
+
+/**
+ * Append the nodes reachable from `expr` in post-order, each node once
+ */
+static void
+expr_collect(NDArrayExpr *expr, NDArrayExpr ***nodes, int *count, int *capacity) {
+    if (expr->slot >= 0) {
+        return;
+    }
+    if (expr->left != NULL) {
+        expr_collect(expr->left, nodes, count, capacity);
+    }
+    if (expr->right != NULL) {
+        expr_collect(expr->right, nodes, count, capacity);
+    }
+    if (*count == *capacity) {
+        *capacity *= 2;
+        *nodes = erealloc(*nodes, sizeof(NDArrayExpr*) * (*capacity));
+    }
+    expr->slot = *count;
+    (*nodes)[(*count)++] = expr;
+}
+
+static void
+expr_unary_loop(ElementWiseDoubleOperation func, char *ip, int is, char *op, int os, long n) {
+    long i;
+    if (is == sizeof(float) && os == sizeof(float)) {
+        float *in = (float *) ip, *out = (float *) op;
+        NDArray_VectorKernel kernel = NDArray_GetVectorKernel(func);
+        if (kernel != NULL) {
+            kernel(in, out, n);
+            return;
+        }
+        for (i = 0; i < n; i++) {
+            out[i] = func(in[i]);
+        }
+        return;
+    }
+    for (i = 0; i < n; i++) {
+        *(float *) (op + i * os) = func(*(float *) (ip + i * is));
+    }
+}
+
+/**
+ * Evaluate one block of `n` elements. `ptrs`/`strides` hold the current
+ * position of every leaf and scalar, intermediate results go to their
+ * scratch block and the last node writes to `out`.
+ */
+static void
+expr_eval_block(NDArrayExpr **nodes, int count, char **ptrs, int *strides,
+                float *scratch, char *out, int out_stride, long n) {
+    int i;
+    char *dst;
+    int dst_stride;
+    NDArrayExpr *node;
+
+    for (i = 0; i < count; i++) {
+        node = nodes[i];
+        if (i == count - 1) {
+            dst = out;
+            dst_stride = out_stride;
+        } else {
+            dst = (char *) (scratch + (long) i * NDARRAY_EXPR_BLOCK);
+            dst_stride = sizeof(float);
+        }
+        switch (node->kind) {
+            case NDARRAY_EXPR_LEAF:
+            case NDARRAY_EXPR_SCALAR:
+                // Leaves are read in place, only copied when they are the whole expression
+                if (i == count - 1) {
+                    for (long k = 0; k < n; k++) {
+                        *(float *) (dst + k * dst_stride) = *(float *) (ptrs[i] + k * strides[i]);
+                    }
+                }
+                continue;
+            case NDARRAY_EXPR_UNARY:
+                expr_unary_loop(node->func, ptrs[node->left->slot], strides[node->left->slot], dst, dst_stride, n);
+                break;
+            case NDARRAY_EXPR_BINARY:
+                NDArray_GetBinaryLoop(node->op)(ptrs[node->left->slot], strides[node->left->slot],
+                                                ptrs[node->right->slot], strides[node->right->slot],
+                                                dst, dst_stride, n);
+                break;
+        }
+        ptrs[i] = dst;
+        strides[i] = dst_stride;
+    }
+}
+
+/**
+ * Evaluate `expr` in a single pass over memory.
+ *
+ * Instead of running one full pass and allocating one array per
+ * operator, the iteration space is walked once: for each block of
+ * NDARRAY_EXPR_BLOCK elements every node of the expression is computed
+ * in turn, so intermediate results never leave the cache. Operands are
+ * read through broadcast strides and never materialized.
+ *
+ * @param expr
+ * @return
+ */
+NDArray*
+NDArrayExpr_Eval(NDArrayExpr *expr) {
+    int i, k, nd = 0, inner, count = 0, capacity = 16, merge;
+    int ndim = expr->ndim;
+    int dims[NDARRAY_MAX_DIMS], coords[NDARRAY_MAX_DIMS], out_strides[NDARRAY_MAX_DIMS];
+    int *rtn_shape, **leaf_strides, *strides, so;
+    long outer = 1, it, start, n;
+    char **base, **ptrs, *out;
+    float *scratch;
+    NDArrayExpr **nodes;
+    NDArray *rtn;
+
+    rtn_shape = emalloc(sizeof(int) * (ndim > 0 ? ndim : 1));
+    rtn_shape[0] = 1;
+    memcpy(rtn_shape, expr->shape, sizeof(int) * ndim);
+    rtn = NDArray_Empty(rtn_shape, ndim, NDARRAY_TYPE_FLOAT32, NDARRAY_DEVICE_CPU);
+    if (NDArray_NUMELEMENTS(rtn) == 0) {
+        return rtn;
+    }
+
+    nodes = emalloc(sizeof(NDArrayExpr*) * capacity);
+    expr_collect(expr, &nodes, &count, &capacity);
+
+    base = emalloc(sizeof(char*) * count);
+    ptrs = emalloc(sizeof(char*) * count);
+    strides = emalloc(sizeof(int) * count);
+    leaf_strides = ecalloc(count, sizeof(int*));
+    scratch = emalloc(sizeof(float) * NDARRAY_EXPR_BLOCK * count);
+
+    // Leaves are read through strides broadcast to the output shape
+    for (k = 0; k < count; k++) {
+        base[k] = NULL;
+        if (nodes[k]->kind == NDARRAY_EXPR_LEAF) {
+            leaf_strides[k] = emalloc(sizeof(int) * (ndim > 0 ? ndim : 1));
+            broadcast_strides(ndim, expr->shape, NDArray_NDIM(nodes[k]->array), NDArray_SHAPE(nodes[k]->array),
+                              NDArray_STRIDES(nodes[k]->array), "operand", leaf_strides[k]);
+            base[k] = NDArray_DATA(nodes[k]->array);
+        } else if (nodes[k]->kind == NDARRAY_EXPR_SCALAR) {
+            base[k] = (char *) &nodes[k]->scalar;
+        }
+    }
+
+    // Drop unit dimensions and merge dimensions contiguous for every leaf
+    for (i = 0; i < ndim; i++) {
+        if (expr->shape[i] == 1) {
+            continue;
+        }
+        merge = nd > 0 && out_strides[nd - 1] == NDArray_STRIDES(rtn)[i] * expr->shape[i];
+        for (k = 0; merge && k < count; k++) {
+            if (leaf_strides[k] != NULL && leaf_strides[k][nd - 1] != leaf_strides[k][i] * expr->shape[i]) {
+                merge = 0;
+            }
+        }
+        if (merge) {
+            dims[nd - 1] *= expr->shape[i];
+        } else {
+            dims[nd] = expr->shape[i];
+            nd++;
+        }
+        out_strides[nd - 1] = NDArray_STRIDES(rtn)[i];
+        for (k = 0; k < count; k++) {
+            if (leaf_strides[k] != NULL) {
+                leaf_strides[k][nd - 1] = leaf_strides[k][i];
+            }
+        }
+    }
+    if (nd == 0) {
+        dims[0] = 1;
+        out_strides[0] = sizeof(float);
+        for (k = 0; k < count; k++) {
+            if (leaf_strides[k] != NULL) {
+                leaf_strides[k][0] = 0;
+            }
+        }
+        nd = 1;
+    }
+
+    inner = nd - 1;
+    for (i = 0; i < inner; i++) {
+        outer *= dims[i];
+        coords[i] = 0;
+    }
+
+    out = NDArray_DATA(rtn);
+    so = out_strides[inner];
+    for (it = 0; it < outer; it++) {
+        for (start = 0; start < dims[inner]; start += NDARRAY_EXPR_BLOCK) {
+            n = dims[inner] - start;
+            if (n > NDARRAY_EXPR_BLOCK) {
+                n = NDARRAY_EXPR_BLOCK;
+            }
+            for (k = 0; k < count; k++) {
+                if (leaf_strides[k] != NULL) {
+                    ptrs[k] = base[k] + start * leaf_strides[k][inner];
+                    strides[k] = leaf_strides[k][inner];
+                } else {
+                    ptrs[k] = base[k];
+                    strides[k] = 0;
+                }
+            }
+            expr_eval_block(nodes, count, ptrs, strides, scratch, out + start * so, so, n);
+        }
+        for (i = inner - 1; i >= 0; i--) {
+            out += out_strides[i];
+            for (k = 0; k < count; k++) {
+                if (leaf_strides[k] != NULL) {
+                    base[k] += leaf_strides[k][i];
+                }
+            }
+            if (++coords[i] < dims[i]) {
+                break;
+            }
+            out -= (long) out_strides[i] * dims[i];
+            for (k = 0; k < count; k++) {
+                if (leaf_strides[k] != NULL) {
+                    base[k] -= (long) leaf_strides[k][i] * dims[i];
+                }
+            }
+            coords[i] = 0;
+        }
+    }
+
+    for (k = 0; k < count; k++) {
+        nodes[k]->slot = -1;
+        if (leaf_strides[k] != NULL) {
+            efree(leaf_strides[k]);
+        }
+    }
+    efree(leaf_strides);
+    efree(scratch);
+    efree(strides);
+    efree(ptrs);
+    efree(base);
+    efree(nodes);
+    return rtn;
+}
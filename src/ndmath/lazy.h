@@ -0,0 +1,39 @@
+#ifndef PHPSCI_NDARRAY_LAZY_H
+#define PHPSCI_NDARRAY_LAZY_H
+
+#include "../ndarray.h"
+#include "elementwise.h"
+
+typedef enum {
+    NDARRAY_EXPR_LEAF = 0,
+    NDARRAY_EXPR_SCALAR,
+    NDARRAY_EXPR_UNARY,
+    NDARRAY_EXPR_BINARY
+} NDArrayExpr_Kind;
+
+/**
+ * Node of a deferred element-wise expression. Nodes are reference
+ * counted and may be shared by several expressions, so an expression
+ * is a DAG rather than a tree.
+ */
+typedef struct NDArrayExpr {
+    NDArrayExpr_Kind kind;
+    int refcount;
+    int ndim;
+    int *shape;
+    NDArray *array;                     // NDARRAY_EXPR_LEAF
+    float scalar;                       // NDARRAY_EXPR_SCALAR
+    ElementWiseDoubleOperation func;    // NDARRAY_EXPR_UNARY
+    NDArray_BinaryOp op;                // NDARRAY_EXPR_BINARY
+    struct NDArrayExpr *left;
+    struct NDArrayExpr *right;
+    int slot;                           // Position in the evaluation order, -1 outside NDArrayExpr_Eval
+} NDArrayExpr;
+
+NDArrayExpr* NDArrayExpr_Leaf(NDArray *array);
+NDArrayExpr* NDArrayExpr_Scalar(float scalar);
+NDArrayExpr* NDArrayExpr_Unary(ElementWiseDoubleOperation func, NDArrayExpr *operand);
+NDArrayExpr* NDArrayExpr_Binary(NDArray_BinaryOp op, NDArrayExpr *left, NDArrayExpr *right);
+NDArray* NDArrayExpr_Eval(NDArrayExpr *expr);
+void NDArrayExpr_FREE(NDArrayExpr *expr);
+#endif //PHPSCI_NDARRAY_LAZY_H
@@ -30,10 +30,6 @@
 #include "../gpu_alloc.h"
 #endif
 
-#ifdef HAVE_AVX2
-#include <immintrin.h>
-#endif
-
 /**
  * Double type (float64) matmul
  *
@@ -1072,31 +1068,11 @@ NDArray_Cholesky(NDArray *a) {
         zend_throw_error(NULL, "Error calculating the cholesky decomposition. (Is $a not positive definite?)");
         return NULL;
     }
-#ifdef HAVE_AVX2
-    int blockSize = 8; // AVX2 can process 8 single-precision floats at a time
-    for (int i = 0; i < NDArray_SHAPE(a)[0]; i++) {
-        // Perform AVX2 loop for blocks of 8 elements
-        int j = i + 1;
-        for (; j < NDArray_SHAPE(a)[0] - blockSize + 1; j += blockSize) {
-            // Load 8 elements of the row (upper triangular elements) into an AVX register
-            __m256 row_avx = _mm256_loadu_ps(&NDArray_FDATA(rtn)[i * NDArray_SHAPE(a)[0] + j]);
-            // Set all elements of the AVX register to 0
-            __m256 zero_avx = _mm256_setzero_ps();
-            // Store the 0s back into the upper triangular elements of the row
-            _mm256_storeu_ps(&NDArray_FDATA(rtn)[i * NDArray_SHAPE(a)[0] + j], zero_avx);
-        }
-        // Handle the remaining elements
-        for (; j < NDArray_SHAPE(a)[0]; j++) {
-            NDArray_FDATA(rtn)[i * NDArray_SHAPE(a)[0] + j] = 0.0f;
-        }
-    }
-#else
     for (int i = 0; i < NDArray_SHAPE(a)[0]; i++) {
         for (int j = i + 1; j < NDArray_SHAPE(a)[1]; j++) {
             NDArray_FDATA(rtn)[i * NDArray_SHAPE(a)[0] + j] = 0.0f;
         }
     }
-#endif
 
     return rtn;
 }
\ No newline at end of file
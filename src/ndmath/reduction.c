@@ -0,0 +1,1062 @@
+#include <php.h>
+#include "Zend/zend_alloc.h"
+#include "Zend/zend_API.h"
+#include <limits.h>
+#include <string.h>
+#include <math.h>
+#include "reduction.h"
+#include "elementwise.h"
+#include "simd_math.h"
+#include "../../config.h"
+#include "../initializers.h"
+#include "../manipulation.h"
+#include "../types.h"
+#include "../threadpool.h"
+
+static const char *reduce_names[NDARRAY_REDUCE_NUM_OPS] = {
+    [NDARRAY_REDUCE_SUM] = "sum",
+    [NDARRAY_REDUCE_PROD] = "prod",
+    [NDARRAY_REDUCE_MIN] = "min",
+    [NDARRAY_REDUCE_MAX] = "max",
+    [NDARRAY_REDUCE_MEAN] = "mean",
+    [NDARRAY_REDUCE_VAR] = "variance",
+    [NDARRAY_REDUCE_STD] = "std",
+};
+
+/**
+ * Largest output, in elements, for which threads reduce into private
+ * copies of the output that are merged afterwards
+ */
+#define REDUCE_MAX_PARTIAL_OUTPUT 4096
+
+/**
+ * Rows are split into blocks of this many elements for the variance,
+ * each block is read twice while it is still in L1
+ */
+#define REDUCE_MOMENTS_BLOCK 1024
+
+/**
+ * Running count, mean and sum of squared deviations of the variance
+ */
+typedef struct {
+    double n;
+    double mean;
+    double m2;
+} reduce_moments;
+
+/**
+ * Count and running result of a masked reduction, only the elements that
+ * are included are counted
+ */
+typedef struct {
+    double n;
+    double value;
+} reduce_masked;
+
+/**
+ * Mask of the reductions that only skip NaN, every element is selected
+ */
+static float reduce_select_all = 1.0f;
+
+/**
+ * Collapsed iteration space of a reduction. Reduced dimensions have an
+ * output stride of 0, so the input is walked once in memory order and
+ * every element is folded into the output element it belongs to.
+ *
+ * Sums and means are accumulated into doubles (`wide`), rows are summed
+ * pairwise, and only the final result is rounded to float. Variances
+ * accumulate reduce_moments (`moments`).
+ *
+ * Masked reductions (`masked`) walk the `where` mask with the input, it
+ * is broadcast through strides of 0, and fold only the selected elements
+ * that are not NaN when `skipnan` is set. Every output keeps a
+ * reduce_masked, or reduce_moments for the variance.
+ */
+typedef struct {
+    NDArray_ReduceOp op;
+    NDArray_BinaryLoop accumulate;
+    int wide;
+    int moments;
+    size_t elsize;
+    int nd;
+    int dims[NDARRAY_MAX_DIMS];
+    int in_strides[NDARRAY_MAX_DIMS];
+    int out_strides[NDARRAY_MAX_DIMS];
+    int where_strides[NDARRAY_MAX_DIMS];
+    char *in;
+    char *out;
+    char *where;
+    int masked;
+    int skipnan;
+    long out_size;
+    long total;
+    int split;
+} reduce_ctx;
+
+/**
+ * Reduce `n` strided elements
+ */
+static float
+reduce_row(NDArray_ReduceOp op, const char *in, int is, long n) {
+    float value;
+    long i;
+
+    switch (op) {
+        case NDARRAY_REDUCE_PROD:
+            value = 1.0f;
+            for (i = 0; i < n; i++) {
+                value *= *(const float *) (in + i * is);
+            }
+            return value;
+        case NDARRAY_REDUCE_MIN:
+            if (is == sizeof(float)) {
+                return NDArray_FloatMin((const float *) in, n);
+            }
+            value = *(const float *) in;
+            for (i = 1; i < n; i++) {
+                if (*(const float *) (in + i * is) < value) {
+                    value = *(const float *) (in + i * is);
+                }
+            }
+            return value;
+        case NDARRAY_REDUCE_MAX:
+            if (is == sizeof(float)) {
+                return NDArray_FloatMax((const float *) in, n);
+            }
+            value = *(const float *) in;
+            for (i = 1; i < n; i++) {
+                if (*(const float *) (in + i * is) > value) {
+                    value = *(const float *) (in + i * is);
+                }
+            }
+            return value;
+        default:
+            return (float) NDArray_PairwiseSum(in, is, n);
+    }
+}
+
+/**
+ * Fold `value` into `acc`. Like the full-array min and max, a NaN is only
+ * kept when it is the first element.
+ */
+static inline float
+reduce_combine(NDArray_ReduceOp op, float acc, float value) {
+    switch (op) {
+        case NDARRAY_REDUCE_PROD:
+            return acc * value;
+        case NDARRAY_REDUCE_MIN:
+            return (value < acc) ? value : acc;
+        case NDARRAY_REDUCE_MAX:
+            return (value > acc) ? value : acc;
+        default:
+            return acc + value;
+    }
+}
+
+/**
+ * Merge the moments of another set of `n` values into `m` (Chan et al.)
+ */
+static inline void
+moments_merge(reduce_moments *m, double n, double mean, double m2) {
+    double total, delta;
+    if (n == 0) {
+        return;
+    }
+    total = m->n + n;
+    delta = mean - m->mean;
+    m->mean += delta * (n / total);
+    m->m2 += m2 + delta * delta * (m->n * n / total);
+    m->n = total;
+}
+
+/**
+ * Fold a row of `n` strided elements into `m`. Contiguous rows go
+ * through the SIMD kernels one block at a time, the block is summed
+ * and then its squared deviations from the block mean, and the blocks
+ * are merged.
+ */
+static void
+moments_row(reduce_moments *m, const char *in, int is, long n) {
+    long i, j, len;
+    double mean, m2, d;
+
+    for (i = 0; i < n; i += REDUCE_MOMENTS_BLOCK) {
+        len = (n - i < REDUCE_MOMENTS_BLOCK) ? n - i : REDUCE_MOMENTS_BLOCK;
+        mean = NDArray_PairwiseSum(in + i * is, is, len) / (double) len;
+        if (is == sizeof(float)) {
+            m2 = NDArray_FloatSquaredDeviations((const float *) in + i, len, mean);
+        } else {
+            m2 = 0;
+            for (j = i; j < i + len; j++) {
+                d = *(const float *) (in + j * is) - mean;
+                m2 += d * d;
+            }
+        }
+        moments_merge(m, (double) len, mean, m2);
+    }
+}
+
+/**
+ * Fold the result of `n` selected elements into `m`. NaN propagates
+ * through MIN and MAX, only the selected elements are ever folded.
+ */
+static inline void
+masked_merge(NDArray_ReduceOp op, reduce_masked *m, double n, double value) {
+    if (n == 0) {
+        return;
+    }
+    if (m->n == 0) {
+        m->value = value;
+    } else {
+        switch (op) {
+            case NDARRAY_REDUCE_PROD:
+                m->value *= value;
+                break;
+            case NDARRAY_REDUCE_MIN:
+                m->value = (value < m->value || isnan(value)) ? value : m->value;
+                break;
+            case NDARRAY_REDUCE_MAX:
+                m->value = (value > m->value || isnan(value)) ? value : m->value;
+                break;
+            default:
+                m->value += value;
+        }
+    }
+    m->n += n;
+}
+
+/**
+ * Fold the selected elements of a row of `n` contiguous floats into a
+ * single output. `mask` is NULL when every element is selected.
+ */
+static void
+masked_row(const reduce_ctx *c, const float *in, const float *mask, long n, char *out) {
+    long i, len, count;
+    double sum, m2;
+    float value;
+
+    if (c->moments) {
+        for (i = 0; i < n; i += REDUCE_MOMENTS_BLOCK) {
+            len = (n - i < REDUCE_MOMENTS_BLOCK) ? n - i : REDUCE_MOMENTS_BLOCK;
+            count = NDArray_FloatMaskedSum(in + i, mask != NULL ? mask + i : NULL, len, c->skipnan, &sum);
+            if (count == 0) {
+                continue;
+            }
+            m2 = NDArray_FloatMaskedSquaredDeviations(in + i, mask != NULL ? mask + i : NULL, len, c->skipnan,
+                                                      sum / (double) count);
+            moments_merge((reduce_moments *) out, (double) count, sum / (double) count, m2);
+        }
+        return;
+    }
+    switch (c->op) {
+        case NDARRAY_REDUCE_MIN:
+        case NDARRAY_REDUCE_MAX:
+            count = NDArray_FloatMaskedMinMax(in, mask, n, c->skipnan, c->op == NDARRAY_REDUCE_MAX, &value);
+            masked_merge(c->op, (reduce_masked *) out, (double) count, value);
+            break;
+        case NDARRAY_REDUCE_PROD:
+            for (i = 0; i < n; i++) {
+                if ((!c->skipnan || !isnan(in[i])) && (mask == NULL || mask[i] != 0)) {
+                    masked_merge(c->op, (reduce_masked *) out, 1, in[i]);
+                }
+            }
+            break;
+        default:
+            count = NDArray_FloatMaskedSum(in, mask, n, c->skipnan, &sum);
+            masked_merge(c->op, (reduce_masked *) out, (double) count, sum);
+    }
+}
+
+/**
+ * Inner loop of the masked reductions, `where` and `ws` are the position
+ * and stride of the mask
+ */
+static void
+reduce_masked_inner(const reduce_ctx *c, const char *in, int is, const char *where, int ws, char *out, int os,
+                    long n) {
+    long i;
+    float x;
+
+    if (ws == 0 && *(const float *) where == 0) {
+        return;
+    }
+    if (os == 0 && is == sizeof(float) && (ws == 0 || ws == sizeof(float))) {
+        masked_row(c, (const float *) in, ws == 0 ? NULL : (const float *) where, n, out);
+        return;
+    }
+    for (i = 0; i < n; i++) {
+        x = *(const float *) (in + i * is);
+        if ((c->skipnan && isnan(x)) || *(const float *) (where + i * ws) == 0) {
+            continue;
+        }
+        if (c->moments) {
+            moments_merge((reduce_moments *) (out + i * os), 1, x, 0);
+        } else {
+            masked_merge(c->op, (reduce_masked *) (out + i * os), 1, x);
+        }
+    }
+}
+
+/**
+ * Inner loop. With an output stride of 0 the row is reduced into a single
+ * output element, otherwise each input element is folded into its own
+ * output element.
+ */
+static void
+reduce_inner(const reduce_ctx *c, char *in, int is, char *where, int ws, char *out, int os, long n) {
+    long i;
+    float *o;
+    reduce_moments *m;
+    double delta;
+
+    if (c->masked) {
+        reduce_masked_inner(c, in, is, where, ws, out, os, n);
+        return;
+    }
+    if (c->moments) {
+        if (os == 0) {
+            moments_row((reduce_moments *) out, in, is, n);
+            return;
+        }
+        // Welford update, one new value for every output element
+        for (i = 0; i < n; i++) {
+            m = (reduce_moments *) (out + i * os);
+            m->n += 1;
+            delta = *(const float *) (in + i * is) - m->mean;
+            m->mean += delta / m->n;
+            m->m2 += delta * (*(const float *) (in + i * is) - m->mean);
+        }
+        return;
+    }
+    if (c->wide) {
+        if (os == 0) {
+            *(double *) out += NDArray_PairwiseSum(in, is, n);
+        } else if (is == sizeof(float) && os == sizeof(double)) {
+            NDArray_FloatAccumulate((double *) out, (const float *) in, n);
+        } else {
+            for (i = 0; i < n; i++) {
+                *(double *) (out + i * os) += *(const float *) (in + i * is);
+            }
+        }
+        return;
+    }
+    if (os == 0) {
+        *(float *) out = reduce_combine(c->op, *(float *) out, reduce_row(c->op, in, is, n));
+        return;
+    }
+    if (c->accumulate != NULL) {
+        c->accumulate(out, os, in, is, out, os, n);
+        return;
+    }
+    for (i = 0; i < n; i++) {
+        o = (float *) (out + i * os);
+        *o = reduce_combine(c->op, *o, *(float *) (in + i * is));
+    }
+}
+
+/**
+ * Walk the iteration space with the sizes in `dims` from the given input
+ * and output positions
+ */
+static void
+reduce_walk(const reduce_ctx *c, const int *dims, char *in, char *where, char *out) {
+    int i, inner = c->nd - 1;
+    int coords[NDARRAY_MAX_DIMS];
+    long outer = 1, it;
+
+    for (i = 0; i < c->nd; i++) {
+        if (dims[i] == 0) {
+            return;
+        }
+    }
+    for (i = 0; i < inner; i++) {
+        outer *= dims[i];
+        coords[i] = 0;
+    }
+    for (it = 0; it < outer; it++) {
+        reduce_inner(c, in, c->in_strides[inner], where, c->where_strides[inner], out, c->out_strides[inner],
+                     dims[inner]);
+        for (i = inner - 1; i >= 0; i--) {
+            in += c->in_strides[i];
+            where += c->where_strides[i];
+            out += c->out_strides[i];
+            if (++coords[i] < dims[i]) {
+                break;
+            }
+            in -= (long) c->in_strides[i] * dims[i];
+            where -= (long) c->where_strides[i] * dims[i];
+            out -= (long) c->out_strides[i] * dims[i];
+            coords[i] = 0;
+        }
+    }
+}
+
+/**
+ * Walk the part of the split dimension that belongs to elements
+ * [start, end) of the iteration space
+ */
+static void
+reduce_walk_range(const reduce_ctx *c, long start, long end, char *out) {
+    int dims[NDARRAY_MAX_DIMS];
+    long size = c->dims[c->split];
+    long lo = (start * size + c->total - 1) / c->total;
+    long hi = (end * size + c->total - 1) / c->total;
+
+    if (lo >= hi) {
+        return;
+    }
+    memcpy(dims, c->dims, sizeof(int) * c->nd);
+    dims[c->split] = (int) (hi - lo);
+    reduce_walk(c, dims, c->in + lo * c->in_strides[c->split], c->where + lo * c->where_strides[c->split],
+                out + lo * c->out_strides[c->split]);
+}
+
+/**
+ * Split along a kept dimension, threads write disjoint outputs
+ */
+static void
+reduce_kept_range(long start, long end, void *ctx) {
+    const reduce_ctx *c = ctx;
+    reduce_walk_range(c, start, end, c->out);
+}
+
+/**
+ * Split along a reduced dimension, each chunk starts from a copy of the
+ * initial output and the caller merges the copies
+ */
+static void
+reduce_partial_range(long start, long end, void *ctx, void *partial) {
+    const reduce_ctx *c = ctx;
+    memcpy(partial, c->out, c->elsize * c->out_size);
+    reduce_walk_range(c, start, end, partial);
+}
+
+/**
+ * Copy the elements at index 0 of every reduced axis to the output, the
+ * starting point of reductions without an identity
+ */
+static void
+reduce_copy_first(NDArray *a, const char *reduced, float *out) {
+    int i, nd = 0;
+    int dims[NDARRAY_MAX_DIMS], strides[NDARRAY_MAX_DIMS], coords[NDARRAY_MAX_DIMS];
+    char *in = NDArray_DATA(a);
+    long n = 1, it;
+
+    for (i = 0; i < NDArray_NDIM(a); i++) {
+        if (!reduced[i]) {
+            dims[nd] = NDArray_SHAPE(a)[i];
+            strides[nd] = NDArray_STRIDES(a)[i];
+            coords[nd] = 0;
+            n *= dims[nd];
+            nd++;
+        }
+    }
+    for (it = 0; it < n; it++) {
+        out[it] = *(float *) in;
+        for (i = nd - 1; i >= 0; i--) {
+            in += strides[i];
+            if (++coords[i] < dims[i]) {
+                break;
+            }
+            in -= (long) strides[i] * dims[i];
+            coords[i] = 0;
+        }
+    }
+}
+
+/**
+ * Validate the `axis` argument of a reduction and mark the reduced axes.
+ * Negative axes count from the end.
+ *
+ * @param ndim
+ * @param axes
+ * @param naxes
+ * @param reduced Set to 1 for every reduced axis, `ndim` entries
+ * @return 0 on success, -1 with an exception set otherwise
+ */
+int
+NDArray_ReduceAxes(int ndim, const int *axes, int naxes, char *reduced) {
+    int i, axis;
+
+    memset(reduced, 0, ndim);
+    for (i = 0; i < naxes; i++) {
+        axis = axes[i];
+        if (axis < -ndim || axis >= ndim) {
+            zend_throw_error(NULL, "axis %d is out of bounds for array of dimension %d", axis, ndim);
+            return -1;
+        }
+        if (axis < 0) {
+            axis += ndim;
+        }
+        if (reduced[axis]) {
+            zend_throw_error(NULL, "duplicate value in 'axis'");
+            return -1;
+        }
+        reduced[axis] = 1;
+    }
+    return 0;
+}
+
+/**
+ * Reduce a CPU array over one or more axes, see NDArray_ReduceDdof
+ *
+ * @param a
+ * @param op
+ * @param axes Axes to reduce, NULL for all of them
+ * @param naxes
+ * @param keepdims Keep the reduced axes with size 1
+ * @return
+ */
+NDArray*
+NDArray_Reduce(NDArray *a, NDArray_ReduceOp op, const int *axes, int naxes, int keepdims) {
+    return NDArray_ReduceDdof(a, op, axes, naxes, keepdims, 0);
+}
+
+/**
+ * Reduce a CPU array over one or more axes, see NDArray_ReduceWhere
+ *
+ * @param a
+ * @param op
+ * @param axes Axes to reduce, NULL for all of them
+ * @param naxes
+ * @param keepdims Keep the reduced axes with size 1
+ * @param ddof Delta degrees of freedom of VAR and STD, the divisor is N - ddof
+ * @return
+ */
+NDArray*
+NDArray_ReduceDdof(NDArray *a, NDArray_ReduceOp op, const int *axes, int naxes, int keepdims, int ddof) {
+    return NDArray_ReduceWhere(a, op, axes, naxes, keepdims, ddof, 0, NULL);
+}
+
+/**
+ * Strides of a `where` mask broadcast to the shape of `a`, 0 along the
+ * axes it is broadcast over
+ *
+ * @param a
+ * @param where
+ * @param strides Set for every axis of `a`
+ * @return 0 on success, -1 with an exception set otherwise
+ */
+static int
+reduce_where_strides(NDArray *a, NDArray *where, int *strides) {
+    int i, j, offset = NDArray_NDIM(a) - NDArray_NDIM(where);
+
+    if (NDArray_DEVICE(where) != NDARRAY_DEVICE_CPU) {
+        zend_throw_error(NULL, "`where` must be a CPU array.");
+        return -1;
+    }
+    if (offset < 0) {
+        zend_throw_error(NULL, "`where` with %d dimensions can not be broadcast to an array of dimension %d",
+                         NDArray_NDIM(where), NDArray_NDIM(a));
+        return -1;
+    }
+    for (i = 0; i < NDArray_NDIM(a); i++) {
+        j = i - offset;
+        if (j < 0 || NDArray_SHAPE(where)[j] == 1) {
+            strides[i] = 0;
+        } else if (NDArray_SHAPE(where)[j] == NDArray_SHAPE(a)[i]) {
+            strides[i] = NDArray_STRIDES(where)[j];
+        } else {
+            zend_throw_error(NULL, "`where` of size %d can not be broadcast to size %d on axis %d",
+                             NDArray_SHAPE(where)[j], NDArray_SHAPE(a)[i], i);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Reduce a CPU array over one or more axes.
+ *
+ * The input is read once through its own strides, in memory order, with
+ * no intermediate arrays: each row of the collapsed iteration space is
+ * either reduced into one output element (reduced innermost axis) or
+ * folded element-wise into a row of the output (kept innermost axis).
+ * Large arrays are split across the thread pool.
+ *
+ * Variances are computed in the same single pass: every output keeps a
+ * running count, mean and sum of squared deviations, and the partial
+ * results of rows, blocks and threads are merged with Chan's formula.
+ *
+ * Missing data is skipped inside the same loops: NaN with `skipnan` and
+ * the elements whose `where` mask is 0, without copying the input. Each
+ * output then divides by its own count, means of no element and the min
+ * and max of no element are NaN, and an included NaN propagates.
+ *
+ * @param a
+ * @param op
+ * @param axes Axes to reduce, NULL for all of them
+ * @param naxes
+ * @param keepdims Keep the reduced axes with size 1
+ * @param ddof Delta degrees of freedom of VAR and STD, the divisor is N - ddof
+ * @param skipnan Ignore NaN elements
+ * @param where Optional mask broadcastable to `a`, only the elements where it is not 0 are reduced
+ * @return
+ */
+NDArray*
+NDArray_ReduceWhere(NDArray *a, NDArray_ReduceOp op, const int *axes, int naxes, int keepdims, int ddof,
+                    int skipnan, NDArray *where) {
+    char reduced[NDARRAY_MAX_DIMS];
+    int i, j, k, nd, out_ndim = 0, split_kept = -1, split_reduced = -1;
+    int *out_shape;
+    int where_strides[NDARRAY_MAX_DIMS];
+    long count = 1, out_stride, chunks, grain;
+    float *out;
+    double *acc = NULL, divisor, variance;
+    reduce_moments *moments = NULL;
+    reduce_masked *masked = NULL;
+    char *partials;
+    NDArray *rtn;
+    reduce_ctx ctx;
+
+    if (NDArray_DEVICE(a) != NDARRAY_DEVICE_CPU) {
+        zend_throw_error(NULL, "NDArray::%s%s with axis is not supported for GPU arrays.", skipnan ? "nan" : "",
+                         reduce_names[op]);
+        return NULL;
+    }
+    if (axes == NULL) {
+        memset(reduced, 1, NDArray_NDIM(a));
+    } else if (NDArray_ReduceAxes(NDArray_NDIM(a), axes, naxes, reduced) < 0) {
+        return NULL;
+    }
+    memset(where_strides, 0, sizeof(int) * NDArray_NDIM(a));
+    if (where != NULL && reduce_where_strides(a, where, where_strides) < 0) {
+        return NULL;
+    }
+
+    out_shape = emalloc(sizeof(int) * (NDArray_NDIM(a) > 0 ? NDArray_NDIM(a) : 1));
+    out_shape[0] = 1;
+    for (i = 0; i < NDArray_NDIM(a); i++) {
+        if (reduced[i]) {
+            count *= NDArray_SHAPE(a)[i];
+            if (keepdims) {
+                out_shape[out_ndim++] = 1;
+            }
+        } else {
+            out_shape[out_ndim++] = NDArray_SHAPE(a)[i];
+        }
+    }
+    if (count == 0 && (op == NDARRAY_REDUCE_MIN || op == NDARRAY_REDUCE_MAX)) {
+        efree(out_shape);
+        zend_throw_error(NULL, "zero-size array to reduction operation %s which has no identity",
+                         reduce_names[op]);
+        return NULL;
+    }
+    rtn = NDArray_Empty(out_shape, out_ndim, NDARRAY_TYPE_FLOAT32, NDARRAY_DEVICE_CPU);
+    out = NDArray_FDATA(rtn);
+
+    ctx.op = op;
+    ctx.accumulate = NULL;
+    ctx.wide = 0;
+    ctx.moments = 0;
+    ctx.elsize = sizeof(float);
+    ctx.in = NDArray_DATA(a);
+    ctx.out = NDArray_DATA(rtn);
+    ctx.out_size = NDArray_NUMELEMENTS(rtn);
+    ctx.masked = skipnan || where != NULL;
+    ctx.skipnan = skipnan;
+    ctx.where = where != NULL ? NDArray_DATA(where) : (char *) &reduce_select_all;
+    if (ctx.masked && op != NDARRAY_REDUCE_VAR && op != NDARRAY_REDUCE_STD) {
+        masked = ecalloc(ctx.out_size > 0 ? ctx.out_size : 1, sizeof(reduce_masked));
+        ctx.elsize = sizeof(reduce_masked);
+        ctx.out = (char *) masked;
+    } else {
+        switch (op) {
+            case NDARRAY_REDUCE_PROD:
+                for (i = 0; i < ctx.out_size; i++) {
+                    out[i] = 1.0f;
+                }
+                ctx.accumulate = NDArray_GetBinaryLoop(NDARRAY_BINARY_MULTIPLY);
+                break;
+            case NDARRAY_REDUCE_MIN:
+            case NDARRAY_REDUCE_MAX:
+                reduce_copy_first(a, reduced, out);
+                break;
+            case NDARRAY_REDUCE_VAR:
+            case NDARRAY_REDUCE_STD:
+                moments = ecalloc(ctx.out_size > 0 ? ctx.out_size : 1, sizeof(reduce_moments));
+                ctx.moments = 1;
+                ctx.elsize = sizeof(reduce_moments);
+                ctx.out = (char *) moments;
+                break;
+            default:
+                acc = ecalloc(ctx.out_size > 0 ? ctx.out_size : 1, sizeof(double));
+                ctx.wide = 1;
+                ctx.elsize = sizeof(double);
+                ctx.out = (char *) acc;
+                break;
+        }
+    }
+
+    // Output strides of every input axis, 0 for the reduced ones
+    int out_strides[NDARRAY_MAX_DIMS];
+    out_stride = (long) ctx.elsize;
+    for (i = NDArray_NDIM(a) - 1; i >= 0; i--) {
+        out_strides[i] = reduced[i] ? 0 : (int) out_stride;
+        if (!reduced[i]) {
+            out_stride *= NDArray_SHAPE(a)[i];
+        }
+    }
+
+    // Drop unit axes and order the rest by decreasing input stride, so
+    // transposed views are read in memory order too
+    nd = 0;
+    ctx.total = 1;
+    for (i = 0; i < NDArray_NDIM(a); i++) {
+        ctx.total *= NDArray_SHAPE(a)[i];
+        if (NDArray_SHAPE(a)[i] == 1) {
+            continue;
+        }
+        for (j = nd; j > 0 && abs(ctx.in_strides[j - 1]) < abs(NDArray_STRIDES(a)[i]); j--) {
+            ctx.dims[j] = ctx.dims[j - 1];
+            ctx.in_strides[j] = ctx.in_strides[j - 1];
+            ctx.out_strides[j] = ctx.out_strides[j - 1];
+            ctx.where_strides[j] = ctx.where_strides[j - 1];
+        }
+        ctx.dims[j] = NDArray_SHAPE(a)[i];
+        ctx.in_strides[j] = NDArray_STRIDES(a)[i];
+        ctx.out_strides[j] = out_strides[i];
+        ctx.where_strides[j] = where_strides[i];
+        nd++;
+    }
+
+    // Merge axes that are contiguous for the input, the output and the mask
+    k = 0;
+    for (i = 0; i < nd; i++) {
+        if (k > 0 && ctx.in_strides[k - 1] == ctx.in_strides[i] * ctx.dims[i]
+                  && ctx.out_strides[k - 1] == ctx.out_strides[i] * ctx.dims[i]
+                  && ctx.where_strides[k - 1] == ctx.where_strides[i] * ctx.dims[i]) {
+            ctx.dims[k - 1] *= ctx.dims[i];
+            ctx.in_strides[k - 1] = ctx.in_strides[i];
+            ctx.out_strides[k - 1] = ctx.out_strides[i];
+            ctx.where_strides[k - 1] = ctx.where_strides[i];
+            continue;
+        }
+        ctx.dims[k] = ctx.dims[i];
+        ctx.in_strides[k] = ctx.in_strides[i];
+        ctx.out_strides[k] = ctx.out_strides[i];
+        ctx.where_strides[k] = ctx.where_strides[i];
+        k++;
+    }
+    ctx.nd = k;
+
+    if (ctx.total > 0 && ctx.nd == 0) {
+        // Every axis has size 1
+        reduce_inner(&ctx, ctx.in, 0, ctx.where, 0, ctx.out, 0, 1);
+    } else if (ctx.total > 0) {
+        for (i = 0; i < ctx.nd; i++) {
+            if (ctx.out_strides[i] != 0 && (split_kept < 0 || ctx.dims[i] > ctx.dims[split_kept])) {
+                split_kept = i;
+            }
+            if (ctx.out_strides[i] == 0 && (split_reduced < 0 || ctx.dims[i] > ctx.dims[split_reduced])) {
+                split_reduced = i;
+            }
+        }
+        chunks = NDArray_ParallelChunks(ctx.total, NDARRAY_PARALLEL_GRAIN);
+        if (chunks > 1 && split_reduced >= 0 && ctx.out_size <= REDUCE_MAX_PARTIAL_OUTPUT &&
+            (split_kept < 0 || split_kept == ctx.nd - 1 || ctx.dims[split_kept] < chunks)) {
+            // Few outputs or a contiguous output row: every thread reduces
+            // a block of the input into its own copy of the output
+            ctx.split = split_reduced;
+            partials = emalloc(ctx.elsize * ctx.out_size * chunks);
+            chunks = NDArray_ParallelReduce(ctx.total, NDARRAY_PARALLEL_GRAIN, reduce_partial_range, &ctx,
+                                            partials, ctx.elsize * ctx.out_size);
+            memcpy(ctx.out, partials, ctx.elsize * ctx.out_size);
+            for (j = 1; j < chunks; j++) {
+                for (i = 0; i < ctx.out_size; i++) {
+                    if (ctx.moments) {
+                        reduce_moments *p = (reduce_moments *) partials + j * ctx.out_size + i;
+                        moments_merge(&moments[i], p->n, p->mean, p->m2);
+                    } else if (masked != NULL) {
+                        reduce_masked *p = (reduce_masked *) partials + j * ctx.out_size + i;
+                        masked_merge(op, &masked[i], p->n, p->value);
+                    } else if (ctx.wide) {
+                        acc[i] += ((double *) partials)[j * ctx.out_size + i];
+                    } else {
+                        out[i] = reduce_combine(op, out[i], ((float *) partials)[j * ctx.out_size + i]);
+                    }
+                }
+            }
+            efree(partials);
+        } else if (chunks > 1 && split_kept >= 0) {
+            // Every thread produces its own block of the output. A handful
+            // of chunks per thread, so each one reads long runs of memory.
+            ctx.split = split_kept;
+            grain = ctx.total / chunks;
+            NDArray_ParallelFor(ctx.total, grain > NDARRAY_PARALLEL_GRAIN ? grain : NDARRAY_PARALLEL_GRAIN,
+                                reduce_kept_range, &ctx);
+        } else {
+            reduce_walk(&ctx, ctx.dims, ctx.in, ctx.where, ctx.out);
+        }
+    }
+
+    if (ctx.wide) {
+        for (i = 0; i < ctx.out_size; i++) {
+            out[i] = (float) (op == NDARRAY_REDUCE_MEAN ? acc[i] / (double) count : acc[i]);
+        }
+        efree(acc);
+    }
+    if (masked != NULL) {
+        for (i = 0; i < ctx.out_size; i++) {
+            if (masked[i].n > 0) {
+                out[i] = (float) (op == NDARRAY_REDUCE_MEAN ? masked[i].value / masked[i].n : masked[i].value);
+            } else {
+                out[i] = op == NDARRAY_REDUCE_SUM ? 0.0f : op == NDARRAY_REDUCE_PROD ? 1.0f : NAN;
+            }
+        }
+        efree(masked);
+    }
+    if (ctx.moments) {
+        // N - ddof <= 0 has no defined variance, masked outputs have their own N
+        for (i = 0; i < ctx.out_size; i++) {
+            divisor = (ctx.masked ? moments[i].n : (double) count) - ddof;
+            variance = divisor > 0 ? moments[i].m2 / divisor : NAN;
+            out[i] = (float) (op == NDARRAY_REDUCE_STD ? sqrt(variance) : variance);
+        }
+        efree(moments);
+    }
+    return rtn;
+}
+
+/**
+ * Largest number of private accumulators, over all threads, a segment
+ * reduction may allocate before it splits the columns between threads
+ * instead of the rows
+ */
+#define SEGMENT_MAX_PARTIAL (1L << 22)
+
+/**
+ * Rows of `values` folded into the segment named by their id. Sums and
+ * means accumulate in doubles.
+ */
+typedef struct {
+    NDArray_ReduceOp op;
+    const float *in;
+    const int *ids;
+    long rows;
+    long row_len;
+    long num_segments;
+    double *acc;            // Shared accumulators when the columns are split
+} segment_ctx;
+
+static inline double
+segment_identity(NDArray_ReduceOp op) {
+    switch (op) {
+        case NDARRAY_REDUCE_MIN:
+            return INFINITY;
+        case NDARRAY_REDUCE_MAX:
+            return -INFINITY;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * Fold rows [start, end) into acc, columns [c0, c1) only
+ */
+static void
+segment_rows(const segment_ctx *c, long start, long end, long c0, long c1, double *acc) {
+    const float *row;
+    double *out;
+    long i, k;
+
+    for (i = start; i < end; i++) {
+        row = c->in + i * c->row_len;
+        out = acc + (long) c->ids[i] * c->row_len;
+        switch (c->op) {
+            case NDARRAY_REDUCE_MIN:
+                for (k = c0; k < c1; k++) {
+                    if (row[k] < out[k] || isnan(row[k])) {
+                        out[k] = row[k];
+                    }
+                }
+                break;
+            case NDARRAY_REDUCE_MAX:
+                for (k = c0; k < c1; k++) {
+                    if (row[k] > out[k] || isnan(row[k])) {
+                        out[k] = row[k];
+                    }
+                }
+                break;
+            default:
+                for (k = c0; k < c1; k++) {
+                    out[k] += row[k];
+                }
+        }
+    }
+}
+
+/**
+ * Fold the rows starting in elements [start, end) into private
+ * accumulators
+ */
+static void
+segment_partial_range(long start, long end, void *ctx, void *partial) {
+    const segment_ctx *c = ctx;
+    double *acc = partial, identity = segment_identity(c->op);
+    long i;
+
+    for (i = 0; i < c->num_segments * c->row_len; i++) {
+        acc[i] = identity;
+    }
+    segment_rows(c, (start + c->row_len - 1) / c->row_len, (end + c->row_len - 1) / c->row_len, 0, c->row_len, acc);
+}
+
+/**
+ * Elements [start, end) in column major order, each chunk owns the
+ * columns whose first element falls in its range
+ */
+static void
+segment_column_range(long start, long end, void *ctx) {
+    const segment_ctx *c = ctx;
+    long c0 = (start + c->rows - 1) / c->rows;
+    long c1 = (end + c->rows - 1) / c->rows;
+    if (c0 < c1) {
+        segment_rows(c, 0, c->rows, c0, c1, c->acc);
+    }
+}
+
+/**
+ * Reduce the rows of `values` (along its first axis) into `num_segments`
+ * buckets selected by `ids`, one id per row. Sum, mean, min and max are
+ * supported. Empty segments are 0 for the sum, NaN for the mean and the
+ * identity of min and max; NaN propagates through min and max.
+ *
+ * Rows are split between threads, each folding into private
+ * accumulators merged in order at the end, unless the accumulators are
+ * too large to replicate: the columns are then split between threads.
+ *
+ * @param values Array of at least one dimension
+ * @param ids 1-D array of integral ids in [0, num_segments)
+ * @param num_segments
+ * @param op
+ * @return array of shape [num_segments, ...values.shape[1:]]
+ */
+NDArray*
+NDArray_SegmentReduce(NDArray *values, NDArray *ids, long num_segments, NDArray_ReduceOp op) {
+    NDArray *contiguous = NULL, *ids_contiguous = NULL, *rtn;
+    const float *id_data;
+    int *out_shape, *seg;
+    long i, k, out_size, total, chunks, grain, *counts;
+    double *partials, *acc, value;
+    float *out;
+    segment_ctx ctx;
+
+    if (op != NDARRAY_REDUCE_SUM && op != NDARRAY_REDUCE_MEAN && op != NDARRAY_REDUCE_MIN &&
+        op != NDARRAY_REDUCE_MAX) {
+        zend_throw_error(NULL, "segment %s is not supported", reduce_names[op]);
+        return NULL;
+    }
+    if (NDArray_DEVICE(values) != NDARRAY_DEVICE_CPU || NDArray_DEVICE(ids) != NDARRAY_DEVICE_CPU) {
+        zend_throw_error(NULL, "GPU not supported.");
+        return NULL;
+    }
+    if (NDArray_NDIM(values) < 1) {
+        zend_throw_error(NULL, "`values` must have at least one dimension.");
+        return NULL;
+    }
+    if (NDArray_NDIM(ids) != 1 || NDArray_SHAPE(ids)[0] != NDArray_SHAPE(values)[0]) {
+        zend_throw_error(NULL, "`ids` must be a 1-D array with one id per row of `values`.");
+        return NULL;
+    }
+    if (num_segments < 0 || num_segments > INT_MAX) {
+        zend_throw_error(NULL, "`num_segments` must be between 0 and %d.", INT_MAX);
+        return NULL;
+    }
+
+    ctx.op = op;
+    ctx.rows = NDArray_SHAPE(values)[0];
+    ctx.num_segments = num_segments;
+    for (i = 1, ctx.row_len = 1; i < NDArray_NDIM(values); i++) {
+        ctx.row_len *= NDArray_SHAPE(values)[i];
+    }
+
+    // Validate and convert the ids once, counting the rows of every segment
+    if (!NDArray_IsContiguous(ids)) {
+        ids_contiguous = NDArray_ToContiguous(ids);
+    }
+    id_data = NDArray_FDATA(ids_contiguous != NULL ? ids_contiguous : ids);
+    seg = emalloc(sizeof(int) * (ctx.rows > 0 ? ctx.rows : 1));
+    counts = ecalloc(num_segments > 0 ? num_segments : 1, sizeof(long));
+    for (i = 0; i < ctx.rows; i++) {
+        if (!(id_data[i] >= 0 && (double) id_data[i] < (double) num_segments) || id_data[i] != floorf(id_data[i])) {
+            zend_throw_error(NULL, "segment id %g out of range [0, %ld)", id_data[i], num_segments);
+            efree(seg);
+            efree(counts);
+            if (ids_contiguous != NULL) {
+                NDArray_FREE(ids_contiguous);
+            }
+            return NULL;
+        }
+        seg[i] = (int) id_data[i];
+        counts[seg[i]]++;
+    }
+    if (ids_contiguous != NULL) {
+        NDArray_FREE(ids_contiguous);
+    }
+
+    out_shape = emalloc(sizeof(int) * NDArray_NDIM(values));
+    memcpy(out_shape, NDArray_SHAPE(values), sizeof(int) * NDArray_NDIM(values));
+    out_shape[0] = (int) num_segments;
+    rtn = NDArray_Empty(out_shape, NDArray_NDIM(values), NDARRAY_TYPE_FLOAT32, NDARRAY_DEVICE_CPU);
+    out = NDArray_FDATA(rtn);
+    out_size = num_segments * ctx.row_len;
+
+    if (!NDArray_IsContiguous(values)) {
+        contiguous = NDArray_ToContiguous(values);
+    }
+    ctx.in = NDArray_FDATA(contiguous != NULL ? contiguous : values);
+    ctx.ids = seg;
+    acc = emalloc(sizeof(double) * (out_size > 0 ? out_size : 1));
+
+    total = ctx.rows * ctx.row_len;
+    grain = NDARRAY_PARALLEL_GRAIN;
+    chunks = NDArray_ParallelChunks(total, grain);
+    if (out_size > 0 && out_size * chunks > SEGMENT_MAX_PARTIAL) {
+        // Fewer chunks so that their accumulators fit
+        grain = total / (SEGMENT_MAX_PARTIAL / out_size > 0 ? SEGMENT_MAX_PARTIAL / out_size : 1) + 1;
+    }
+    for (i = 0; i < out_size; i++) {
+        acc[i] = segment_identity(op);
+    }
+    if (out_size > 0 && chunks > 1 && ctx.row_len > 1 && NDArray_ParallelChunks(total, grain) <= 1) {
+        ctx.acc = acc;
+        NDArray_ParallelFor(total, NDARRAY_PARALLEL_GRAIN, segment_column_range, &ctx);
+    } else if (out_size > 0) {
+        chunks = NDArray_ParallelChunks(total, grain);
+        partials = emalloc(sizeof(double) * out_size * chunks);
+        chunks = NDArray_ParallelReduce(total, grain, segment_partial_range, &ctx, partials, sizeof(double) * out_size);
+        for (k = 0; k < chunks; k++) {
+            for (i = 0; i < out_size; i++) {
+                value = partials[k * out_size + i];
+                switch (op) {
+                    case NDARRAY_REDUCE_MIN:
+                        acc[i] = (value < acc[i] || isnan(value)) ? value : acc[i];
+                        break;
+                    case NDARRAY_REDUCE_MAX:
+                        acc[i] = (value > acc[i] || isnan(value)) ? value : acc[i];
+                        break;
+                    default:
+                        acc[i] += value;
+                }
+            }
+        }
+        efree(partials);
+    }
+
+    for (i = 0; i < out_size; i++) {
+        if (op == NDARRAY_REDUCE_MEAN) {
+            k = counts[i / ctx.row_len];
+            out[i] = k > 0 ? (float) (acc[i] / (double) k) : NAN;
+        } else {
+            out[i] = (float) acc[i];
+        }
+    }
+    efree(acc);
+    efree(counts);
+    efree(seg);
+    if (contiguous != NULL) {
+        NDArray_FREE(contiguous);
+    }
+    return rtn;
+}
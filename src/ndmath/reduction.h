@@ -0,0 +1,26 @@
+#ifndef PHPSCI_NDARRAY_REDUCTION_H
+#define PHPSCI_NDARRAY_REDUCTION_H
+
+#include "../ndarray.h"
+
+/**
+ * Reductions handled by NDArray_Reduce
+ */
+typedef enum {
+    NDARRAY_REDUCE_SUM = 0,
+    NDARRAY_REDUCE_PROD,
+    NDARRAY_REDUCE_MIN,
+    NDARRAY_REDUCE_MAX,
+    NDARRAY_REDUCE_MEAN,
+    NDARRAY_REDUCE_VAR,
+    NDARRAY_REDUCE_STD,
+    NDARRAY_REDUCE_NUM_OPS
+} NDArray_ReduceOp;
+
+int NDArray_ReduceAxes(int ndim, const int *axes, int naxes, char *reduced);
+NDArray* NDArray_Reduce(NDArray *a, NDArray_ReduceOp op, const int *axes, int naxes, int keepdims);
+NDArray* NDArray_SegmentReduce(NDArray *values, NDArray *ids, long num_segments, NDArray_ReduceOp op);
+NDArray* NDArray_ReduceDdof(NDArray *a, NDArray_ReduceOp op, const int *axes, int naxes, int keepdims, int ddof);
+NDArray* NDArray_ReduceWhere(NDArray *a, NDArray_ReduceOp op, const int *axes, int naxes, int keepdims, int ddof,
+                             int skipnan, NDArray *where);
+#endif //PHPSCI_NDARRAY_REDUCTION_H
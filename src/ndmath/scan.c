@@ -0,0 +1,326 @@
+#include <php.h>
+#include "Zend/zend_alloc.h"
+#include "Zend/zend_API.h"
+#include <string.h>
+#include <math.h>
+#include "scan.h"
+#include "reduction.h"
+#include "elementwise.h"
+#include "simd_math.h"
+#include "../../config.h"
+#include "../initializers.h"
+#include "../manipulation.h"
+#include "../types.h"
+#include "../threadpool.h"
+
+static const char *scan_names[NDARRAY_SCAN_NUM_OPS] = {
+    [NDARRAY_SCAN_SUM] = "cumsum",
+    [NDARRAY_SCAN_PROD] = "cumprod",
+    [NDARRAY_SCAN_MAX] = "cummax",
+};
+
+/**
+ * Iteration space of a scan along one axis. The other axes are walked
+ * in C order through their strides, so neither the input nor the output
+ * is transposed.
+ */
+typedef struct {
+    NDArray_ScanOp op;
+    int nd;
+    int dims[NDARRAY_MAX_DIMS];
+    int in_strides[NDARRAY_MAX_DIMS];
+    int out_strides[NDARRAY_MAX_DIMS];
+    long m;                 // Length of the scanned axis
+    int in_axis_stride;
+    int out_axis_stride;
+    long columns;           // Lines scanned together, the innermost other axis when it is contiguous
+    char *in;
+    char *out;
+    // Two-pass scan of a single line
+    long chunk_size;
+    const float *carries;
+} scan_ctx;
+
+static inline float
+scan_combine(NDArray_ScanOp op, float acc, float x) {
+    switch (op) {
+        case NDARRAY_SCAN_PROD:
+            return acc * x;
+        case NDARRAY_SCAN_MAX:
+            return (x > acc || isnan(x)) ? x : acc;
+        default:
+            return acc + x;
+    }
+}
+
+static void
+scan_contiguous(NDArray_ScanOp op, const float *in, float *out, long n) {
+    switch (op) {
+        case NDARRAY_SCAN_PROD:
+            NDArray_FloatCumProd(in, out, n);
+            break;
+        case NDARRAY_SCAN_MAX:
+            NDArray_FloatCumMax(in, out, n);
+            break;
+        default:
+            NDArray_FloatCumSum(in, out, n);
+    }
+}
+
+/**
+ * Scan one line of `n` strided elements
+ */
+static void
+scan_line(NDArray_ScanOp op, const char *in, int is, char *out, int os, long n) {
+    float acc;
+    long i;
+
+    if (is == sizeof(float) && os == sizeof(float)) {
+        scan_contiguous(op, (const float *) in, (float *) out, n);
+        return;
+    }
+    acc = *(const float *) in;
+    *(float *) out = acc;
+    for (i = 1; i < n; i++) {
+        acc = scan_combine(op, acc, *(const float *) (in + i * is));
+        *(float *) (out + i * os) = acc;
+    }
+}
+
+/**
+ * out = op(prev, in) over `n` contiguous floats
+ */
+static void
+scan_step(NDArray_ScanOp op, const float *prev, const float *in, float *out, long n) {
+    long k;
+    switch (op) {
+        case NDARRAY_SCAN_SUM:
+            NDArray_GetBinaryLoop(NDARRAY_BINARY_ADD)((char *) prev, sizeof(float), (char *) in, sizeof(float),
+                                                      (char *) out, sizeof(float), n);
+            break;
+        case NDARRAY_SCAN_PROD:
+            NDArray_GetBinaryLoop(NDARRAY_BINARY_MULTIPLY)((char *) prev, sizeof(float), (char *) in, sizeof(float),
+                                                           (char *) out, sizeof(float), n);
+            break;
+        default:
+            for (k = 0; k < n; k++) {
+                out[k] = scan_combine(op, prev[k], in[k]);
+            }
+    }
+}
+
+/**
+ * Scan `columns` contiguous lines at once, one row of the scanned axis
+ * after the other, so every row is read sequentially
+ */
+static void
+scan_columns(const scan_ctx *c, const char *in, char *out) {
+    long i;
+
+    memmove(out, in, sizeof(float) * c->columns);
+    for (i = 1; i < c->m; i++) {
+        scan_step(c->op, (const float *) (out + (i - 1) * c->out_axis_stride),
+                  (const float *) (in + i * c->in_axis_stride),
+                  (float *) (out + i * c->out_axis_stride), c->columns);
+    }
+}
+
+/**
+ * Scan the groups of lines belonging to elements [start, end)
+ */
+static void
+scan_range(long start, long end, void *ctx) {
+    const scan_ctx *c = ctx;
+    long per_group = c->m * c->columns;
+    long lo = (start + per_group - 1) / per_group;
+    long hi = (end + per_group - 1) / per_group;
+    long g, rest, index;
+    int d, nd = (c->columns > 1) ? c->nd - 1 : c->nd;
+    char *in, *out;
+
+    for (g = lo; g < hi; g++) {
+        in = c->in;
+        out = c->out;
+        rest = g;
+        for (d = nd - 1; d >= 0; d--) {
+            index = rest % c->dims[d];
+            in += index * c->in_strides[d];
+            out += index * c->out_strides[d];
+            rest /= c->dims[d];
+        }
+        if (c->columns > 1) {
+            scan_columns(c, in, out);
+        } else {
+            scan_line(c->op, in, c->in_axis_stride, out, c->out_axis_stride, c->m);
+        }
+    }
+}
+
+/**
+ * First pass of the scan of a single contiguous line, every chunk is
+ * scanned on its own and reports its last value
+ */
+static void
+scan_chunk(long start, long end, void *ctx, void *partial) {
+    const scan_ctx *c = ctx;
+    float *out = (float *) c->out;
+    scan_contiguous(c->op, (const float *) c->in + start, out + start, end - start);
+    *(float *) partial = out[end - 1];
+}
+
+/**
+ * Second pass, combine every chunk with the carry of the chunks before it
+ */
+static void
+scan_fixup(long start, long end, void *ctx, void *partial) {
+    const scan_ctx *c = ctx;
+    long chunk = start / c->chunk_size;
+    float *out = (float *) c->out + start;
+    long n = end - start, k;
+    float carry;
+
+    if (chunk == 0) {
+        return;
+    }
+    carry = c->carries[chunk - 1];
+    switch (c->op) {
+        case NDARRAY_SCAN_SUM:
+            NDArray_GetBinaryLoop(NDARRAY_BINARY_ADD)((char *) &carry, 0, (char *) out, sizeof(float),
+                                                      (char *) out, sizeof(float), n);
+            break;
+        case NDARRAY_SCAN_PROD:
+            NDArray_GetBinaryLoop(NDARRAY_BINARY_MULTIPLY)((char *) &carry, 0, (char *) out, sizeof(float),
+                                                           (char *) out, sizeof(float), n);
+            break;
+        default:
+            for (k = 0; k < n; k++) {
+                out[k] = scan_combine(c->op, carry, out[k]);
+            }
+    }
+}
+
+/**
+ * Scan a single contiguous line. Large lines are scanned in two passes
+ * over the pool: the chunks are scanned independently, their carries
+ * are accumulated serially and every chunk is then combined with the
+ * carry of the ones before it.
+ */
+static void
+scan_single_line(scan_ctx *c) {
+    float partials[NDARRAY_MAX_CHUNKS], carries[NDARRAY_MAX_CHUNKS];
+    long chunks, i;
+
+    chunks = NDArray_ParallelChunks(c->m, NDARRAY_PARALLEL_GRAIN);
+    if (chunks <= 1) {
+        scan_contiguous(c->op, (const float *) c->in, (float *) c->out, c->m);
+        return;
+    }
+    chunks = NDArray_ParallelReduce(c->m, NDARRAY_PARALLEL_GRAIN, scan_chunk, c, partials, sizeof(float));
+    carries[0] = partials[0];
+    for (i = 1; i < chunks; i++) {
+        carries[i] = scan_combine(c->op, carries[i - 1], partials[i]);
+    }
+    // Same chunks as the first pass, the chunking only depends on the length
+    c->chunk_size = (c->m + chunks - 1) / chunks;
+    c->carries = carries;
+    NDArray_ParallelReduce(c->m, NDARRAY_PARALLEL_GRAIN, scan_fixup, c, partials, sizeof(float));
+}
+
+/**
+ * Cumulative sum, product or maximum of a float32 CPU array along an
+ * axis. NaN propagates through cummax like through max.
+ *
+ * @param a
+ * @param op
+ * @param axis Axis to scan, NDARRAY_MAX_DIMS to scan the flattened array
+ * @param out Optional contiguous output array, may be `a` itself
+ * @return a C-contiguous array, 1-D when the array is flattened
+ */
+NDArray *
+NDArray_Scan(NDArray *a, NDArray_ScanOp op, int axis, NDArray *out) {
+    char reduced[NDARRAY_MAX_DIMS];
+    NDArray *contiguous = NULL, *rtn;
+    int *shape, i, ndim;
+    long n = NDArray_NUMELEMENTS(a);
+    scan_ctx ctx;
+
+    if (NDArray_DEVICE(a) == NDARRAY_DEVICE_GPU) {
+        zend_throw_error(NULL, "NDArray::%s is not supported for GPU arrays.", scan_names[op]);
+        return NULL;
+    }
+    if (axis != NDARRAY_MAX_DIMS) {
+        if (NDArray_ReduceAxes(NDArray_NDIM(a), &axis, 1, reduced) < 0) {
+            return NULL;
+        }
+        if (axis < 0) {
+            axis += NDArray_NDIM(a);
+        }
+    }
+
+    ndim = (axis == NDARRAY_MAX_DIMS) ? 1 : NDArray_NDIM(a);
+    shape = emalloc(sizeof(int) * ndim);
+    if (axis == NDARRAY_MAX_DIMS) {
+        shape[0] = (int) n;
+    } else {
+        memcpy(shape, NDArray_SHAPE(a), sizeof(int) * ndim);
+    }
+    if (out != NULL) {
+        if (!NDArray_CheckOutput(out, ndim, shape, NDARRAY_DEVICE_CPU)) {
+            efree(shape);
+            return NULL;
+        }
+        if (!NDArray_IsContiguous(out)) {
+            efree(shape);
+            zend_throw_error(NULL, "`out` must be a contiguous array.");
+            return NULL;
+        }
+        efree(shape);
+        rtn = out;
+    } else {
+        rtn = NDArray_Empty(shape, ndim, NDARRAY_TYPE_FLOAT32, NDARRAY_DEVICE_CPU);
+    }
+    if (n == 0) {
+        return rtn;
+    }
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.op = op;
+    ctx.out = NDArray_DATA(rtn);
+    if (axis == NDARRAY_MAX_DIMS) {
+        if (!NDArray_IsContiguous(a)) {
+            contiguous = NDArray_ToContiguous(a);
+        }
+        ctx.in = NDArray_DATA(contiguous != NULL ? contiguous : a);
+        ctx.m = n;
+        scan_single_line(&ctx);
+        if (contiguous != NULL) {
+            NDArray_FREE(contiguous);
+        }
+        return rtn;
+    }
+
+    ctx.in = NDArray_DATA(a);
+    ctx.m = NDArray_SHAPE(a)[axis];
+    ctx.in_axis_stride = NDArray_STRIDES(a)[axis];
+    ctx.out_axis_stride = NDArray_STRIDES(rtn)[axis];
+    for (i = 0; i < NDArray_NDIM(a); i++) {
+        if (i == axis) {
+            continue;
+        }
+        ctx.dims[ctx.nd] = NDArray_SHAPE(a)[i];
+        ctx.in_strides[ctx.nd] = NDArray_STRIDES(a)[i];
+        ctx.out_strides[ctx.nd++] = NDArray_STRIDES(rtn)[i];
+    }
+    if (ctx.m == n && ctx.in_axis_stride == sizeof(float)) {
+        scan_single_line(&ctx);
+        return rtn;
+    }
+    // When the scanned axis is not the innermost one, the contiguous
+    // innermost axis is scanned a whole row at a time
+    ctx.columns = 1;
+    if (ctx.out_axis_stride != sizeof(float) && ctx.nd > 0 && ctx.in_strides[ctx.nd - 1] == sizeof(float)) {
+        ctx.columns = ctx.dims[ctx.nd - 1];
+    }
+    NDArray_ParallelFor(n, NDARRAY_PARALLEL_GRAIN, scan_range, &ctx);
+    return rtn;
+}
@@ -0,0 +1,17 @@
+#ifndef PHPSCI_NDARRAY_SCAN_H
+#define PHPSCI_NDARRAY_SCAN_H
+
+#include "../ndarray.h"
+
+/**
+ * Cumulative operations handled by NDArray_Scan
+ */
+typedef enum {
+    NDARRAY_SCAN_SUM = 0,
+    NDARRAY_SCAN_PROD,
+    NDARRAY_SCAN_MAX,
+    NDARRAY_SCAN_NUM_OPS
+} NDArray_ScanOp;
+
+NDArray* NDArray_Scan(NDArray *a, NDArray_ScanOp op, int axis, NDArray *out);
+#endif //PHPSCI_NDARRAY_SCAN_H
@@ -0,0 +1,1252 @@
+#include <math.h>
+#include <stdint.h>
+#include "simd_math.h"
+#include "double_math.h"
+#include "../cpu.h"
+#include "../../config.h"
+
+#ifdef HAVE_AVX2
+#include <immintrin.h>
+#endif
+
+#ifdef HAVE_AVX2
+/*
+ * AVX2 versions of the transcendental functions used by NDArray_Map,
+ * returned only when NDArray_CPU_Init found AVX2 and FMA.
+ *
+ * The polynomials are the single precision Cephes ones. Each kernel
+ * checks the domain of every block of 8 elements and computes blocks
+ * holding NaN, infinities or values outside the reduced range with the
+ * scalar function instead, so special values behave exactly like libm.
+ * Tails shorter than a vector use the scalar function as well.
+ *
+ * Maximum error against the correctly rounded result, measured over
+ * the valid range of each kernel:
+ *
+ *   sqrt     0 ULP (IEEE sqrt)
+ *   rsqrt    1 ULP
+ *   exp      1 ULP   [-87, 88]
+ *   log      1 ULP   normal positive numbers
+ *   sin/cos  2 ULP   |x| <= 8192
+ *   tan      4 ULP   |x| <= 8192
+ *   tanh     2 ULP
+ *   sigmoid  2 ULP   x >= -87
+ */
+
+static inline NDARRAY_TARGET_AVX2 __m256
+v_madd(__m256 a, __m256 b, __m256 c) {
+    return _mm256_fmadd_ps(a, b, c);
+}
+
+#define V_SET(v) _mm256_set1_ps(v)
+
+/**
+ * e^x for x in [-87, 88]
+ */
+static inline NDARRAY_TARGET_AVX2 __m256
+v_exp(__m256 x) {
+    __m256 fx, r, z, y;
+    __m256i n;
+    fx = _mm256_round_ps(_mm256_mul_ps(x, V_SET(1.44269504088896341f)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    // x - fx * ln(2), with ln(2) split in two parts for extra precision
+    r = v_madd(fx, V_SET(-0.693359375f), x);
+    r = v_madd(fx, V_SET(2.12194440e-4f), r);
+    z = _mm256_mul_ps(r, r);
+    y = V_SET(1.9875691500E-4f);
+    y = v_madd(y, r, V_SET(1.3981999507E-3f));
+    y = v_madd(y, r, V_SET(8.3334519073E-3f));
+    y = v_madd(y, r, V_SET(4.1665795894E-2f));
+    y = v_madd(y, r, V_SET(1.6666665459E-1f));
+    y = v_madd(y, r, V_SET(5.0000001201E-1f));
+    y = v_madd(y, z, r);
+    y = _mm256_add_ps(y, V_SET(1.0f));
+    // 2^fx built directly in the exponent bits
+    n = _mm256_cvtps_epi32(fx);
+    n = _mm256_slli_epi32(_mm256_add_epi32(n, _mm256_set1_epi32(127)), 23);
+    return _mm256_mul_ps(y, _mm256_castsi256_ps(n));
+}
+
+/**
+ * ln(x) for normal positive finite x
+ */
+static inline NDARRAY_TARGET_AVX2 __m256
+v_log(__m256 x) {
+    __m256i xi = _mm256_castps_si256(x);
+    __m256 e, m, mask, z, y;
+    // x = m * 2^e with m in [0.5, 1)
+    e = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(xi, 23), _mm256_set1_epi32(126)));
+    m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(xi, _mm256_set1_epi32(0x007fffff)),
+                                            _mm256_set1_epi32(0x3f000000)));
+    // Move m to [sqrt(0.5), sqrt(2)) and take m - 1
+    mask = _mm256_cmp_ps(m, V_SET(0.707106781186547524f), _CMP_LT_OQ);
+    e = _mm256_sub_ps(e, _mm256_and_ps(V_SET(1.0f), mask));
+    m = _mm256_add_ps(_mm256_sub_ps(m, V_SET(1.0f)), _mm256_and_ps(m, mask));
+    z = _mm256_mul_ps(m, m);
+    y = V_SET(7.0376836292E-2f);
+    y = v_madd(y, m, V_SET(-1.1514610310E-1f));
+    y = v_madd(y, m, V_SET(1.1676998740E-1f));
+    y = v_madd(y, m, V_SET(-1.2420140846E-1f));
+    y = v_madd(y, m, V_SET(1.4249322787E-1f));
+    y = v_madd(y, m, V_SET(-1.6668057665E-1f));
+    y = v_madd(y, m, V_SET(2.0000714765E-1f));
+    y = v_madd(y, m, V_SET(-2.4999993993E-1f));
+    y = v_madd(y, m, V_SET(3.3333331174E-1f));
+    y = _mm256_mul_ps(_mm256_mul_ps(y, m), z);
+    y = v_madd(e, V_SET(-2.12194440e-4f), y);
+    y = v_madd(z, V_SET(-0.5f), y);
+    return v_madd(e, V_SET(0.693359375f), _mm256_add_ps(m, y));
+}
+
+/**
+ * sin(x) and cos(x) for |x| <= 8192
+ */
+static inline NDARRAY_TARGET_AVX2 void
+v_sincos(__m256 x, __m256 *s, __m256 *c) {
+    const __m256 sign_mask = _mm256_castsi256_ps(_mm256_set1_epi32((int) 0x80000000));
+    __m256 sign_sin, y, z, y1, y2, poly_mask, sign_cos;
+    __m256i j;
+
+    sign_sin = _mm256_and_ps(x, sign_mask);
+    x = _mm256_andnot_ps(sign_mask, x);
+
+    // Octant of x, rounded to an even number
+    j = _mm256_cvttps_epi32(_mm256_mul_ps(x, V_SET(1.27323954473516f)));
+    j = _mm256_and_si256(_mm256_add_epi32(j, _mm256_set1_epi32(1)), _mm256_set1_epi32(~1));
+    y = _mm256_cvtepi32_ps(j);
+
+    sign_sin = _mm256_xor_ps(sign_sin, _mm256_castsi256_ps(
+            _mm256_slli_epi32(_mm256_and_si256(j, _mm256_set1_epi32(4)), 29)));
+    sign_cos = _mm256_castsi256_ps(_mm256_slli_epi32(
+            _mm256_andnot_si256(_mm256_sub_epi32(j, _mm256_set1_epi32(2)), _mm256_set1_epi32(4)), 29));
+    poly_mask = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(j, _mm256_set1_epi32(2)),
+                                                       _mm256_setzero_si256()));
+
+    // x - y * pi/4 in three steps
+    x = v_madd(y, V_SET(-0.78539818525314331f), x);
+    x = v_madd(y, V_SET(2.1855694143368964e-08f), x);
+    x = v_madd(y, V_SET(8.5756225500294094e-16f), x);
+    z = _mm256_mul_ps(x, x);
+
+    y1 = V_SET(2.443315711809948E-005f);
+    y1 = v_madd(y1, z, V_SET(-1.388731625493765E-003f));
+    y1 = v_madd(y1, z, V_SET(4.166664568298827E-002f));
+    y1 = _mm256_mul_ps(_mm256_mul_ps(y1, z), z);
+    y1 = v_madd(z, V_SET(-0.5f), y1);
+    y1 = _mm256_add_ps(y1, V_SET(1.0f));
+
+    y2 = V_SET(-1.9515295891E-4f);
+    y2 = v_madd(y2, z, V_SET(8.3321608736E-3f));
+    y2 = v_madd(y2, z, V_SET(-1.6666654611E-1f));
+    y2 = v_madd(_mm256_mul_ps(y2, z), x, x);
+
+    *s = _mm256_xor_ps(_mm256_blendv_ps(y1, y2, poly_mask), sign_sin);
+    *c = _mm256_xor_ps(_mm256_blendv_ps(y2, y1, poly_mask), sign_cos);
+}
+
+/**
+ * Generates a kernel over contiguous floats. `VALID` is a mask over the
+ * __m256 `x` of the lanes `VECTOR_OP` handles, blocks with any other lane
+ * go through `SCALAR_OP`.
+ */
+#define NDARRAY_VECTOR_KERNEL(name, SCALAR_OP, VALID, VECTOR_OP)               \
+static NDARRAY_TARGET_AVX2 void                                                 \
+name(const float *in, float *out, long n) {                                     \
+    long i = 0;                                                                 \
+    int k;                                                                      \
+    for (; i + 8 <= n; i += 8) {                                                \
+        __m256 x = _mm256_loadu_ps(in + i);                                     \
+        if (_mm256_movemask_ps(VALID) != 0xFF) {                                \
+            for (k = 0; k < 8; k++) {                                           \
+                out[i + k] = SCALAR_OP(in[i + k]);                              \
+            }                                                                   \
+            continue;                                                           \
+        }                                                                       \
+        _mm256_storeu_ps(out + i, VECTOR_OP);                                   \
+    }                                                                           \
+    for (; i < n; i++) {                                                        \
+        out[i] = SCALAR_OP(in[i]);                                              \
+    }                                                                           \
+}
+
+#define V_ALL(x) _mm256_cmp_ps(x, x, _CMP_TRUE_UQ)
+#define V_IN_RANGE(x, lo, hi) _mm256_and_ps(_mm256_cmp_ps(x, V_SET(lo), _CMP_GE_OQ), \
+                                            _mm256_cmp_ps(x, V_SET(hi), _CMP_LE_OQ))
+
+static inline NDARRAY_TARGET_AVX2 __m256
+v_sin(__m256 x) {
+    __m256 s, c;
+    v_sincos(x, &s, &c);
+    return s;
+}
+
+static inline NDARRAY_TARGET_AVX2 __m256
+v_cos(__m256 x) {
+    __m256 s, c;
+    v_sincos(x, &s, &c);
+    return c;
+}
+
+static inline NDARRAY_TARGET_AVX2 __m256
+v_tan(__m256 x) {
+    __m256 s, c;
+    v_sincos(x, &s, &c);
+    return _mm256_div_ps(s, c);
+}
+
+static inline NDARRAY_TARGET_AVX2 __m256
+v_tanh(__m256 x) {
+    const __m256 sign_mask = _mm256_castsi256_ps(_mm256_set1_epi32((int) 0x80000000));
+    __m256 ax = _mm256_andnot_ps(sign_mask, x);
+    __m256 z = _mm256_mul_ps(x, x);
+    __m256 small, large, e;
+
+    // x + x^3 P(x^2) for |x| < 0.625
+    small = V_SET(-5.70498872745E-3f);
+    small = v_madd(small, z, V_SET(2.06390887954E-2f));
+    small = v_madd(small, z, V_SET(-5.37397155531E-2f));
+    small = v_madd(small, z, V_SET(1.33314422036E-1f));
+    small = v_madd(small, z, V_SET(-3.33332819422E-1f));
+    small = v_madd(_mm256_mul_ps(small, z), x, x);
+
+    // 1 - 2 / (e^2|x| + 1), tanh(10) already rounds to 1
+    e = v_exp(_mm256_add_ps(_mm256_min_ps(ax, V_SET(10.0f)), _mm256_min_ps(ax, V_SET(10.0f))));
+    large = _mm256_sub_ps(V_SET(1.0f), _mm256_div_ps(V_SET(2.0f), _mm256_add_ps(e, V_SET(1.0f))));
+    large = _mm256_or_ps(large, _mm256_and_ps(x, sign_mask));
+
+    return _mm256_blendv_ps(large, small, _mm256_cmp_ps(ax, V_SET(0.625f), _CMP_LT_OQ));
+}
+
+static inline NDARRAY_TARGET_AVX2 __m256
+v_sigmoid(__m256 x) {
+    // sigmoid(87) already rounds to 1
+    __m256 e = v_exp(_mm256_sub_ps(_mm256_setzero_ps(), _mm256_min_ps(x, V_SET(87.0f))));
+    return _mm256_div_ps(V_SET(1.0f), _mm256_add_ps(V_SET(1.0f), e));
+}
+
+NDARRAY_VECTOR_KERNEL(vector_sqrt, float_sqrt, V_ALL(x), _mm256_sqrt_ps(x))
+NDARRAY_VECTOR_KERNEL(vector_rsqrt, float_rsqrt, V_ALL(x), _mm256_div_ps(V_SET(1.0f), _mm256_sqrt_ps(x)))
+NDARRAY_VECTOR_KERNEL(vector_exp, float_exp, V_IN_RANGE(x, -87.0f, 88.0f), v_exp(x))
+NDARRAY_VECTOR_KERNEL(vector_log, float_log, V_IN_RANGE(x, 1.17549435e-38f, 3.40282347e+38f), v_log(x))
+NDARRAY_VECTOR_KERNEL(vector_sin, float_sin, V_IN_RANGE(x, -8192.0f, 8192.0f), v_sin(x))
+NDARRAY_VECTOR_KERNEL(vector_cos, float_cos, V_IN_RANGE(x, -8192.0f, 8192.0f), v_cos(x))
+NDARRAY_VECTOR_KERNEL(vector_tan, float_tan, V_IN_RANGE(x, -8192.0f, 8192.0f), v_tan(x))
+NDARRAY_VECTOR_KERNEL(vector_tanh, float_tanh, _mm256_cmp_ps(x, x, _CMP_ORD_Q), v_tanh(x))
+NDARRAY_VECTOR_KERNEL(vector_sigmoid, float_sigmoid, _mm256_cmp_ps(x, V_SET(-87.0f), _CMP_GE_OQ), v_sigmoid(x))
+
+/**
+ * min(max(x, val1), val2) with the NaN behavior of float_clip
+ */
+static NDARRAY_TARGET_AVX2 void
+vector_clip(const float *in, float *out, long n, float val1, float val2) {
+    long i = 0;
+    const __m256 lo = _mm256_set1_ps(val1), hi = _mm256_set1_ps(val2);
+    for (; i + 8 <= n; i += 8) {
+        // max_ps/min_ps return the second operand when one of them is NaN
+        __m256 x = _mm256_max_ps(_mm256_loadu_ps(in + i), lo);
+        _mm256_storeu_ps(out + i, _mm256_min_ps(hi, x));
+    }
+    for (; i < n; i++) {
+        out[i] = float_clip(in[i], val1, val2);
+    }
+}
+
+static const struct {
+    ElementWiseDoubleOperation op;
+    NDArray_VectorKernel kernel;
+} vector_kernels[] = {
+    {float_sqrt, vector_sqrt},
+    {float_rsqrt, vector_rsqrt},
+    {float_exp, vector_exp},
+    {float_log, vector_log},
+    {float_sin, vector_sin},
+    {float_cos, vector_cos},
+    {float_tan, vector_tan},
+    {float_tanh, vector_tanh},
+    {float_sigmoid, vector_sigmoid},
+};
+#endif
+
+/**
+ * Vectorized kernel computing the same function as `op`, NULL if
+ * there is none and `op` must be called per element.
+ *
+ * @param op
+ * @return
+ */
+NDArray_VectorKernel
+NDArray_GetVectorKernel(ElementWiseDoubleOperation op) {
+#ifdef HAVE_AVX2
+    size_t i;
+    if (NDArray_CPU_Level() < NDARRAY_CPU_AVX2) {
+        return NULL;
+    }
+    for (i = 0; i < sizeof(vector_kernels) / sizeof(vector_kernels[0]); i++) {
+        if (vector_kernels[i].op == op) {
+            return vector_kernels[i].kernel;
+        }
+    }
+#endif
+    return NULL;
+}
+
+/**
+ * @param op
+ * @return
+ */
+NDArray_VectorKernel2F
+NDArray_GetVectorKernel2F(ElementWiseFloatOperation2F op) {
+#ifdef HAVE_AVX2
+    if (op == float_clip && NDArray_CPU_Level() >= NDARRAY_CPU_AVX2) {
+        return vector_clip;
+    }
+#endif
+    return NULL;
+}
+
+/*
+ * Index of the first maximum (minimum) of `n` floats, or of the first
+ * NaN if there is one, like numpy
+ */
+static long
+float_arg_scalar(const float *in, long n, int is_max) {
+    long i, r = 0;
+    if (isnan(in[0])) {
+        return 0;
+    }
+    for (i = 1; i < n; i++) {
+        if (is_max ? in[i] > in[r] : in[i] < in[r]) {
+            r = i;
+        } else if (isnan(in[i])) {
+            return i;
+        }
+    }
+    return r;
+}
+
+/*
+ * Whether element `i` takes part in a masked reduction, `mask` may be NULL
+ */
+static inline int
+masked_keep(float x, const float *mask, long i, int skipnan) {
+    return (!skipnan || !isnan(x)) && (mask == NULL || mask[i] != 0);
+}
+
+static long
+float_first_nan(const float *in, long n) {
+    long i;
+    for (i = 0; i < n; i++) {
+        if (isnan(in[i])) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Pick the best of the per-lane results, the lowest index on ties
+ */
+static long
+float_arg_lanes(const float *vals, const int *idxs, int lanes, int is_max) {
+    int j, r = 0;
+    for (j = 1; j < lanes; j++) {
+        if ((is_max ? vals[j] > vals[r] : vals[j] < vals[r]) || (vals[j] == vals[r] && idxs[j] < idxs[r])) {
+            r = j;
+        }
+    }
+    return idxs[r];
+}
+
+#ifdef HAVE_AVX512F
+/*
+ * AVX-512F reductions. The last partial vector of the float kernels is
+ * read with a masked load, so there is no scalar remainder loop.
+ */
+#define V512_TAIL_MASK(n) ((__mmask16) ((1u << (n)) - 1))
+
+/*
+ * Pairwise leaf of up to PAIRWISE_BLOCK_AVX512F contiguous floats
+ */
+static NDARRAY_TARGET_AVX512F double
+pairwise_leaf_avx512f(const char *data, long stride, long n) {
+    const float *in = (const float *) data;
+    __m512 acc0 = _mm512_setzero_ps(), acc1 = _mm512_setzero_ps();
+    __m512 acc2 = _mm512_setzero_ps(), acc3 = _mm512_setzero_ps();
+    long i = 0;
+    for (; i + 64 <= n; i += 64) {
+        acc0 = _mm512_add_ps(acc0, _mm512_loadu_ps(in + i));
+        acc1 = _mm512_add_ps(acc1, _mm512_loadu_ps(in + i + 16));
+        acc2 = _mm512_add_ps(acc2, _mm512_loadu_ps(in + i + 32));
+        acc3 = _mm512_add_ps(acc3, _mm512_loadu_ps(in + i + 48));
+    }
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm512_add_ps(acc0, _mm512_loadu_ps(in + i));
+    }
+    if (i < n) {
+        acc1 = _mm512_add_ps(acc1, _mm512_maskz_loadu_ps(V512_TAIL_MASK(n - i), in + i));
+    }
+    return _mm512_reduce_add_ps(_mm512_add_ps(_mm512_add_ps(acc0, acc1), _mm512_add_ps(acc2, acc3)));
+}
+
+static NDARRAY_TARGET_AVX512F void
+float_accumulate_avx512f(double *acc, const float *in, long n) {
+    long i = 0;
+    for (; i + 8 <= n; i += 8) {
+        _mm512_storeu_pd(acc + i, _mm512_add_pd(_mm512_loadu_pd(acc + i),
+                                                _mm512_cvtps_pd(_mm256_loadu_ps(in + i))));
+    }
+    for (; i < n; i++) {
+        acc[i] += in[i];
+    }
+}
+
+/*
+ * min_ps(x, acc) returns acc when either is NaN, so like the scalar loop
+ * NaNs are skipped unless the first element is one.
+ */
+static NDARRAY_TARGET_AVX512F float
+float_min_avx512f(const float *in, long n) {
+    __m512 acc = _mm512_set1_ps(in[0]);
+    long i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc = _mm512_min_ps(_mm512_loadu_ps(in + i), acc);
+    }
+    if (i < n) {
+        acc = _mm512_min_ps(_mm512_mask_loadu_ps(acc, V512_TAIL_MASK(n - i), in + i), acc);
+    }
+    return _mm512_reduce_min_ps(acc);
+}
+
+static NDARRAY_TARGET_AVX512F float
+float_max_avx512f(const float *in, long n) {
+    __m512 acc = _mm512_set1_ps(in[0]);
+    long i = 0;
+    for (; i + 16 <= n; i += 16) {
+        acc = _mm512_max_ps(_mm512_loadu_ps(in + i), acc);
+    }
+    if (i < n) {
+        acc = _mm512_max_ps(_mm512_mask_loadu_ps(acc, V512_TAIL_MASK(n - i), in + i), acc);
+    }
+    return _mm512_reduce_max_ps(acc);
+}
+
+static NDARRAY_TARGET_AVX512F double
+float_sqdev_avx512f(const float *in, long n, double mean) {
+    __m512d m = _mm512_set1_pd(mean), d0, d1;
+    __m512d acc0 = _mm512_setzero_pd(), acc1 = _mm512_setzero_pd();
+    double value, d;
+    long i = 0;
+    for (; i + 16 <= n; i += 16) {
+        d0 = _mm512_sub_pd(_mm512_cvtps_pd(_mm256_loadu_ps(in + i)), m);
+        d1 = _mm512_sub_pd(_mm512_cvtps_pd(_mm256_loadu_ps(in + i + 8)), m);
+        acc0 = _mm512_fmadd_pd(d0, d0, acc0);
+        acc1 = _mm512_fmadd_pd(d1, d1, acc1);
+    }
+    if (i + 8 <= n) {
+        d0 = _mm512_sub_pd(_mm512_cvtps_pd(_mm256_loadu_ps(in + i)), m);
+        acc0 = _mm512_fmadd_pd(d0, d0, acc0);
+        i += 8;
+    }
+    value = _mm512_reduce_add_pd(_mm512_add_pd(acc0, acc1));
+    for (; i < n; i++) {
+        d = in[i] - mean;
+        value += d * d;
+    }
+    return value;
+}
+
+/*
+ * Every lane keeps its best value and where it was seen, NaNs are only
+ * recorded and looked up again at the end. `n` must be below 2^31.
+ */
+static NDARRAY_TARGET_AVX512F long
+float_arg_avx512f(const float *in, long n, int is_max) {
+    __m512 best, x;
+    __m512i idx, cur, step = _mm512_set1_epi32(16);
+    __mmask16 m, nan;
+    float vals[16];
+    int idxs[16];
+    long i, r;
+
+    if (n < 16) {
+        return float_arg_scalar(in, n, is_max);
+    }
+    best = _mm512_loadu_ps(in);
+    idx = cur = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    nan = _mm512_cmp_ps_mask(best, best, _CMP_UNORD_Q);
+    for (i = 16; i + 16 <= n; i += 16) {
+        x = _mm512_loadu_ps(in + i);
+        cur = _mm512_add_epi32(cur, step);
+        m = is_max ? _mm512_cmp_ps_mask(x, best, _CMP_GT_OQ) : _mm512_cmp_ps_mask(x, best, _CMP_LT_OQ);
+        best = _mm512_mask_blend_ps(m, best, x);
+        idx = _mm512_mask_blend_epi32(m, idx, cur);
+        nan |= _mm512_cmp_ps_mask(x, x, _CMP_UNORD_Q);
+    }
+    if (nan) {
+        return float_first_nan(in, n);
+    }
+    _mm512_storeu_ps(vals, best);
+    _mm512_storeu_si512(idxs, idx);
+    r = float_arg_lanes(vals, idxs, 16, is_max);
+    for (; i < n; i++) {
+        if (is_max ? in[i] > in[r] : in[i] < in[r]) {
+            r = i;
+        } else if (isnan(in[i])) {
+            return i;
+        }
+    }
+    return r;
+}
+#endif
+
+#ifdef HAVE_AVX2
+static inline NDARRAY_TARGET_AVX2 float
+hsum256(__m256 v) {
+    __m128 x = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    x = _mm_add_ps(x, _mm_movehl_ps(x, x));
+    x = _mm_add_ss(x, _mm_movehdup_ps(x));
+    return _mm_cvtss_f32(x);
+}
+
+/*
+ * Pairwise leaf of up to PAIRWISE_BLOCK_AVX2 contiguous floats
+ */
+static NDARRAY_TARGET_AVX2 double
+pairwise_leaf_avx2(const char *data, long stride, long n) {
+    const float *in = (const float *) data;
+    __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+    __m256 acc2 = _mm256_setzero_ps(), acc3 = _mm256_setzero_ps();
+    double value;
+    long i = 0;
+    for (; i + 32 <= n; i += 32) {
+        acc0 = _mm256_add_ps(acc0, _mm256_loadu_ps(in + i));
+        acc1 = _mm256_add_ps(acc1, _mm256_loadu_ps(in + i + 8));
+        acc2 = _mm256_add_ps(acc2, _mm256_loadu_ps(in + i + 16));
+        acc3 = _mm256_add_ps(acc3, _mm256_loadu_ps(in + i + 24));
+    }
+    for (; i + 8 <= n; i += 8) {
+        acc0 = _mm256_add_ps(acc0, _mm256_loadu_ps(in + i));
+    }
+    value = hsum256(_mm256_add_ps(_mm256_add_ps(acc0, acc1), _mm256_add_ps(acc2, acc3)));
+    for (; i < n; i++) {
+        value += in[i];
+    }
+    return value;
+}
+
+static NDARRAY_TARGET_AVX2 void
+float_accumulate_avx2(double *acc, const float *in, long n) {
+    long i = 0;
+    for (; i + 4 <= n; i += 4) {
+        _mm256_storeu_pd(acc + i, _mm256_add_pd(_mm256_loadu_pd(acc + i),
+                                                _mm256_cvtps_pd(_mm_loadu_ps(in + i))));
+    }
+    for (; i < n; i++) {
+        acc[i] += in[i];
+    }
+}
+
+/*
+ * Same NaN handling as the AVX-512F versions below
+ */
+static NDARRAY_TARGET_AVX2 float
+float_min_avx2(const float *in, long n) {
+    __m256 acc = _mm256_set1_ps(in[0]);
+    __m128 x;
+    float value;
+    long i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc = _mm256_min_ps(_mm256_loadu_ps(in + i), acc);
+    }
+    x = _mm_min_ps(_mm256_extractf128_ps(acc, 1), _mm256_castps256_ps128(acc));
+    x = _mm_min_ps(_mm_movehl_ps(x, x), x);
+    value = _mm_cvtss_f32(_mm_min_ss(_mm_movehdup_ps(x), x));
+    for (; i < n; i++) {
+        if (in[i] < value) {
+            value = in[i];
+        }
+    }
+    return value;
+}
+
+static NDARRAY_TARGET_AVX2 float
+float_max_avx2(const float *in, long n) {
+    __m256 acc = _mm256_set1_ps(in[0]);
+    __m128 x;
+    float value;
+    long i = 0;
+    for (; i + 8 <= n; i += 8) {
+        acc = _mm256_max_ps(_mm256_loadu_ps(in + i), acc);
+    }
+    x = _mm_max_ps(_mm256_extractf128_ps(acc, 1), _mm256_castps256_ps128(acc));
+    x = _mm_max_ps(_mm_movehl_ps(x, x), x);
+    value = _mm_cvtss_f32(_mm_max_ss(_mm_movehdup_ps(x), x));
+    for (; i < n; i++) {
+        if (in[i] > value) {
+            value = in[i];
+        }
+    }
+    return value;
+}
+
+static NDARRAY_TARGET_AVX2 double
+float_sqdev_avx2(const float *in, long n, double mean) {
+    __m256d m = _mm256_set1_pd(mean), d0, d1;
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    __m128d x;
+    double value, d;
+    long i = 0;
+    for (; i + 8 <= n; i += 8) {
+        d0 = _mm256_sub_pd(_mm256_cvtps_pd(_mm_loadu_ps(in + i)), m);
+        d1 = _mm256_sub_pd(_mm256_cvtps_pd(_mm_loadu_ps(in + i + 4)), m);
+        acc0 = _mm256_fmadd_pd(d0, d0, acc0);
+        acc1 = _mm256_fmadd_pd(d1, d1, acc1);
+    }
+    acc0 = _mm256_add_pd(acc0, acc1);
+    x = _mm_add_pd(_mm256_castpd256_pd128(acc0), _mm256_extractf128_pd(acc0, 1));
+    value = _mm_cvtsd_f64(_mm_add_sd(x, _mm_unpackhi_pd(x, x)));
+    for (; i < n; i++) {
+        d = in[i] - mean;
+        value += d * d;
+    }
+    return value;
+}
+
+/*
+ * In-register prefix scans of 8 floats. Lanes are combined with the
+ * lane 1, then 2 positions to their left inside each 128-bit half, and
+ * the low half is folded into the high one. `fill` is the identity
+ * shifted in on the left.
+ */
+#define SCAN256_BODY(OP, fill)                                                   \
+    x = OP(x, _mm256_blend_ps(_mm256_castsi256_ps(                              \
+            _mm256_slli_si256(_mm256_castps_si256(x), 4)), fill, 0x11));        \
+    x = OP(x, _mm256_blend_ps(_mm256_castsi256_ps(                              \
+            _mm256_slli_si256(_mm256_castps_si256(x), 8)), fill, 0x33));        \
+    t = _mm256_permute2f128_ps(_mm256_permute_ps(x, 0xFF), x, 0x08);            \
+    x = OP(x, _mm256_blend_ps(t, fill, 0x0F));
+
+#define SCAN256_LOOP(OP, fill, SCALAR_OP)                                         \
+    carry = _mm256_set1_ps(in[0]);                                              \
+    out[0] = in[0];                                                             \
+    for (i = 1; i + 8 <= n; i += 8) {                                           \
+        x = _mm256_loadu_ps(in + i);                                            \
+        SCAN256_BODY(OP, fill)                                                  \
+        x = OP(x, carry);                                                       \
+        _mm256_storeu_ps(out + i, x);                                           \
+        carry = _mm256_permute_ps(_mm256_permute2f128_ps(x, x, 0x11), 0xFF);    \
+    }                                                                           \
+    for (; i < n; i++) {                                                        \
+        out[i] = SCALAR_OP(out[i - 1], in[i]);                                  \
+    }
+
+#define SCAN_ADD(a, b) ((a) + (b))
+#define SCAN_MUL(a, b) ((a) * (b))
+#define SCAN_MAX(a, b) (((b) > (a) || isnan(b)) ? (b) : (a))
+
+// _mm256_max_ps returns its second operand when either one is NaN
+static inline NDARRAY_TARGET_AVX2 __m256
+max_nan256(__m256 a, __m256 b) {
+    return _mm256_blendv_ps(_mm256_max_ps(a, b), _mm256_add_ps(a, b), _mm256_cmp_ps(a, b, _CMP_UNORD_Q));
+}
+
+static NDARRAY_TARGET_AVX2 void
+float_cumsum_avx2(const float *in, float *out, long n) {
+    __m256 x, t, carry, fill = _mm256_setzero_ps();
+    long i;
+    SCAN256_LOOP(_mm256_add_ps, fill, SCAN_ADD)
+}
+
+static NDARRAY_TARGET_AVX2 void
+float_cumprod_avx2(const float *in, float *out, long n) {
+    __m256 x, t, carry, fill = _mm256_set1_ps(1.0f);
+    long i;
+    SCAN256_LOOP(_mm256_mul_ps, fill, SCAN_MUL)
+}
+
+static NDARRAY_TARGET_AVX2 void
+float_cummax_avx2(const float *in, float *out, long n) {
+    __m256 x, t, carry, fill = _mm256_set1_ps(-INFINITY);
+    long i;
+    SCAN256_LOOP(max_nan256, fill, SCAN_MAX)
+}
+
+static NDARRAY_TARGET_AVX2 long
+float_arg_avx2(const float *in, long n, int is_max) {
+    __m256 best, x, m, nan;
+    __m256i idx, cur, step = _mm256_set1_epi32(8);
+    float vals[8];
+    int idxs[8];
+    long i, r;
+
+    if (n < 8) {
+        return float_arg_scalar(in, n, is_max);
+    }
+    best = _mm256_loadu_ps(in);
+    idx = cur = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    nan = _mm256_cmp_ps(best, best, _CMP_UNORD_Q);
+    for (i = 8; i + 8 <= n; i += 8) {
+        x = _mm256_loadu_ps(in + i);
+        cur = _mm256_add_epi32(cur, step);
+        m = is_max ? _mm256_cmp_ps(x, best, _CMP_GT_OQ) : _mm256_cmp_ps(x, best, _CMP_LT_OQ);
+        best = _mm256_blendv_ps(best, x, m);
+        idx = _mm256_blendv_epi8(idx, cur, _mm256_castps_si256(m));
+        nan = _mm256_or_ps(nan, _mm256_cmp_ps(x, x, _CMP_UNORD_Q));
+    }
+    if (_mm256_movemask_ps(nan)) {
+        return float_first_nan(in, n);
+    }
+    _mm256_storeu_ps(vals, best);
+    _mm256_storeu_si256((__m256i *) idxs, idx);
+    r = float_arg_lanes(vals, idxs, 8, is_max);
+    for (; i < n; i++) {
+        if (is_max ? in[i] > in[r] : in[i] < in[r]) {
+            r = i;
+        } else if (isnan(in[i])) {
+            return i;
+        }
+    }
+    return r;
+}
+
+/*
+ * Lanes of `x` that take part in a masked reduction: the ones with a
+ * non-zero mask, and that are not NaN when NaNs are skipped
+ */
+static inline NDARRAY_TARGET_AVX2 __m256
+masked_lanes256(__m256 x, const float *mask, int skipnan) {
+    __m256 keep = skipnan ? _mm256_cmp_ps(x, x, _CMP_ORD_Q) : _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    if (mask != NULL) {
+        keep = _mm256_and_ps(keep, _mm256_cmp_ps(_mm256_loadu_ps(mask), _mm256_setzero_ps(), _CMP_NEQ_UQ));
+    }
+    return keep;
+}
+
+static NDARRAY_TARGET_AVX2 long
+float_masked_sum_avx2(const float *in, const float *mask, long n, int skipnan, double *sum) {
+    __m256 x, keep, zero = _mm256_setzero_ps();
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    __m128d h;
+    double value;
+    long i = 0, count = 0;
+    for (; i + 8 <= n; i += 8) {
+        x = _mm256_loadu_ps(in + i);
+        keep = masked_lanes256(x, mask != NULL ? mask + i : NULL, skipnan);
+        x = _mm256_blendv_ps(zero, x, keep);
+        acc0 = _mm256_add_pd(acc0, _mm256_cvtps_pd(_mm256_castps256_ps128(x)));
+        acc1 = _mm256_add_pd(acc1, _mm256_cvtps_pd(_mm256_extractf128_ps(x, 1)));
+        count += __builtin_popcount(_mm256_movemask_ps(keep));
+    }
+    acc0 = _mm256_add_pd(acc0, acc1);
+    h = _mm_add_pd(_mm256_castpd256_pd128(acc0), _mm256_extractf128_pd(acc0, 1));
+    value = _mm_cvtsd_f64(_mm_add_sd(h, _mm_unpackhi_pd(h, h)));
+    for (; i < n; i++) {
+        if (masked_keep(in[i], mask, i, skipnan)) {
+            value += in[i];
+            count++;
+        }
+    }
+    *sum = value;
+    return count;
+}
+
+static NDARRAY_TARGET_AVX2 long
+float_masked_minmax_avx2(const float *in, const float *mask, long n, int skipnan, int is_max, float *value) {
+    __m256 x, keep, fill = _mm256_set1_ps(is_max ? -INFINITY : INFINITY);
+    __m256 acc = fill, nan = _mm256_setzero_ps();
+    float lanes[8], v;
+    long i = 0, count = 0;
+    int k;
+    for (; i + 8 <= n; i += 8) {
+        x = _mm256_loadu_ps(in + i);
+        keep = masked_lanes256(x, mask != NULL ? mask + i : NULL, skipnan);
+        x = _mm256_blendv_ps(fill, x, keep);
+        nan = _mm256_or_ps(nan, _mm256_cmp_ps(x, x, _CMP_UNORD_Q));
+        acc = is_max ? _mm256_max_ps(x, acc) : _mm256_min_ps(x, acc);
+        count += __builtin_popcount(_mm256_movemask_ps(keep));
+    }
+    _mm256_storeu_ps(lanes, acc);
+    v = lanes[0];
+    for (k = 1; k < 8; k++) {
+        v = (is_max ? lanes[k] > v : lanes[k] < v) ? lanes[k] : v;
+    }
+    if (_mm256_movemask_ps(nan)) {
+        v = NAN;
+    }
+    for (; i < n; i++) {
+        if (masked_keep(in[i], mask, i, skipnan)) {
+            v = ((is_max ? in[i] > v : in[i] < v) || isnan(in[i])) ? in[i] : v;
+            count++;
+        }
+    }
+    *value = v;
+    return count;
+}
+
+static NDARRAY_TARGET_AVX2 double
+float_masked_sqdev_avx2(const float *in, const float *mask, long n, int skipnan, double mean) {
+    __m256 x, keep;
+    __m256d m = _mm256_set1_pd(mean), d0, d1;
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    __m128d h;
+    double value, d;
+    long i = 0;
+    for (; i + 8 <= n; i += 8) {
+        x = _mm256_loadu_ps(in + i);
+        keep = masked_lanes256(x, mask != NULL ? mask + i : NULL, skipnan);
+        // Widen the lane mask to the double lanes, excluded lanes deviate by 0
+        d0 = _mm256_sub_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(x)), m);
+        d1 = _mm256_sub_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(x, 1)), m);
+        d0 = _mm256_and_pd(d0, _mm256_castsi256_pd(
+                _mm256_cvtepi32_epi64(_mm_castps_si128(_mm256_castps256_ps128(keep)))));
+        d1 = _mm256_and_pd(d1, _mm256_castsi256_pd(
+                _mm256_cvtepi32_epi64(_mm_castps_si128(_mm256_extractf128_ps(keep, 1)))));
+        acc0 = _mm256_fmadd_pd(d0, d0, acc0);
+        acc1 = _mm256_fmadd_pd(d1, d1, acc1);
+    }
+    acc0 = _mm256_add_pd(acc0, acc1);
+    h = _mm_add_pd(_mm256_castpd256_pd128(acc0), _mm256_extractf128_pd(acc0, 1));
+    value = _mm_cvtsd_f64(_mm_add_sd(h, _mm_unpackhi_pd(h, h)));
+    for (; i < n; i++) {
+        if (masked_keep(in[i], mask, i, skipnan)) {
+            d = in[i] - mean;
+            value += d * d;
+        }
+    }
+    return value;
+}
+#endif
+
+/*
+ * Pairwise summation. Ranges longer than a block are halved recursively
+ * and each block is summed with independent accumulators, so the error
+ * grows with log(n) instead of n. The block sizes keep every accumulator
+ * lane at 16 additions, like numpy's 128 element blocks with 8 scalar
+ * accumulators. Partial sums are combined in double.
+ */
+#define PAIRWISE_BLOCK 128
+#define PAIRWISE_BLOCK_AVX2 512
+#define PAIRWISE_BLOCK_AVX512F 1024
+
+typedef double (*pairwise_leaf_func)(const char *in, long stride, long n);
+
+static double
+pairwise_leaf(const char *in, long stride, long n) {
+    float r[8];
+    double value = 0;
+    long i, j;
+
+    if (n < 8) {
+        for (i = 0; i < n; i++) {
+            value += *(const float *) (in + i * stride);
+        }
+        return value;
+    }
+    for (j = 0; j < 8; j++) {
+        r[j] = *(const float *) (in + j * stride);
+    }
+    for (i = 8; i + 8 <= n; i += 8) {
+        for (j = 0; j < 8; j++) {
+            r[j] += *(const float *) (in + (i + j) * stride);
+        }
+    }
+    value = ((double) (r[0] + r[1]) + (r[2] + r[3])) + ((double) (r[4] + r[5]) + (r[6] + r[7]));
+    for (; i < n; i++) {
+        value += *(const float *) (in + i * stride);
+    }
+    return value;
+}
+
+static double
+pairwise_sum(const char *in, long stride, long n, long block, pairwise_leaf_func leaf) {
+    long half;
+    if (n <= block) {
+        return leaf(in, stride, n);
+    }
+    // Keep the halves a multiple of the widest vector unroll
+    half = n / 2;
+    half -= half % 64;
+    return pairwise_sum(in, stride, half, block, leaf) +
+           pairwise_sum(in + half * stride, stride, n - half, block, leaf);
+}
+
+/**
+ * Pairwise sum of `n` floats `stride` bytes apart
+ *
+ * @param in
+ * @param stride
+ * @param n
+ * @return
+ */
+double
+NDArray_PairwiseSum(const char *in, long stride, long n) {
+    if (n < 8) {
+        return pairwise_leaf(in, stride, n);
+    }
+    if (stride == sizeof(float)) {
+#ifdef HAVE_AVX512F
+        if (NDArray_CPU_Level() >= NDARRAY_CPU_AVX512F) {
+            return pairwise_sum(in, stride, n, PAIRWISE_BLOCK_AVX512F, pairwise_leaf_avx512f);
+        }
+#endif
+#ifdef HAVE_AVX2
+        if (NDArray_CPU_Level() >= NDARRAY_CPU_AVX2) {
+            return pairwise_sum(in, stride, n, PAIRWISE_BLOCK_AVX2, pairwise_leaf_avx2);
+        }
+#endif
+    }
+    return pairwise_sum(in, stride, n, PAIRWISE_BLOCK, pairwise_leaf);
+}
+
+/**
+ * Sum of `n` contiguous floats
+ *
+ * @param in
+ * @param n
+ * @return
+ */
+float
+NDArray_FloatSum(const float *in, long n) {
+    return (float) NDArray_PairwiseSum((const char *) in, sizeof(float), n);
+}
+
+/**
+ * acc[i] += in[i] for `n` elements, accumulating float data in double
+ *
+ * @param acc
+ * @param in
+ * @param n
+ */
+void
+NDArray_FloatAccumulate(double *acc, const float *in, long n) {
+    long i;
+#ifdef HAVE_AVX512F
+    if (NDArray_CPU_Level() >= NDARRAY_CPU_AVX512F) {
+        float_accumulate_avx512f(acc, in, n);
+        return;
+    }
+#endif
+#ifdef HAVE_AVX2
+    if (NDArray_CPU_Level() >= NDARRAY_CPU_AVX2) {
+        float_accumulate_avx2(acc, in, n);
+        return;
+    }
+#endif
+    for (i = 0; i < n; i++) {
+        acc[i] += in[i];
+    }
+}
+
+/**
+ * Minimum of `n` contiguous floats, `n` must be at least 1
+ *
+ * @param in
+ * @param n
+ * @return
+ */
+float
+NDArray_FloatMin(const float *in, long n) {
+    float value = in[0];
+    long i;
+#ifdef HAVE_AVX512F
+    if (NDArray_CPU_Level() >= NDARRAY_CPU_AVX512F) {
+        return float_min_avx512f(in, n);
+    }
+#endif
+#ifdef HAVE_AVX2
+    if (NDArray_CPU_Level() >= NDARRAY_CPU_AVX2) {
+        return float_min_avx2(in, n);
+    }
+#endif
+    for (i = 1; i < n; i++) {
+        if (in[i] < value) {
+            value = in[i];
+        }
+    }
+    return value;
+}
+
+/**
+ * Maximum of `n` contiguous floats, `n` must be at least 1
+ *
+ * @param in
+ * @param n
+ * @return
+ */
+float
+NDArray_FloatMax(const float *in, long n) {
+    float value = in[0];
+    long i;
+#ifdef HAVE_AVX512F
+    if (NDArray_CPU_Level() >= NDARRAY_CPU_AVX512F) {
+        return float_max_avx512f(in, n);
+    }
+#endif
+#ifdef HAVE_AVX2
+    if (NDArray_CPU_Level() >= NDARRAY_CPU_AVX2) {
+        return float_max_avx2(in, n);
+    }
+#endif
+    for (i = 1; i < n; i++) {
+        if (in[i] > value) {
+            value = in[i];
+        }
+    }
+    return value;
+}
+
+/**
+ * Sum of the squared deviations of `n` contiguous floats from `mean`,
+ * computed in double
+ *
+ * @param in
+ * @param n
+ * @param mean
+ * @return
+ */
+double
+NDArray_FloatSquaredDeviations(const float *in, long n, double mean) {
+    double value = 0, d;
+    long i;
+#ifdef HAVE_AVX512F
+    if (NDArray_CPU_Level() >= NDARRAY_CPU_AVX512F) {
+        return float_sqdev_avx512f(in, n, mean);
+    }
+#endif
+#ifdef HAVE_AVX2
+    if (NDArray_CPU_Level() >= NDARRAY_CPU_AVX2) {
+        return float_sqdev_avx2(in, n, mean);
+    }
+#endif
+    for (i = 0; i < n; i++) {
+        d = in[i] - mean;
+        value += d * d;
+    }
+    return value;
+}
+
+/*
+ * The SIMD kernels keep lane indexes in 32 bits, longer ranges are
+ * handled in segments
+ */
+#define ARG_SEGMENT (1L << 30)
+
+static long
+float_arg(const float *in, long n, int is_max) {
+    long start, len, r = -1, k;
+    for (start = 0; start < n; start += ARG_SEGMENT) {
+        len = (n - start < ARG_SEGMENT) ? n - start : ARG_SEGMENT;
+#ifdef HAVE_AVX512F
+        if (NDArray_CPU_Level() >= NDARRAY_CPU_AVX512F) {
+            k = start + float_arg_avx512f(in + start, len, is_max);
+        } else
+#endif
+#ifdef HAVE_AVX2
+        if (NDArray_CPU_Level() >= NDARRAY_CPU_AVX2) {
+            k = start + float_arg_avx2(in + start, len, is_max);
+        } else
+#endif
+        {
+            k = start + float_arg_scalar(in + start, len, is_max);
+        }
+        if (isnan(in[k])) {
+            return k;
+        }
+        if (r < 0 || (is_max ? in[k] > in[r] : in[k] < in[r])) {
+            r = k;
+        }
+    }
+    return r;
+}
+
+/**
+ * Index of the first maximum of `n` contiguous floats, or of the first
+ * NaN. `n` must be at least 1.
+ *
+ * @param in
+ * @param n
+ * @return
+ */
+long
+NDArray_FloatArgMax(const float *in, long n) {
+    return float_arg(in, n, 1);
+}
+
+/**
+ * Index of the first minimum of `n` contiguous floats, or of the first
+ * NaN. `n` must be at least 1.
+ *
+ * @param in
+ * @param n
+ * @return
+ */
+long
+NDArray_FloatArgMin(const float *in, long n) {
+    return float_arg(in, n, 0);
+}
+
+/**
+ * Running sum of `n` contiguous floats, out[i] = in[0] + ... + in[i].
+ * `in` and `out` may be the same buffer.
+ *
+ * @param in
+ * @param out
+ * @param n
+ */
+void
+NDArray_FloatCumSum(const float *in, float *out, long n) {
+    long i;
+    if (n <= 0) {
+        return;
+    }
+#ifdef HAVE_AVX2
+    if (NDArray_CPU_Level() >= NDARRAY_CPU_AVX2) {
+        float_cumsum_avx2(in, out, n);
+        return;
+    }
+#endif
+    out[0] = in[0];
+    for (i = 1; i < n; i++) {
+        out[i] = out[i - 1] + in[i];
+    }
+}
+
+/**
+ * Running product of `n` contiguous floats
+ *
+ * @param in
+ * @param out
+ * @param n
+ */
+void
+NDArray_FloatCumProd(const float *in, float *out, long n) {
+    long i;
+    if (n <= 0) {
+        return;
+    }
+#ifdef HAVE_AVX2
+    if (NDArray_CPU_Level() >= NDARRAY_CPU_AVX2) {
+        float_cumprod_avx2(in, out, n);
+        return;
+    }
+#endif
+    out[0] = in[0];
+    for (i = 1; i < n; i++) {
+        out[i] = out[i - 1] * in[i];
+    }
+}
+
+/**
+ * Running maximum of `n` contiguous floats, NaN propagates
+ *
+ * @param in
+ * @param out
+ * @param n
+ */
+void
+NDArray_FloatCumMax(const float *in, float *out, long n) {
+    long i;
+    if (n <= 0) {
+        return;
+    }
+#ifdef HAVE_AVX2
+    if (NDArray_CPU_Level() >= NDARRAY_CPU_AVX2) {
+        float_cummax_avx2(in, out, n);
+        return;
+    }
+#endif
+    out[0] = in[0];
+    for (i = 1; i < n; i++) {
+        out[i] = (in[i] > out[i - 1] || isnan(in[i])) ? in[i] : out[i - 1];
+    }
+}
+
+/**
+ * Sum of the elements of `n` contiguous floats that have a non-zero
+ * `mask`, skipping NaN when `skipnan` is set. Excluded lanes are blended
+ * to 0 inside the loop, nothing is copied. The sum is computed in double.
+ *
+ * @param in
+ * @param mask `n` floats, NULL to include every element
+ * @param n
+ * @param skipnan
+ * @param sum Set to the sum of the included elements
+ * @return the number of included elements
+ */
+long
+NDArray_FloatMaskedSum(const float *in, const float *mask, long n, int skipnan, double *sum) {
+    double value = 0;
+    long i, count = 0;
+#ifdef HAVE_AVX2
+    if (NDArray_CPU_Level() >= NDARRAY_CPU_AVX2) {
+        return float_masked_sum_avx2(in, mask, n, skipnan, sum);
+    }
+#endif
+    for (i = 0; i < n; i++) {
+        if (masked_keep(in[i], mask, i, skipnan)) {
+            value += in[i];
+            count++;
+        }
+    }
+    *sum = value;
+    return count;
+}
+
+/**
+ * Minimum or maximum of the included elements of `n` contiguous floats,
+ * see NDArray_FloatMaskedSum. An included NaN propagates.
+ *
+ * @param in
+ * @param mask `n` floats, NULL to include every element
+ * @param n
+ * @param skipnan
+ * @param is_max
+ * @param value Set to the result, undefined when nothing is included
+ * @return the number of included elements
+ */
+long
+NDArray_FloatMaskedMinMax(const float *in, const float *mask, long n, int skipnan, int is_max, float *value) {
+    float v = is_max ? -INFINITY : INFINITY;
+    long i, count = 0;
+#ifdef HAVE_AVX2
+    if (NDArray_CPU_Level() >= NDARRAY_CPU_AVX2) {
+        return float_masked_minmax_avx2(in, mask, n, skipnan, is_max, value);
+    }
+#endif
+    for (i = 0; i < n; i++) {
+        if (masked_keep(in[i], mask, i, skipnan)) {
+            v = ((is_max ? in[i] > v : in[i] < v) || isnan(in[i])) ? in[i] : v;
+            count++;
+        }
+    }
+    *value = v;
+    return count;
+}
+
+/**
+ * Sum of the squared deviations from `mean` of the included elements of
+ * `n` contiguous floats, see NDArray_FloatMaskedSum
+ *
+ * @param in
+ * @param mask `n` floats, NULL to include every element
+ * @param n
+ * @param skipnan
+ * @param mean
+ * @return
+ */
+double
+NDArray_FloatMaskedSquaredDeviations(const float *in, const float *mask, long n, int skipnan, double mean) {
+    double value = 0, d;
+    long i;
+#ifdef HAVE_AVX2
+    if (NDArray_CPU_Level() >= NDARRAY_CPU_AVX2) {
+        return float_masked_sqdev_avx2(in, mask, n, skipnan, mean);
+    }
+#endif
+    for (i = 0; i < n; i++) {
+        if (masked_keep(in[i], mask, i, skipnan)) {
+            d = in[i] - mean;
+            value += d * d;
+        }
+    }
+    return value;
+}
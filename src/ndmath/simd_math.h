@@ -0,0 +1,33 @@
+#ifndef PHPSCI_NDARRAY_SIMD_MATH_H
+#define PHPSCI_NDARRAY_SIMD_MATH_H
+
+#include "../ndarray.h"
+
+/**
+ * Vectorized version of an ElementWiseDoubleOperation over `n`
+ * contiguous floats. `in` and `out` may be the same buffer.
+ */
+typedef void (*NDArray_VectorKernel)(const float *in, float *out, long n);
+
+/**
+ * Vectorized version of an ElementWiseFloatOperation2F
+ */
+typedef void (*NDArray_VectorKernel2F)(const float *in, float *out, long n, float val1, float val2);
+
+NDArray_VectorKernel NDArray_GetVectorKernel(ElementWiseDoubleOperation op);
+NDArray_VectorKernel2F NDArray_GetVectorKernel2F(ElementWiseFloatOperation2F op);
+double NDArray_PairwiseSum(const char *in, long stride, long n);
+float NDArray_FloatSum(const float *in, long n);
+void NDArray_FloatAccumulate(double *acc, const float *in, long n);
+float NDArray_FloatMin(const float *in, long n);
+float NDArray_FloatMax(const float *in, long n);
+void NDArray_FloatCumSum(const float *in, float *out, long n);
+void NDArray_FloatCumProd(const float *in, float *out, long n);
+void NDArray_FloatCumMax(const float *in, float *out, long n);
+long NDArray_FloatArgMax(const float *in, long n);
+long NDArray_FloatArgMin(const float *in, long n);
+double NDArray_FloatSquaredDeviations(const float *in, long n, double mean);
+long NDArray_FloatMaskedSum(const float *in, const float *mask, long n, int skipnan, double *sum);
+long NDArray_FloatMaskedMinMax(const float *in, const float *mask, long n, int skipnan, int is_max, float *value);
+double NDArray_FloatMaskedSquaredDeviations(const float *in, const float *mask, long n, int skipnan, double mean);
+#endif //PHPSCI_NDARRAY_SIMD_MATH_H
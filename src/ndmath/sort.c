@@ -0,0 +1,550 @@
+#include <php.h>
+#include "Zend/zend_alloc.h"
+#include "Zend/zend_API.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "sort.h"
+#include "reduction.h"
+#include "../../config.h"
+#include "../initializers.h"
+#include "../manipulation.h"
+#include "../types.h"
+#include "../threadpool.h"
+
+/**
+ * Lines shorter than this are sorted by insertion instead of radix
+ */
+#define RADIX_MIN 64
+
+/**
+ * Ranges shorter than this are finished with an insertion sort
+ */
+#define SELECT_SMALL 16
+
+typedef enum {
+    SORT_VALUES = 0,
+    SORT_INDEXES,
+    SORT_PARTITION,
+    SORT_TOPK,
+} sort_kind;
+
+/**
+ * Map a float to an unsigned key with the same order. NaN gets the
+ * largest key so it is sorted last, like numpy. With `canonical` -0 and
+ * +0 share a key, so ties between them keep their original order.
+ */
+static inline uint32_t
+float_key(float x, int canonical) {
+    uint32_t u;
+    if (isnan(x)) {
+        return 0xFFFFFFFFu;
+    }
+    if (canonical && x == 0.0f) {
+        x = 0.0f;
+    }
+    memcpy(&u, &x, sizeof(u));
+    return (u & 0x80000000u) ? ~u : (u | 0x80000000u);
+}
+
+static inline float
+key_float(uint32_t k) {
+    uint32_t u = (k & 0x80000000u) ? (k & 0x7FFFFFFFu) : ~k;
+    float x;
+    memcpy(&x, &u, sizeof(x));
+    return x;
+}
+
+/**
+ * Stable sort of `n` keys, and of their indexes when `idx` is not NULL.
+ * LSD radix sort over the 4 bytes of the keys, skipping the bytes all
+ * keys share. `tmp_keys` and `tmp_idx` hold `n` elements each.
+ */
+static void
+radix_sort(uint32_t *keys, uint32_t *idx, uint32_t *tmp_keys, uint32_t *tmp_idx, long n) {
+    long counts[4][256], offsets[256], i, j, o, sum;
+    uint32_t *src = keys, *dst = tmp_keys, *src_idx = idx, *dst_idx = tmp_idx, *swap, k, ix;
+    int p, b, shift;
+
+    if (n < RADIX_MIN) {
+        for (i = 1; i < n; i++) {
+            k = keys[i];
+            ix = idx != NULL ? idx[i] : 0;
+            for (j = i; j > 0 && keys[j - 1] > k; j--) {
+                keys[j] = keys[j - 1];
+                if (idx != NULL) {
+                    idx[j] = idx[j - 1];
+                }
+            }
+            keys[j] = k;
+            if (idx != NULL) {
+                idx[j] = ix;
+            }
+        }
+        return;
+    }
+
+    memset(counts, 0, sizeof(counts));
+    for (i = 0; i < n; i++) {
+        k = keys[i];
+        counts[0][k & 0xFF]++;
+        counts[1][(k >> 8) & 0xFF]++;
+        counts[2][(k >> 16) & 0xFF]++;
+        counts[3][k >> 24]++;
+    }
+    for (p = 0; p < 4; p++) {
+        shift = p * 8;
+        if (counts[p][(src[0] >> shift) & 0xFF] == n) {
+            continue;
+        }
+        for (b = 0, sum = 0; b < 256; b++) {
+            offsets[b] = sum;
+            sum += counts[p][b];
+        }
+        for (i = 0; i < n; i++) {
+            o = offsets[(src[i] >> shift) & 0xFF]++;
+            dst[o] = src[i];
+            if (idx != NULL) {
+                dst_idx[o] = src_idx[i];
+            }
+        }
+        swap = src; src = dst; dst = swap;
+        swap = src_idx; src_idx = dst_idx; dst_idx = swap;
+    }
+    if (src != keys) {
+        memcpy(keys, src, sizeof(uint32_t) * n);
+        if (idx != NULL) {
+            memcpy(idx, src_idx, sizeof(uint32_t) * n);
+        }
+    }
+}
+
+static int
+compare_u64(const void *a, const void *b) {
+    uint64_t ua = *(const uint64_t *) a, ub = *(const uint64_t *) b;
+    return (ua > ub) - (ua < ub);
+}
+
+static inline void
+swap_u64(uint64_t *a, uint64_t *b) {
+    uint64_t tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+/**
+ * Introselect over integer keys, see select_kth in statistics.c: reorder
+ * v[lo, hi) so that v[k] holds the element it would hold if the range
+ * was sorted, with nothing greater before it and nothing smaller after.
+ */
+static void
+select_kth_u64(uint64_t *v, long lo, long hi, long k) {
+    long i, j, mid, depth = 0;
+    uint64_t pivot;
+
+    for (i = hi - lo; i > 1; i >>= 1) {
+        depth += 2;
+    }
+    while (hi - lo > SELECT_SMALL) {
+        if (depth-- == 0) {
+            qsort(v + lo, hi - lo, sizeof(uint64_t), compare_u64);
+            return;
+        }
+        mid = lo + (hi - lo) / 2;
+        if (v[mid] < v[lo]) swap_u64(&v[mid], &v[lo]);
+        if (v[hi - 1] < v[lo]) swap_u64(&v[hi - 1], &v[lo]);
+        if (v[hi - 1] < v[mid]) swap_u64(&v[hi - 1], &v[mid]);
+        pivot = v[mid];
+        i = lo;
+        j = hi - 1;
+        while (i <= j) {
+            while (v[i] < pivot) i++;
+            while (v[j] > pivot) j--;
+            if (i <= j) {
+                swap_u64(&v[i], &v[j]);
+                i++;
+                j--;
+            }
+        }
+        if (k <= j) {
+            hi = j + 1;
+        } else if (k >= i) {
+            lo = i;
+        } else {
+            return;
+        }
+    }
+    for (i = lo + 1; i < hi; i++) {
+        pivot = v[i];
+        for (j = i; j > lo && v[j - 1] > pivot; j--) {
+            v[j] = v[j - 1];
+        }
+        v[j] = pivot;
+    }
+}
+
+/**
+ * Lines of a sort along one axis. The other axes are walked in C order
+ * through their strides, every line is gathered into a scratch buffer,
+ * sorted or selected there and written to the contiguous outputs.
+ */
+typedef struct {
+    sort_kind kind;
+    int nd;
+    int dims[NDARRAY_MAX_DIMS];
+    int in_strides[NDARRAY_MAX_DIMS];
+    int out_strides[NDARRAY_MAX_DIMS];
+    long m;                 // Length of the sorted axis
+    int in_axis_stride;
+    int out_axis_stride;
+    char *in;
+    char *out;
+    char *out_indexes;      // Second output of top-k
+    const long *kth;        // Sorted distinct partition indexes
+    int nkth;
+    long k;
+    int largest;
+    int failed;
+} sort_ctx;
+
+static void
+sort_line(const sort_ctx *c, const char *in, char *out, char *out_indexes, void *scratch) {
+    uint32_t *keys = scratch, *idx = keys + c->m, *tmp_keys = idx + c->m, *tmp_idx = tmp_keys + c->m;
+    uint64_t *v = scratch, key;
+    long i, lo, index;
+    int canonical = c->kind == SORT_INDEXES || c->kind == SORT_TOPK;
+
+    switch (c->kind) {
+        case SORT_VALUES:
+        case SORT_INDEXES:
+            for (i = 0; i < c->m; i++) {
+                keys[i] = float_key(*(const float *) (in + i * c->in_axis_stride), canonical);
+                if (c->kind == SORT_INDEXES) {
+                    idx[i] = (uint32_t) i;
+                }
+            }
+            radix_sort(keys, c->kind == SORT_INDEXES ? idx : NULL, tmp_keys, tmp_idx, c->m);
+            for (i = 0; i < c->m; i++) {
+                *(float *) (out + i * c->out_axis_stride) = c->kind == SORT_INDEXES ? (float) idx[i] : key_float(keys[i]);
+            }
+            break;
+        case SORT_PARTITION:
+            for (i = 0; i < c->m; i++) {
+                v[i] = (uint64_t) float_key(*(const float *) (in + i * c->in_axis_stride), 0) << 32;
+            }
+            // Every selection leaves the elements above its kth in place for the next one
+            for (i = 0, lo = 0; i < c->nkth; i++) {
+                select_kth_u64(v, lo, c->m, c->kth[i]);
+                lo = c->kth[i] + 1;
+            }
+            for (i = 0; i < c->m; i++) {
+                *(float *) (out + i * c->out_axis_stride) = key_float((uint32_t) (v[i] >> 32));
+            }
+            break;
+        case SORT_TOPK:
+            // The index in the low bits breaks ties in favor of the first occurrence
+            for (i = 0; i < c->m; i++) {
+                key = float_key(*(const float *) (in + i * c->in_axis_stride), 1);
+                v[i] = ((c->largest ? ~key & 0xFFFFFFFFu : key) << 32) | (uint64_t) i;
+            }
+            if (c->k < c->m) {
+                select_kth_u64(v, 0, c->m, c->k - 1);
+            }
+            qsort(v, c->k, sizeof(uint64_t), compare_u64);
+            for (i = 0; i < c->k; i++) {
+                index = (long) (v[i] & 0xFFFFFFFFu);
+                *(float *) (out + i * c->out_axis_stride) = *(const float *) (in + index * c->in_axis_stride);
+                *(float *) (out_indexes + i * c->out_axis_stride) = (float) index;
+            }
+            break;
+    }
+}
+
+/**
+ * Process the lines belonging to elements [start, end) of the input,
+ * runs on the thread pool with its own scratch buffer
+ */
+static void
+sort_range(long start, long end, void *ctx) {
+    sort_ctx *c = ctx;
+    long lo = (start + c->m - 1) / c->m;
+    long hi = (end + c->m - 1) / c->m;
+    long g, rest, index, in_offset, out_offset;
+    int d;
+    void *scratch;
+
+    if (lo >= hi) {
+        return;
+    }
+    scratch = malloc(sizeof(uint32_t) * 4 * c->m);
+    if (scratch == NULL) {
+        c->failed = 1;
+        return;
+    }
+    for (g = lo; g < hi; g++) {
+        in_offset = 0;
+        out_offset = 0;
+        rest = g;
+        for (d = c->nd - 1; d >= 0; d--) {
+            index = rest % c->dims[d];
+            in_offset += index * c->in_strides[d];
+            out_offset += index * c->out_strides[d];
+            rest /= c->dims[d];
+        }
+        sort_line(c, c->in + in_offset, c->out + out_offset,
+                  c->out_indexes != NULL ? c->out_indexes + out_offset : NULL, scratch);
+    }
+    free(scratch);
+}
+
+/**
+ * Set up the lines of `a` along `axis`, NDARRAY_MAX_DIMS for the
+ * flattened array, in which case `*contiguous` may receive a copy to
+ * free afterwards. The output shape is the input shape with the sorted
+ * axis resized to `out_len`, -1 to keep it.
+ *
+ * @return the output shape, NULL with an exception set on error
+ */
+static int *
+sort_setup(sort_ctx *c, NDArray *a, int *axis, long out_len, int *out_ndim, NDArray **contiguous) {
+    char reduced[NDARRAY_MAX_DIMS];
+    int *shape, i;
+
+    memset(c, 0, sizeof(*c));
+    *contiguous = NULL;
+    if (NDArray_DEVICE(a) == NDARRAY_DEVICE_GPU) {
+        zend_throw_error(NULL, "GPU not supported.");
+        return NULL;
+    }
+    if (*axis == NDARRAY_MAX_DIMS) {
+        if (!NDArray_IsContiguous(a)) {
+            *contiguous = NDArray_ToContiguous(a);
+        }
+        c->in = NDArray_DATA(*contiguous != NULL ? *contiguous : a);
+        c->m = NDArray_NUMELEMENTS(a);
+        c->in_axis_stride = sizeof(float);
+        shape = emalloc(sizeof(int));
+        shape[0] = (int) (out_len < 0 ? c->m : out_len);
+        *out_ndim = 1;
+        *axis = 0;
+        return shape;
+    }
+    if (NDArray_ReduceAxes(NDArray_NDIM(a), axis, 1, reduced) < 0) {
+        return NULL;
+    }
+    if (*axis < 0) {
+        *axis += NDArray_NDIM(a);
+    }
+    c->in = NDArray_DATA(a);
+    c->m = NDArray_SHAPE(a)[*axis];
+    c->in_axis_stride = NDArray_STRIDES(a)[*axis];
+    for (i = 0; i < NDArray_NDIM(a); i++) {
+        if (i != *axis) {
+            c->dims[c->nd] = NDArray_SHAPE(a)[i];
+            c->in_strides[c->nd++] = NDArray_STRIDES(a)[i];
+        }
+    }
+    shape = emalloc(sizeof(int) * NDArray_NDIM(a));
+    memcpy(shape, NDArray_SHAPE(a), sizeof(int) * NDArray_NDIM(a));
+    if (out_len >= 0) {
+        shape[*axis] = (int) out_len;
+    }
+    *out_ndim = NDArray_NDIM(a);
+    return shape;
+}
+
+/**
+ * Run the lines of a set up context into `rtn` (and `indexes`)
+ *
+ * @return 0, -1 with an exception set on error
+ */
+static int
+sort_run(sort_ctx *c, NDArray *rtn, NDArray *indexes, int axis, long n) {
+    int i, d = 0;
+
+    c->out = NDArray_DATA(rtn);
+    c->out_indexes = indexes != NULL ? NDArray_DATA(indexes) : NULL;
+    c->out_axis_stride = NDArray_STRIDES(rtn)[axis];
+    for (i = 0; i < NDArray_NDIM(rtn); i++) {
+        if (i != axis) {
+            c->out_strides[d++] = NDArray_STRIDES(rtn)[i];
+        }
+    }
+    if (n == 0 || c->m == 0 || NDArray_NUMELEMENTS(rtn) == 0) {
+        return 0;
+    }
+    NDArray_ParallelFor(n, NDARRAY_PARALLEL_GRAIN, sort_range, c);
+    if (c->failed) {
+        zend_throw_error(NULL, "failed to allocate memory for sort");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Sort a float32 CPU array along an axis, or compute the indexes that
+ * would sort it. The sort is stable and NaN is placed last. Every line
+ * is radix sorted, lines are spread over the thread pool.
+ *
+ * Indexes are stored in a float32 array, so argsort rejects axes longer
+ * than NDARRAY_MAX_FLOAT_INDEX instead of returning rounded indexes.
+ *
+ * @param a
+ * @param axis Axis to sort, NDARRAY_MAX_DIMS to sort the flattened array
+ * @param is_argsort
+ * @return
+ */
+NDArray *
+NDArray_Sort(NDArray *a, int axis, int is_argsort) {
+    NDArray *contiguous, *rtn;
+    int *shape, ndim;
+    sort_ctx ctx;
+
+    shape = sort_setup(&ctx, a, &axis, -1, &ndim, &contiguous);
+    if (shape == NULL) {
+        return NULL;
+    }
+    if (is_argsort && ctx.m > NDARRAY_MAX_FLOAT_INDEX) {
+        zend_throw_error(NULL, "argsort along an axis of more than %d elements can't be stored exactly in a float32 array",
+                         NDARRAY_MAX_FLOAT_INDEX);
+        efree(shape);
+        if (contiguous != NULL) {
+            NDArray_FREE(contiguous);
+        }
+        return NULL;
+    }
+    ctx.kind = is_argsort ? SORT_INDEXES : SORT_VALUES;
+    rtn = NDArray_Empty(shape, ndim, NDARRAY_TYPE_FLOAT32, NDARRAY_DEVICE_CPU);
+    if (sort_run(&ctx, rtn, NULL, axis, NDArray_NUMELEMENTS(a)) < 0) {
+        NDArray_FREE(rtn);
+        rtn = NULL;
+    }
+    if (contiguous != NULL) {
+        NDArray_FREE(contiguous);
+    }
+    return rtn;
+}
+
+/**
+ * Partially sort a float32 CPU array along an axis: every element at a
+ * `kth` position is the one a full sort would put there, smaller
+ * elements come before it and greater ones after it. Linear time per
+ * line, NaN is placed last.
+ *
+ * @param a
+ * @param kth Positions to select, negative values count from the end
+ * @param nkth
+ * @param axis Axis to partition, NDARRAY_MAX_DIMS for the flattened array
+ * @return
+ */
+NDArray *
+NDArray_Partition(NDArray *a, const long *kth, int nkth, int axis) {
+    NDArray *contiguous, *rtn;
+    int *shape, ndim, i, j;
+    long *sorted, k;
+    sort_ctx ctx;
+
+    shape = sort_setup(&ctx, a, &axis, -1, &ndim, &contiguous);
+    if (shape == NULL) {
+        return NULL;
+    }
+    sorted = emalloc(sizeof(long) * (nkth > 0 ? nkth : 1));
+    ctx.nkth = 0;
+    for (i = 0; i < nkth; i++) {
+        k = kth[i] < 0 ? kth[i] + ctx.m : kth[i];
+        if (k < 0 || k >= ctx.m) {
+            zend_throw_error(NULL, "kth(=%ld) out of bounds (%ld)", kth[i], ctx.m);
+            efree(sorted);
+            efree(shape);
+            if (contiguous != NULL) {
+                NDArray_FREE(contiguous);
+            }
+            return NULL;
+        }
+        // Insert in order, skipping duplicates
+        for (j = 0; j < ctx.nkth && sorted[j] < k; j++);
+        if (j < ctx.nkth && sorted[j] == k) {
+            continue;
+        }
+        memmove(sorted + j + 1, sorted + j, sizeof(long) * (ctx.nkth - j));
+        sorted[j] = k;
+        ctx.nkth++;
+    }
+    ctx.kind = SORT_PARTITION;
+    ctx.kth = sorted;
+    rtn = NDArray_Empty(shape, ndim, NDARRAY_TYPE_FLOAT32, NDARRAY_DEVICE_CPU);
+    if (sort_run(&ctx, rtn, NULL, axis, NDArray_NUMELEMENTS(a)) < 0) {
+        NDArray_FREE(rtn);
+        rtn = NULL;
+    }
+    efree(sorted);
+    if (contiguous != NULL) {
+        NDArray_FREE(contiguous);
+    }
+    return rtn;
+}
+
+/**
+ * The `k` largest (or smallest) elements of every line of a float32 CPU
+ * array along an axis, in order, and their indexes. Each line is reduced
+ * with a linear time selection and only the `k` selected elements are
+ * sorted. Ties are resolved in favor of the first occurrence and NaN
+ * ranks above every other value.
+ *
+ * @param a
+ * @param k
+ * @param axis Axis to search, NDARRAY_MAX_DIMS for the flattened array
+ * @param largest
+ * @param values Receives the values, the axis resized to `k`
+ * @param indexes Receives the indexes along the axis, as float32. Axes
+ *                longer than NDARRAY_MAX_FLOAT_INDEX are rejected.
+ * @return 0, -1 with an exception set on error
+ */
+int
+NDArray_TopK(NDArray *a, long k, int axis, int largest, NDArray **values, NDArray **indexes) {
+    NDArray *contiguous;
+    int *shape, *shape_indexes, ndim;
+    sort_ctx ctx;
+
+    *values = NULL;
+    *indexes = NULL;
+    shape = sort_setup(&ctx, a, &axis, k, &ndim, &contiguous);
+    if (shape == NULL) {
+        return -1;
+    }
+    if (k < 0 || k > ctx.m) {
+        zend_throw_error(NULL, "k(=%ld) out of bounds (%ld)", k, ctx.m);
+        efree(shape);
+        if (contiguous != NULL) {
+            NDArray_FREE(contiguous);
+        }
+        return -1;
+    }
+    if (ctx.m > NDARRAY_MAX_FLOAT_INDEX) {
+        zend_throw_error(NULL, "topk along an axis of more than %d elements can't be stored exactly in a float32 array",
+                         NDARRAY_MAX_FLOAT_INDEX);
+        efree(shape);
+        if (contiguous != NULL) {
+            NDArray_FREE(contiguous);
+        }
+        return -1;
+    }
+    ctx.kind = SORT_TOPK;
+    ctx.k = k;
+    ctx.largest = largest;
+    shape_indexes = emalloc(sizeof(int) * ndim);
+    memcpy(shape_indexes, shape, sizeof(int) * ndim);
+    *values = NDArray_Empty(shape, ndim, NDARRAY_TYPE_FLOAT32, NDARRAY_DEVICE_CPU);
+    *indexes = NDArray_Empty(shape_indexes, ndim, NDARRAY_TYPE_FLOAT32, NDARRAY_DEVICE_CPU);
+    if (sort_run(&ctx, *values, *indexes, axis, NDArray_NUMELEMENTS(a)) < 0) {
+        NDArray_FREE(*values);
+        NDArray_FREE(*indexes);
+        *values = NULL;
+        *indexes = NULL;
+    }
+    if (contiguous != NULL) {
+        NDArray_FREE(contiguous);
+    }
+    return *values != NULL ? 0 : -1;
+}
@@ -0,0 +1,9 @@
+#ifndef PHPSCI_NDARRAY_SORT_H
+#define PHPSCI_NDARRAY_SORT_H
+
+#include "../ndarray.h"
+
+NDArray* NDArray_Sort(NDArray *a, int axis, int is_argsort);
+NDArray* NDArray_Partition(NDArray *a, const long *kth, int nkth, int axis);
+int NDArray_TopK(NDArray *a, long k, int axis, int largest, NDArray **values, NDArray **indices);
+#endif //PHPSCI_NDARRAY_SORT_H
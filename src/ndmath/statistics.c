@@ -1,52 +1,372 @@
 #include "Zend/zend_API.h"
+#include <math.h>
+#include <stdlib.h>
 #include "statistics.h"
 #include "string.h"
 #include "../initializers.h"
+#include "../types.h"
 #include "arithmetics.h"
+#include "reduction.h"
+#include "../threadpool.h"
+
+/**
+ * Ranges shorter than this are finished with an insertion sort
+ */
+#define SELECT_SMALL 16
 
 // Comparison function for sorting
-int compare_quantile(const void* a, const void* b) {
+static int
+compare_float(const void* a, const void* b) {
     float fa = *((const float*)a);
     float fb = *((const float*)b);
     return (fa > fb) - (fa < fb);
 }
 
-float calculate_quantile(float* vector, int num_elements, int stride, float quantile) {
-    // Copy vector elements to a separate array
-    float* temp = emalloc(num_elements * sizeof(float));
-    if (temp == NULL) {
-        // Handle memory allocation error
-        fprintf(stderr, "Memory allocation failed.\n");
-        exit(1);
+static inline void
+swap_float(float *a, float *b) {
+    float tmp = *a;
+    *a = *b;
+    *b = tmp;
+}
+
+/**
+ * Introselect: reorder v[lo, hi) so that v[k] is the element that would
+ * be there if the range was sorted, with nothing greater before it and
+ * nothing smaller after it. Quickselect with a median of three pivot,
+ * falling back to a sort when the partitions stop shrinking, so the
+ * worst case stays O(n log n). `v` must not contain NaN.
+ */
+static void
+select_kth(float *v, long lo, long hi, long k) {
+    long i, j, mid, depth = 0;
+    float pivot;
+
+    for (i = hi - lo; i > 1; i >>= 1) {
+        depth += 2;
+    }
+    while (hi - lo > SELECT_SMALL) {
+        if (depth-- == 0) {
+            qsort(v + lo, hi - lo, sizeof(float), compare_float);
+            return;
+        }
+        mid = lo + (hi - lo) / 2;
+        if (v[mid] < v[lo]) swap_float(&v[mid], &v[lo]);
+        if (v[hi - 1] < v[lo]) swap_float(&v[hi - 1], &v[lo]);
+        if (v[hi - 1] < v[mid]) swap_float(&v[hi - 1], &v[mid]);
+        pivot = v[mid];
+        // v[lo] <= pivot <= v[hi - 1] stop both scans
+        i = lo;
+        j = hi - 1;
+        while (i <= j) {
+            while (v[i] < pivot) i++;
+            while (v[j] > pivot) j--;
+            if (i <= j) {
+                swap_float(&v[i], &v[j]);
+                i++;
+                j--;
+            }
+        }
+        // [lo, j] <= pivot, (j, i) == pivot, [i, hi) >= pivot
+        if (k <= j) {
+            hi = j + 1;
+        } else if (k >= i) {
+            lo = i;
+        } else {
+            return;
+        }
     }
+    for (i = lo + 1; i < hi; i++) {
+        pivot = v[i];
+        for (j = i; j > lo && v[j - 1] > pivot; j--) {
+            v[j] = v[j - 1];
+        }
+        v[j] = pivot;
+    }
+}
+
+/**
+ * Order statistics needed by a set of quantiles of `n` values, shared by
+ * every output of a reduction
+ */
+typedef struct {
+    long n;
+    int nq;
+    long *lower;            // Index of the element below each quantile
+    double *weight;         // Interpolation weight of the element above
+    long *kth;              // Sorted distinct indexes to select
+    int nkth;
+} quantile_plan;
 
-    // Populate the temporary array using the strided vector
-    for (int i = 0; i < num_elements; i++) {
-        temp[i] = *((float*)((char*)vector + i * stride));
+static void
+quantile_plan_init(quantile_plan *plan, long n, const float *q, int nq) {
+    int i, j;
+    long k;
+    double pos;
+
+    plan->n = n;
+    plan->nq = nq;
+    plan->lower = emalloc(sizeof(long) * nq);
+    plan->weight = emalloc(sizeof(double) * nq);
+    plan->kth = emalloc(sizeof(long) * 2 * nq);
+    plan->nkth = 0;
+    for (i = 0; i < nq && n > 0; i++) {
+        pos = (double) q[i] * (double) (n - 1);
+        plan->lower[i] = (long) pos;
+        if (plan->lower[i] > n - 1) {
+            plan->lower[i] = n - 1;
+        }
+        plan->weight[i] = pos - (double) plan->lower[i];
+        plan->kth[plan->nkth++] = plan->lower[i];
+        if (plan->weight[i] > 0 && plan->lower[i] + 1 < n) {
+            plan->kth[plan->nkth++] = plan->lower[i] + 1;
+        }
     }
+    // Insertion sort and drop duplicates, nq is small
+    for (i = 1; i < plan->nkth; i++) {
+        k = plan->kth[i];
+        for (j = i; j > 0 && plan->kth[j - 1] > k; j--) {
+            plan->kth[j] = plan->kth[j - 1];
+        }
+        plan->kth[j] = k;
+    }
+    for (i = 0, j = 0; i < plan->nkth; i++) {
+        if (j == 0 || plan->kth[j - 1] != plan->kth[i]) {
+            plan->kth[j++] = plan->kth[i];
+        }
+    }
+    plan->nkth = j;
+}
+
+static void
+quantile_plan_free(quantile_plan *plan) {
+    efree(plan->lower);
+    efree(plan->weight);
+    efree(plan->kth);
+}
+
+/**
+ * Compute the quantiles of the plan from the `n` values in `v`, which is
+ * reordered. Every selection only partitions what is right of the
+ * previous one, so all quantiles together cost about one quickselect.
+ * Results are written `out_stride` floats apart.
+ */
+static void
+quantile_values(const quantile_plan *plan, float *v, float *out, long out_stride) {
+    long i, start = 0, k;
+    int j;
+    float a, b;
+    double t;
 
-    // Sort the array in ascending order
-    qsort(temp, num_elements, sizeof(float), compare_quantile);
+    for (j = 0; j < plan->nkth; j++) {
+        k = plan->kth[j];
+        if (k == start) {
+            // Only the minimum of the rest is needed
+            for (i = start + 1; i < plan->n; i++) {
+                if (v[i] < v[start]) {
+                    swap_float(&v[i], &v[start]);
+                }
+            }
+        } else {
+            select_kth(v, start, plan->n, k);
+        }
+        start = k + 1;
+    }
+    for (j = 0; j < plan->nq; j++) {
+        a = v[plan->lower[j]];
+        t = plan->weight[j];
+        if (t == 0) {
+            out[j * out_stride] = a;
+            continue;
+        }
+        b = v[plan->lower[j] + 1];
+        // Same linear interpolation as numpy, exact at both ends
+        out[j * out_stride] = (float) (t < 0.5 ? a + ((double) b - a) * t : b - ((double) b - a) * (1 - t));
+    }
+}
 
-    // Calculate the index of the desired quantile
-    float index = (float)(num_elements - 1) * quantile;
+/**
+ * Iteration space of a quantile reduction, the kept axes index the
+ * outputs and the reduced axes the values of each output
+ */
+typedef struct {
+    const quantile_plan *plan;
+    int kept_nd;
+    int red_nd;
+    int kept_dims[NDARRAY_MAX_DIMS];
+    int kept_strides[NDARRAY_MAX_DIMS];
+    int red_dims[NDARRAY_MAX_DIMS];
+    int red_strides[NDARRAY_MAX_DIMS];
+    char *in;
+    float *out;
+    long out_size;
+    long count;
+    int failed;
+} quantile_ctx;
+
+/**
+ * Compute the outputs belonging to elements [start, end) of the input,
+ * runs on the thread pool with its own scratch buffer
+ */
+static void
+quantile_range(long start, long end, void *ctx) {
+    quantile_ctx *c = ctx;
+    long lo = (start + c->count - 1) / c->count;
+    long hi = (end + c->count - 1) / c->count;
+    long o, rest, i, j;
+    int coords[NDARRAY_MAX_DIMS];
+    int d, has_nan;
+    char *base, *in;
+    float *buf;
+
+    if (lo >= hi) {
+        return;
+    }
+    buf = malloc(sizeof(float) * c->count);
+    if (buf == NULL) {
+        c->failed = 1;
+        return;
+    }
+    for (o = lo; o < hi; o++) {
+        base = c->in;
+        rest = o;
+        for (d = c->kept_nd - 1; d >= 0; d--) {
+            base += (rest % c->kept_dims[d]) * (long) c->kept_strides[d];
+            rest /= c->kept_dims[d];
+        }
+        // Gather the reduced values
+        has_nan = 0;
+        in = base;
+        for (d = 0; d < c->red_nd; d++) {
+            coords[d] = 0;
+        }
+        for (i = 0; i < c->count; i++) {
+            buf[i] = *(float *) in;
+            has_nan |= isnan(buf[i]);
+            for (d = c->red_nd - 1; d >= 0; d--) {
+                in += c->red_strides[d];
+                if (++coords[d] < c->red_dims[d]) {
+                    break;
+                }
+                in -= (long) c->red_strides[d] * c->red_dims[d];
+                coords[d] = 0;
+            }
+        }
+        if (has_nan) {
+            for (j = 0; j < c->plan->nq; j++) {
+                c->out[j * c->out_size + o] = NAN;
+            }
+            continue;
+        }
+        quantile_values(c->plan, buf, c->out + o, c->out_size);
+    }
+    free(buf);
+}
 
-    // Calculate the lower and upper indices for interpolation
-    int lower_index = (int)index;
-    int upper_index = lower_index + 1;
+/**
+ * Quantiles of a CPU array over one or more axes, with linear
+ * interpolation between the closest values. Each output gathers its
+ * values once and selects the order statistics of every quantile in
+ * place, in linear time, instead of sorting them.
+ *
+ * @param a
+ * @param q Quantiles, between 0 and 1
+ * @param nq
+ * @param q_vector Add a leading axis of size `nq` to the output
+ * @param axes Axes to reduce, NULL for all of them
+ * @param naxes
+ * @param keepdims Keep the reduced axes with size 1
+ * @return
+ */
+NDArray*
+NDArray_Quantiles(NDArray *a, const float *q, int nq, int q_vector, const int *axes, int naxes, int keepdims) {
+    char reduced[NDARRAY_MAX_DIMS];
+    int i, out_ndim = 0;
+    int *out_shape;
+    quantile_plan plan;
+    quantile_ctx ctx;
+    NDArray *rtn;
 
-    // Calculate the weight for interpolation
-    float weight =index - (float)lower_index;
+    if (NDArray_DEVICE(a) != NDARRAY_DEVICE_CPU) {
+        zend_throw_error(NULL, "Quantile not available for GPU device.");
+        return NULL;
+    }
+    for (i = 0; i < nq; i++) {
+        if (!(q[i] >= 0 && q[i] <= 1)) {
+            zend_throw_error(NULL, "Q must be between 0 and 1");
+            return NULL;
+        }
+    }
+    if (axes == NULL) {
+        memset(reduced, 1, NDArray_NDIM(a));
+    } else if (NDArray_ReduceAxes(NDArray_NDIM(a), axes, naxes, reduced) < 0) {
+        return NULL;
+    }
 
-    // Perform linear interpolation between the two adjacent values
-    float lower_value = temp[lower_index];
-    float upper_value = temp[upper_index];
-    float quantile_value = (1 - weight) * lower_value + weight * upper_value;
+    out_shape = emalloc(sizeof(int) * (NDArray_NDIM(a) + 1));
+    if (q_vector) {
+        out_shape[out_ndim++] = nq;
+    }
+    ctx.kept_nd = 0;
+    ctx.red_nd = 0;
+    ctx.count = 1;
+    for (i = 0; i < NDArray_NDIM(a); i++) {
+        if (reduced[i]) {
+            ctx.red_dims[ctx.red_nd] = NDArray_SHAPE(a)[i];
+            ctx.red_strides[ctx.red_nd++] = NDArray_STRIDES(a)[i];
+            ctx.count *= NDArray_SHAPE(a)[i];
+            if (keepdims) {
+                out_shape[out_ndim++] = 1;
+            }
+        } else {
+            ctx.kept_dims[ctx.kept_nd] = NDArray_SHAPE(a)[i];
+            ctx.kept_strides[ctx.kept_nd++] = NDArray_STRIDES(a)[i];
+            out_shape[out_ndim++] = NDArray_SHAPE(a)[i];
+        }
+    }
+    if (out_ndim == 0) {
+        out_shape[0] = 1;
+    }
+    rtn = NDArray_Empty(out_shape, out_ndim, NDARRAY_TYPE_FLOAT32, NDARRAY_DEVICE_CPU);
 
-    // Free the temporary array
-    efree(temp);
+    ctx.in = NDArray_DATA(a);
+    ctx.out = NDArray_FDATA(rtn);
+    ctx.out_size = NDArray_NUMELEMENTS(rtn) / (nq > 0 ? nq : 1);
+    ctx.failed = 0;
+    if (ctx.count == 0) {
+        for (i = 0; i < NDArray_NUMELEMENTS(rtn); i++) {
+            ctx.out[i] = NAN;
+        }
+        return rtn;
+    }
+    quantile_plan_init(&plan, ctx.count, q, nq);
+    ctx.plan = &plan;
+    NDArray_ParallelFor(ctx.out_size * ctx.count, NDARRAY_PARALLEL_GRAIN, quantile_range, &ctx);
+    quantile_plan_free(&plan);
+    if (ctx.failed) {
+        NDArray_FREE(rtn);
+        zend_throw_error(NULL, "failed to allocate memory for quantile");
+        return NULL;
+    }
+    return rtn;
+}
 
-    return quantile_value;
+/**
+ * NDArray::median
+ *
+ * @param a
+ * @param axes Axes to reduce, NULL for all of them
+ * @param naxes
+ * @param keepdims Keep the reduced axes with size 1
+ * @return
+ */
+NDArray*
+NDArray_Median(NDArray *a, const int *axes, int naxes, int keepdims) {
+    const float half = 0.5f;
+    if (NDArray_DEVICE(a) != NDARRAY_DEVICE_CPU) {
+        zend_throw_error(NULL, "Median not available for GPU.");
+        return NULL;
+    }
+    return NDArray_Quantiles(a, &half, 1, 0, axes, naxes, keepdims);
 }
 
 /**
@@ -54,34 +374,31 @@ float calculate_quantile(float* vector, int num_elements, int stride, float quan
  *
  * @todo Implement GPU
  * @param target
- * @param q
+ * @param q A scalar or a vector of quantiles
+ * @param axes Axes to reduce, NULL for all of them
+ * @param naxes
+ * @param keepdims Keep the reduced axes with size 1
  * @return
  */
 NDArray*
-NDArray_Quantile(NDArray *target, NDArray *q) {
+NDArray_Quantile(NDArray *target, NDArray *q, const int *axes, int naxes, int keepdims) {
     if (NDArray_DEVICE(target) == NDARRAY_DEVICE_GPU || NDArray_DEVICE(q) == NDARRAY_DEVICE_GPU) {
         zend_throw_error(NULL, "Quantile not available for GPU device.");
         return NULL;
     }
 
-    if (NDArray_NDIM(q) > 0) {
-        zend_throw_error(NULL, "Q must be a scalar");
+    if (NDArray_NDIM(q) > 1) {
+        zend_throw_error(NULL, "Q must be a scalar or a vector");
         return NULL;
     }
-
-    if (NDArray_FDATA(q)[0] < 0 || NDArray_FDATA(q)[0] > 1) {
-        zend_throw_error(NULL, "Q must be between 0 and 1");
-        return NULL;
-    }
-
-    float result = calculate_quantile(NDArray_FDATA(target), NDArray_NUMELEMENTS(target), sizeof(float), NDArray_FDATA(q)[0]);
-    return NDArray_CreateFromFloatScalar(result);
+    return NDArray_Quantiles(target, NDArray_FDATA(q), (int) NDArray_NUMELEMENTS(q), NDArray_NDIM(q) == 1,
+                             axes, naxes, keepdims);
 }
 
 /**
  * NDArray::std
  *
- * @todo Implement
+ * @param a
  * @return
  */
 NDArray *
@@ -90,16 +407,7 @@ NDArray_Std(NDArray *a) {
         zend_throw_error(NULL, "NDArray::std not available for GPU.");
         return NULL;
     }
-    if (NDArray_DEVICE(a) == NDARRAY_DEVICE_CPU) {
-        float mean = NDArray_Sum_Float(a) / NDArray_NUMELEMENTS(a);
-        float sum = 0.0f;
-
-        for (int i = 0; i < NDArray_NUMELEMENTS(a); i++) {
-            sum += powf(NDArray_FDATA(a)[i] - mean, 2);
-        }
-
-        return NDArray_CreateFromFloatScalar(sqrtf(sum / (float)(NDArray_NUMELEMENTS(a))));
-    }
+    return NDArray_Reduce(a, NDARRAY_REDUCE_STD, NULL, 0, 0);
 }
 
 /**
@@ -110,6 +418,9 @@ NDArray_Std(NDArray *a) {
  */
 NDArray*
 NDArray_Variance(NDArray *a) {
+    if (NDArray_DEVICE(a) == NDARRAY_DEVICE_CPU) {
+        return NDArray_Reduce(a, NDARRAY_REDUCE_VAR, NULL, 0, 0);
+    }
     NDArray *mean = NDArray_CreateFromFloatScalar(NDArray_Sum_Float(a) / NDArray_NUMELEMENTS(a));
     NDArray *subtracted = NDArray_Subtract_Float(a, mean);
     NDArray_FREE(mean);
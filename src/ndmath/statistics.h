@@ -3,7 +3,9 @@
 
 #include "../ndarray.h"
 
-NDArray* NDArray_Quantile(NDArray *target, NDArray *q);
+NDArray* NDArray_Quantiles(NDArray *a, const float *q, int nq, int q_vector, const int *axes, int naxes, int keepdims);
+NDArray* NDArray_Quantile(NDArray *target, NDArray *q, const int *axes, int naxes, int keepdims);
+NDArray* NDArray_Median(NDArray *a, const int *axes, int naxes, int keepdims);
 NDArray* NDArray_Std(NDArray *a);
 NDArray* NDArray_Variance(NDArray *a);
 NDArray* NDArray_Average(NDArray *a, NDArray *weights);
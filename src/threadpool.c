@@ -0,0 +1,375 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include "threadpool.h"
+
+/*
+ * Persistent worker pool shared by the CPU kernels.
+ *
+ * A parallel region splits [0, n) into chunks of equal size and every
+ * thread, the caller included, keeps claiming the next unprocessed
+ * chunk from an atomic counter until none is left. Threads that finish
+ * early therefore take over work from the slow ones. The chunking only
+ * depends on `n`, the grain and the number of threads, so reductions
+ * give the same result whether or not workers took part.
+ *
+ * Workers are started on the first parallel region, not in MINIT, so
+ * that forking SAPIs only start them in the processes running scripts.
+ */
+typedef struct {
+    pthread_mutex_t region_lock;        // One parallel region at a time
+    pthread_mutex_t lock;               // Protects the fields below
+    pthread_cond_t work;
+    pthread_cond_t done;
+    pthread_t *threads;
+    pid_t owner;                        // Process the workers were started in
+    int num_workers;                    // Running workers
+    int num_threads;                    // Requested threads, including the caller
+    long threshold;                     // Smallest range split across threads
+    int shutdown;
+    unsigned long generation;           // Incremented for every region
+    int pending;                        // Workers still inside the current region
+    long n;
+    long chunk_size;
+    long num_chunks;
+    long next_chunk;                    // Accessed atomically
+    NDArray_ParallelFunc func;
+    NDArray_ParallelReduceFunc reduce_func;
+    void *ctx;
+    char *partials;
+    size_t partial_size;
+} NDArrayThreadPool;
+
+static NDArrayThreadPool pool = {
+    .region_lock = PTHREAD_MUTEX_INITIALIZER,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .work = PTHREAD_COND_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER,
+    .num_threads = 1,
+    .threshold = NDARRAY_PARALLEL_THRESHOLD,
+};
+
+// Set on workers and on a caller inside a region, nested regions run serially
+static __thread int in_parallel_region = 0;
+
+static void
+run_chunk(long chunk) {
+    long start = chunk * pool.chunk_size;
+    long end = (start + pool.chunk_size < pool.n) ? start + pool.chunk_size : pool.n;
+    if (pool.reduce_func != NULL) {
+        pool.reduce_func(start, end, pool.ctx, pool.partials + chunk * pool.partial_size);
+    } else {
+        pool.func(start, end, pool.ctx);
+    }
+}
+
+static void
+run_chunks(void) {
+    long chunk;
+    while ((chunk = __atomic_fetch_add(&pool.next_chunk, 1, __ATOMIC_RELAXED)) < pool.num_chunks) {
+        run_chunk(chunk);
+    }
+}
+
+static void *
+worker_main(void *arg) {
+    // Generation at creation time, the worker only runs later regions
+    unsigned long seen = (unsigned long) arg;
+    in_parallel_region = 1;
+    pthread_mutex_lock(&pool.lock);
+    for (;;) {
+        while (!pool.shutdown && pool.generation == seen) {
+            pthread_cond_wait(&pool.work, &pool.lock);
+        }
+        if (pool.shutdown) {
+            break;
+        }
+        seen = pool.generation;
+        pthread_mutex_unlock(&pool.lock);
+        run_chunks();
+        pthread_mutex_lock(&pool.lock);
+        if (--pool.pending == 0) {
+            pthread_cond_signal(&pool.done);
+        }
+    }
+    pthread_mutex_unlock(&pool.lock);
+    return NULL;
+}
+
+/**
+ * Start the workers if needed, called with region_lock held
+ */
+static void
+start_workers(void) {
+    int i, wanted = pool.num_threads - 1;
+    if (pool.threads != NULL || wanted <= 0) {
+        return;
+    }
+    pool.threads = malloc(sizeof(pthread_t) * wanted);
+    if (pool.threads == NULL) {
+        return;
+    }
+    pool.owner = getpid();
+    pthread_mutex_lock(&pool.lock);
+    for (i = 0; i < wanted; i++) {
+        if (pthread_create(&pool.threads[i], NULL, worker_main, (void *) pool.generation) != 0) {
+            break;
+        }
+    }
+    // If a thread could not be created the caller just does more of the work
+    pool.num_workers = i;
+    pthread_mutex_unlock(&pool.lock);
+}
+
+/**
+ * Stop and join the workers, called with region_lock held
+ */
+static void
+stop_workers(void) {
+    int i;
+    if (pool.threads == NULL) {
+        return;
+    }
+    pthread_mutex_lock(&pool.lock);
+    pool.shutdown = 1;
+    pthread_cond_broadcast(&pool.work);
+    pthread_mutex_unlock(&pool.lock);
+    for (i = 0; i < pool.num_workers; i++) {
+        pthread_join(pool.threads[i], NULL);
+    }
+    free(pool.threads);
+    pool.threads = NULL;
+    pool.num_workers = 0;
+    pool.shutdown = 0;
+}
+
+/**
+ * The workers do not exist in a forked child, forget about them. The
+ * locks are reset too, a worker may have held one during the fork.
+ */
+static void
+reset_after_fork(void) {
+    pthread_mutex_init(&pool.region_lock, NULL);
+    pthread_mutex_init(&pool.lock, NULL);
+    pthread_cond_init(&pool.work, NULL);
+    pthread_cond_init(&pool.done, NULL);
+    free(pool.threads);
+    pool.threads = NULL;
+    pool.num_workers = 0;
+    pool.shutdown = 0;
+}
+
+static inline void
+check_fork(void) {
+    if (pool.threads != NULL && pool.owner != getpid()) {
+        reset_after_fork();
+    }
+}
+
+static long
+run_region(long n, long num_chunks, long chunk_size, NDArray_ParallelFunc func, NDArray_ParallelReduceFunc reduce_func,
+           void *ctx, void *partials, size_t partial_size) {
+    long chunk;
+
+    if (num_chunks > 1) {
+        check_fork();
+    }
+    if (num_chunks > 1 && pool.num_threads > 1 && !in_parallel_region &&
+        pthread_mutex_trylock(&pool.region_lock) == 0) {
+        start_workers();
+        pthread_mutex_lock(&pool.lock);
+        pool.n = n;
+        pool.num_chunks = num_chunks;
+        pool.chunk_size = chunk_size;
+        pool.next_chunk = 0;
+        pool.func = func;
+        pool.reduce_func = reduce_func;
+        pool.ctx = ctx;
+        pool.partials = partials;
+        pool.partial_size = partial_size;
+        pool.pending = pool.num_workers;
+        pool.generation++;
+        pthread_cond_broadcast(&pool.work);
+        pthread_mutex_unlock(&pool.lock);
+
+        in_parallel_region = 1;
+        run_chunks();
+        in_parallel_region = 0;
+
+        pthread_mutex_lock(&pool.lock);
+        while (pool.pending > 0) {
+            pthread_cond_wait(&pool.done, &pool.lock);
+        }
+        pthread_mutex_unlock(&pool.lock);
+        pthread_mutex_unlock(&pool.region_lock);
+        return num_chunks;
+    }
+
+    // Serially, with the same chunks so reductions round the same way
+    for (chunk = 0; chunk < num_chunks; chunk++) {
+        long start = chunk * chunk_size;
+        long end = (start + chunk_size < n) ? start + chunk_size : n;
+        if (reduce_func != NULL) {
+            reduce_func(start, end, ctx, (char *) partials + chunk * partial_size);
+        } else {
+            func(start, end, ctx);
+        }
+    }
+    return num_chunks;
+}
+
+/**
+ * Read the default number of threads from NDARRAY_NUM_THREADS, or use
+ * one per online CPU, and the threshold from NDARRAY_PARALLEL_THRESHOLD.
+ * Called from MINIT.
+ */
+void
+NDArray_ThreadPool_Init(void) {
+    const char *env = getenv("NDARRAY_NUM_THREADS");
+    const char *env_threshold = getenv("NDARRAY_PARALLEL_THRESHOLD");
+    long num_threads = 0;
+
+    if (env_threshold != NULL && strtol(env_threshold, NULL, 10) > 0) {
+        pool.threshold = strtol(env_threshold, NULL, 10);
+    }
+    if (env != NULL) {
+        num_threads = strtol(env, NULL, 10);
+    }
+    if (num_threads < 1) {
+        num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    NDArray_SetNumThreads(num_threads < 1 ? 1 : (int) num_threads);
+}
+
+/**
+ * Join the workers. Called from MSHUTDOWN.
+ */
+void
+NDArray_ThreadPool_Shutdown(void) {
+    check_fork();
+    pthread_mutex_lock(&pool.region_lock);
+    stop_workers();
+    pthread_mutex_unlock(&pool.region_lock);
+}
+
+/**
+ * Number of threads used by parallel regions, including the calling
+ * thread. Running workers are stopped and restarted with the new count
+ * on the next region.
+ *
+ * @param num_threads
+ */
+void
+NDArray_SetNumThreads(int num_threads) {
+    if (num_threads < 1) {
+        num_threads = 1;
+    }
+    check_fork();
+    pthread_mutex_lock(&pool.region_lock);
+    if (num_threads != pool.num_threads) {
+        stop_workers();
+        pool.num_threads = num_threads;
+    }
+    pthread_mutex_unlock(&pool.region_lock);
+}
+
+/**
+ * @return
+ */
+int
+NDArray_GetNumThreads(void) {
+    return pool.num_threads;
+}
+
+/**
+ * @return
+ */
+long
+NDArray_GetParallelThreshold(void) {
+    return pool.threshold;
+}
+
+/**
+ * Number of chunks [0, n) is split into by NDArray_ParallelReduce, each
+ * holding at least `grain` elements. 1 when the range is below the
+ * parallel threshold.
+ *
+ * The count does not depend on the number of threads, so reductions
+ * merge the same partial results, and round the same way, whatever
+ * NDARRAY_NUM_THREADS is. With one thread the chunks run serially.
+ *
+ * @param n
+ * @param grain
+ * @return
+ */
+long
+NDArray_ParallelChunks(long n, long grain) {
+    long chunks;
+    if (n < pool.threshold) {
+        return 1;
+    }
+    if (grain < 1) {
+        grain = 1;
+    }
+    chunks = n / grain;
+    if (chunks > NDARRAY_MAX_CHUNKS) {
+        chunks = NDARRAY_MAX_CHUNKS;
+    }
+    return (chunks < 1) ? 1 : chunks;
+}
+
+/**
+ * Run func over [0, n) split across the pool in chunks of about `grain`
+ * elements. Unlike NDArray_ParallelReduce the number of chunks is not
+ * bounded, so streaming kernels can keep each chunk cache-sized.
+ *
+ * @param n
+ * @param grain Elements per chunk
+ * @param func
+ * @param ctx
+ */
+void
+NDArray_ParallelFor(long n, long grain, NDArray_ParallelFunc func, void *ctx) {
+    long num_chunks, chunk_size;
+    if (n <= 0) {
+        return;
+    }
+    if (grain < 1) {
+        grain = 1;
+    }
+    num_chunks = NDArray_ParallelChunks(n, grain);
+    if (num_chunks > 1 && n / grain > num_chunks) {
+        num_chunks = n / grain;
+    }
+    chunk_size = (n + num_chunks - 1) / num_chunks;
+    // Chunks of aligned buffers then start on a cache line of their own
+    if (num_chunks > 1 && grain >= NDARRAY_PARALLEL_ALIGN) {
+        chunk_size = (chunk_size + NDARRAY_PARALLEL_ALIGN - 1) / NDARRAY_PARALLEL_ALIGN * NDARRAY_PARALLEL_ALIGN;
+        num_chunks = (n + chunk_size - 1) / chunk_size;
+    }
+    run_region(n, num_chunks, chunk_size, func, NULL, ctx, NULL, 0);
+}
+
+/**
+ * Run func over [0, n) split across the pool. Chunk `i` writes its
+ * result to `partials + i * partial_size`, `partials` must hold
+ * NDArray_ParallelChunks(n, grain) results and the caller merges them.
+ *
+ * @param n
+ * @param grain Minimum number of elements per chunk
+ * @param func
+ * @param ctx
+ * @param partials
+ * @param partial_size
+ * @return the number of partial results written
+ */
+long
+NDArray_ParallelReduce(long n, long grain, NDArray_ParallelReduceFunc func, void *ctx,
+                       void *partials, size_t partial_size) {
+    if (n <= 0) {
+        return 0;
+    }
+    long num_chunks = NDArray_ParallelChunks(n, grain);
+    return run_region(n, num_chunks, (n + num_chunks - 1) / num_chunks, NULL, func, ctx, partials, partial_size);
+}
@@ -0,0 +1,51 @@
+#ifndef PHPSCI_NDARRAY_THREADPOOL_H
+#define PHPSCI_NDARRAY_THREADPOOL_H
+
+#include <stddef.h>
+
+/**
+ * Work on the index range [start, end). Runs on worker threads, so it
+ * must not call into the Zend engine (no emalloc, no exceptions).
+ */
+typedef void (*NDArray_ParallelFunc)(long start, long end, void *ctx);
+
+/**
+ * Same as NDArray_ParallelFunc, writing the result of its range into
+ * `partial`.
+ */
+typedef void (*NDArray_ParallelReduceFunc)(long start, long end, void *ctx, void *partial);
+
+/**
+ * Default number of elements below which a range runs on the calling
+ * thread, NDARRAY_PARALLEL_THRESHOLD in the environment overrides it
+ */
+#define NDARRAY_PARALLEL_THRESHOLD 65536
+
+/**
+ * Elements per chunk of the streaming kernels (element-wise operations,
+ * copies). 64KB of floats per operand, so a chunk stays in L2.
+ */
+#define NDARRAY_PARALLEL_GRAIN 16384
+
+/**
+ * NDArray_ParallelFor rounds its chunks to this many elements, one
+ * cache line of floats.
+ */
+#define NDARRAY_PARALLEL_ALIGN 16
+
+/**
+ * Upper bound of NDArray_ParallelChunks, so callers can keep the
+ * partial results of NDArray_ParallelReduce on the stack.
+ */
+#define NDARRAY_MAX_CHUNKS 256
+
+void NDArray_ThreadPool_Init(void);
+void NDArray_ThreadPool_Shutdown(void);
+void NDArray_SetNumThreads(int num_threads);
+int NDArray_GetNumThreads(void);
+long NDArray_GetParallelThreshold(void);
+long NDArray_ParallelChunks(long n, long grain);
+void NDArray_ParallelFor(long n, long grain, NDArray_ParallelFunc func, void *ctx);
+long NDArray_ParallelReduce(long n, long grain, NDArray_ParallelReduceFunc func, void *ctx,
+                            void *partials, size_t partial_size);
+#endif //PHPSCI_NDARRAY_THREADPOOL_H
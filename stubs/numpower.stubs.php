@@ -31,6 +31,32 @@ final class NDArray {
      */
     public static function setDevice(int $deviceId): void {}
 
+    /**
+     * Sets the number of threads used by the CPU kernels, including the calling thread.
+     * Defaults to the NDARRAY_NUM_THREADS environment variable or the number of online CPUs.
+     *
+     * @param int $num_threads
+     * @return void
+     */
+    public static function setNumThreads(int $num_threads): void {}
+
+    /**
+     * Returns the number of threads used by the CPU kernels.
+     *
+     * @return int
+     */
+    public static function getNumThreads(): int {}
+
+    /**
+     * Returns allocator statistics for array buffers. Buffers of at least ndarray.mmap_threshold
+     * bytes are mapped outside of the Zend allocator and count against ndarray.mmap_limit
+     * instead of memory_limit. The arrays_* counters cover the NDArray objects of the request,
+     * array_slots is the size of the table tracking them.
+     *
+     * @return array{mmap_threshold: int, mmap_limit: int, mapped: int, peak_mapped: int, mappings: int, total_mappings: int, pool_cached: int, arrays_live: int, arrays_allocated: int, arrays_freed: int, array_slots: int}
+     */
+    public static function memoryStats(): array {}
+
     /**
      * Add arguments element-wise
      *
@@ -38,9 +64,10 @@ final class NDArray {
      *
      * @param NDArray|array|float|int $a The array to be added
      * @param NDArray|array|float|int $b The array to be added
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int The sum of $a and $b
      */
-    public static function add(NDArray|array|float|int $a, NDArray|array|float|int $b): NDArray|float|int {}
+    public static function add(NDArray|array|float|int $a, NDArray|array|float|int $b, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Return the division between two arrays element-wise
@@ -49,9 +76,10 @@ final class NDArray {
      *
      * @param NDArray|array|float|int $a Dividend
      * @param NDArray|array|float|int $b Divisor
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int Array with the division between $a and $b element-wise
      */
-    public static function divide(NDArray|array|float|int $a, NDArray|array|float|int $b): NDArray|float|int {}
+    public static function divide(NDArray|array|float|int $a, NDArray|array|float|int $b, ?NDArray $out = null): NDArray|float|int {}
 
 
     /**
@@ -62,9 +90,10 @@ final class NDArray {
      *
      * @param NDArray|array|float|int $a
      * @param NDArray|array|float|int $b
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int
      */
-    public static function mod(NDArray|array|float|int $a, NDArray|array|float|int $b): NDArray|float|int {}
+    public static function mod(NDArray|array|float|int $a, NDArray|array|float|int $b, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Multiply arrays element-wise
@@ -73,9 +102,10 @@ final class NDArray {
      *
      * @param NDArray|array|float|int $a The arrays to be multiplied.
      * @param NDArray|array|float|int $b The arrays to be multiplied.
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int The multiplication of $a and $b element-wise
      */
-    public static function multiply(NDArray|array|float|int $a, NDArray|array|float|int $b): NDArray|float|int {}
+    public static function multiply(NDArray|array|float|int $a, NDArray|array|float|int $b, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Computes the element-wise negation (unary minus) of an array, returning a new array with the negation of each element.
@@ -83,17 +113,19 @@ final class NDArray {
      * Same as -$a
      *
      * @param NDArray|array|float|int $a Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int The multiplication of $a * -1
      */
-    public static function negative(NDArray|array|float|int $a): NDArray|float|int {}
+    public static function negative(NDArray|array|float|int $a, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Numerical positive, element-wise.
      *
      * @param NDArray|array|float|int $a Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int
      */
-    public static function positive(NDArray|array|float|int $a): NDArray|float|int {}
+    public static function positive(NDArray|array|float|int $a, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Return the reciprocal of the argument, element-wise.
@@ -101,9 +133,10 @@ final class NDArray {
      * Calculates `1 / $a`
      *
      * @param NDArray|array|float|int $a Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int
      */
-    public static function reciprocal(NDArray|array|float|int $a): NDArray|float|int {}
+    public static function reciprocal(NDArray|array|float|int $a, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Raises each element of an array $a to a specified power $b and returns a new array containing the result.
@@ -112,168 +145,200 @@ final class NDArray {
      *
      * @param NDArray|array|float|int $a Input array
      * @param NDArray|array|float|int $b Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int $a ** $b
      */
-    public static function pow(NDArray|array|float|int $a, NDArray|array|float|int $b): NDArray|float|int {};
+    public static function pow(NDArray|array|float|int $a, NDArray|array|float|int $b, ?NDArray $out = null): NDArray|float|int {};
 
     /**
      * Subtract two arrays element-wise
      *
      * @param NDArray|array|float|int $a Input array
      * @param NDArray|array|float|int $b Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int $a - $b
      */
-    public static function subtract(NDArray|array|float|int $a, NDArray|array|float|int $b): NDArray|float|int {}
+    public static function subtract(NDArray|array|float|int $a, NDArray|array|float|int $b, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Computes the element-wise exponential function of an array, returning
      * a new array with each element raised to the power of $array.
      *
      * @param NDArray|array|float|int $array Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int
      */
-    public static function exp(NDArray|array|float|int $array): NDArray|float|int {}
+    public static function exp(NDArray|array|float|int $array, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Computes the element-wise 2 raised to the power of an array,
      * returning a new array with each element raised to the power of 2.
      *
      * @param NDArray|array|float|int $array Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int
      */
-    public static function exp2(NDArray|array|float|int $array): NDArray|float|int {}
+    public static function exp2(NDArray|array|float|int $array, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Calculates the element-wise exponential minus one function, returning
      * a new array with each element raised to the power of `$array` - 1.
      *
      * @param NDArray|array|float|int $array Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int
      */
-    public static function expm1(NDArray|array|float|int $array): NDArray|float|int {}
+    public static function expm1(NDArray|array|float|int $array, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Calculates the element-wise natural logarithm of an array, returning
      * a new array with the natural logarithm of each element.
      *
      * @param NDArray|array|float|int $array Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int
      */
-    public static function log(NDArray|array|float|int $array): NDArray|float|int {}
+    public static function log(NDArray|array|float|int $array, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Computes the element-wise logarithm of one plus an array, returning a new array with
      * the natural logarithm of each element plus one.
      *
      * @param NDArray|array|float|int $array Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int
      */
-    public static function log1p(NDArray|array|float|int $array): NDArray|float|int {}
+    public static function log1p(NDArray|array|float|int $array, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Computes the element-wise base-2 logarithm of an array,
      * returning a new array with the base-2 logarithm of each element
      *
      * @param NDArray|array|float|int $array Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int
      */
-    public static function log2(NDArray|array|float|int $array): NDArray|float|int {}
+    public static function log2(NDArray|array|float|int $array, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Calculates the element-wise base-10 logarithm of an array,
      * returning a new array with the base-10 logarithm of each element.
      *
      * @param NDArray|array|float|int $array Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int
      */
-    public static function log10(NDArray|array|float|int $array): NDArray|float|int {}
+    public static function log10(NDArray|array|float|int $array, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Computes the element-wise logarithm base b of an array, returning
      * a new array with the logarithm base b of each element.
      *
      * @param NDArray|array|float|int $array Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int
      */
-    public static function logb(NDArray|array|float|int $array): NDArray|float|int {}
+    public static function logb(NDArray|array|float|int $array, ?NDArray $out = null): NDArray|float|int {}
 
     /**
-     * Finds the maximum value in the array.
+     * Finds the maximum value in the array, or along the given axes.
      *
      * @param NDArray|array|float|int $a Input array
-     * @return float|int
+     * @param int|int[]|null $axis Axis or axes to reduce. By default the whole array is reduced.
+     * @param bool $keepdims If true, the reduced axes are kept with size one.
+     * @param NDArray|array|null $where Optional mask broadcastable to `$a`, only the elements where it is not zero are reduced.
+     * @return NDArray|float|int
      */
-    public static function max(NDArray|array|float|int $a): float|int {}
+    public static function max(NDArray|array|float|int $a, int|array|null $axis = NULL, bool $keepdims = false, NDArray|array|null $where = NULL): NDArray|float|int {}
 
     /**
-     * Finds the minimum value in the array.
+     * Finds the minimum value in the array, or along the given axes.
      *
      * @param NDArray|array|float|int $a Input array
-     * @return float|int
+     * @param int|int[]|null $axis Axis or axes to reduce. By default the whole array is reduced.
+     * @param bool $keepdims If true, the reduced axes are kept with size one.
+     * @param NDArray|array|null $where Optional mask broadcastable to `$a`, only the elements where it is not zero are reduced.
+     * @return NDArray|float|int
      */
-    public static function min(NDArray|array|float|int $a): float|int {}
+    public static function min(NDArray|array|float|int $a, int|array|null $axis = NULL, bool $keepdims = false, NDArray|array|null $where = NULL): NDArray|float|int {}
 
     /**
      * Calculates the element-wise inverse hyperbolic cosine (arccosineh) of an array,
      * returning a new array with the inverse hyperbolic cosine of each element.
      *
      * @param NDArray|array|float|int $array Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int
      */
-    public static function arccosh(NDArray|array|float|int $array): NDArray|float|int {}
+    public static function arccosh(NDArray|array|float|int $array, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Computes the element-wise inverse hyperbolic sine (arcsineh) of an array, returning a new
      * array with the inverse hyperbolic sine of each element.
      *
      * @param NDArray|array|float|int $array Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int
      */
-    public static function arcsinh(NDArray|array|float|int $array): NDArray|float|int {}
+    public static function arcsinh(NDArray|array|float|int $array, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Computes the element-wise inverse hyperbolic tangent (arctangenth) of an array,
      * returning a new array with the inverse hyperbolic tangent of each element.
      *
      * @param NDArray|array|float|int $array Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int
      */
-    public static function arctanh(NDArray|array|float|int $array): NDArray|float|int {}
+    public static function arctanh(NDArray|array|float|int $array, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Computes the element-wise hyperbolic cosine of an array,
      * returning a new array with the hyperbolic cosine of each element.
      *
      * @param NDArray|array|float|int $array Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int
      */
-    public static function cosh(NDArray|array|float|int $array): NDArray|float|int {}
+    public static function cosh(NDArray|array|float|int $array, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Calculates the element-wise inverse hyperbolic cosine (arccosineh) of an array,
      * returning a new array with the inverse hyperbolic cosine of each element.
      *
      * @param NDArray|array|float|int $array Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int
      */
-    public static function sinh(NDArray|array|float|int $array): NDArray|float|int {}
+    public static function sinh(NDArray|array|float|int $array, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Calculates the element-wise hyperbolic tangent of an array,
      * returning a new array with the hyperbolic tangent of each element.
      *
      * @param NDArray|array|float|int $array Input array
+     * @param NDArray|null $out Optional array to write the result into
+     * @return NDArray|float|int
+     */
+    public static function tanh(NDArray|array|float|int $array, ?NDArray $out = null): NDArray|float|int {}
+
+    /**
+     * Calculates the element-wise logistic sigmoid 1 / (1 + e^-x) of an array.
+     *
+     * @param NDArray|array|float|int $array Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int
      */
-    public static function tanh(NDArray|array|float|int $array): NDArray|float|int {}
+    public static function sigmoid(NDArray|array|float|int $array, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Computes the element-wise absolute value of an array, returning a new array with non-negative elements.
      *
      * @param NDArray|array|float|int $array Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int
      */
-    public static function abs(NDArray|array|float|int $array): NDArray|float|int {}
+    public static function abs(NDArray|array|float|int $array, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Clips the values of an array between a minimum and maximum value, returning
@@ -282,97 +347,108 @@ final class NDArray {
      * @param NDArray|array|float|int $array Input array
      * @param float $min Minimum value
      * @param float $max Maximum value
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int clipped $array
      */
-    public static function clip(NDArray|array|float|int $array, float $min, float $max): NDArray|float|int {}
+    public static function clip(NDArray|array|float|int $array, float $min, float $max, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Computes the element-wise sign of an array, returning a new array
      * with the sign of each element (1 for positive, -1 for negative, 0 for zero).
      *
      * @param NDArray|array|float|int $array Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int
      */
-    public static function sign(NDArray|array|float|int $array): NDArray|float|int {}
+    public static function sign(NDArray|array|float|int $array, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Calculates the element-wise sinc function of an array,
      * returning a new array with the sinc function evaluated for each element.
      *
      * @param NDArray|array|float|int $array Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int
      */
-    public static function sinc(NDArray|array|float|int $array): NDArray|float|int {}
+    public static function sinc(NDArray|array|float|int $array, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Calculates the element-wise square root of an array, returning a new array
      * with the positive square root of each element.
      *
      * @param NDArray|array|float|int $array Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int
      */
-    public static function sqrt(NDArray|array|float|int $array): NDArray|float|int {}
+    public static function sqrt(NDArray|array|float|int $array, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Computes the element-wise square of an array, returning a new array with each element squared.
      *
      * @param NDArray|array|float|int $array Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int
      */
-    public static function square(NDArray|array|float|int $array): NDArray|float|int {}
+    public static function square(NDArray|array|float|int $array, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Rounds the elements of an array to the nearest integer greater than or equal to the element,
      * returning a new array with the elements rounded upwards.
      *
      * @param NDArray|array|float|int $array Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int
      */
-    public static function ceil(NDArray|array|float|int $array): NDArray|float|int {}
+    public static function ceil(NDArray|array|float|int $array, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Rounds the elements of an array towards zero, returning a new array with the elements rounded towards zero.
      *
      * @param NDArray|array|float|int $array Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int
      */
-    public static function fix(NDArray|array|float|int $array): NDArray|float|int {}
+    public static function fix(NDArray|array|float|int $array, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Rounds the elements of an array to the nearest integer less than or equal to the element,
      * returning a new array with the elements rounded downwards.
      *
      * @param NDArray|array|float|int $array Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int
      */
-    public static function floor(NDArray|array|float|int $array): NDArray|float|int {}
+    public static function floor(NDArray|array|float|int $array, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Rounds the elements of an array to the nearest integer,
      * returning a new array with the elements rounded to the nearest integer.
      *
      * @param NDArray|array|float|int $array Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int
      */
-    public static function rint(NDArray|array|float|int $array): NDArray|float|int {}
+    public static function rint(NDArray|array|float|int $array, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Rounds the elements of an array to the nearest integer,
      * returning a new array with the elements rounded to the nearest integer.
      *
      * @param NDArray|array|float|int $array Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int
      */
-    public static function round(NDArray|array|float|int $array): NDArray|float|int {}
+    public static function round(NDArray|array|float|int $array, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Truncates the elements of an array towards zero, returning a
      * new array with the elements truncated towards zero.
      *
      * @param NDArray|array|float|int $array Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int
      */
-    public static function trunc(NDArray|array|float|int $array): NDArray|float|int {}
+    public static function trunc(NDArray|array|float|int $array, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Calculates the product of all elements in the array over a given axis
@@ -380,10 +456,12 @@ final class NDArray {
      * will calculate the product of all the elements in the input array.
      *
      * @param NDArray|array|float|int $a Input array
-     * @param int|null $axis The axis to perform the product. If `$axis` is NULL, will calculate the product of all the elements of `$a`.
+     * @param int|int[]|null $axis The axis or axes to perform the product. If `$axis` is NULL, will calculate the product of all the elements of `$a`.
+     * @param bool $keepdims If true, the reduced axes are kept with size one.
+     * @param NDArray|array|null $where Optional mask broadcastable to `$a`, only the elements where it is not zero are reduced.
      * @return NDArray|float|int The product of `$a`. If `$axis` is not NULL, the specified axis is removed.
      */
-    public static function prod(NDArray|array|float|int $a, ?int $axis = NULL): NDArray|float|int {}
+    public static function prod(NDArray|array|float|int $a, int|array|null $axis = NULL, bool $keepdims = false, NDArray|array|null $where = NULL): NDArray|float|int {}
 
     /**
      * Calculates the sum of all elements in the array over a given axis
@@ -391,77 +469,305 @@ final class NDArray {
      * will calculate the product of all the elements in the input array.
      *
      * @param NDArray|array|float|int $a Input array
-     * @param int|null $axis Specifies the axis along which the sum is performed. By default, ($axis=NULL),
+     * @param int|int[]|null $axis Specifies the axis or axes along which the sum is performed. By default, ($axis=NULL),
      * the function sums all elements of the input array.
+     * @param bool $keepdims If true, the reduced axes are kept with size one.
+     * @param NDArray|array|null $where Optional mask broadcastable to `$a`, only the elements where it is not zero are reduced.
      * @return NDArray|float|int The function returns the summed array along the
      * specified axis, resulting in an array with the same shape as the input array,
      * but with the specified axis removed. If the input array is 0-dimensional
      * or if axis=NULL, a scalar value is returned.
      */
-    public static function sum(NDArray|array|float|int $a, ?int $axis = NULL): NDArray|float|int {}
+    public static function sum(NDArray|array|float|int $a, int|array|null $axis = NULL, bool $keepdims = false, NDArray|array|null $where = NULL): NDArray|float|int {}
+
+    /**
+     * Sum of the array elements over the given axes, treating NaN as missing. Axes made only of NaN sum to 0.
+     *
+     * @param NDArray|array|float|int $a Input array
+     * @param int|int[]|null $axis Axis or axes to reduce. By default the whole array is reduced.
+     * @param bool $keepdims If true, the reduced axes are kept with size one.
+     * @param NDArray|array|null $where Optional mask broadcastable to `$a`, only the elements where it is not zero are reduced.
+     * @return NDArray|float|int
+     */
+    public static function nansum(NDArray|array|float|int $a, int|array|null $axis = NULL, bool $keepdims = false, NDArray|array|null $where = NULL): NDArray|float|int {}
+
+    /**
+     * Mean of the array elements over the given axes, ignoring NaN. The mean of no element is NaN.
+     *
+     * @param NDArray|array|float|int $a Input array
+     * @param int|int[]|null $axis Axis or axes to reduce. By default the whole array is reduced.
+     * @param bool $keepdims If true, the reduced axes are kept with size one.
+     * @param NDArray|array|null $where Optional mask broadcastable to `$a`, only the elements where it is not zero are reduced.
+     * @return NDArray|float|int
+     */
+    public static function nanmean(NDArray|array|float|int $a, int|array|null $axis = NULL, bool $keepdims = false, NDArray|array|null $where = NULL): NDArray|float|int {}
+
+    /**
+     * Minimum of the array elements over the given axes, ignoring NaN. Axes made only of NaN give NaN.
+     *
+     * @param NDArray|array|float|int $a Input array
+     * @param int|int[]|null $axis Axis or axes to reduce. By default the whole array is reduced.
+     * @param bool $keepdims If true, the reduced axes are kept with size one.
+     * @param NDArray|array|null $where Optional mask broadcastable to `$a`, only the elements where it is not zero are reduced.
+     * @return NDArray|float|int
+     */
+    public static function nanmin(NDArray|array|float|int $a, int|array|null $axis = NULL, bool $keepdims = false, NDArray|array|null $where = NULL): NDArray|float|int {}
+
+    /**
+     * Maximum of the array elements over the given axes, ignoring NaN. Axes made only of NaN give NaN.
+     *
+     * @param NDArray|array|float|int $a Input array
+     * @param int|int[]|null $axis Axis or axes to reduce. By default the whole array is reduced.
+     * @param bool $keepdims If true, the reduced axes are kept with size one.
+     * @param NDArray|array|null $where Optional mask broadcastable to `$a`, only the elements where it is not zero are reduced.
+     * @return NDArray|float|int
+     */
+    public static function nanmax(NDArray|array|float|int $a, int|array|null $axis = NULL, bool $keepdims = false, NDArray|array|null $where = NULL): NDArray|float|int {}
+
+    /**
+     * Variance of the array elements over the given axes, ignoring NaN. N is the number of non-NaN elements.
+     *
+     * @param NDArray|array|float|int $a Input array
+     * @param int|int[]|null $axis Axis or axes to reduce. By default the whole array is reduced.
+     * @param int $ddof Delta degrees of freedom, the divisor is N - ddof.
+     * @param bool $keepdims If true, the reduced axes are kept with size one.
+     * @param NDArray|array|null $where Optional mask broadcastable to `$a`, only the elements where it is not zero are reduced.
+     * @return NDArray|float|int
+     */
+    public static function nanvar(NDArray|array|float|int $a, int|array|null $axis = NULL, int $ddof = 0, bool $keepdims = false, NDArray|array|null $where = NULL): NDArray|float|int {}
+
+    /**
+     * Standard deviation of the array elements over the given axes, ignoring NaN. N is the number of non-NaN elements.
+     *
+     * @param NDArray|array|float|int $a Input array
+     * @param int|int[]|null $axis Axis or axes to reduce. By default the whole array is reduced.
+     * @param int $ddof Delta degrees of freedom, the divisor is N - ddof.
+     * @param bool $keepdims If true, the reduced axes are kept with size one.
+     * @param NDArray|array|null $where Optional mask broadcastable to `$a`, only the elements where it is not zero are reduced.
+     * @return NDArray|float|int
+     */
+    public static function nanstd(NDArray|array|float|int $a, int|array|null $axis = NULL, int $ddof = 0, bool $keepdims = false, NDArray|array|null $where = NULL): NDArray|float|int {}
+
+    /**
+     * Sum of the rows of `$values` grouped by segment id: row `i` is folded into output row `$ids[i]`. Empty segments are 0.
+     *
+     * @param NDArray|array $values Array of at least one dimension, reduced along its first axis.
+     * @param NDArray|array $ids Integral segment ids in [0, `$num_segments`), one per row of `$values`.
+     * @param int $num_segments Number of output rows.
+     * @return NDArray An array of shape [`$num_segments`, ...shape of a row of `$values`].
+     */
+    public static function segmentSum(NDArray|array $values, NDArray|array $ids, int $num_segments): NDArray {}
+
+    /**
+     * Mean of the rows of `$values` grouped by segment id: row `i` is folded into output row `$ids[i]`. Empty segments are NaN.
+     *
+     * @param NDArray|array $values Array of at least one dimension, reduced along its first axis.
+     * @param NDArray|array $ids Integral segment ids in [0, `$num_segments`), one per row of `$values`.
+     * @param int $num_segments Number of output rows.
+     * @return NDArray An array of shape [`$num_segments`, ...shape of a row of `$values`].
+     */
+    public static function segmentMean(NDArray|array $values, NDArray|array $ids, int $num_segments): NDArray {}
+
+    /**
+     * Minimum of the rows of `$values` grouped by segment id: row `i` is folded into output row `$ids[i]`. Empty segments are INF, NaN values propagate.
+     *
+     * @param NDArray|array $values Array of at least one dimension, reduced along its first axis.
+     * @param NDArray|array $ids Integral segment ids in [0, `$num_segments`), one per row of `$values`.
+     * @param int $num_segments Number of output rows.
+     * @return NDArray An array of shape [`$num_segments`, ...shape of a row of `$values`].
+     */
+    public static function segmentMin(NDArray|array $values, NDArray|array $ids, int $num_segments): NDArray {}
+
+    /**
+     * Maximum of the rows of `$values` grouped by segment id: row `i` is folded into output row `$ids[i]`. Empty segments are -INF, NaN values propagate.
+     *
+     * @param NDArray|array $values Array of at least one dimension, reduced along its first axis.
+     * @param NDArray|array $ids Integral segment ids in [0, `$num_segments`), one per row of `$values`.
+     * @param int $num_segments Number of output rows.
+     * @return NDArray An array of shape [`$num_segments`, ...shape of a row of `$values`].
+     */
+    public static function segmentMax(NDArray|array $values, NDArray|array $ids, int $num_segments): NDArray {}
+
+    /**
+     * Cumulative sum of the elements along a given axis.
+     *
+     * @param NDArray|array|float|int $a Input array
+     * @param int|null $axis Axis along which the sum is accumulated. If `$axis` is NULL, the flattened array is used.
+     * @param NDArray|null $out Optional contiguous array of the result shape to write into, may be `$a` itself.
+     * @return NDArray An array of the shape of `$a`, or 1-D of the size of `$a` when `$axis` is NULL.
+     */
+    public static function cumsum(NDArray|array|float|int $a, ?int $axis = NULL, ?NDArray $out = null): NDArray {}
+
+    /**
+     * Cumulative product of the elements along a given axis.
+     *
+     * @param NDArray|array|float|int $a Input array
+     * @param int|null $axis Axis along which the product is accumulated. If `$axis` is NULL, the flattened array is used.
+     * @param NDArray|null $out Optional contiguous array of the result shape to write into, may be `$a` itself.
+     * @return NDArray An array of the shape of `$a`, or 1-D of the size of `$a` when `$axis` is NULL.
+     */
+    public static function cumprod(NDArray|array|float|int $a, ?int $axis = NULL, ?NDArray $out = null): NDArray {}
+
+    /**
+     * Cumulative maximum of the elements along a given axis. NaN values propagate.
+     *
+     * @param NDArray|array|float|int $a Input array
+     * @param int|null $axis Axis along which the maximum is accumulated. If `$axis` is NULL, the flattened array is used.
+     * @param NDArray|null $out Optional contiguous array of the result shape to write into, may be `$a` itself.
+     * @return NDArray An array of the shape of `$a`, or 1-D of the size of `$a` when `$axis` is NULL.
+     */
+    public static function cummax(NDArray|array|float|int $a, ?int $axis = NULL, ?NDArray $out = null): NDArray {}
+
+    /**
+     * Return a sorted copy of an array. The sort is stable and NaN values are placed last.
+     *
+     * @param NDArray|array|float|int $a Input array
+     * @param int|null $axis Axis along which to sort, the last one by default. If `$axis` is NULL, the flattened array is sorted.
+     * @return NDArray
+     */
+    public static function sort(NDArray|array|float|int $a, ?int $axis = -1): NDArray {}
+
+    /**
+     * Return the indices that would sort an array along an axis. Equal elements keep their order.
+     *
+     * @param NDArray|array|float|int $a Input array
+     * @param int|null $axis Axis along which to sort, the last one by default. If `$axis` is NULL, the flattened array is used.
+     * @return NDArray Indices along the axis, exact for axes of up to 2^24 elements.
+     */
+    public static function argsort(NDArray|array|float|int $a, ?int $axis = -1): NDArray {}
+
+    /**
+     * Return a partitioned copy of an array: the element at each `$kth` position is the one a sort would
+     * place there, smaller elements are moved before it and greater ones after it, in no particular order.
+     *
+     * @param NDArray|array|float|int $a Input array
+     * @param int|int[] $kth Position or positions to partition by, negative values count from the end.
+     * @param int|null $axis Axis along which to partition, the last one by default. If `$axis` is NULL, the flattened array is used.
+     * @return NDArray
+     */
+    public static function partition(NDArray|array|float|int $a, int|array $kth, ?int $axis = -1): NDArray {}
+
+    /**
+     * Return the `$k` largest (or smallest) elements along an axis, in order, and their indices.
+     * Ties keep the first occurrence and NaN ranks above every other value.
+     *
+     * @param NDArray|array|float|int $a Input array
+     * @param int $k Number of elements to return
+     * @param int|null $axis Axis to search, the last one by default. If `$axis` is NULL, the flattened array is used.
+     * @param bool $largest Return the largest elements if true, the smallest ones otherwise.
+     * @return NDArray[] The values and their indices along the axis, the axis resized to `$k`.
+     */
+    public static function topk(NDArray|array|float|int $a, int $k, ?int $axis = -1, bool $largest = true): array {}
+
+    /**
+     * Compute the histogram of the elements of an array.
+     *
+     * @param NDArray|array|float|int $a Input array, flattened
+     * @param int|NDArray|array $bins Number of equal width bins, or the ascending bin edges.
+     * @param array|null $range Lower and upper edge of equal width bins, the minimum and maximum of `$a` by default.
+     * Values outside of the edges are ignored, the last bin includes its right edge.
+     * @return NDArray[] The counts and the bin edges.
+     */
+    public static function histogram(NDArray|array|float|int $a, int|NDArray|array $bins = 10, ?array $range = null): array {}
+
+    /**
+     * Count the number of occurrences of each non-negative integer value.
+     *
+     * @param NDArray|array|float|int $x Non-negative integral values
+     * @param NDArray|array|null $weights Optional weights of the shape of `$x`, summed instead of counting.
+     * @param int $minlength Minimum number of bins.
+     * @return NDArray 1-D array of max(max($x) + 1, $minlength) elements.
+     */
+    public static function bincount(NDArray|array|float|int $x, NDArray|array|null $weights = null, int $minlength = 0): NDArray {}
+
+    /**
+     * Return the indices of the bins each value belongs to.
+     *
+     * @param NDArray|array|float|int $x Input array
+     * @param NDArray|array $bins Monotonically increasing or decreasing bin edges
+     * @param bool $right Whether the intervals include their right edge instead of their left one.
+     * @return NDArray|float|int An array of the shape of `$x`.
+     */
+    public static function digitize(NDArray|array|float|int $x, NDArray|array $bins, bool $right = false): NDArray|float|int {}
+
+    /**
+     * Return the sorted unique elements of an array. NaN values are merged into one.
+     *
+     * @param NDArray|array|float|int $a Input array, flattened
+     * @param bool $return_counts Also return the number of times each unique value occurs.
+     * @return NDArray|NDArray[] The unique values, or the unique values and their counts.
+     */
+    public static function unique(NDArray|array|float|int $a, bool $return_counts = false): NDArray|array {}
 
     /**
      * Calculates the element-wise inverse cosine (arccosine) of an array,
      * returning a new array with the arccosine of each element.
      *
      * @param NDArray|array|float|int $array Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int
      */
-    public static function arccos(NDArray|array|float|int $array): NDArray|float|int {}
+    public static function arccos(NDArray|array|float|int $array, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Computes the element-wise inverse sine (arcsine) of an array,
      * returning a new array with the arcsine of each element.
      *
      * @param NDArray|array|float|int $array Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int
      */
-    public static function arcsin(NDArray|array|float|int $array): NDArray|float|int {}
+    public static function arcsin(NDArray|array|float|int $array, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Computes the element-wise inverse tangent (arctangent) of an array,
      * returning a new array with the arctangent of each element.
      *
      * @param NDArray|array|float|int $array Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int
      */
-    public static function arctan(NDArray|array|float|int $array): NDArray|float|int {}
+    public static function arctan(NDArray|array|float|int $array, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Computes the element-wise cosine of an array, returning
      * a new array with the cosine of each element.
      *
      * @param NDArray|array|float|int $array Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int
      */
-    public static function cos(NDArray|array|float|int $array): NDArray|float|int {}
+    public static function cos(NDArray|array|float|int $array, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Converts the element-wise angle from radians to degrees,
      * returning a new array with the angles converted to degrees.
      *
      * @param NDArray|array|float|int $array Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int
      */
-    public static function degrees(NDArray|array|float|int $array): NDArray|float|int {}
+    public static function degrees(NDArray|array|float|int $array, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Converts the element-wise angle from degrees to radians,
      * returning a new array with the angles converted to radians.
      *
      * @param NDArray|array|float|int $array Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int
      */
-    public static function radians(NDArray|array|float|int $array): NDArray|float|int {}
+    public static function radians(NDArray|array|float|int $array, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Calculates the element-wise sine of an array,
      * returning a new array with the sine of each element.
      *
      * @param NDArray|array|float|int $array Input array
+     * @param NDArray|null $out Optional array to write the result into
      * @return NDArray|float|int
      */
-    public static function sin(NDArray|array|float|int $array): NDArray|float|int {}
+    public static function sin(NDArray|array|float|int $array, ?NDArray $out = null): NDArray|float|int {}
 
     /**
      * Generates an array of random numbers from a normal distribution. The normal distribution, also
@@ -550,29 +856,38 @@ final class NDArray {
      * Same as calling `nd::sum($a) / $a->size()`
      *
      * @param NDArray|array|float|int $a
-     * @return float|int
+     * @param int|int[]|null $axis Axis or axes along which the means are computed. By default the whole array is used.
+     * @param bool $keepdims If true, the reduced axes are kept with size one.
+     * @param NDArray|array|null $where Optional mask broadcastable to `$a`, only the elements where it is not zero are reduced.
+     * @return NDArray|float|int
      */
-    public static function mean(NDArray|array|float|int $a): float|int {}
+    public static function mean(NDArray|array|float|int $a, int|array|null $axis = NULL, bool $keepdims = false, NDArray|array|null $where = NULL): NDArray|float|int {}
 
     /**
-     * The median of the elements in the array. It sorts the array, and if the number of elements is odd,
+     * The median of the elements in the array. If the number of elements is odd,
      * it returns the middle value; if the number of elements is even, it returns the average of the two middle values
      *
      * @param NDArray|array|float|int $a
-     * @return float|int
+     * @param int|int[]|null $axis Axis or axes along which the medians are computed. By default the whole array is used.
+     * @param bool $keepdims If true, the reduced axes are kept with size one.
+     * @return NDArray|float|int
      */
-    public static function median(NDArray|array|float|int $a): float|int {}
+    public static function median(NDArray|array|float|int $a, int|array|null $axis = NULL, bool $keepdims = false): NDArray|float|int {}
 
     /**
      * Computes the specified quantile of the elements in the array. A quantile represents a
      * particular value below which a given percentage of data falls. For example,
-     * the median is the 50th quantile.
+     * the median is the 50th quantile. Values between two elements are linearly interpolated.
+     *
+     * With a vector of quantiles, the first axis of the result indexes the quantiles.
      *
      * @param NDArray|array|float|int $a
-     * @param float|int $q
-     * @return float|int
+     * @param NDArray|array|float|int $q Quantile or quantiles, between 0 and 1
+     * @param int|int[]|null $axis Axis or axes along which the quantiles are computed. By default the whole array is used.
+     * @param bool $keepdims If true, the reduced axes are kept with size one.
+     * @return NDArray|float|int
      */
-    public static function quantile(NDArray|array|float|int $a, float|int $q): float|int {}
+    public static function quantile(NDArray|array|float|int $a, NDArray|array|float|int $q, int|array|null $axis = NULL, bool $keepdims = false): NDArray|float|int {}
 
     /**
      * Calculates the standard deviation of the elements in the array. It is the
@@ -580,18 +895,26 @@ final class NDArray {
      * or dispersion in the data.
      *
      * @param NDArray|array|float|int $a
-     * @return float|int
+     * @param int|int[]|null $axis Axis or axes along which the standard deviation is computed. By default the whole array is used.
+     * @param int $ddof Delta degrees of freedom, the divisor is N - ddof.
+     * @param bool $keepdims If true, the reduced axes are kept with size one.
+     * @param NDArray|array|null $where Optional mask broadcastable to `$a`, only the elements where it is not zero are reduced.
+     * @return NDArray|float|int
      */
-    public static function std(NDArray|array|float|int $a): float|int {}
+    public static function std(NDArray|array|float|int $a, int|array|null $axis = NULL, int $ddof = 0, bool $keepdims = false, NDArray|array|null $where = NULL): NDArray|float|int {}
 
     /**
      * Calculates the variance of the elements in the array. It measures the average of the
      * squared differences between each element and the mean.
      *
      * @param NDArray|array|float|int $array
-     * @return float|int
+     * @param int|int[]|null $axis Axis or axes along which the variance is computed. By default the whole array is used.
+     * @param int $ddof Delta degrees of freedom, the divisor is N - ddof.
+     * @param bool $keepdims If true, the reduced axes are kept with size one.
+     * @param NDArray|array|null $where Optional mask broadcastable to `$array`, only the elements where it is not zero are reduced.
+     * @return NDArray|float|int
      */
-    public static function variance(NDArray|array|float|int $array): float|int {}
+    public static function variance(NDArray|array|float|int $array, int|array|null $axis = NULL, int $ddof = 0, bool $keepdims = false, NDArray|array|null $where = NULL): NDArray|float|int {}
 
     /**
      * Convert inputs to arrays with at least one dimension.
@@ -1121,24 +1444,88 @@ final class NDArray {
     public function fill(float|int $fill_value): NDArray {}
 
     /**
-     * Returns the indices of the minimum values along an axis.
+     * Add $b element-wise, writing the result into this array.
+     *
+     * @param NDArray|array|float|int $b Operand, must broadcast to the shape of this array
+     * @return NDArray This array
+     */
+    public function addInPlace(NDArray|array|float|int $b): NDArray {}
+
+    /**
+     * Subtract $b element-wise, writing the result into this array.
+     *
+     * @param NDArray|array|float|int $b Operand, must broadcast to the shape of this array
+     * @return NDArray This array
+     */
+    public function subtractInPlace(NDArray|array|float|int $b): NDArray {}
+
+    /**
+     * Multiply by $b element-wise, writing the result into this array.
+     *
+     * @param NDArray|array|float|int $b Operand, must broadcast to the shape of this array
+     * @return NDArray This array
+     */
+    public function multiplyInPlace(NDArray|array|float|int $b): NDArray {}
+
+    /**
+     * Divide by $b element-wise, writing the result into this array.
+     *
+     * @param NDArray|array|float|int $b Operand, must broadcast to the shape of this array
+     * @return NDArray This array
+     */
+    public function divideInPlace(NDArray|array|float|int $b): NDArray {}
+
+    /**
+     * Take the remainder of division by $b element-wise, writing the result into this array.
+     *
+     * @param NDArray|array|float|int $b Operand, must broadcast to the shape of this array
+     * @return NDArray This array
+     */
+    public function modInPlace(NDArray|array|float|int $b): NDArray {}
+
+    /**
+     * Raise to the power of $b element-wise, writing the result into this array.
+     *
+     * @param NDArray|array|float|int $b Operand, must broadcast to the shape of this array
+     * @return NDArray This array
+     */
+    public function powInPlace(NDArray|array|float|int $b): NDArray {}
+
+    /**
+     * Start a deferred expression. Operators and element-wise math functions applied
+     * to the result are recorded instead of executed, and LazyNDArray::eval() computes
+     * the whole expression in a single pass without intermediate arrays.
+     *
+     * Ex: NDArray::sqrt(NDArray::lazy($x) * $x + $y * $y)->eval()
+     *
+     * @param NDArray|array|float|int $a
+     * @return LazyNDArray
+     */
+    public static function lazy(NDArray|array|float|int $a): LazyNDArray {}
+
+    /**
+     * Returns the indices of the minimum values along an axis. The first occurrence
+     * is returned on ties, and the first NaN if there is one.
      *
      * @param NDArray|array $a Target array
      * @param int|null $axis If NULL, the index is into the flattened array, otherwise along the specified axis.
      * @param bool $keepdims
-     * @return NDArray Array of indices into the array. It has the same shape as $a with the dimension along $axis removed.
+     * @return NDArray|int Array of indices into the array. It has the same shape as $a with the dimension along $axis removed.
+     *                     The index into the flattened array is returned as an integer.
      */
-    public static function argmin(NDArray|array $a, ?int $axis, bool $keepdims = false): NDArray {}
+    public static function argmin(NDArray|array $a, ?int $axis = NULL, bool $keepdims = false): NDArray|int {}
 
     /**
-     * Returns the indices of the maximum values along an axis.
+     * Returns the indices of the maximum values along an axis. The first occurrence
+     * is returned on ties, and the first NaN if there is one.
      *
      * @param NDArray|array $a Target array
      * @param int|null $axis If NULL, the index is into the flattened array, otherwise along the specified axis.
      * @param bool $keepdims
-     * @return NDArray Array of indices into the array. It has the same shape as $a with the dimension along axis removed.
+     * @return NDArray|int Array of indices into the array. It has the same shape as $a with the dimension along axis removed.
+     *                     The index into the flattened array is returned as an integer.
      */
-    public static function argmax(NDArray|array $a, ?int $axis, bool $keepdims = false): NDArray {}
+    public static function argmax(NDArray|array $a, ?int $axis = NULL, bool $keepdims = false): NDArray|int {}
 
     /**
      * Array slicing, each argument represents a slice of a dimension.
@@ -1163,4 +1550,15 @@ final class NDArray {
      * @return NDArray|float
      */
     public function slice(...$indices): NDArray|float {};
-}
\ No newline at end of file
+}
+
+final class LazyNDArray {
+
+    /**
+     * Evaluate the recorded expression. The result is computed once and
+     * later calls return the same NDArray.
+     *
+     * @return NDArray|float
+     */
+    public function eval(): NDArray|float {}
+}
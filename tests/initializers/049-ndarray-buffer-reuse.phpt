@@ -0,0 +1,25 @@
+--TEST--
+NDArray buffer slots are reused when several arrays die between allocations
+--FILE--
+<?php
+$keep = \NDArray::ones([2]);
+$batch = [];
+for ($i = 0; $i < 1000; $i++) {
+    $batch = [\NDArray::ones([2]), \NDArray::zeros([2]), \NDArray::ones([2])];
+    $batch = [];
+}
+$before = memory_get_usage();
+for ($i = 0; $i < 100000; $i++) {
+    $batch = [\NDArray::ones([2]), \NDArray::zeros([2]), \NDArray::ones([2])];
+    $batch = [];
+}
+var_dump(memory_get_usage() - $before < 4096);
+print_r($keep->toArray());
+?>
+--EXPECT--
+bool(true)
+Array
+(
+    [0] => 1
+    [1] => 1
+)
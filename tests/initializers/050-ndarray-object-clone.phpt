@@ -0,0 +1,81 @@
+--TEST--
+NDArray objects own their array: clones are independent copies and wrapped arrays outlive the original object
+--FILE--
+<?php
+$a = \NDArray::ones([2, 2]);
+$b = clone $a;
+$a->fill(3);
+print_r($b->toArray());
+print_r($a->toArray());
+
+$c = new \NDArray($a);
+unset($a);
+print_r($c->toArray());
+unset($b);
+print_r((\NDArray::zeros([2]) + $c[0])->toArray());
+
+$d = new \NDArray([1, 2]);
+for ($i = 0; $i < 10; $i++) {
+    $d->__construct(\NDArray::ones([64, 64]));
+}
+$before = memory_get_usage();
+for ($i = 0; $i < 1000; $i++) {
+    $d->__construct(\NDArray::ones([64, 64]));
+    $d->__construct($d);
+}
+var_dump(memory_get_usage() - $before < 65536);
+var_dump(\NDArray::sum($d));
+?>
+--EXPECT--
+Array
+(
+    [0] => Array
+        (
+            [0] => 1
+            [1] => 1
+        )
+
+    [1] => Array
+        (
+            [0] => 1
+            [1] => 1
+        )
+
+)
+Array
+(
+    [0] => Array
+        (
+            [0] => 3
+            [1] => 3
+        )
+
+    [1] => Array
+        (
+            [0] => 3
+            [1] => 3
+        )
+
+)
+Array
+(
+    [0] => Array
+        (
+            [0] => 3
+            [1] => 3
+        )
+
+    [1] => Array
+        (
+            [0] => 3
+            [1] => 3
+        )
+
+)
+Array
+(
+    [0] => 3
+    [1] => 3
+)
+bool(true)
+float(4096)
@@ -0,0 +1,62 @@
+--TEST--
+Small arrays keep working through copies, views and reshapes once their header is released
+--FILE--
+<?php
+use \NDArray as nd;
+
+$v = nd::reshape([[1, 2], [3, 4]], [4]);
+print_r($v->toArray());
+
+$m = nd::array([[1, 2, 3], [4, 5, 6], [7, 8, 9]]);
+$row = $m[1];
+unset($m);
+print_r($row->toArray());
+
+$c = nd::copy(nd::array([0.5, 1.5, 2.5]));
+print_r(nd::flatten(nd::reshape($c, [3, 1]))->toArray());
+
+$t = nd::transpose(nd::array([[1, 2], [3, 4]]));
+print_r(nd::copy($t)->toArray());
+
+$sum = 0;
+for ($i = 0; $i < 10000; $i++) {
+    $sum += nd::sum(nd::array([$i, 1, 2]) + nd::ones([3]));
+}
+var_dump($sum);
+?>
+--EXPECT--
+Array
+(
+    [0] => 1
+    [1] => 2
+    [2] => 3
+    [3] => 4
+)
+Array
+(
+    [0] => 4
+    [1] => 5
+    [2] => 6
+)
+Array
+(
+    [0] => 0.5
+    [1] => 1.5
+    [2] => 2.5
+)
+Array
+(
+    [0] => Array
+        (
+            [0] => 1
+            [1] => 3
+        )
+
+    [1] => Array
+        (
+            [0] => 2
+            [1] => 4
+        )
+
+)
+float(50055000)
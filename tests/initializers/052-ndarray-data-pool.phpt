@@ -0,0 +1,39 @@
+--TEST--
+Data buffers of freed arrays are reused by later arrays of a similar size
+--FILE--
+<?php
+use \NDArray as nd;
+
+$a = nd::ones([100, 100]);
+for ($i = 0; $i < 10; $i++) {
+    $a = $a + nd::ones([100, 100]);
+}
+$before = memory_get_usage();
+for ($i = 0; $i < 1000; $i++) {
+    $a = $a + nd::ones([100, 100]);
+    $a = $a - nd::ones([100, 100]);
+}
+var_dump(memory_get_usage() - $before < 65536);
+var_dump(nd::sum($a));
+print_r(nd::zeros([2, 3])->toArray());
+?>
+--EXPECT--
+bool(true)
+float(110000)
+Array
+(
+    [0] => Array
+        (
+            [0] => 0
+            [1] => 0
+            [2] => 0
+        )
+
+    [1] => Array
+        (
+            [0] => 0
+            [1] => 0
+            [2] => 0
+        )
+
+)
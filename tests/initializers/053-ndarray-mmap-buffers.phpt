@@ -0,0 +1,38 @@
+--TEST--
+Buffers above ndarray.mmap_threshold are mapped outside of memory_limit and unmapped on free
+--INI--
+ndarray.mmap_threshold=1M
+--FILE--
+<?php
+use \NDArray as nd;
+
+$before = memory_get_usage();
+$a = nd::ones([512, 1024]);
+$b = $a + nd::ones([512, 1024]);
+var_dump(memory_get_usage() - $before < 1048576);
+var_dump(nd::sum($b));
+var_dump(nd::sum(nd::zeros([512, 1024])));
+$stats = nd::memoryStats();
+var_dump($stats['mmap_threshold'], $stats['mappings'], $stats['mapped'] >= 2 * 2097152);
+unset($a, $b);
+$stats = nd::memoryStats();
+var_dump($stats['mappings'], $stats['mapped'], $stats['peak_mapped'] >= 3 * 2097152);
+var_dump(nd::memoryStats()['mappings'] === 0 && count(nd::ones([4, 4])->toArray()) === 4);
+
+ini_set('ndarray.mmap_limit', '3M');
+$c = nd::ones([512, 1024]);
+$d = nd::ones([512, 1024]);
+?>
+--EXPECTF--
+bool(true)
+float(1048576)
+float(0)
+int(1048576)
+int(2)
+bool(true)
+int(0)
+int(0)
+bool(true)
+bool(true)
+
+Fatal error: NDArray mmap limit of 3145728 bytes exhausted (tried to allocate 2097152 bytes) in %s on line %d
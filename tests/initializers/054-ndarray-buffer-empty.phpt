@@ -0,0 +1,45 @@
+--TEST--
+Freeing every array and allocating again reuses the buffer slots
+--FILE--
+<?php
+$sums = [];
+for ($round = 0; $round < 50; $round++) {
+    $arrays = [];
+    for ($i = 0; $i < 100; $i++) {
+        $arrays[] = \NDArray::array([$i, $i]);
+    }
+    $sum = 0;
+    foreach ($arrays as $a) {
+        $sum += \NDArray::sum($a);
+    }
+    $sums[$sum] = true;
+    unset($a, $arrays);
+    if ($round == 0) {
+        $before = memory_get_usage();
+    }
+}
+var_dump(memory_get_usage() - $before < 4096);
+var_dump(array_keys($sums));
+$stats = \NDArray::memoryStats();
+var_dump($stats['arrays_live'], $stats['array_slots']);
+var_dump($stats['arrays_allocated'] >= 5000);
+var_dump($stats['arrays_allocated'] === $stats['arrays_freed'] + $stats['arrays_live']);
+$a = \NDArray::array([1, 2]);
+$b = \NDArray::array([3, 4]);
+print_r(($a + $b)->toArray());
+?>
+--EXPECT--
+bool(true)
+array(1) {
+  [0]=>
+  int(9900)
+}
+int(0)
+int(16)
+bool(true)
+bool(true)
+Array
+(
+    [0] => 4
+    [1] => 6
+)
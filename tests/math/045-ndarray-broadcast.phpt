@@ -0,0 +1,147 @@
+--TEST--
+NDArray broadcasting
+--FILE--
+<?php
+$a = \NDArray::array([[[1, 2, 3], [4, 5, 6]], [[7, 8, 9], [10, 11, 12]]]);
+$b = \NDArray::array([[10], [20]]);
+$c = \NDArray::array([1, 0, -1]);
+print_r(($a + $b)->toArray());
+print_r(($a * $c)->toArray());
+print_r(\NDArray::greater($a, $b / 2)->toArray());
+print_r(($b - $c)->toArray());
+?>
+--EXPECT--
+Array
+(
+    [0] => Array
+        (
+            [0] => Array
+                (
+                    [0] => 11
+                    [1] => 12
+                    [2] => 13
+                )
+
+            [1] => Array
+                (
+                    [0] => 24
+                    [1] => 25
+                    [2] => 26
+                )
+
+        )
+
+    [1] => Array
+        (
+            [0] => Array
+                (
+                    [0] => 17
+                    [1] => 18
+                    [2] => 19
+                )
+
+            [1] => Array
+                (
+                    [0] => 30
+                    [1] => 31
+                    [2] => 32
+                )
+
+        )
+
+)
+Array
+(
+    [0] => Array
+        (
+            [0] => Array
+                (
+                    [0] => 1
+                    [1] => 0
+                    [2] => -3
+                )
+
+            [1] => Array
+                (
+                    [0] => 4
+                    [1] => 0
+                    [2] => -6
+                )
+
+        )
+
+    [1] => Array
+        (
+            [0] => Array
+                (
+                    [0] => 7
+                    [1] => 0
+                    [2] => -9
+                )
+
+            [1] => Array
+                (
+                    [0] => 10
+                    [1] => 0
+                    [2] => -12
+                )
+
+        )
+
+)
+Array
+(
+    [0] => Array
+        (
+            [0] => Array
+                (
+                    [0] => 0
+                    [1] => 0
+                    [2] => 0
+                )
+
+            [1] => Array
+                (
+                    [0] => 0
+                    [1] => 0
+                    [2] => 0
+                )
+
+        )
+
+    [1] => Array
+        (
+            [0] => Array
+                (
+                    [0] => 1
+                    [1] => 1
+                    [2] => 1
+                )
+
+            [1] => Array
+                (
+                    [0] => 0
+                    [1] => 1
+                    [2] => 1
+                )
+
+        )
+
+)
+Array
+(
+    [0] => Array
+        (
+            [0] => 9
+            [1] => 10
+            [2] => 11
+        )
+
+    [1] => Array
+        (
+            [0] => 19
+            [1] => 20
+            [2] => 21
+        )
+
+)
\ No newline at end of file
@@ -0,0 +1,87 @@
+--TEST--
+NDArray array-scalar operators
+--FILE--
+<?php
+$a = \NDArray::array([[1, 2], [4, 8]]);
+print_r((2 - $a)->toArray());
+print_r((8 / $a)->toArray());
+print_r(($a ** 2)->toArray());
+print_r(($a * 0.5)->toArray());
+print_r((10 % $a)->toArray());
+?>
+--EXPECT--
+Array
+(
+    [0] => Array
+        (
+            [0] => 1
+            [1] => 0
+        )
+
+    [1] => Array
+        (
+            [0] => -2
+            [1] => -6
+        )
+
+)
+Array
+(
+    [0] => Array
+        (
+            [0] => 8
+            [1] => 4
+        )
+
+    [1] => Array
+        (
+            [0] => 2
+            [1] => 1
+        )
+
+)
+Array
+(
+    [0] => Array
+        (
+            [0] => 1
+            [1] => 4
+        )
+
+    [1] => Array
+        (
+            [0] => 16
+            [1] => 64
+        )
+
+)
+Array
+(
+    [0] => Array
+        (
+            [0] => 0.5
+            [1] => 1
+        )
+
+    [1] => Array
+        (
+            [0] => 2
+            [1] => 4
+        )
+
+)
+Array
+(
+    [0] => Array
+        (
+            [0] => 0
+            [1] => 0
+        )
+
+    [1] => Array
+        (
+            [0] => 2
+            [1] => 2
+        )
+
+)
\ No newline at end of file
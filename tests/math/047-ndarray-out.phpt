@@ -0,0 +1,90 @@
+--TEST--
+NDArray out argument and in-place operations
+--FILE--
+<?php
+$a = \NDArray::array([[1, 2], [3, 4]]);
+$b = \NDArray::array([10, 20]);
+$c = \NDArray::zeros([2, 2]);
+$r = \NDArray::add($a, $b, $c);
+print_r($c->toArray());
+var_dump($r === $c);
+$a->multiplyInPlace(2);
+print_r($a->toArray());
+$a->subtractInPlace([1, 1]);
+print_r($a->toArray());
+$d = \NDArray::array([4, 9, 16]);
+\NDArray::sqrt($d, $d);
+print_r($d->toArray());
+var_dump($d->powInPlace(2)->modInPlace(7.0) === $d);
+print_r($d->toArray());
+$x = \NDArray::array([-1, -2, -3, -4, -5, -6, -7, -8, -9]);
+\NDArray::abs($x->slice([0, 8]), $x->slice([1, 9]));
+echo implode(' ', $x->toArray()), "\n";
+try {
+    \NDArray::add($a, $b, \NDArray::zeros([3]));
+} catch (\Error $e) {
+    echo $e->getMessage() . "\n";
+}
+?>
+--EXPECT--
+Array
+(
+    [0] => Array
+        (
+            [0] => 11
+            [1] => 22
+        )
+
+    [1] => Array
+        (
+            [0] => 13
+            [1] => 24
+        )
+
+)
+bool(true)
+Array
+(
+    [0] => Array
+        (
+            [0] => 2
+            [1] => 4
+        )
+
+    [1] => Array
+        (
+            [0] => 6
+            [1] => 8
+        )
+
+)
+Array
+(
+    [0] => Array
+        (
+            [0] => 1
+            [1] => 3
+        )
+
+    [1] => Array
+        (
+            [0] => 5
+            [1] => 7
+        )
+
+)
+Array
+(
+    [0] => 2
+    [1] => 3
+    [2] => 4
+)
+bool(true)
+Array
+(
+    [0] => 4
+    [1] => 2
+    [2] => 2
+)
+-1 1 2 3 4 5 6 7 8
+`out` shape does not match the result shape.
\ No newline at end of file
@@ -0,0 +1,65 @@
+--TEST--
+NDArray operator chains reuse temporaries without touching named arrays
+--FILE--
+<?php
+$a = \NDArray::array([1, 2]);
+$b = \NDArray::array([3, 4]);
+$c = \NDArray::array([10, 20]);
+print_r(($a * $b + $c - $a)->toArray());
+print_r($a->toArray());
+print_r($b->toArray());
+$x = $a * 2;
+$y = $x + 1;
+print_r($x->toArray());
+print_r($y->toArray());
+print_r((($a + $b) * 2 - ($b - $a) * 1)->toArray());
+$m = \NDArray::array([[1, 2], [3, 4]]);
+$v = ($m[0] + 1) * 2;
+print_r($m->toArray());
+?>
+--EXPECT--
+Array
+(
+    [0] => 12
+    [1] => 26
+)
+Array
+(
+    [0] => 1
+    [1] => 2
+)
+Array
+(
+    [0] => 3
+    [1] => 4
+)
+Array
+(
+    [0] => 2
+    [1] => 4
+)
+Array
+(
+    [0] => 3
+    [1] => 5
+)
+Array
+(
+    [0] => 6
+    [1] => 10
+)
+Array
+(
+    [0] => Array
+        (
+            [0] => 1
+            [1] => 2
+        )
+
+    [1] => Array
+        (
+            [0] => 3
+            [1] => 4
+        )
+
+)
\ No newline at end of file
@@ -0,0 +1,37 @@
+--TEST--
+NDArray::lazy deferred expressions
+--FILE--
+<?php
+$x = \NDArray::array([[3, 6], [0, 15]]);
+$y = \NDArray::array([4, 8]);
+$e = \NDArray::sqrt(\NDArray::lazy($x) * $x + \NDArray::lazy($y) * $y) * 2;
+var_dump($e instanceof \LazyNDArray);
+print_r($e->eval()->toArray());
+var_dump($e->eval() === $e->eval());
+print_r((1 - \NDArray::lazy($y))->eval()->toArray());
+echo \NDArray::sum(\NDArray::lazy([1, 2]) + 1) . "\n";
+?>
+--EXPECT--
+bool(true)
+Array
+(
+    [0] => Array
+        (
+            [0] => 10
+            [1] => 20
+        )
+
+    [1] => Array
+        (
+            [0] => 8
+            [1] => 34
+        )
+
+)
+bool(true)
+Array
+(
+    [0] => -3
+    [1] => -7
+)
+5
\ No newline at end of file
@@ -0,0 +1,88 @@
+--TEST--
+Element-wise math functions on arrays longer than a vector
+--FILE--
+<?php
+$x = [];
+for ($i = 0; $i < 21; $i++) {
+    $x[] = ($i - 10) * 0.37;
+}
+$check = function ($name, $expected) use ($x) {
+    $rtn = \NDArray::$name($x)->toArray();
+    foreach ($x as $i => $value) {
+        $want = $expected($value);
+        if (abs($rtn[$i] - $want) > 1e-5 * max(1, abs($want))) {
+            echo "$name($value) = {$rtn[$i]}, expected $want\n";
+            return;
+        }
+    }
+    echo "$name ok\n";
+};
+$check('exp', 'exp');
+$check('sin', 'sin');
+$check('cos', 'cos');
+$check('tan', 'tan');
+$check('tanh', 'tanh');
+$check('sigmoid', function ($v) { return 1 / (1 + exp(-$v)); });
+print_r(\NDArray::sqrt([0, 1, 4, 9, 16, 25, 36, 49, 64, 81])->toArray());
+print_r(\NDArray::log([1, 1, 1, 1, 1, 1, 1, 1, 0, -1])->toArray());
+print_r(\NDArray::exp([0, 0, 0, 0, 0, 0, 0, 0, 1000, -1000])->toArray());
+print_r(\NDArray::clip([-3, -2, -1, 0, 1, 2, 3, 4, 5], 0, 2)->toArray());
+?>
+--EXPECT--
+exp ok
+sin ok
+cos ok
+tan ok
+tanh ok
+sigmoid ok
+Array
+(
+    [0] => 0
+    [1] => 1
+    [2] => 2
+    [3] => 3
+    [4] => 4
+    [5] => 5
+    [6] => 6
+    [7] => 7
+    [8] => 8
+    [9] => 9
+)
+Array
+(
+    [0] => 0
+    [1] => 0
+    [2] => 0
+    [3] => 0
+    [4] => 0
+    [5] => 0
+    [6] => 0
+    [7] => 0
+    [8] => -INF
+    [9] => NAN
+)
+Array
+(
+    [0] => 1
+    [1] => 1
+    [2] => 1
+    [3] => 1
+    [4] => 1
+    [5] => 1
+    [6] => 1
+    [7] => 1
+    [8] => INF
+    [9] => 0
+)
+Array
+(
+    [0] => 0
+    [1] => 0
+    [2] => 0
+    [3] => 0
+    [4] => 1
+    [5] => 2
+    [6] => 2
+    [7] => 2
+    [8] => 2
+)
@@ -0,0 +1,68 @@
+--TEST--
+Baseline kernels selected with NDARRAY_CPU
+--ENV--
+NDARRAY_CPU=baseline
+--FILE--
+<?php
+$a = \NDArray::array([1, 2, 3, 4, 5, 6, 7, 8, 9, 10]);
+$b = \NDArray::array([10, 9, 8, 7, 6, 5, 4, 3, 2, 1]);
+print_r(($a + $b)->toArray());
+print_r(($a * 2)->toArray());
+print_r(\NDArray::greater($a, $b)->toArray());
+print_r(\NDArray::sqrt($a * $a)->toArray());
+var_dump(\NDArray::all($a));
+?>
+--EXPECT--
+Array
+(
+    [0] => 11
+    [1] => 11
+    [2] => 11
+    [3] => 11
+    [4] => 11
+    [5] => 11
+    [6] => 11
+    [7] => 11
+    [8] => 11
+    [9] => 11
+)
+Array
+(
+    [0] => 2
+    [1] => 4
+    [2] => 6
+    [3] => 8
+    [4] => 10
+    [5] => 12
+    [6] => 14
+    [7] => 16
+    [8] => 18
+    [9] => 20
+)
+Array
+(
+    [0] => 0
+    [1] => 0
+    [2] => 0
+    [3] => 0
+    [4] => 0
+    [5] => 1
+    [6] => 1
+    [7] => 1
+    [8] => 1
+    [9] => 1
+)
+Array
+(
+    [0] => 1
+    [1] => 2
+    [2] => 3
+    [3] => 4
+    [4] => 5
+    [5] => 6
+    [6] => 7
+    [7] => 8
+    [8] => 9
+    [9] => 10
+)
+int(1)
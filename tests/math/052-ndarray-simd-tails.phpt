@@ -0,0 +1,36 @@
+--TEST--
+Element-wise ops and reductions on every length around the vector width
+--FILE--
+<?php
+$failed = 0;
+for ($n = 1; $n <= 40; $n++) {
+    $x = [];
+    $y = [];
+    for ($i = 0; $i < $n; $i++) {
+        $x[] = ($i * 7) % 11 - 5;
+        $y[] = ($i * 3) % 7 - 3;
+    }
+    $a = \NDArray::array($x);
+    $b = \NDArray::array($y);
+    $sum = ($a + $b)->toArray();
+    $product = ($a * $b)->toArray();
+    $less = \NDArray::less($a, $b)->toArray();
+    for ($i = 0; $i < $n; $i++) {
+        if ($sum[$i] != $x[$i] + $y[$i] || $product[$i] != $x[$i] * $y[$i]
+            || $less[$i] != ($x[$i] < $y[$i] ? 1 : 0)) {
+            $failed++;
+        }
+    }
+    if (\NDArray::sum($a) != array_sum($x) || \NDArray::min($a) != min($x) || \NDArray::max($a) != max($x)) {
+        $failed++;
+    }
+    $c = $x;
+    $c[$n - 1] += 1;
+    if (!\NDArray::allclose($a, $a) || \NDArray::allclose($a, \NDArray::array($c))) {
+        $failed++;
+    }
+}
+var_dump($failed);
+?>
+--EXPECT--
+int(0)
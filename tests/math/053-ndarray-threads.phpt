@@ -0,0 +1,39 @@
+--TEST--
+Copies of large strided arrays split across worker threads
+--ENV--
+NDARRAY_NUM_THREADS=2
+--FILE--
+<?php
+echo \NDArray::getNumThreads() . "\n";
+\NDArray::setNumThreads(4);
+echo \NDArray::getNumThreads() . "\n";
+$rows = 300;
+$cols = 257;
+$a = \NDArray::reshape(\NDArray::arange($rows * $cols), [$rows, $cols]);
+$t = \NDArray::transpose($a)->toArray();
+$ok = count($t) == $cols;
+for ($j = 0; $j < $cols && $ok; $j++) {
+    for ($i = 0; $i < $rows; $i++) {
+        if ($t[$j][$i] != $i * $cols + $j) {
+            echo "t[$j][$i] = {$t[$j][$i]}\n";
+            $ok = false;
+            break;
+        }
+    }
+}
+echo $ok ? "transpose ok\n" : "transpose failed\n";
+\NDArray::setNumThreads(1);
+print_r(\NDArray::transpose($a)->toArray() === $t);
+echo "\n";
+try {
+    \NDArray::setNumThreads(0);
+} catch (\Error $e) {
+    echo $e->getMessage() . "\n";
+}
+?>
+--EXPECT--
+2
+4
+transpose ok
+1
+The number of threads must be between 1 and 1024.
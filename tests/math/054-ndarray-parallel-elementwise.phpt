@@ -0,0 +1,58 @@
+--TEST--
+Element-wise operations split across worker threads
+--ENV--
+NDARRAY_NUM_THREADS=4
+NDARRAY_PARALLEL_THRESHOLD=1000
+--FILE--
+<?php
+$rows = 200;
+$cols = 251;
+$x = [];
+$y = [];
+for ($i = 0; $i < $rows; $i++) {
+    for ($j = 0; $j < $cols; $j++) {
+        $x[$i][$j] = ($i * $cols + $j) % 97;
+    }
+}
+for ($j = 0; $j < $cols; $j++) {
+    $y[] = $j % 13;
+}
+$check = function ($name, $rtn, $expected) use ($rows, $cols) {
+    for ($i = 0; $i < $rows; $i++) {
+        for ($j = 0; $j < $cols; $j++) {
+            $want = $expected($i, $j);
+            if (abs($rtn[$i][$j] - $want) > 1e-4 * max(1, abs($want))) {
+                echo "$name [$i][$j] = {$rtn[$i][$j]}, expected $want\n";
+                return;
+            }
+        }
+    }
+    echo "$name ok\n";
+};
+$check('add', \NDArray::add($x, $y)->toArray(), function ($i, $j) use ($x, $y) {
+    return $x[$i][$j] + $y[$j];
+});
+$check('multiply', \NDArray::multiply($x, 0.5)->toArray(), function ($i, $j) use ($x) {
+    return $x[$i][$j] * 0.5;
+});
+$check('greater', \NDArray::greater($x, $y)->toArray(), function ($i, $j) use ($x, $y) {
+    return $x[$i][$j] > $y[$j] ? 1 : 0;
+});
+$t = \NDArray::transpose($x);
+$check('transposed add', \NDArray::transpose(\NDArray::add($t, $t))->toArray(), function ($i, $j) use ($x) {
+    return 2 * $x[$i][$j];
+});
+$check('sqrt', \NDArray::sqrt($x)->toArray(), function ($i, $j) use ($x) {
+    return sqrt($x[$i][$j]);
+});
+$check('clip', \NDArray::clip($x, 10, 20)->toArray(), function ($i, $j) use ($x) {
+    return min(max($x[$i][$j], 10), 20);
+});
+?>
+--EXPECT--
+add ok
+multiply ok
+greater ok
+transposed add ok
+sqrt ok
+clip ok
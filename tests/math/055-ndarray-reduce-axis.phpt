@@ -0,0 +1,173 @@
+--TEST--
+Reductions over one or more axes with keepdims
+--ENV--
+NDARRAY_NUM_THREADS=4
+NDARRAY_PARALLEL_THRESHOLD=1000
+--FILE--
+<?php
+$a = \NDArray::reshape(\NDArray::arange(12), [2, 3, 2]);
+print_r(\NDArray::sum($a, 0)->toArray());
+print_r(\NDArray::sum($a, [0, 2])->toArray());
+print_r(\NDArray::sum($a, -1, keepdims: true)->toArray());
+print_r(\NDArray::min($a, 1)->toArray());
+print_r(\NDArray::max($a, [0, 1])->toArray());
+print_r(\NDArray::mean($a, 2)->toArray());
+print_r(\NDArray::max($a, keepdims: true)->toArray());
+print_r(\NDArray::prod([[1, 2], [3, 4]], axis: 0)->toArray());
+echo \NDArray::sum($a, [0, 1, 2]) . "\n";
+try {
+    \NDArray::sum($a, 3);
+} catch (\Error $e) {
+    echo $e->getMessage() . "\n";
+}
+try {
+    \NDArray::sum($a, [1, -2]);
+} catch (\Error $e) {
+    echo $e->getMessage() . "\n";
+}
+$rows = 300;
+$cols = 257;
+$x = [];
+for ($i = 0; $i < $rows; $i++) {
+    for ($j = 0; $j < $cols; $j++) {
+        $x[$i][$j] = ($i * 7 + $j * 3) % 11;
+    }
+}
+$columns = \NDArray::sum($x, 0)->toArray();
+$rowsum = \NDArray::sum(\NDArray::transpose($x), 0)->toArray();
+$ok = true;
+for ($j = 0; $j < $cols; $j++) {
+    $ok = $ok && $columns[$j] == array_sum(array_column($x, $j));
+}
+for ($i = 0; $i < $rows; $i++) {
+    $ok = $ok && $rowsum[$i] == array_sum($x[$i]);
+}
+echo $ok ? "large ok\n" : "large failed\n";
+?>
+--EXPECT--
+Array
+(
+    [0] => Array
+        (
+            [0] => 6
+            [1] => 8
+        )
+
+    [1] => Array
+        (
+            [0] => 10
+            [1] => 12
+        )
+
+    [2] => Array
+        (
+            [0] => 14
+            [1] => 16
+        )
+
+)
+Array
+(
+    [0] => 14
+    [1] => 22
+    [2] => 30
+)
+Array
+(
+    [0] => Array
+        (
+            [0] => Array
+                (
+                    [0] => 1
+                )
+
+            [1] => Array
+                (
+                    [0] => 5
+                )
+
+            [2] => Array
+                (
+                    [0] => 9
+                )
+
+        )
+
+    [1] => Array
+        (
+            [0] => Array
+                (
+                    [0] => 13
+                )
+
+            [1] => Array
+                (
+                    [0] => 17
+                )
+
+            [2] => Array
+                (
+                    [0] => 21
+                )
+
+        )
+
+)
+Array
+(
+    [0] => Array
+        (
+            [0] => 0
+            [1] => 1
+        )
+
+    [1] => Array
+        (
+            [0] => 6
+            [1] => 7
+        )
+
+)
+Array
+(
+    [0] => 10
+    [1] => 11
+)
+Array
+(
+    [0] => Array
+        (
+            [0] => 0.5
+            [1] => 2.5
+            [2] => 4.5
+        )
+
+    [1] => Array
+        (
+            [0] => 6.5
+            [1] => 8.5
+            [2] => 10.5
+        )
+
+)
+Array
+(
+    [0] => Array
+        (
+            [0] => Array
+                (
+                    [0] => 11
+                )
+
+        )
+
+)
+Array
+(
+    [0] => 3
+    [1] => 8
+)
+66
+axis 3 is out of bounds for array of dimension 3
+duplicate value in 'axis'
+large ok
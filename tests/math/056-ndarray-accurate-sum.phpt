@@ -0,0 +1,37 @@
+--TEST--
+Sums of many float32 values do not accumulate rounding errors
+--ENV--
+NDARRAY_NUM_THREADS=4
+NDARRAY_PARALLEL_THRESHOLD=1000
+--FILE--
+<?php
+$a = \NDArray::full([100000], 0.1);
+echo round(\NDArray::sum($a), 3) . "\n";
+echo round(\NDArray::mean($a), 6) . "\n";
+echo round(\NDArray::std($a), 6) . "\n";
+$b = \NDArray::full([2, 100000], 0.1);
+print_r(array_map(fn($v) => round($v, 3), \NDArray::sum($b, 1)->toArray()));
+$c = \NDArray::full([100000, 2], 0.1);
+print_r(array_map(fn($v) => round($v, 3), \NDArray::sum($c, 0)->toArray()));
+print_r(array_map(fn($v) => round($v, 6), \NDArray::mean(\NDArray::transpose($c), 1)->toArray()));
+echo \NDArray::sum([16777216, 1, 1, 1, 1]) . "\n";
+--EXPECT--
+10000.001
+0.1
+0
+Array
+(
+    [0] => 10000.001
+    [1] => 10000.001
+)
+Array
+(
+    [0] => 10000.001
+    [1] => 10000.001
+)
+Array
+(
+    [0] => 0.1
+    [1] => 0.1
+)
+16777220
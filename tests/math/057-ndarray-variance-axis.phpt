@@ -0,0 +1,77 @@
+--TEST--
+Variance and standard deviation with axis, ddof and keepdims
+--ENV--
+NDARRAY_NUM_THREADS=4
+NDARRAY_PARALLEL_THRESHOLD=1000
+--FILE--
+<?php
+$r = fn($a) => array_map(fn($v) => is_array($v) ? array_map(fn($w) => round($w, 5), $v) : round($v, 5), $a);
+$a = [[1, 2, 3, 4], [2, 4, 6, 8]];
+echo round(\NDArray::variance($a), 5) . "\n";
+echo round(\NDArray::std($a), 5) . "\n";
+echo round(\NDArray::variance($a, ddof: 1), 5) . "\n";
+print_r($r(\NDArray::variance($a, 1)->toArray()));
+print_r($r(\NDArray::variance($a, 1, 1)->toArray()));
+print_r($r(\NDArray::variance($a, 0)->toArray()));
+print_r($r(\NDArray::std($a, 0, keepdims: true)->toArray()));
+print_r(\NDArray::variance($a, 0, 2)->toArray());
+echo round(\NDArray::variance([10001, 10002, 10003]), 5) . "\n";
+$big = \NDArray::reshape(\NDArray::arange(300000), [3000, 100]);
+print_r($r(array_slice(\NDArray::std($big, 1)->toArray(), 0, 2)));
+print_r(array_map(fn($v) => round($v / 1e9, 5), array_slice(\NDArray::variance($big, 0)->toArray(), 0, 2)));
+try {
+    \NDArray::std($a, 2);
+} catch (\Error $e) {
+    echo $e->getMessage() . "\n";
+}
+--EXPECT--
+4.6875
+2.16506
+5.35714
+Array
+(
+    [0] => 1.25
+    [1] => 5
+)
+Array
+(
+    [0] => 1.66667
+    [1] => 6.66667
+)
+Array
+(
+    [0] => 0.25
+    [1] => 1
+    [2] => 2.25
+    [3] => 4
+)
+Array
+(
+    [0] => Array
+        (
+            [0] => 0.5
+            [1] => 1
+            [2] => 1.5
+            [3] => 2
+        )
+
+)
+Array
+(
+    [0] => NAN
+    [1] => NAN
+    [2] => NAN
+    [3] => NAN
+)
+0.66667
+Array
+(
+    [0] => 28.86607
+    [1] => 28.86607
+)
+Array
+(
+    [0] => 7.5
+    [1] => 7.5
+)
+axis 2 is out of bounds for array of dimension 2
@@ -0,0 +1,82 @@
+--TEST--
+Median and quantiles with axis, keepdims and several quantiles at once
+--ENV--
+NDARRAY_NUM_THREADS=4
+NDARRAY_PARALLEL_THRESHOLD=1000
+--FILE--
+<?php
+$a = [[7, 1, 3, 5], [2, 8, 6, 4]];
+echo \NDArray::median($a) . "\n";
+print_r(\NDArray::median($a, 1)->toArray());
+$b = [[1, 2, 3], [4, 5, 6], [7, 8, 10]];
+print_r(\NDArray::median($b, 0)->toArray());
+print_r(\NDArray::median($b, 1, keepdims: true)->toArray());
+echo \NDArray::quantile($a, 0.25) . "\n";
+print_r(\NDArray::quantile($a, [0, 0.5, 1], 1)->toArray());
+echo \NDArray::quantile(\NDArray::arange(101), 0.95) . "\n";
+echo \NDArray::median([1, NAN, 3]) . "\n";
+$big = \NDArray::reshape(\NDArray::arange(100000), [1000, 100]);
+$q = \NDArray::quantile($big, [0.5, 0.99], 0)->toArray();
+echo round($q[0][0], 2) . " " . round($q[1][0], 2) . " " . round($q[0][99], 2) . "\n";
+try {
+    \NDArray::quantile($a, 1.5);
+} catch (\Error $e) {
+    echo $e->getMessage() . "\n";
+}
+--EXPECT--
+4.5
+Array
+(
+    [0] => 4
+    [1] => 5
+)
+Array
+(
+    [0] => 4
+    [1] => 5
+    [2] => 6
+)
+Array
+(
+    [0] => Array
+        (
+            [0] => 2
+        )
+
+    [1] => Array
+        (
+            [0] => 5
+        )
+
+    [2] => Array
+        (
+            [0] => 8
+        )
+
+)
+2.75
+Array
+(
+    [0] => Array
+        (
+            [0] => 1
+            [1] => 2
+        )
+
+    [1] => Array
+        (
+            [0] => 4
+            [1] => 5
+        )
+
+    [2] => Array
+        (
+            [0] => 7
+            [1] => 8
+        )
+
+)
+95
+NAN
+49950 98901 50049
+Q must be between 0 and 1
@@ -0,0 +1,72 @@
+--TEST--
+argmax and argmin along any axis with integer flat indexes
+--ENV--
+NDARRAY_NUM_THREADS=4
+NDARRAY_PARALLEL_THRESHOLD=1000
+--FILE--
+<?php
+$a = [[3, 9, 2], [9, 1, 7]];
+var_dump(\NDArray::argmax($a));
+var_dump(\NDArray::argmin($a));
+print_r(\NDArray::argmax($a, 0)->toArray());
+print_r(\NDArray::argmin($a, 1)->toArray());
+print_r(\NDArray::argmax($a, -1, true)->toArray());
+print_r(\NDArray::argmax(\NDArray::transpose($a), 0)->toArray());
+var_dump(\NDArray::argmax([1, NAN, 5]));
+$big = \NDArray::arange(200000);
+var_dump(\NDArray::argmax($big));
+var_dump(\NDArray::argmin($big));
+$m = \NDArray::reshape($big, [400, 500]);
+print_r(array_slice(\NDArray::argmax($m, 0)->toArray(), 0, 2));
+print_r(array_slice(\NDArray::argmin($m, 1)->toArray(), 0, 2));
+try {
+    \NDArray::argmax($a, 2);
+} catch (\Error $e) {
+    echo $e->getMessage() . "\n";
+}
+--EXPECT--
+int(1)
+int(4)
+Array
+(
+    [0] => 1
+    [1] => 0
+    [2] => 1
+)
+Array
+(
+    [0] => 2
+    [1] => 1
+)
+Array
+(
+    [0] => Array
+        (
+            [0] => 1
+        )
+
+    [1] => Array
+        (
+            [0] => 0
+        )
+
+)
+Array
+(
+    [0] => 1
+    [1] => 0
+)
+int(1)
+int(199999)
+int(0)
+Array
+(
+    [0] => 399
+    [1] => 399
+)
+Array
+(
+    [0] => 0
+    [1] => 0
+)
+axis 2 is out of bounds for array of dimension 2
@@ -0,0 +1,121 @@
+--TEST--
+cumsum, cumprod and cummax along any axis
+--ENV--
+NDARRAY_NUM_THREADS=4
+NDARRAY_PARALLEL_THRESHOLD=1000
+--FILE--
+<?php
+$a = [[1, 2, 3], [4, 5, 6]];
+print_r(\NDArray::cumsum($a)->toArray());
+print_r(\NDArray::cumsum($a, 0)->toArray());
+print_r(\NDArray::cumprod($a, 1)->toArray());
+print_r(\NDArray::cumsum(\NDArray::transpose($a), 1)->toArray());
+print_r(\NDArray::cummax([3, 1, 4, 1, 5, 9, 2])->toArray());
+print_r(\NDArray::cummax([1, NAN, 5])->toArray());
+$b = \NDArray::array([1, 2, 3, 4]);
+\NDArray::cumsum($b, null, $b);
+print_r($b->toArray());
+$ones = \NDArray::cumsum(\NDArray::ones([200000]))->toArray();
+var_dump($ones[199999]);
+$m = \NDArray::reshape(\NDArray::arange(200000), [400, 500]);
+print_r(array_slice(\NDArray::cummax($m, 0)->toArray()[399], 0, 2));
+try {
+    \NDArray::cumsum($a, 2);
+} catch (\Error $e) {
+    echo $e->getMessage() . "\n";
+}
+--EXPECT--
+Array
+(
+    [0] => 1
+    [1] => 3
+    [2] => 6
+    [3] => 10
+    [4] => 15
+    [5] => 21
+)
+Array
+(
+    [0] => Array
+        (
+            [0] => 1
+            [1] => 2
+            [2] => 3
+        )
+
+    [1] => Array
+        (
+            [0] => 5
+            [1] => 7
+            [2] => 9
+        )
+
+)
+Array
+(
+    [0] => Array
+        (
+            [0] => 1
+            [1] => 2
+            [2] => 6
+        )
+
+    [1] => Array
+        (
+            [0] => 4
+            [1] => 20
+            [2] => 120
+        )
+
+)
+Array
+(
+    [0] => Array
+        (
+            [0] => 1
+            [1] => 5
+        )
+
+    [1] => Array
+        (
+            [0] => 2
+            [1] => 7
+        )
+
+    [2] => Array
+        (
+            [0] => 3
+            [1] => 9
+        )
+
+)
+Array
+(
+    [0] => 3
+    [1] => 3
+    [2] => 4
+    [3] => 4
+    [4] => 5
+    [5] => 9
+    [6] => 9
+)
+Array
+(
+    [0] => 1
+    [1] => NAN
+    [2] => NAN
+)
+Array
+(
+    [0] => 1
+    [1] => 3
+    [2] => 6
+    [3] => 10
+)
+float(200000)
+Array
+(
+    [0] => 199500
+    [1] => 199501
+)
+axis 2 is out of bounds for array of dimension 2
@@ -0,0 +1,129 @@
+--TEST--
+sort, argsort, partition and topk along an axis
+--ENV--
+NDARRAY_NUM_THREADS=4
+NDARRAY_PARALLEL_THRESHOLD=1000
+--FILE--
+<?php
+$a = [[3, 1, 2], [9, 7, 8]];
+print_r(\NDArray::sort($a)->toArray());
+print_r(\NDArray::sort(\NDArray::transpose($a), 0)->toArray());
+print_r(\NDArray::sort($a, null)->toArray());
+print_r(\NDArray::argsort([3, 1, 2, 1])->toArray());
+print_r(\NDArray::sort([3, NAN, 1])->toArray());
+$p = \NDArray::partition([7, 2, 9, 4, 1], 2)->toArray();
+var_dump($p[2]);
+var_dump(max(array_slice($p, 0, 2)) <= $p[2] && min(array_slice($p, 3)) >= $p[2]);
+[$values, $indexes] = \NDArray::topk([1, 5, 3, 5, 2], 2);
+print_r($values->toArray());
+print_r($indexes->toArray());
+[$values, $indexes] = \NDArray::topk($a, 1, 0, false);
+print_r($values->toArray());
+print_r($indexes->toArray());
+[$values, $indexes] = \NDArray::topk(\NDArray::arange(100000), 3);
+print_r($indexes->toArray());
+try {
+    \NDArray::topk([1, 2], 3);
+} catch (\Error $e) {
+    echo $e->getMessage() . "\n";
+}
+--EXPECT--
+Array
+(
+    [0] => Array
+        (
+            [0] => 1
+            [1] => 2
+            [2] => 3
+        )
+
+    [1] => Array
+        (
+            [0] => 7
+            [1] => 8
+            [2] => 9
+        )
+
+)
+Array
+(
+    [0] => Array
+        (
+            [0] => 1
+            [1] => 7
+        )
+
+    [1] => Array
+        (
+            [0] => 2
+            [1] => 8
+        )
+
+    [2] => Array
+        (
+            [0] => 3
+            [1] => 9
+        )
+
+)
+Array
+(
+    [0] => 1
+    [1] => 2
+    [2] => 3
+    [3] => 7
+    [4] => 8
+    [5] => 9
+)
+Array
+(
+    [0] => 1
+    [1] => 3
+    [2] => 2
+    [3] => 0
+)
+Array
+(
+    [0] => 1
+    [1] => 3
+    [2] => NAN
+)
+float(4)
+bool(true)
+Array
+(
+    [0] => 5
+    [1] => 5
+)
+Array
+(
+    [0] => 1
+    [1] => 3
+)
+Array
+(
+    [0] => Array
+        (
+            [0] => 3
+            [1] => 1
+            [2] => 2
+        )
+
+)
+Array
+(
+    [0] => Array
+        (
+            [0] => 0
+            [1] => 0
+            [2] => 0
+        )
+
+)
+Array
+(
+    [0] => 99999
+    [1] => 99998
+    [2] => 99997
+)
+k(=3) out of bounds (2)
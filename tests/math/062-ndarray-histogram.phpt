@@ -0,0 +1,103 @@
+--TEST--
+histogram, bincount, digitize and unique
+--ENV--
+NDARRAY_NUM_THREADS=4
+NDARRAY_PARALLEL_THRESHOLD=1000
+--FILE--
+<?php
+[$hist, $edges] = \NDArray::histogram([1, 2, 1, 4, 3, 4, 4], 3);
+print_r($hist->toArray());
+print_r($edges->toArray());
+[$hist, $edges] = \NDArray::histogram([0.5, 1, 2.5, 9], [0, 1, 3]);
+print_r($hist->toArray());
+[$hist, $edges] = \NDArray::histogram(\NDArray::arange(100000), 4, [0, 100000]);
+print_r($hist->toArray());
+print_r(\NDArray::bincount([0, 1, 1, 3, 1])->toArray());
+print_r(\NDArray::bincount([0, 1, 1], [0.5, 1, 2], 4)->toArray());
+print_r(\NDArray::digitize([-1, 0, 10, 15, 30], [0, 10, 20, 30])->toArray());
+print_r(\NDArray::digitize([-1, 0, 10, 15, 30], [0, 10, 20, 30], true)->toArray());
+print_r(\NDArray::unique([[3, 1, 3], [NAN, 2, NAN]])->toArray());
+[$values, $counts] = \NDArray::unique([5, 1, 5, 5, 2], true);
+print_r($values->toArray());
+print_r($counts->toArray());
+try {
+    \NDArray::bincount([1, -1]);
+} catch (\Error $e) {
+    echo $e->getMessage() . "\n";
+}
+--EXPECT--
+Array
+(
+    [0] => 2
+    [1] => 1
+    [2] => 4
+)
+Array
+(
+    [0] => 1
+    [1] => 2
+    [2] => 3
+    [3] => 4
+)
+Array
+(
+    [0] => 1
+    [1] => 2
+)
+Array
+(
+    [0] => 25000
+    [1] => 25000
+    [2] => 25000
+    [3] => 25000
+)
+Array
+(
+    [0] => 1
+    [1] => 3
+    [2] => 0
+    [3] => 1
+)
+Array
+(
+    [0] => 0.5
+    [1] => 3
+    [2] => 0
+    [3] => 0
+)
+Array
+(
+    [0] => 0
+    [1] => 1
+    [2] => 2
+    [3] => 2
+    [4] => 4
+)
+Array
+(
+    [0] => 0
+    [1] => 0
+    [2] => 1
+    [3] => 2
+    [4] => 3
+)
+Array
+(
+    [0] => 1
+    [1] => 2
+    [2] => 3
+    [3] => NAN
+)
+Array
+(
+    [0] => 1
+    [1] => 2
+    [2] => 5
+)
+Array
+(
+    [0] => 1
+    [1] => 1
+    [2] => 3
+)
+bincount only accepts non-negative integers
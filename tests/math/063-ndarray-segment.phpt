@@ -0,0 +1,97 @@
+--TEST--
+segment sum, mean, min and max keyed by an id array
+--ENV--
+NDARRAY_NUM_THREADS=4
+NDARRAY_PARALLEL_THRESHOLD=1000
+--FILE--
+<?php
+$values = [[1, 2], [3, 4], [5, 6], [7, 8]];
+$ids = [0, 2, 0, 2];
+print_r(\NDArray::segmentSum($values, $ids, 3)->toArray());
+print_r(\NDArray::segmentMean($values, $ids, 3)->toArray());
+print_r(\NDArray::segmentMax($values, $ids, 3)->toArray());
+print_r(\NDArray::segmentMin([4, 1, 3], [1, 1, 0], 2)->toArray());
+$ids = array_map(fn($i) => $i % 4, range(0, 99999));
+print_r(\NDArray::segmentSum(\NDArray::ones([100000]), $ids, 4)->toArray());
+try {
+    \NDArray::segmentSum([1, 2], [0, 5], 2);
+} catch (\Error $e) {
+    echo $e->getMessage() . "\n";
+}
+--EXPECT--
+Array
+(
+    [0] => Array
+        (
+            [0] => 6
+            [1] => 8
+        )
+
+    [1] => Array
+        (
+            [0] => 0
+            [1] => 0
+        )
+
+    [2] => Array
+        (
+            [0] => 10
+            [1] => 12
+        )
+
+)
+Array
+(
+    [0] => Array
+        (
+            [0] => 3
+            [1] => 4
+        )
+
+    [1] => Array
+        (
+            [0] => NAN
+            [1] => NAN
+        )
+
+    [2] => Array
+        (
+            [0] => 5
+            [1] => 6
+        )
+
+)
+Array
+(
+    [0] => Array
+        (
+            [0] => 5
+            [1] => 6
+        )
+
+    [1] => Array
+        (
+            [0] => -INF
+            [1] => -INF
+        )
+
+    [2] => Array
+        (
+            [0] => 7
+            [1] => 8
+        )
+
+)
+Array
+(
+    [0] => 3
+    [1] => 1
+)
+Array
+(
+    [0] => 25000
+    [1] => 25000
+    [2] => 25000
+    [3] => 25000
+)
+segment id 5 out of range [0, 2)
@@ -0,0 +1,64 @@
+--TEST--
+NaN-ignoring reductions and the where mask of reductions
+--ENV--
+NDARRAY_NUM_THREADS=4
+NDARRAY_PARALLEL_THRESHOLD=1000
+--FILE--
+<?php
+$a = [[1, NAN, 3], [NAN, NAN, NAN], [4, 5, NAN]];
+print_r(\NDArray::nansum($a, 1)->toArray());
+print_r(\NDArray::nanmean($a, 1)->toArray());
+print_r(\NDArray::nanmin($a, 1)->toArray());
+print_r(\NDArray::nanmax($a, 0)->toArray());
+var_dump(\NDArray::nanstd([1, NAN, 3]));
+$w = [[1, 0, 1], [0, 0, 0], [1, 1, 0]];
+print_r(\NDArray::sum([[1, 2, 3], [4, 5, 6], [7, 8, 9]], 1, false, $w)->toArray());
+print_r(\NDArray::mean([[1, 2, 3], [4, 5, 6]], 0, false, [1, 0, 1])->toArray());
+var_dump(\NDArray::max([1, 9, 3], null, false, [1, 0, 1]));
+var_dump(\NDArray::nansum(array_map(fn($i) => $i % 7 == 0 ? NAN : 1, range(0, 99999))));
+try {
+    \NDArray::sum([1, 2, 3], null, false, [1, 0]);
+} catch (\Error $e) {
+    echo $e->getMessage() . "\n";
+}
+--EXPECT--
+Array
+(
+    [0] => 4
+    [1] => 0
+    [2] => 9
+)
+Array
+(
+    [0] => 2
+    [1] => NAN
+    [2] => 4.5
+)
+Array
+(
+    [0] => 1
+    [1] => NAN
+    [2] => 4
+)
+Array
+(
+    [0] => 4
+    [1] => 5
+    [2] => 3
+)
+float(1)
+Array
+(
+    [0] => 4
+    [1] => 0
+    [2] => 15
+)
+Array
+(
+    [0] => 2.5
+    [1] => NAN
+    [2] => 4.5
+)
+float(3)
+float(85714)
+`where` of size 2 can not be broadcast to size 3 on axis 0
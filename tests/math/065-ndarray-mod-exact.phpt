@@ -0,0 +1,18 @@
+--TEST--
+NDArray::mod matches fmod for large dividends and infinite divisors at every position
+--FILE--
+<?php
+$x = [];
+$y = [];
+for ($i = 0; $i < 35; $i++) {
+    $x[] = ($i % 2) ? 5 : 1e9;
+    $y[] = ($i % 2) ? INF : 7;
+}
+$r = (\NDArray::array($x) % \NDArray::array($y))->toArray();
+echo implode(' ', $r), "\n";
+$r = \NDArray::mod(\NDArray::array($x), 7)->toArray();
+echo implode(' ', $r), "\n";
+?>
+--EXPECT--
+6 5 6 5 6 5 6 5 6 5 6 5 6 5 6 5 6 5 6 5 6 5 6 5 6 5 6 5 6 5 6 5 6 5 6
+6 5 6 5 6 5 6 5 6 5 6 5 6 5 6 5 6 5 6 5 6 5 6 5 6 5 6 5 6 5 6 5 6 5 6
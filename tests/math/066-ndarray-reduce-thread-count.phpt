@@ -0,0 +1,24 @@
+--TEST--
+Parallel reductions give the same result whatever the number of threads
+--FILE--
+<?php
+$a = \NDArray::sin(\NDArray::arange(1000000)) * 1000;
+\NDArray::setNumThreads(1);
+$sum = \NDArray::sum($a);
+$std = \NDArray::std($a);
+$scan = \NDArray::sum(\NDArray::cumsum($a));
+foreach ([2, 3, 8] as $threads) {
+    \NDArray::setNumThreads($threads);
+    var_dump(\NDArray::sum($a) === $sum, \NDArray::std($a) === $std, \NDArray::sum(\NDArray::cumsum($a)) === $scan);
+}
+?>
+--EXPECT--
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+bool(true)